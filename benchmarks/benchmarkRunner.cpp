@@ -0,0 +1,171 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "benchmarkRunner.h"
+
+#include <algorithm>
+#include <iostream>
+
+#include <QtCore/QDateTime>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QJsonArray>
+#include <QtCore/QSysInfo>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <trikKernel/version.h>
+
+using namespace benchmarks;
+
+void BenchmarkRunner::add(const QString &name, Kind kind, int operations, const Body &body)
+{
+	mBenchmarks << Benchmark{name, kind, operations, body, DistributionBody()};
+}
+
+void BenchmarkRunner::add(const QString &name, Kind kind, int operations, const DistributionBody &body)
+{
+	mBenchmarks << Benchmark{name, kind, operations, Body(), body};
+}
+
+QStringList BenchmarkRunner::names() const
+{
+	QStringList result;
+	for (const Benchmark &benchmark : mBenchmarks) {
+		result << benchmark.name;
+	}
+
+	return result;
+}
+
+QJsonObject BenchmarkRunner::run(const QRegularExpression &filter, int repetitions) const
+{
+	QJsonArray results;
+	for (const Benchmark &benchmark : mBenchmarks) {
+		if (filter.match(benchmark.name).hasMatch()) {
+			results << run(benchmark, repetitions);
+		}
+	}
+
+	QJsonObject system;
+	system["os"] = QSysInfo::prettyProductName();
+	system["kernel"] = QSysInfo::kernelVersion();
+	system["cpu"] = QSysInfo::currentCpuArchitecture();
+	system["cores"] = QThread::idealThreadCount();
+	system["qt"] = QString(qVersion());
+#ifdef QT_NO_DEBUG
+	system["build"] = QString("release");
+#else
+	system["build"] = QString("debug");
+#endif
+
+	QJsonObject report;
+	report["version"] = trikKernel::version;
+	report["date"] = QDateTime::currentDateTimeUtc().toString(Qt::ISODate);
+	report["system"] = system;
+	report["repetitions"] = repetitions;
+	report["benchmarks"] = results;
+	return report;
+}
+
+qint64 BenchmarkRunner::measure(const std::function<void()> &function)
+{
+	QElapsedTimer timer;
+	timer.start();
+	function();
+	return timer.nsecsElapsed();
+}
+
+QJsonObject BenchmarkRunner::run(const Benchmark &benchmark, int repetitions)
+{
+	std::cerr << benchmark.name.toStdString() << ": " << std::flush;
+
+	// Values of operations of distribution benchmarks are collected from all repetitions except warm up.
+	QVector<qint64> values;
+	const Body body = benchmark.body ? benchmark.body : [&benchmark, &values](int operations) -> qint64 {
+		const QVector<qint64> result = benchmark.distributionBody(operations);
+		if (result.size() != operations) {
+			return -1;
+		}
+
+		values += result;
+		qint64 total = 0;
+		for (const qint64 value : result) {
+			total += value;
+		}
+
+		return qMax<qint64>(total, 0);
+	};
+
+	bool failed = body(benchmark.operations) < 0;
+	values.clear();
+	QVector<double> samples;
+	for (int i = 0; i < repetitions && !failed; ++i) {
+		const qint64 time = body(benchmark.operations);
+		failed = time < 0;
+		samples << static_cast<double>(time) / benchmark.operations;
+	}
+
+	QJsonObject result;
+	result["name"] = benchmark.name;
+	result["kind"] = QString(benchmark.kind == Kind::micro ? "micro" : "macro");
+	result["operations"] = benchmark.operations;
+	result["failed"] = failed;
+	if (failed) {
+		std::cerr << "FAILED" << std::endl;
+		return result;
+	}
+
+	QJsonArray samplesArray;
+	double sum = 0;
+	for (const double sample : samples) {
+		samplesArray << sample;
+		sum += sample;
+	}
+
+	QVector<double> sorted = samples;
+	std::sort(sorted.begin(), sorted.end());
+	const int middle = sorted.size() / 2;
+	const double median = sorted.size() % 2 == 1 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2;
+
+	result["min"] = sorted.first();
+	result["median"] = median;
+	result["mean"] = sum / sorted.size();
+	result["max"] = sorted.last();
+	result["samples"] = samplesArray;
+	if (!values.isEmpty()) {
+		result["distribution"] = distribution(values);
+	}
+
+	std::cerr << median << " ns/op (min " << sorted.first() << ", max " << sorted.last() << ")" << std::endl;
+	return result;
+}
+
+QJsonObject BenchmarkRunner::distribution(QVector<qint64> values)
+{
+	std::sort(values.begin(), values.end());
+	double sum = 0;
+	for (const qint64 value : values) {
+		sum += value;
+	}
+
+	// Nearest-rank percentile.
+	const int p99 = qMax((values.size() * 99 + 99) / 100 - 1, 0);
+
+	QJsonObject result;
+	result["min"] = static_cast<double>(values.first());
+	result["mean"] = sum / values.size();
+	result["p99"] = static_cast<double>(values[p99]);
+	result["max"] = static_cast<double>(values.last());
+	return result;
+}
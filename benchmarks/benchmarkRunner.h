@@ -0,0 +1,95 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <functional>
+
+#include <QtCore/QJsonObject>
+#include <QtCore/QList>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+namespace benchmarks {
+
+/// Kind of a benchmark.
+enum class Kind
+{
+	/// Times one function in a tight loop, in one thread.
+	micro
+
+	/// Times a scenario that involves threads, event loops, files or sockets.
+	, macro
+};
+
+/// Runs registered benchmarks and reports their results as JSON.
+///
+/// Every benchmark does a fixed number of operations per repetition on fixed data. It is run once to warm up caches
+/// and lazy initialization, then given number of times. Time per operation of every repetition is reported along
+/// with its minimum, median, mean and maximum, so runs of different builds and releases can be compared, preferably
+/// by median.
+class BenchmarkRunner
+{
+public:
+	/// Benchmark body: performs given number of operations and returns time they took in nanoseconds, or -1 if they
+	/// failed. Body measures time itself, so preparation of a repetition can be excluded.
+	using Body = std::function<qint64(int operations)>;
+
+	/// Body of a benchmark that measures every operation separately: performs given number of operations and returns
+	/// their values in nanoseconds (latency, deviation from a schedule and so on), or empty vector if they failed.
+	using DistributionBody = std::function<QVector<qint64>(int operations)>;
+
+	/// Adds a benchmark.
+	/// @param name - unique name in form "<module>.<subject>", for example "kernel.configurerLookup".
+	/// @param operations - number of operations in one repetition.
+	void add(const QString &name, Kind kind, int operations, const Body &body);
+
+	/// Adds a benchmark which reports distribution of values of operations in addition to mean value per operation
+	/// of every repetition.
+	void add(const QString &name, Kind kind, int operations, const DistributionBody &body);
+
+	/// Returns names of all added benchmarks.
+	QStringList names() const;
+
+	/// Runs benchmarks with names matching given regular expression and returns a report. Progress is printed to
+	/// stderr. Report has "version" of runtime, "system" description, "repetitions" and "benchmarks" array with
+	/// results: "name", "kind", "operations", "failed", and "min", "median", "mean", "max" and "samples" in
+	/// nanoseconds per operation. Results of benchmarks with DistributionBody also have "distribution" with "min",
+	/// "mean", "p99" and "max" of values of all operations of all repetitions, in nanoseconds.
+	QJsonObject run(const QRegularExpression &filter, int repetitions) const;
+
+	/// Runs a function and returns time it took in nanoseconds.
+	static qint64 measure(const std::function<void()> &function);
+
+private:
+	struct Benchmark
+	{
+		QString name;
+		Kind kind;
+		int operations;
+		Body body;
+		DistributionBody distributionBody;
+	};
+
+	/// Runs one benchmark and returns its result.
+	static QJsonObject run(const Benchmark &benchmark, int repetitions);
+
+	/// Returns "min", "mean", "p99" and "max" of non-empty vector of values.
+	static QJsonObject distribution(QVector<qint64> values);
+
+	QList<Benchmark> mBenchmarks;
+};
+
+}
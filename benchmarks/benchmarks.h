@@ -0,0 +1,51 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QString>
+
+namespace trikControl {
+class BrickInterface;
+}
+
+namespace benchmarks {
+
+class BenchmarkRunner;
+
+/// System config used by benchmarks, the same as in tests.
+const QString systemConfig = "./test-system-config.xml";
+
+/// Model config used by benchmarks, the same as in tests. Shared state is optional in system config and is not listed
+/// here, so it is disabled and does not publish snapshots while benchmarks run; benchmarks check it on start.
+const QString modelConfig = "./test-model-config.xml";
+
+/// Adds configurer loading and lookup, timer wheel, logger and metrics benchmarks.
+void addKernelBenchmarks(BenchmarkRunner &runner);
+
+/// Adds event file decoding, camera frame conversion and fake sysfs device file benchmarks. They use Linux
+/// implementations of trikHal that are compiled for desktop Linux along with stub ones.
+void addHalBenchmarks(BenchmarkRunner &runner);
+
+/// Adds benchmarks of creation of a brick and of its devices: gyroscope, motors, encoders, control loop, motor
+/// controllers and motor groups.
+void addControlBenchmarks(BenchmarkRunner &runner, trikControl::BrickInterface &brick);
+
+/// Adds server scaling, connection framing, mailbox routing and mailbox inbox benchmarks over loopback.
+void addNetworkBenchmarks(BenchmarkRunner &runner);
+
+/// Adds script engine, script threads, Python script start and stop, and "getPhoto" benchmarks.
+void addScriptRunnerBenchmarks(BenchmarkRunner &runner, trikControl::BrickInterface &brick);
+
+}
@@ -0,0 +1,57 @@
+# Copyright 2018 CyberTech Labs Ltd.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+# Micro and macro benchmarks of runtime, results are printed as JSON to compare releases. Benchmarks are meant for
+# desktop builds, where trikControl works with stub hardware abstraction, so they use test configs.
+
+include(../global.pri)
+
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+QT += widgets network script
+
+equals(ARCHITECTURE, arm) {
+	warning("Benchmarks are meant for stub hardware abstraction of desktop builds")
+}
+
+HEADERS += \
+	$$PWD/benchmarkRunner.h \
+	$$PWD/benchmarks.h \
+
+SOURCES += \
+	$$PWD/main.cpp \
+	$$PWD/benchmarkRunner.cpp \
+	$$PWD/controlBenchmarks.cpp \
+	$$PWD/kernelBenchmarks.cpp \
+	$$PWD/networkBenchmarks.cpp \
+	$$PWD/scriptRunnerBenchmarks.cpp \
+
+# Event file decoding and camera frame conversion use Linux implementations of trikHal.
+linux {
+	SOURCES += $$PWD/halBenchmarks.cpp
+}
+
+# Internal headers of benchmarked implementations.
+INCLUDEPATH += \
+	$$PWD/../trikHal/src \
+	$$PWD/../trikHal/include/trikHal \
+	$$PWD/../trikScriptRunner/src \
+
+implementationIncludes(trikKernel trikHal trikControl trikNetwork trikScriptRunner)
+links(qslog trikKernel trikHal trikControl trikNetwork trikScriptRunner)
+
+copyToDestdir($$PWD/../tests/test-system-config.xml, now)
+copyToDestdir($$PWD/../tests/test-model-config.xml, now)
@@ -0,0 +1,339 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "benchmarks.h"
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QMetaMethod>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+#include <trikControl/controlLoopInterface.h>
+#include <trikControl/encoderInterface.h>
+#include <trikControl/motorControllerInterface.h>
+#include <trikControl/motorGroupInterface.h>
+#include <trikControl/motorInterface.h>
+#include <trikControl/sharedStateClient.h>
+#include <trikControl/sharedStateLayout.h>
+#include <trikControl/gyroSensorInterface.h>
+#include <trikKernel/timeVal.h>
+
+#include "benchmarkRunner.h"
+
+using namespace benchmarks;
+
+void benchmarks::addControlBenchmarks(BenchmarkRunner &runner, trikControl::BrickInterface &brick)
+{
+	// Operation is creation of a brick with all devices of the test model, destruction of a brick is not timed.
+	runner.add("control.brickCreation", Kind::macro, 5, [](int operations) -> qint64 {
+		qint64 total = 0;
+		for (int i = 0; i < operations; ++i) {
+			QElapsedTimer timer;
+			timer.start();
+			QScopedPointer<trikControl::BrickInterface> created(trikControl::BrickFactory::create(systemConfig
+					, modelConfig, "./media/"));
+			total += timer.nsecsElapsed();
+
+			const bool initialized = !created->initializationReport().contains("failed");
+			created.reset();
+			QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+			if (!initialized) {
+				return -1;
+			}
+		}
+
+		return total;
+	});
+
+	// Number of gyroscope readings fed so far, time of a reading is 1 ms after the previous one in all repetitions.
+	QSharedPointer<int> readings(new int(0));
+
+	// Stub event files emit nothing, so readings are fed to the slot which worker thread of a gyroscope is connected
+	// to. It is invoked by meta-object system, as it is on a robot where it is called by a queued connection.
+	runner.add("control.gyroFusion", Kind::micro, 100000, [&brick, readings](int operations) -> qint64 {
+		trikControl::GyroSensorInterface * const gyroscope = brick.gyroscope();
+		if (!gyroscope) {
+			return -1;
+		}
+
+		const QMetaObject * const metaObject = gyroscope->metaObject();
+		const int index = metaObject->indexOfSlot(
+				QMetaObject::normalizedSignature("countTilt(QVector<int>,trikKernel::TimeVal)"));
+		if (index < 0) {
+			return -1;
+		}
+
+		const QMetaMethod countTilt = metaObject->method(index);
+		QVector<int> reading(3);
+		bool failed = false;
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				const int tick = (*readings)++;
+				reading[0] = 100 + tick % 7;
+				reading[1] = -50 + tick % 5;
+				reading[2] = 30 - tick % 3;
+				const trikKernel::TimeVal eventTime(tick / 1000, (tick % 1000) * 1000);
+				failed |= !countTilt.invoke(gyroscope, Qt::DirectConnection
+						, Q_ARG(QVector<int>, reading), Q_ARG(trikKernel::TimeVal, eventTime));
+			}
+		});
+
+		return failed ? -1 : time;
+	});
+
+	// Time of an operation is lateness of start of a cycle of a control loop at 500 Hz comparing to its deadline.
+	runner.add("control.loopJitter", Kind::macro, 500, [&brick](int operations) -> qint64 {
+		trikControl::ControlLoopInterface * const loop = brick.controlLoop();
+		if (!loop) {
+			return -1;
+		}
+
+		const int rate = loop->rate();
+		loop->setRate(500);
+		const int controller = loop->addController([](qreal setpoint, qreal dt) {
+			Q_UNUSED(setpoint)
+			Q_UNUSED(dt)
+		});
+
+		loop->resetStatistics();
+		QElapsedTimer timeout;
+		timeout.start();
+		QVariantMap statistics = loop->statistics();
+		while (statistics["cycles"].toInt() < operations && timeout.elapsed() < 10000) {
+			QThread::msleep(10);
+			statistics = loop->statistics();
+		}
+
+		loop->removeController(controller);
+		loop->setRate(rate);
+
+		const int cycles = statistics["cycles"].toInt();
+		return cycles < operations ? -1 : statistics["meanJitter"].toLongLong() * 1000 * operations;
+	});
+
+	// Time of an operation is settling time of a motor controller moving simulated motor by a turn, back and forth.
+	runner.add("control.motorControllerMoveTo", Kind::macro, 4, [&brick](int operations) -> qint64 {
+		trikControl::MotorControllerInterface * const controller = brick.motorController("M1", "E1");
+		if (!controller) {
+			return -1;
+		}
+
+		brick.encoder("E1")->reset();
+		qint64 total = 0;
+		for (int i = 0; i < operations; ++i) {
+			QElapsedTimer timer;
+			timer.start();
+			controller->moveTo(i % 2 == 0 ? 360 : 0);
+			while (!controller->isSettled()) {
+				if (timer.elapsed() > 3000) {
+					controller->stop();
+					return -1;
+				}
+
+				QThread::msleep(1);
+			}
+
+			total += timer.nsecsElapsed();
+		}
+
+		controller->stop();
+		return total;
+	});
+
+	// Servo of stub hardware abstraction, every operation changes duty.
+	runner.add("control.servoSetPowerChanging", Kind::micro, 100000, [&brick](int operations) -> qint64 {
+		trikControl::MotorInterface * const servo = brick.motor("S1");
+		if (!servo) {
+			return -1;
+		}
+
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				servo->setPower(i % 2 == 0 ? 10 : -10);
+			}
+		});
+
+		servo->powerOff();
+		return time;
+	});
+
+	// Servo of stub hardware abstraction, duty stays the same, so nothing is written after the first operation.
+	runner.add("control.servoSetPowerUnchanged", Kind::micro, 100000, [&brick](int operations) -> qint64 {
+		trikControl::MotorInterface * const servo = brick.motor("S1");
+		if (!servo) {
+			return -1;
+		}
+
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				servo->setPower(20);
+			}
+		});
+
+		servo->powerOff();
+		return time;
+	});
+
+	// Operation is setting powers of 4 motors by one burst of bus commands.
+	runner.add("control.motorGroupSetPowers", Kind::micro, 10000, [&brick](int operations) -> qint64 {
+		trikControl::MotorGroupInterface * const group = brick.motorGroup({"M1", "M2", "M3", "M4"});
+		if (!group) {
+			return -1;
+		}
+
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				group->setPowers({i % 100, -(i % 100), i % 50, -(i % 50)});
+			}
+		});
+
+		group->stopAll();
+		return time;
+	});
+
+	// Operation is setting powers of the same 4 motors by separate calls, for comparison with a group.
+	runner.add("control.motorSeparateSetPowers", Kind::micro, 10000, [&brick](int operations) -> qint64 {
+		QVector<trikControl::MotorInterface *> motors;
+		for (const QString &port : QStringList({"M1", "M2", "M3", "M4"})) {
+			motors << brick.motor(port);
+			if (!motors.last()) {
+				return -1;
+			}
+		}
+
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				motors[0]->setPower(i % 100);
+				motors[1]->setPower(-(i % 100));
+				motors[2]->setPower(i % 50);
+				motors[3]->setPower(-(i % 50));
+			}
+		});
+
+		for (trikControl::MotorInterface * const motor : motors) {
+			motor->powerOff();
+		}
+
+		return time;
+	});
+
+	// Time of an operation is skew between commands to the first and the last motor of a group.
+	runner.add("control.motorGroupSkew", Kind::micro, 10000, [&brick](int operations) -> qint64 {
+		trikControl::MotorGroupInterface * const group = brick.motorGroup({"M1", "M2", "M3", "M4"});
+		if (!group) {
+			return -1;
+		}
+
+		qint64 total = 0;
+		for (int i = 0; i < operations; ++i) {
+			group->setPowers({i % 100, -(i % 100), i % 50, -(i % 50)});
+			const QVariantList times = group->commandTimes();
+			if (times.size() != 4) {
+				return -1;
+			}
+
+			total += (times.last().toLongLong() - times.first().toLongLong()) * 1000;
+		}
+
+		group->stopAll();
+		return total;
+	});
+
+	// Operation is reading of all 4 encoders of a brick one by one.
+	runner.add("control.encoderRead", Kind::micro, 10000, [&brick](int operations) -> qint64 {
+		QVector<trikControl::EncoderInterface *> encoders;
+		for (const QString &port : QStringList({"E1", "E2", "E3", "E4"})) {
+			encoders << brick.encoder(port);
+			if (!encoders.last()) {
+				return -1;
+			}
+		}
+
+		return BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				for (trikControl::EncoderInterface * const encoder : encoders) {
+					encoder->read();
+				}
+			}
+		});
+	});
+
+	// Operation is getting speed of all 4 encoders of a brick, which are sampled in the background in one burst.
+	runner.add("control.encoderSampledSpeed", Kind::micro, 10000, [&brick](int operations) -> qint64 {
+		QVector<trikControl::EncoderInterface *> encoders;
+		for (const QString &port : QStringList({"E1", "E2", "E3", "E4"})) {
+			encoders << brick.encoder(port);
+			if (!encoders.last()) {
+				return -1;
+			}
+
+			// The first query starts sampling.
+			encoders.last()->readSpeed();
+		}
+
+		QThread::msleep(100);
+		if (encoders.first()->history(2).size() != 2) {
+			return -1;
+		}
+
+		return BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				for (trikControl::EncoderInterface * const encoder : encoders) {
+					encoder->readSpeed();
+				}
+			}
+		});
+	});
+
+	// Operation is reading of a snapshot of shared state while a brick publishes new ones. Configs of benchmarks keep
+	// shared state disabled, so the benchmark enables it in a copy of model config for a brick of its own.
+	runner.add("control.sharedStateRead", Kind::micro, 1000000, [](int operations) -> qint64 {
+		const QTemporaryDir dir;
+		QFile testModelConfig(modelConfig);
+		QFile publishingModelConfig(dir.path() + "/model-config.xml");
+		if (!dir.isValid() || !testModelConfig.open(QIODevice::ReadOnly)
+				|| !publishingModelConfig.open(QIODevice::WriteOnly))
+		{
+			return -1;
+		}
+
+		publishingModelConfig.write(QString::fromUtf8(testModelConfig.readAll())
+				.replace("<mailbox />", "<mailbox />\n<sharedState />").toUtf8());
+		publishingModelConfig.close();
+
+		QScopedPointer<trikControl::BrickInterface> publishing(trikControl::BrickFactory::create(systemConfig
+				, publishingModelConfig.fileName(), "./media/"));
+		trikControl::SharedStateClient client("trikRuntimeTestState");
+		if (!client.attach()) {
+			return -1;
+		}
+
+		trikControl::sharedState::Snapshot snapshot;
+		int failures = 0;
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				failures += client.read(snapshot) ? 0 : 1;
+			}
+		});
+
+		return failures > 0 ? -1 : time;
+	});
+}
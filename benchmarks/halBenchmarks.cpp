@@ -0,0 +1,322 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "benchmarks.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <unistd.h>
+#include <linux/input.h>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+#include <trikControl/motorInterface.h>
+#include <trikControl/pwmCaptureInterface.h>
+#include <trikHal/hardwareAbstractionFactory.h>
+#include <trik/trikEventFile.h>
+#include <trik/yuvConversion.h>
+
+#include "benchmarkRunner.h"
+
+using namespace benchmarks;
+
+namespace {
+
+/// Size of a camera frame, the same as TrikV4l2VideoDevice requests.
+const int frameWidth = 320;
+const int frameHeight = 240;
+
+/// Thread that listens to an event file in its event loop, like a worker thread of a sensor does, and counts
+/// decoded events.
+class EventFileThread : public QThread
+{
+public:
+	explicit EventFileThread(const QString &fileName)
+		: mFileName(fileName)
+	{
+	}
+
+	/// 1 if event file is opened, -1 if it failed to open, 0 if it is not opened yet.
+	int opened() const
+	{
+		return mOpened.load();
+	}
+
+	int received() const
+	{
+		return mReceived.load();
+	}
+
+private:
+	void run() override
+	{
+		// Event file is created, used and destroyed in this thread, so is its socket notifier.
+		trikHal::trik::TrikEventFile eventFile(mFileName, *this);
+		QObject::connect(&eventFile, &trikHal::EventFileInterface::newEvent, [this]() { mReceived.ref(); });
+		if (!eventFile.open()) {
+			mOpened.store(-1);
+			return;
+		}
+
+		mOpened.store(1);
+		exec();
+		eventFile.close();
+	}
+
+	const QString mFileName;
+	QAtomicInt mOpened;
+	QAtomicInt mReceived;
+};
+
+/// Waits until a condition holds, returns false if it did not hold in 10 seconds.
+template<typename Condition>
+bool waitFor(const Condition &condition)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!condition()) {
+		if (timer.elapsed() > 10000) {
+			return false;
+		}
+
+		QThread::usleep(100);
+	}
+
+	return true;
+}
+
+/// Writes events of a 3-axis sensor, one SYN_REPORT after every 3 axes, to a FIFO which TrikEventFile reads like a
+/// device event file. Returns time from the start of writing till all events are decoded and emitted.
+qint64 decodeEvents(int operations)
+{
+	QTemporaryDir dir;
+	const QString fileName = dir.path() + "/event";
+	if (!dir.isValid() || ::mkfifo(fileName.toLocal8Bit().constData(), 0600) != 0) {
+		return -1;
+	}
+
+	QVector<input_event> events(operations);
+	timeval now;
+	gettimeofday(&now, nullptr);
+	for (int i = 0; i < operations; ++i) {
+		events[i].time = now;
+		if (i % 4 == 3) {
+			events[i].type = EV_SYN;
+			events[i].code = SYN_REPORT;
+			events[i].value = 0;
+		} else {
+			events[i].type = EV_ABS;
+			events[i].code = ABS_X + i % 4;
+			events[i].value = (i * 37) % 4096 - 2048;
+		}
+	}
+
+	EventFileThread thread(fileName);
+	thread.start();
+	if (!waitFor([&thread]() { return thread.opened() != 0; }) || thread.opened() < 0) {
+		thread.wait();
+		return -1;
+	}
+
+	// Reader is already opened, so blocking open for writing returns immediately. Writes block while FIFO is full,
+	// so decoding goes on in parallel with writing.
+	const int writer = ::open(fileName.toLocal8Bit().constData(), O_WRONLY);
+	const char * const data = reinterpret_cast<const char *>(events.constData());
+	const int size = events.size() * static_cast<int>(sizeof(input_event));
+	int written = 0;
+
+	QElapsedTimer timer;
+	timer.start();
+	while (writer != -1 && written < size) {
+		const ssize_t result = ::write(writer, data + written, size - written);
+		if (result <= 0) {
+			break;
+		}
+
+		written += result;
+	}
+
+	const bool decoded = written == size && waitFor([&thread, operations]() {
+		return thread.received() >= operations;
+	});
+
+	const qint64 time = timer.nsecsElapsed();
+
+	// Writer is closed after reader stops, otherwise reader would be woken up by end of file.
+	thread.quit();
+	thread.wait();
+	if (writer != -1) {
+		::close(writer);
+	}
+
+	return decoded ? time : -1;
+}
+
+/// Returns deterministic frame of given size with some variety in colors.
+QVector<uint8_t> testFrame(int size)
+{
+	QVector<uint8_t> frame(size);
+	for (int i = 0; i < size; ++i) {
+		frame[i] = static_cast<uint8_t>((i * 7 + i / frameWidth * 3) & 0xff);
+	}
+
+	return frame;
+}
+
+/// Benchmark body that converts a YUV 4:2:2 frame (2 bytes per pixel) with given function.
+BenchmarkRunner::Body conversion(QVector<uint8_t> (*convert)(const QVector<uint8_t> &, int, int))
+{
+	return [convert](int operations) {
+		const QVector<uint8_t> frame = testFrame(frameWidth * frameHeight * 2);
+		bool failed = false;
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				failed |= convert(frame, frameHeight, frameWidth).size() != frameWidth * frameHeight * 3;
+			}
+		});
+
+		return failed ? -1 : time;
+	};
+}
+
+QByteArray readFile(const QString &fileName)
+{
+	QFile file(fileName);
+	file.open(QIODevice::ReadOnly);
+	return file.readAll();
+}
+
+/// Brick with devices of the test model working with device files of fake sysfs, on tmpfs if there is one. Port S2
+/// has PWM capture instead of a servo.
+class FakeSysfsBrick
+{
+public:
+	FakeSysfsBrick()
+		: mSysfs(QDir("/dev/shm").exists() ? "/dev/shm/trikSysfs-XXXXXX" : QString())
+	{
+		if (!mSysfs.isValid()) {
+			return;
+		}
+
+		// Sysfs files exist before anybody opens them.
+		const QString config = QString::fromUtf8(readFile(systemConfig));
+		QRegularExpressionMatchIterator files = QRegularExpression("\"(/sys/[^\"]+)\"").globalMatch(config);
+		while (files.hasNext()) {
+			const QString fileName = mSysfs.path() + files.next().captured(1);
+			QDir().mkpath(QFileInfo(fileName).path());
+			QFile(fileName).open(QIODevice::WriteOnly);
+		}
+
+		QFile frequencyFile(mSysfs.path() + "/sys/class/pwm/ecap_cap.1/freq");
+		frequencyFile.open(QIODevice::WriteOnly);
+		frequencyFile.write("50:-3:1000\n");
+		frequencyFile.close();
+
+		QFile captureModelConfig(mSysfs.path() + "/model-config.xml");
+		captureModelConfig.open(QIODevice::WriteOnly);
+		captureModelConfig.write(QString::fromUtf8(readFile(modelConfig))
+				.replace(QRegularExpression("<S2>\\s*<angularServomotor />"), "<S2><pwmCapture />").toUtf8());
+		captureModelConfig.close();
+
+		mHardwareAbstraction = trikHal::HardwareAbstractionFactory::createWithFakeSysfs(mSysfs.path());
+		mBrick.reset(trikControl::BrickFactory::create(*mHardwareAbstraction, systemConfig
+				, captureModelConfig.fileName(), "./media/"));
+	}
+
+	~FakeSysfsBrick()
+	{
+		mBrick.reset();
+		QCoreApplication::sendPostedEvents(nullptr, QEvent::DeferredDelete);
+	}
+
+	/// Returns servo on port S1 or nullptr if brick was not created.
+	trikControl::MotorInterface *servo()
+	{
+		return mBrick ? mBrick->motor("S1") : nullptr;
+	}
+
+	/// Returns PWM capture on port S2 or nullptr if brick was not created.
+	trikControl::PwmCaptureInterface *pwmCapture()
+	{
+		return mBrick ? mBrick->pwmCapture("S2") : nullptr;
+	}
+
+private:
+	QTemporaryDir mSysfs;
+	QSharedPointer<trikHal::HardwareAbstractionInterface> mHardwareAbstraction;
+	QScopedPointer<trikControl::BrickInterface> mBrick;
+};
+
+/// Servo writes duty to a device file of fake sysfs, every operation changes duty.
+qint64 setServoPower(int operations)
+{
+	FakeSysfsBrick brick;
+	trikControl::MotorInterface * const servo = brick.servo();
+	if (!servo) {
+		return -1;
+	}
+
+	const qint64 time = BenchmarkRunner::measure([&]() {
+		for (int i = 0; i < operations; ++i) {
+			servo->setPower(i % 2 == 0 ? 10 : -10);
+		}
+	});
+
+	servo->powerOff();
+	return time;
+}
+
+/// PWM capture reads and parses a device file of fake sysfs.
+qint64 readPwmCapture(int operations)
+{
+	FakeSysfsBrick brick;
+	trikControl::PwmCaptureInterface * const capture = brick.pwmCapture();
+	if (!capture) {
+		return -1;
+	}
+
+	bool failed = false;
+	const qint64 time = BenchmarkRunner::measure([&]() {
+		for (int i = 0; i < operations; ++i) {
+			failed |= capture->frequency().size() != 3;
+		}
+	});
+
+	return failed ? -1 : time;
+}
+
+}
+
+void benchmarks::addHalBenchmarks(BenchmarkRunner &runner)
+{
+	runner.add("hal.eventFileDecoding", Kind::macro, 100000, decodeEvents);
+	runner.add("hal.yuyvToRgb", Kind::micro, 200, conversion(trikHal::trik::yuyvToRgb));
+	runner.add("hal.yuv422pToRgb", Kind::micro, 200, conversion(trikHal::trik::yuv422pToRgb));
+	runner.add("hal.fakeSysfsServoSetPower", Kind::micro, 100000, setServoPower);
+	runner.add("hal.fakeSysfsPwmCaptureRead", Kind::micro, 100000, readPwmCapture);
+}
@@ -0,0 +1,251 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "benchmarks.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QPair>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <QsLog.h>
+#include <QsLogDest.h>
+#include <trikKernel/configurer.h>
+#include <trikKernel/metrics.h>
+#include <trikKernel/timerWheel.h>
+
+#include "benchmarkRunner.h"
+
+using namespace benchmarks;
+
+namespace {
+
+/// Copies configs used by benchmarks into a given directory, so that a cache of a model is not shared with others.
+bool copyConfigs(const QTemporaryDir &dir)
+{
+	return dir.isValid() && QFile::copy(systemConfig, dir.filePath("system-config.xml"))
+			&& QFile::copy(modelConfig, dir.filePath("model-config.xml"));
+}
+
+/// Returns body of a benchmark where operation is an empty timed section with metrics enabled or disabled.
+BenchmarkRunner::Body scopedTimer(bool enabled)
+{
+	return [enabled](int operations) {
+		trikKernel::Metrics::Histogram &histogram = trikKernel::Metrics::histogram("benchmarks.scopedTimer");
+		const bool wasEnabled = trikKernel::Metrics::isEnabled();
+		trikKernel::Metrics::setEnabled(enabled);
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				trikKernel::Metrics::ScopedTimer timer(histogram);
+				Q_UNUSED(timer);
+			}
+		});
+
+		// Collected values and trace are not needed and shall not grow with repetitions.
+		trikKernel::Metrics::setEnabled(wasEnabled);
+		trikKernel::Metrics::reset();
+		return time;
+	};
+}
+
+}
+
+void benchmarks::addKernelBenchmarks(BenchmarkRunner &runner)
+{
+	// Configurers of the same files share a compiled model, so it is a lookup of a model, not parsing of XML.
+	runner.add("kernel.configurerCreate", Kind::micro, 10000, [](int operations) {
+		return BenchmarkRunner::measure([operations]() {
+			for (int i = 0; i < operations; ++i) {
+				trikKernel::Configurer configurer(systemConfig, modelConfig);
+				Q_UNUSED(configurer);
+			}
+		});
+	});
+
+	// Operation is parsing of configs, cache of a model is removed before each one and it is not timed.
+	runner.add("kernel.configurerLoadXml", Kind::macro, 20, [](int operations) -> qint64 {
+		const QTemporaryDir dir;
+		if (!copyConfigs(dir)) {
+			return -1;
+		}
+
+		const QString system = dir.filePath("system-config.xml");
+		const QString model = dir.filePath("model-config.xml");
+		QElapsedTimer timer;
+		qint64 total = 0;
+		for (int i = 0; i < operations; ++i) {
+			QFile::remove(dir.filePath("model-config.cache"));
+			timer.start();
+			const trikKernel::Configurer configurer(system, model);
+			Q_UNUSED(configurer);
+			total += timer.nsecsElapsed();
+		}
+
+		return total;
+	});
+
+	// Operation is loading of a model from cache, no other configurer of the same files exists at that time.
+	runner.add("kernel.configurerLoadCache", Kind::macro, 20, [](int operations) -> qint64 {
+		const QTemporaryDir dir;
+		if (!copyConfigs(dir)) {
+			return -1;
+		}
+
+		const QString system = dir.filePath("system-config.xml");
+		const QString model = dir.filePath("model-config.xml");
+		{
+			const trikKernel::Configurer configurer(system, model);
+			Q_UNUSED(configurer);
+		}
+
+		if (!QFile::exists(dir.filePath("model-config.cache"))) {
+			return -1;
+		}
+
+		return BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				const trikKernel::Configurer configurer(system, model);
+				Q_UNUSED(configurer);
+			}
+		});
+	});
+
+	runner.add("kernel.configurerAttributeByPort", Kind::micro, 1000000, [](int operations) {
+		const trikKernel::Configurer configurer(systemConfig, modelConfig);
+		const QVector<QPair<QString, QString>> lookups = {
+			{"M1", "i2cCommandNumber"}, {"A1", "type"}, {"E1", "i2cCommandNumber"}, {"M1", "invert"}
+		};
+
+		int checksum = 0;
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				const auto &lookup = lookups[i % lookups.size()];
+				checksum += configurer.attributeByPort(lookup.first, lookup.second).size();
+			}
+		});
+
+		return checksum > 0 ? time : -1;
+	});
+
+	runner.add("kernel.configurerAttributeByDevice", Kind::micro, 1000000, [](int operations) {
+		const trikKernel::Configurer configurer(systemConfig, modelConfig);
+		int checksum = 0;
+		const qint64 time = BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				switch (i % 3) {
+				case 0:
+					checksum += configurer.attributeByDevice("gyroscope", "deviceFile").size();
+					break;
+				case 1:
+					checksum += configurer.hasAttributeByDevice("sharedState", "rate") ? 1 : 0;
+					break;
+				default:
+					checksum += configurer.isEnabled("mailbox") ? 1 : 0;
+				}
+			}
+		});
+
+		return checksum > 0 ? time : -1;
+	});
+
+	// Operation is start and stop of a timer, with 10000 timers active at once.
+	runner.add("kernel.timerWheelStartStop", Kind::micro, 10000, [](int operations) {
+		trikKernel::TimerWheel wheel;
+		QVector<trikKernel::TimerWheel::TimerId> ids(operations);
+		return BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				ids[i] = wheel.start(10 + (i % 200) * 5, []() {}, true);
+			}
+
+			for (const trikKernel::TimerWheel::TimerId id : ids) {
+				wheel.stop(id);
+			}
+		});
+	});
+
+	// Value of an operation is absolute deviation of expiration of a timer from its due time, 10000 timers with
+	// intervals from 10 to 205 ms are active at once.
+	runner.add("kernel.timerWheelLateness", Kind::macro, 10000
+			, BenchmarkRunner::DistributionBody([](int operations) -> QVector<qint64> {
+		trikKernel::TimerWheel wheel;
+		QElapsedTimer clock;
+		QVector<qint64> deviation(operations, 0);
+		QAtomicInt fired;
+
+		clock.start();
+		QVector<trikKernel::TimerWheel::TimerId> ids;
+		for (int i = 0; i < operations; ++i) {
+			const qint64 interval = 10 + (i % 40) * 5;
+			const qint64 started = clock.nsecsElapsed();
+			ids << wheel.start(static_cast<int>(interval), [&, i, interval, started]() {
+				// Timers may fire up to a tick early due to rounding to ticks.
+				deviation[i] = qAbs(clock.nsecsElapsed() - started - interval * 1000000);
+				fired.fetchAndAddOrdered(1);
+			}, true);
+		}
+
+		while (fired.loadAcquire() < operations && clock.elapsed() < 10000) {
+			QThread::msleep(10);
+		}
+
+		for (const trikKernel::TimerWheel::TimerId id : ids) {
+			wheel.stop(id);
+		}
+
+		return fired.loadAcquire() < operations ? QVector<qint64>() : deviation;
+	}));
+
+	// Cost of a log line for a caller, lines are written to a log file of benchmarks by the background thread.
+	runner.add("kernel.logLine", Kind::micro, 2000, [](int operations) -> qint64 {
+		const int droppedBefore = QsLogging::Logger::instance().droppedCount();
+		const QByteArray payload(200, 'x');
+		QElapsedTimer timer;
+		qint64 total = 0;
+		for (int i = 0; i < operations; ++i) {
+			timer.start();
+			QLOG_INFO() << "kernel.logLine" << i << payload;
+			total += timer.nsecsElapsed();
+			// Roughly the rate of a busy control loop, so the queue does not overflow.
+			QThread::usleep(50);
+		}
+
+		QsLogging::Logger::instance().flush();
+		return QsLogging::Logger::instance().droppedCount() == droppedBefore ? total : -1;
+	});
+
+	// The same lines written to a file and flushed by a caller, as it would be without the background thread.
+	runner.add("kernel.logLineSynchronous", Kind::micro, 2000, [](int operations) -> qint64 {
+		const QTemporaryDir dir;
+		const QsLogging::DestinationPtr file = QsLogging::DestinationFactory::MakeFileDestination(
+				dir.path() + "/benchmark.log", QsLogging::DisableLogRotation, QsLogging::MaxSizeBytes()
+				, QsLogging::MaxOldLogCount(), QsLogging::TraceLevel);
+		if (!dir.isValid() || !file->isValid()) {
+			return -1;
+		}
+
+		const QString payload(200, 'x');
+		return BenchmarkRunner::measure([&]() {
+			for (int i = 0; i < operations; ++i) {
+				file->write(QString("INFO  kernel.logLineSynchronous %1 %2").arg(i).arg(payload), QsLogging::InfoLevel);
+				file->flush();
+			}
+		});
+	});
+
+	runner.add("kernel.metricsScopedTimerDisabled", Kind::micro, 1000000, scopedTimer(false));
+	runner.add("kernel.metricsScopedTimerEnabled", Kind::micro, 1000000, scopedTimer(true));
+}
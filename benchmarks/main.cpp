@@ -0,0 +1,113 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <iostream>
+
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QScopedPointer>
+#include <QtWidgets/QApplication>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+#include <trikKernel/commandLineParser.h>
+#include <trikKernel/configurer.h>
+#include <trikKernel/deinitializationHelper.h>
+#include <trikKernel/loggingHelper.h>
+#include <trikKernel/version.h>
+
+#include "benchmarkRunner.h"
+#include "benchmarks.h"
+
+int main(int argc, char *argv[])
+{
+	QApplication app(argc, argv);
+	app.setApplicationName("benchmarks");
+	app.setApplicationVersion(trikKernel::version);
+
+	trikKernel::LoggingHelper loggingHelper(".");
+	Q_UNUSED(loggingHelper);
+
+	// RAII-style code to ensure that after brick gets destroyed there will be an event loop that cleans it up.
+	trikKernel::DeinitializationHelper helper;
+	Q_UNUSED(helper);
+
+	trikKernel::CommandLineParser parser;
+	parser.addApplicationDescription(QObject::tr("Runs benchmarks of TRIK runtime on stub hardware and prints "
+			"results as JSON."));
+	parser.addFlag("h", "help", QObject::tr("Print this help text."));
+	parser.addFlag("l", "list", QObject::tr("Print names of benchmarks and exit."));
+	parser.addOption("f", "filter", QObject::tr("Regular expression, only benchmarks with matching names are run."));
+	parser.addOption("r", "repetitions", QObject::tr("Number of repetitions of every benchmark, 10 by default."));
+	parser.addOption("o", "output", QObject::tr("File to write results to, they are printed to stdout by default."));
+
+	if (!parser.process(app) || parser.isSet("h")) {
+		parser.showHelp();
+		return 1;
+	}
+
+	const int repetitions = parser.isSet("r") ? parser.value("r").toInt() : 10;
+	const QRegularExpression filter(parser.value("f"));
+	if (repetitions < 1 || !filter.isValid()) {
+		parser.showHelp();
+		return 1;
+	}
+
+	// Publishing of shared state runs in the background and would skew timings of all benchmarks.
+	if (trikKernel::Configurer(benchmarks::systemConfig, benchmarks::modelConfig).isEnabled("sharedState")) {
+		std::cerr << "Shared state shall be disabled in configs of benchmarks" << std::endl;
+		return 1;
+	}
+
+	QScopedPointer<trikControl::BrickInterface> brick(trikControl::BrickFactory::create(benchmarks::systemConfig
+			, benchmarks::modelConfig, "./media/"));
+
+	benchmarks::BenchmarkRunner runner;
+	benchmarks::addKernelBenchmarks(runner);
+#ifdef Q_OS_LINUX
+	benchmarks::addHalBenchmarks(runner);
+#endif
+	benchmarks::addControlBenchmarks(runner, *brick);
+	benchmarks::addNetworkBenchmarks(runner);
+	benchmarks::addScriptRunnerBenchmarks(runner, *brick);
+
+	if (parser.isSet("l")) {
+		for (const QString &name : runner.names()) {
+			std::cout << name.toStdString() << std::endl;
+		}
+
+		return 0;
+	}
+
+	const QJsonObject report = runner.run(filter, repetitions);
+	const QByteArray json = QJsonDocument(report).toJson();
+	if (parser.isSet("o")) {
+		QFile output(parser.value("o"));
+		if (!output.open(QIODevice::WriteOnly) || output.write(json) != json.size()) {
+			std::cerr << "Can not write results to " << output.fileName().toStdString() << std::endl;
+			return 1;
+		}
+	} else {
+		std::cout << json.constData();
+	}
+
+	for (const QJsonValue &result : report["benchmarks"].toArray()) {
+		if (result.toObject()["failed"].toBool()) {
+			return 1;
+		}
+	}
+
+	return 0;
+}
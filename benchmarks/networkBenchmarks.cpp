@@ -0,0 +1,394 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "benchmarks.h"
+
+#include <functional>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+
+#include <trikNetwork/connection.h>
+#include <trikNetwork/mailboxFactory.h>
+#include <trikNetwork/mailboxInterface.h>
+#include <trikNetwork/trikServer.h>
+
+#include "benchmarkRunner.h"
+
+using namespace benchmarks;
+
+namespace {
+
+/// Ports of servers started by benchmarks, they differ from ports used by tests.
+const int framingPort = 8910;
+const int mailboxPort = 8911;
+const int echoPort = 8912;
+
+/// Number of robots connected to a mailbox in routing benchmarks.
+const int robotsCount = 10;
+
+/// Number of clients connected to a server in round trip benchmark.
+const int clientsCount = 100;
+
+/// Connection that counts received messages, both on server and client side.
+class CountingConnection : public trikNetwork::Connection
+{
+public:
+	CountingConnection()
+		: Connection(trikNetwork::Protocol::messageLength, trikNetwork::Heartbeat::dontUse)
+	{
+	}
+
+	/// Connects to a server on local host.
+	void connectTo(int port)
+	{
+		init(QHostAddress::LocalHost, port);
+	}
+
+	/// Returns number of received messages.
+	int messages() const
+	{
+		return mMessages.load();
+	}
+
+	/// Returns number of received messages that carry mailbox data.
+	int dataMessages() const
+	{
+		return mDataMessages.load();
+	}
+
+private:
+	void processData(const QByteArray &data) override
+	{
+		if (data.startsWith("data:")) {
+			mDataMessages.ref();
+		}
+
+		mMessages.ref();
+	}
+
+	QAtomicInt mMessages;
+	QAtomicInt mDataMessages;
+};
+
+/// Server connection which sends every message back.
+class EchoConnection : public trikNetwork::Connection
+{
+public:
+	EchoConnection()
+		: Connection(trikNetwork::Protocol::messageLength, trikNetwork::Heartbeat::dontUse)
+	{
+	}
+
+private:
+	void processData(const QByteArray &data) override
+	{
+		send(data);
+	}
+};
+
+/// Processes events of a current thread until condition holds, returns false if it did not hold in 10 seconds.
+bool waitFor(const std::function<bool()> &condition)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!condition()) {
+		if (timer.elapsed() > 10000) {
+			return false;
+		}
+
+		QCoreApplication::processEvents();
+		QThread::usleep(20);
+	}
+
+	return true;
+}
+
+/// Returns body of a benchmark that sends messages of given size through loopback connection to a server. Server
+/// connection works in I/O thread of a server and splits incoming stream into messages.
+BenchmarkRunner::Body framing(int size)
+{
+	return [size](int operations) -> qint64 {
+		CountingConnection *sink = nullptr;
+		trikNetwork::TrikServer server([&sink]() { return sink = new CountingConnection(); }, 1);
+		server.startServer(framingPort);
+
+		CountingConnection client;
+		client.connectTo(framingPort);
+		if (!waitFor([&client, &sink]() { return client.isConnected() && sink; })) {
+			return -1;
+		}
+
+		const QByteArray payload(size, 'x');
+		QElapsedTimer timer;
+		timer.start();
+		for (int i = 0; i < operations; ++i) {
+			client.send(payload);
+		}
+
+		const bool received = waitFor([&sink, operations]() { return sink->messages() >= operations; });
+		const qint64 time = timer.nsecsElapsed();
+		return received ? time : -1;
+	};
+}
+
+/// Waits until every client gets given number of messages.
+bool waitForMessages(const QList<QSharedPointer<CountingConnection>> &clients, int expected)
+{
+	return waitFor([&clients, expected]() {
+		for (const auto &client : clients) {
+			if (client->messages() < expected) {
+				return false;
+			}
+		}
+
+		return true;
+	});
+}
+
+/// Connects clients to a server, every client sends a request and waits for a response. Server serves connections by
+/// a fixed pool of I/O threads.
+qint64 connectClients(int operations)
+{
+	trikNetwork::TrikServer server([]() { return new EchoConnection(); });
+	server.startServer(echoPort);
+
+	QList<QSharedPointer<CountingConnection>> clients;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < operations; ++i) {
+		clients << QSharedPointer<CountingConnection>(new CountingConnection());
+		clients.last()->connectTo(echoPort);
+		clients.last()->send("ping");
+	}
+
+	const bool answered = waitForMessages(clients, 1);
+	const qint64 time = timer.nsecsElapsed();
+	return answered ? time : -1;
+}
+
+/// Connected clients send requests in rounds, every client waits for a response before the next round.
+qint64 doRoundTrips(int operations)
+{
+	trikNetwork::TrikServer server([]() { return new EchoConnection(); });
+	server.startServer(echoPort);
+
+	// The first round connects clients and is not timed.
+	QList<QSharedPointer<CountingConnection>> clients;
+	for (int i = 0; i < clientsCount; ++i) {
+		clients << QSharedPointer<CountingConnection>(new CountingConnection());
+		clients.last()->connectTo(echoPort);
+		clients.last()->send("ping");
+	}
+
+	if (!waitForMessages(clients, 1)) {
+		return -1;
+	}
+
+	const int rounds = operations / clientsCount;
+	QElapsedTimer timer;
+	timer.start();
+	for (int round = 0; round < rounds; ++round) {
+		for (const auto &client : clients) {
+			client->send("ping");
+		}
+
+		if (!waitForMessages(clients, round + 2)) {
+			return -1;
+		}
+	}
+
+	return timer.nsecsElapsed();
+}
+
+/// Mailbox with robots simulated by loopback connections. Robot with index i has hull number i + 1.
+class Robots
+{
+public:
+	Robots()
+		: mMailbox(trikNetwork::MailboxFactory::create(mailboxPort))
+	{
+		// Server of a mailbox is started in its own thread.
+		QElapsedTimer timer;
+		timer.start();
+		waitFor([&timer]() { return timer.elapsed() >= 100; });
+
+		for (int i = 0; i < robotsCount; ++i) {
+			mRobots << QSharedPointer<CountingConnection>(new CountingConnection());
+			mRobots.last()->connectTo(mailboxPort);
+			mRobots.last()->send(QString("register:%1:%2").arg(20000 + i).arg(i + 1).toUtf8());
+		}
+
+		// Every robot gets information about robots registered before it and "self" reply.
+		mIsRegistered = waitFor([this]() {
+			for (int i = 0; i < mRobots.size(); ++i) {
+				if (mRobots[i]->messages() < i + 1) {
+					return false;
+				}
+			}
+
+			return true;
+		});
+	}
+
+	bool isRegistered() const
+	{
+		return mIsRegistered;
+	}
+
+	trikNetwork::MailboxInterface &mailbox()
+	{
+		return *mMailbox;
+	}
+
+	CountingConnection &robot(int hullNumber)
+	{
+		return *mRobots[hullNumber - 1];
+	}
+
+private:
+	QScopedPointer<trikNetwork::MailboxInterface> mMailbox;
+	QList<QSharedPointer<CountingConnection>> mRobots;
+	bool mIsRegistered = false;
+};
+
+/// Robots send messages to a mailbox, which attributes them to senders by connections.
+qint64 routeIncoming(int operations)
+{
+	// Counter outlives a mailbox, which may emit signals from its threads.
+	QAtomicInt received;
+	Robots robots;
+	if (!robots.isRegistered()) {
+		return -1;
+	}
+
+	QObject::connect(&robots.mailbox(), &trikNetwork::MailboxInterface::newMessage, [&received]() {
+		received.ref();
+	});
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < operations; ++i) {
+		const int hullNumber = i % robotsCount + 1;
+		robots.robot(hullNumber).send(QString("data:%1").arg(i).toUtf8());
+	}
+
+	const bool delivered = waitFor([&received, operations]() { return received.load() >= operations; });
+	const qint64 time = timer.nsecsElapsed();
+	return delivered ? time : -1;
+}
+
+/// Mailbox sends messages to robots by hull numbers.
+qint64 routeOutgoing(int operations)
+{
+	Robots robots;
+	if (!robots.isRegistered()) {
+		return -1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < operations; ++i) {
+		robots.mailbox().send(i % robotsCount + 1, QString::number(i));
+	}
+
+	const bool delivered = waitFor([&robots, operations]() {
+		int total = 0;
+		for (int hullNumber = 1; hullNumber <= robotsCount; ++hullNumber) {
+			total += robots.robot(hullNumber).dataMessages();
+		}
+
+		return total >= operations;
+	});
+
+	const qint64 time = timer.nsecsElapsed();
+	return delivered ? time : -1;
+}
+
+/// Robots send messages to a mailbox, returns false if not all of them arrived to an inbox of a mailbox. Counter of
+/// arrived messages shall outlive a mailbox, which may emit signals from its threads.
+bool fillInbox(Robots &robots, QAtomicInt &arrived, int operations)
+{
+	if (!robots.isRegistered()) {
+		return false;
+	}
+
+	QObject::connect(&robots.mailbox(), &trikNetwork::MailboxInterface::newMessage, [&arrived]() { arrived.ref(); });
+	for (int i = 0; i < operations; ++i) {
+		robots.robot(i % robotsCount + 1).send(QString("data:%1").arg(i).toUtf8());
+	}
+
+	return waitFor([&arrived, operations]() { return arrived.load() >= operations; });
+}
+
+/// Messages are taken from a filled inbox one by one.
+qint64 receiveMessages(int operations)
+{
+	QAtomicInt arrived;
+	Robots robots;
+	if (!fillInbox(robots, arrived, operations)) {
+		return -1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < operations; ++i) {
+		robots.mailbox().receive(false);
+	}
+
+	const qint64 time = timer.nsecsElapsed();
+	return robots.mailbox().hasMessages() ? -1 : time;
+}
+
+/// Messages are taken from a filled inbox in batches.
+qint64 receiveBatches(int operations)
+{
+	QAtomicInt arrived;
+	Robots robots;
+	if (!fillInbox(robots, arrived, operations)) {
+		return -1;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	int received = 0;
+	while (received < operations) {
+		const int batch = robots.mailbox().receiveBatch(256).size();
+		if (batch == 0) {
+			return -1;
+		}
+
+		received += batch;
+	}
+
+	return timer.nsecsElapsed();
+}
+
+}
+
+void benchmarks::addNetworkBenchmarks(BenchmarkRunner &runner)
+{
+	runner.add("network.serverConnect", Kind::macro, clientsCount, connectClients);
+	runner.add("network.serverRoundTrip", Kind::macro, clientsCount * 20, doRoundTrips);
+	runner.add("network.connectionFramingSmall", Kind::macro, 50000, framing(64));
+	runner.add("network.connectionFramingLarge", Kind::macro, 200, framing(256 * 1024));
+	runner.add("network.mailboxRoutingIncoming", Kind::macro, 5000, routeIncoming);
+	runner.add("network.mailboxRoutingOutgoing", Kind::macro, 5000, routeOutgoing);
+	runner.add("network.mailboxReceive", Kind::macro, 5000, receiveMessages);
+	runner.add("network.mailboxReceiveBatch", Kind::macro, 5000, receiveBatches);
+}
@@ -0,0 +1,205 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "benchmarks.h"
+
+#include <functional>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QTimer>
+#include <QtCore/QVector>
+
+#include <trikControl/brickInterface.h>
+#include <trikScriptRunner/trikScriptRunner.h>
+
+#include "utils.h"
+
+#include "benchmarkRunner.h"
+
+using namespace benchmarks;
+
+namespace {
+
+/// Does an action which leads to completion of a script and waits for it. Returns time from the action till
+/// completion, or -1 if script failed or did not complete in a minute.
+qint64 waitForCompletion(trikScriptRunner::TrikScriptRunner &runner, const std::function<void()> &action)
+{
+	QEventLoop loop;
+	QString error;
+	bool completed = false;
+	QObject::connect(&runner, &trikScriptRunner::TrikScriptRunner::completed, &loop
+			, [&loop, &error, &completed](const QString &message, int) {
+				error = message;
+				completed = true;
+				loop.quit();
+			});
+
+	QTimer::singleShot(60000, &loop, SLOT(quit()));
+
+	QElapsedTimer timer;
+	timer.start();
+	action();
+	loop.exec();
+	const qint64 time = timer.nsecsElapsed();
+
+	return completed && error.isEmpty() ? time : -1;
+}
+
+/// Runs JavaScript and waits for its completion. Returns time from start till completion, or -1 if script failed or
+/// did not complete in a minute.
+qint64 runScript(trikControl::BrickInterface &brick, const QString &script)
+{
+	trikScriptRunner::TrikScriptRunner runner(brick, nullptr);
+	return waitForCompletion(runner, [&runner, &script]() { runner.run(script); });
+}
+
+/// Runs Python scripts one after another in one interpreter, every script gets a fresh module.
+qint64 startPythonScripts(trikControl::BrickInterface &brick, int operations)
+{
+	trikScriptRunner::TrikScriptRunner runner(brick, nullptr);
+	qint64 time = 0;
+	for (int i = 0; i < operations; ++i) {
+		const qint64 scriptTime = waitForCompletion(runner, [&runner]() { runner.run("x = 1", "benchmark.py"); });
+		if (scriptTime < 0) {
+			return -1;
+		}
+
+		time += scriptTime;
+	}
+
+	return time;
+}
+
+/// Stops Python scripts which are busy in Python code and do not call runtime.
+qint64 stopPythonScripts(trikControl::BrickInterface &brick, int operations)
+{
+	trikScriptRunner::TrikScriptRunner runner(brick, nullptr);
+	qint64 time = 0;
+	for (int i = 0; i < operations; ++i) {
+		runner.run("while True:\n    pass\n", "benchmark.py");
+
+		QEventLoop loop;
+		QTimer::singleShot(50, &loop, SLOT(quit()));
+		loop.exec();
+
+		const qint64 stopTime = waitForCompletion(runner, [&runner]() { runner.abort(); });
+		if (stopTime < 0) {
+			return -1;
+		}
+
+		time += stopTime;
+	}
+
+	return time;
+}
+
+/// Creates an engine for every script, so the time is mostly time of engine creation.
+qint64 createEngines(trikControl::BrickInterface &brick, int operations)
+{
+	qint64 time = 0;
+	for (int i = 0; i < operations; ++i) {
+		const qint64 scriptTime = runScript(brick, "var x = 1;");
+		if (scriptTime < 0) {
+			return -1;
+		}
+
+		time += scriptTime;
+	}
+
+	return time;
+}
+
+/// Every thread gets its own engine, cloned from the engine of main thread.
+qint64 spawnThreads(trikControl::BrickInterface &brick, int operations)
+{
+	return runScript(brick, QString(
+			"var count = %1;\n"
+			"var worker = function() {};\n"
+			"var main = function() {\n"
+			"	for (var i = 0; i < count; ++i) {\n"
+			"		Threading.startThread('worker' + i, worker);\n"
+			"	}\n"
+			"	for (var i = 0; i < count; ++i) {\n"
+			"		Threading.joinThread('worker' + i);\n"
+			"	}\n"
+			"};\n").arg(operations));
+}
+
+/// Main thread sends messages to a thread which waits for every message.
+qint64 passMessages(trikControl::BrickInterface &brick, int operations)
+{
+	return runScript(brick, QString(
+			"var count = %1;\n"
+			"var receiver = function() {\n"
+			"	for (var i = 0; i < count; ++i) {\n"
+			"		Threading.receiveMessage(true);\n"
+			"	}\n"
+			"};\n"
+			"var main = function() {\n"
+			"	Threading.startThread('receiver', receiver);\n"
+			"	for (var i = 0; i < count; ++i) {\n"
+			"		Threading.sendMessage('receiver', i);\n"
+			"	}\n"
+			"	Threading.joinThread('receiver');\n"
+			"};\n").arg(operations));
+}
+
+/// Repacks RGB888 image of camera size, the same way as "getPhoto" does.
+qint64 repackPhotos(int operations)
+{
+	const int width = 320;
+	const int height = 240;
+	QVector<uint8_t> image(width * height * 3);
+	for (int i = 0; i < image.size(); ++i) {
+		image[i] = static_cast<uint8_t>((i * 13 + i / (width * 3) * 5) & 0xff);
+	}
+
+	bool failed = false;
+	const qint64 time = BenchmarkRunner::measure([&]() {
+		for (int i = 0; i < operations; ++i) {
+			failed |= trikScriptRunner::Utils::repackPhoto(image, width, height).size() != width * height / 4;
+		}
+	});
+
+	return failed ? -1 : time;
+}
+
+}
+
+void benchmarks::addScriptRunnerBenchmarks(BenchmarkRunner &runner, trikControl::BrickInterface &brick)
+{
+	runner.add("script.getPhotoRepacking", Kind::micro, 500, repackPhotos);
+	runner.add("script.engineCreation", Kind::macro, 20, [&brick](int operations) {
+		return createEngines(brick, operations);
+	});
+
+	// Time of a script with threads includes creation of an engine of main thread, so there are enough operations
+	// to make it small compared to them.
+	runner.add("script.threadSpawn", Kind::macro, 50, [&brick](int operations) {
+		return spawnThreads(brick, operations);
+	});
+
+	runner.add("script.messagePassing", Kind::macro, 20000, [&brick](int operations) {
+		return passMessages(brick, operations);
+	});
+
+	runner.add("script.pythonStart", Kind::macro, 20, [&brick](int operations) {
+		return startPythonScripts(brick, operations);
+	});
+
+	runner.add("script.pythonStop", Kind::macro, 10, [&brick](int operations) {
+		return stopPythonScripts(brick, operations);
+	});
+}
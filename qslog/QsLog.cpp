@@ -25,14 +25,20 @@
 
 #include "QsLog.h"
 #include "QsLogDest.h"
-#include <QThreadPool>
-#include <QRunnable>
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QHash>
 #include <QMutex>
+#include <QRegExp>
+#include <QStringList>
+#include <QThread>
 #include <QVector>
+#include <QWaitCondition>
 #include <QDateTime>
 #include <QtGlobal>
 #include <cassert>
 #include <cstdlib>
+#include <cstring>
 #include <stdexcept>
 
 namespace QsLogging
@@ -46,8 +52,15 @@ static const char WarnString[]  = "WARN ";
 static const char ErrorString[] = "ERROR";
 static const char FatalString[] = "FATAL";
 
-// not using Qt::ISODate because we need the milliseconds too
-static const QString fmtDateTime("yyyy-MM-ddThh:mm:ss.zzz");
+// not using Qt::ISODate because we need the milliseconds too, not a QString because the writer thread may still
+// run when static objects are destroyed at exit
+static const char fmtDateTime[] = "yyyy-MM-ddThh:mm:ss.zzz";
+
+// Capacity of the message queue, shall be a power of 2. Messages logged when it is full are dropped.
+static const int queueCapacity = 4096;
+
+// Writer thread wakes up with this interval to write a batch of messages, or earlier for errors and flush().
+static const int writeIntervalMs = 20;
 
 static Logger* sInstance = 0;
 
@@ -75,15 +88,231 @@ static const char* LevelToText(Level theLevel)
 	}
 }
 
-class LogWriterRunnable : public QRunnable
+static QString formatMessage(Level level, qint64 time, const QString &message)
+{
+	return QString("%1 %2 %3")
+			.arg(LevelToText(level))
+			.arg(QDateTime::fromMSecsSinceEpoch(time).toString(QLatin1String(fmtDateTime)))
+			.arg(message);
+}
+
+struct LogEntry
+{
+	qint64 time;
+	Level level;
+	QString message;
+};
+
+// Bounded lock-free queue with many producers and one consumer (the writer thread). Each slot has a sequence number
+// that tells whether it is free for a producer with a given position or filled for a consumer, so producers only
+// compete for a position with one compare-and-swap and never wait for each other or for the consumer.
+class LogQueue
+{
+public:
+	LogQueue()
+	{
+		for (int i = 0; i < queueCapacity; ++i) {
+			mSlots[i].sequence.store(i);
+		}
+	}
+
+	// Returns false if the queue is full.
+	bool push(LogEntry &entry)
+	{
+		Slot *slot = nullptr;
+		unsigned position = static_cast<unsigned>(mEnqueuePosition.load());
+		forever {
+			slot = &mSlots[position & (queueCapacity - 1)];
+			const int difference = static_cast<int>(static_cast<unsigned>(slot->sequence.loadAcquire()) - position);
+			if (difference == 0) {
+				int current = 0;
+				if (mEnqueuePosition.testAndSetOrdered(static_cast<int>(position), static_cast<int>(position + 1)
+						, current)) {
+					break;
+				}
+
+				position = static_cast<unsigned>(current);
+			} else if (difference < 0) {
+				return false;
+			} else {
+				position = static_cast<unsigned>(mEnqueuePosition.load());
+			}
+		}
+
+		qSwap(slot->entry, entry);
+		slot->sequence.storeRelease(static_cast<int>(position + 1));
+		return true;
+	}
+
+	// Shall be called only by the consumer. Returns false if the queue is empty.
+	bool pop(LogEntry &entry)
+	{
+		Slot &slot = mSlots[mDequeuePosition & (queueCapacity - 1)];
+		const int difference = static_cast<int>(static_cast<unsigned>(slot.sequence.loadAcquire())
+				- (mDequeuePosition + 1));
+		if (difference < 0) {
+			return false;
+		}
+
+		qSwap(entry, slot.entry);
+		slot.entry.message.clear();
+		slot.sequence.storeRelease(static_cast<int>(mDequeuePosition + queueCapacity));
+		++mDequeuePosition;
+		return true;
+	}
+
+	// Number of messages pushed so far, modulo 2^32.
+	unsigned pushed() const
+	{
+		return static_cast<unsigned>(mEnqueuePosition.loadAcquire());
+	}
+
+	// Number of messages popped so far, modulo 2^32. Shall be called only by the consumer.
+	unsigned popped() const
+	{
+		return mDequeuePosition;
+	}
+
+private:
+	struct Slot
+	{
+		QAtomicInt sequence;
+		LogEntry entry;
+	};
+
+	Slot mSlots[queueCapacity];
+	QAtomicInt mEnqueuePosition;
+	unsigned mDequeuePosition = 0;
+};
+
+// Levels of categories. Every source file is resolved to a level once and cached in a lock-free table by the address
+// of its __FILE__ literal, resolved levels are tagged with a generation which is changed when categories change.
+class CategoryLevels
+{
+public:
+	CategoryLevels()
+	{
+		for (Slot &slot : mSlots) {
+			slot.level.store(-1);
+		}
+	}
+
+	bool isEmpty() const
+	{
+		return mEmpty.loadAcquire() != 0;
+	}
+
+	void set(const QString &category, Level level)
+	{
+		QMutexLocker locker(&mMutex);
+		mLevels[category] = level;
+		mEmpty.storeRelease(0);
+		mGeneration.ref();
+	}
+
+	void reset()
+	{
+		QMutexLocker locker(&mMutex);
+		mLevels.clear();
+		mEmpty.storeRelease(1);
+		mGeneration.ref();
+	}
+
+	// Returns the lowest level of all categories or OffLevel if there are none.
+	Level minimum() const
+	{
+		QMutexLocker locker(&mMutex);
+		Level result = OffLevel;
+		for (const Level level : mLevels) {
+			result = qMin(result, level);
+		}
+
+		return result;
+	}
+
+	// Returns level of a category of a file or -1 if it does not belong to any category.
+	int level(const char *file)
+	{
+		const int generation = mGeneration.loadAcquire() & generationMask;
+		const quintptr hash = (reinterpret_cast<quintptr>(file) >> 3) * 2654435761u;
+		for (int i = 0; i < maxProbes; ++i) {
+			Slot &slot = mSlots[(hash + i) & (slotsCount - 1)];
+			const char *key = slot.file.loadAcquire();
+			if (key == nullptr && slot.file.testAndSetOrdered(nullptr, file)) {
+				key = file;
+			} else if (key == nullptr) {
+				key = slot.file.loadAcquire();
+			}
+
+			if (key != file) {
+				continue;
+			}
+
+			const int tagged = slot.level.loadAcquire();
+			if (tagged >= 0 && (tagged >> 3) == generation) {
+				return (tagged & 7) - 1;
+			}
+
+			const int result = resolve(file);
+			slot.level.storeRelease((generation << 3) | (result + 1));
+			return result;
+		}
+
+		// Table is full, which is not expected with the number of source files we have.
+		return resolve(file);
+	}
+
+private:
+	static const int slotsCount = 1024;
+	static const int maxProbes = 16;
+	static const int generationMask = 0x0fffffff;
+
+	struct Slot
+	{
+		QAtomicPointer<const char> file;
+		QAtomicInt level;
+	};
+
+	int resolve(const char *file) const
+	{
+		QStringList parts = QString::fromUtf8(file, static_cast<int>(strlen(file)))
+				.split(QRegExp("[/\\\\]"), QString::SkipEmptyParts);
+		if (!parts.isEmpty()) {
+			parts.last() = parts.last().section('.', 0, 0);
+		}
+
+		QMutexLocker locker(&mMutex);
+		for (int i = parts.size() - 1; i >= 0; --i) {
+			const auto level = mLevels.constFind(parts[i]);
+			if (level != mLevels.constEnd()) {
+				return level.value();
+			}
+		}
+
+		return -1;
+	}
+
+	Slot mSlots[slotsCount];
+	QAtomicInt mGeneration;
+	QAtomicInt mEmpty{1};
+	QHash<QString, Level> mLevels;
+	mutable QMutex mMutex;
+};
+
+// Takes messages from the queue and writes them in batches, flushing destinations once per batch.
+class LogWriterThread : public QThread
 {
 public:
-	LogWriterRunnable(QString message, Level level);
-	virtual void run();
+	explicit LogWriterThread(LoggerImpl &impl)
+		: mImpl(impl)
+	{
+	}
+
+protected:
+	void run() override;
 
 private:
-	QString mMessage;
-	Level mLevel;
+	LoggerImpl &mImpl;
 };
 
 class LoggerImpl
@@ -91,32 +320,94 @@ class LoggerImpl
 public:
 	LoggerImpl();
 
-	QThreadPool threadPool;
+	void wakeWriter();
+
+	LogQueue queue;
+	CategoryLevels categories;
+	QAtomicInt level;
+	// min(level, lowest category level), messages below it are rejected right away.
+	QAtomicInt minimumLevel;
+	// Dropped messages not reported to destinations yet and dropped messages total.
+	QAtomicInt dropped;
+	QAtomicInt droppedTotal;
+
 	QMutex logMutex;
-	Level level;
 	DestinationList destList;
+
+	LogWriterThread writer;
+	QMutex wakeMutex;
+	QWaitCondition wakeCondition;
+	bool wakeRequested = false;
+	bool stopRequested = false;
+
+	// Number of messages written so far, modulo 2^32, to wait for them in Logger::flush().
+	QMutex writtenMutex;
+	QWaitCondition writtenCondition;
+	unsigned written = 0;
 };
 
-LogWriterRunnable::LogWriterRunnable(QString message, Level level)
-	: QRunnable()
-	, mMessage(message)
-	, mLevel(level)
+LoggerImpl::LoggerImpl()
+	: level(InfoLevel)
+	, minimumLevel(InfoLevel)
+	, writer(*this)
 {
+	// assume at least file + console
+	destList.reserve(2);
+	// Writing logs shall not take time from control loops.
+	writer.start(QThread::LowPriority);
 }
 
-void LogWriterRunnable::run()
+void LoggerImpl::wakeWriter()
 {
-	Logger::instance().write(mMessage, mLevel);
+	QMutexLocker locker(&wakeMutex);
+	wakeRequested = true;
+	wakeCondition.wakeOne();
 }
 
-
-LoggerImpl::LoggerImpl()
-	: level(InfoLevel)
+void LogWriterThread::run()
 {
-	// assume at least file + console
-	destList.reserve(2);
-	threadPool.setMaxThreadCount(1);
-	threadPool.setExpiryTimeout(-1);
+	LogEntry entry;
+	forever {
+		bool stop = false;
+		{
+			QMutexLocker locker(&mImpl.wakeMutex);
+			if (!mImpl.wakeRequested && !mImpl.stopRequested) {
+				mImpl.wakeCondition.wait(&mImpl.wakeMutex, writeIntervalMs);
+			}
+
+			mImpl.wakeRequested = false;
+			stop = mImpl.stopRequested;
+		}
+
+		bool hasMessages = false;
+		while (mImpl.queue.pop(entry)) {
+			Logger::instance().write(formatMessage(entry.level, entry.time, entry.message), entry.level);
+			hasMessages = true;
+		}
+
+		const int dropped = mImpl.dropped.fetchAndStoreOrdered(0);
+		if (dropped > 0) {
+			const QString message = QString("QsLog: %1 messages were dropped, log queue is full").arg(dropped);
+			Logger::instance().write(formatMessage(WarnLevel, QDateTime::currentMSecsSinceEpoch(), message)
+					, WarnLevel);
+			hasMessages = true;
+		}
+
+		if (hasMessages) {
+			Logger::instance().flushDestinations();
+		}
+
+		{
+			QMutexLocker locker(&mImpl.writtenMutex);
+			mImpl.written = mImpl.queue.popped();
+		}
+
+		mImpl.writtenCondition.wakeAll();
+
+		if (stop) {
+			return;
+		}
+	}
 }
 
 
@@ -166,7 +457,14 @@ Level Logger::levelFromLogMessage(const QString& logMessage, bool* conversionSuc
 
 Logger::~Logger()
 {
-	d->threadPool.waitForDone();
+	{
+		QMutexLocker locker(&d->wakeMutex);
+		d->stopRequested = true;
+		d->wakeCondition.wakeOne();
+	}
+
+	// Writer drains the queue before it stops.
+	d->writer.wait();
 	delete d;
 	d = 0;
 }
@@ -174,30 +472,80 @@ Logger::~Logger()
 void Logger::addDestination(DestinationPtr destination)
 {
 	assert(destination.data());
+	QMutexLocker lock(&d->logMutex);
 	d->destList.push_back(destination);
 }
 
+void Logger::removeDestination(DestinationPtr destination)
+{
+	flush();
+	QMutexLocker lock(&d->logMutex);
+	d->destList.removeAll(destination);
+}
+
 void Logger::setLoggingLevel(Level newLevel)
 {
-	d->level = newLevel;
+	d->level.store(newLevel);
+	d->minimumLevel.store(qMin(newLevel, d->categories.minimum()));
 }
 
 Level Logger::loggingLevel() const
 {
-	return d->level;
+	return static_cast<Level>(d->level.load());
 }
 
-/// creates the complete log message and passes it to the logger
-void Logger::Helper::writeToLog()
+void Logger::setCategoryLevel(const QString &category, Level level)
 {
-	const char* const levelName = LevelToText(level);
-	const QString completeMessage(QString("%1 %2 %3")
-								  .arg(levelName)
-								  .arg(QDateTime::currentDateTime().toString(fmtDateTime))
-								  .arg(buffer)
-								  );
+	d->categories.set(category, level);
+	d->minimumLevel.store(qMin(loggingLevel(), d->categories.minimum()));
+}
 
-	Logger::instance().enqueueWrite(completeMessage, level);
+void Logger::resetCategoryLevels()
+{
+	d->categories.reset();
+	d->minimumLevel.store(loggingLevel());
+}
+
+bool Logger::isEnabled(Level level, const char *file) const
+{
+	if (level < d->minimumLevel.load()) {
+		return false;
+	}
+
+	if (d->categories.isEmpty()) {
+		// Minimum level is the logging level then.
+		return true;
+	}
+
+	const int categoryLevel = d->categories.level(file);
+	return level >= (categoryLevel >= 0 ? categoryLevel : d->level.load());
+}
+
+void Logger::flush()
+{
+	if (QThread::currentThread() == &d->writer) {
+		// Called from a destination, messages before are written already.
+		return;
+	}
+
+	const unsigned target = d->queue.pushed();
+	d->wakeWriter();
+
+	QMutexLocker locker(&d->writtenMutex);
+	while (static_cast<int>(d->written - target) < 0 && d->writer.isRunning()) {
+		d->writtenCondition.wait(&d->writtenMutex, writeIntervalMs);
+	}
+}
+
+int Logger::droppedCount() const
+{
+	return d->droppedTotal.load();
+}
+
+/// passes the message to the logger, it is formatted by the writer thread
+void Logger::Helper::writeToLog()
+{
+	Logger::instance().enqueueWrite(buffer, level);
 }
 
 Logger::Helper::~Helper()
@@ -212,11 +560,22 @@ Logger::Helper::~Helper()
 	}
 }
 
-/// directs the message to the task queue or writes it directly
+/// puts the message to the queue for the writer thread, never blocks; the message is dropped if the queue is full
 void Logger::enqueueWrite(const QString& message, Level level)
 {
-	LogWriterRunnable *r = new LogWriterRunnable(message, level);
-	d->threadPool.start(r);
+	LogEntry entry{QDateTime::currentMSecsSinceEpoch(), level, message};
+	if (!d->queue.push(entry)) {
+		d->dropped.ref();
+		d->droppedTotal.ref();
+		return;
+	}
+
+	if (level == FatalLevel) {
+		// Application is likely to die soon, so fatal message shall get to disk.
+		flush();
+	} else if (level == ErrorLevel) {
+		d->wakeWriter();
+	}
 }
 
 /// Sends the message to all the destinations. The level for this message is passed in case
@@ -230,4 +589,14 @@ void Logger::write(const QString& message, Level level)
 	}
 }
 
+/// Completes a batch of messages written by write().
+void Logger::flushDestinations()
+{
+	QMutexLocker lock(&d->logMutex);
+	for (DestinationList::iterator it = d->destList.begin(),
+		endIt = d->destList.end();it != endIt;++it) {
+		(*it)->flush();
+	}
+}
+
 } // end namespace
@@ -48,11 +48,29 @@ public:
 
 	/// Adds a log message destination. Don't add null destinations.
 	void addDestination(DestinationPtr destination);
+	/// Removes a previously added destination, pending messages are written to it before.
+	void removeDestination(DestinationPtr destination);
 	/// Logging at a level < 'newLevel' will be ignored
 	void setLoggingLevel(Level newLevel);
 	/// The default level is INFO
 	Level loggingLevel() const;
 
+	/// Overrides logging level for a category. Category is a name of a directory or a source file without extension,
+	/// for example "trikNetwork" or "mailboxServer"; the most specific category in a path of a source file is used.
+	/// Can be changed at runtime from any thread.
+	void setCategoryLevel(const QString &category, Level level);
+	/// Removes all category levels, so only logging level is used.
+	void resetCategoryLevels();
+
+	/// Returns true if a message of a given level from a given source file shall be logged. Used by QLOG_* macros,
+	/// locks only when a source file is checked for the first time after categories are changed.
+	bool isEnabled(Level level, const char *file) const;
+
+	/// Blocks until all messages logged before are written and flushed by destinations.
+	void flush();
+	/// Returns number of messages dropped because the queue was full since the logger was created.
+	int droppedCount() const;
+
 	/// The helper forwards the streaming to QDebug and builds the final
 	/// log message.
 	class QSLOG_SHARED_OBJECT Helper
@@ -79,33 +97,35 @@ private:
 
 	void enqueueWrite(const QString& message, Level level);
 	void write(const QString& message, Level level);
+	void flushDestinations();
 
 	LoggerImpl* d;
 
-	friend class LogWriterRunnable;
+	friend class LogWriterThread;
 };
 
 } // end namespace
 
 /// WARNING: Here was some piece of code that enabled or disabled file and line info logging.
 /// It was removed, so the version from the repo differs from out one.
+/// Also messages are filtered by per-category levels, see Logger::setCategoryLevel().
 #define QLOG_TRACE() \
-	if (QsLogging::Logger::instance().loggingLevel() > QsLogging::TraceLevel) {} \
+	if (!QsLogging::Logger::instance().isEnabled(QsLogging::TraceLevel, __FILE__)) {} \
 	else  QsLogging::Logger::Helper(QsLogging::TraceLevel).stream() << __FILE__ << '@' << __LINE__
 #define QLOG_DEBUG() \
-	if (QsLogging::Logger::instance().loggingLevel() > QsLogging::DebugLevel) {} \
+	if (!QsLogging::Logger::instance().isEnabled(QsLogging::DebugLevel, __FILE__)) {} \
 	else QsLogging::Logger::Helper(QsLogging::DebugLevel).stream() << __FILE__ << '@' << __LINE__
 #define QLOG_INFO()  \
-	if (QsLogging::Logger::instance().loggingLevel() > QsLogging::InfoLevel) {} \
+	if (!QsLogging::Logger::instance().isEnabled(QsLogging::InfoLevel, __FILE__)) {} \
 	else QsLogging::Logger::Helper(QsLogging::InfoLevel).stream() << __FILE__ << '@' << __LINE__
 #define QLOG_WARN()  \
-	if (QsLogging::Logger::instance().loggingLevel() > QsLogging::WarnLevel) {} \
+	if (!QsLogging::Logger::instance().isEnabled(QsLogging::WarnLevel, __FILE__)) {} \
 	else QsLogging::Logger::Helper(QsLogging::WarnLevel).stream() << __FILE__ << '@' << __LINE__
 #define QLOG_ERROR() \
-	if (QsLogging::Logger::instance().loggingLevel() > QsLogging::ErrorLevel) {} \
+	if (!QsLogging::Logger::instance().isEnabled(QsLogging::ErrorLevel, __FILE__)) {} \
 	else QsLogging::Logger::Helper(QsLogging::ErrorLevel).stream() << __FILE__ << '@' << __LINE__
 #define QLOG_FATAL() \
-	if (QsLogging::Logger::instance().loggingLevel() > QsLogging::FatalLevel) {} \
+	if (!QsLogging::Logger::instance().isEnabled(QsLogging::FatalLevel, __FILE__)) {} \
 	else QsLogging::Logger::Helper(QsLogging::FatalLevel).stream() << __FILE__ << '@' << __LINE__
 
 #ifdef QS_LOG_DISABLE
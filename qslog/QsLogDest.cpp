@@ -36,6 +36,10 @@ Destination::~Destination()
 {
 }
 
+void Destination::flush()
+{
+}
+
 /// destination factory
 DestinationPtr DestinationFactory::MakeFileDestination(const QString& filePath,
 	LogRotationOption rotation, const MaxSizeBytes &sizeInBytesToRotateAfter,
@@ -51,6 +51,7 @@ public:
 	virtual ~Destination();
 	virtual void write(const QString& message, Level level) = 0;
 	virtual bool isValid() = 0; // returns whether the destination was created correctly
+	virtual void flush(); // called by the writer thread after a batch of messages is written
 };
 typedef QSharedPointer<Destination> DestinationPtr;
 
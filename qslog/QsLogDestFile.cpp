@@ -149,7 +149,12 @@ void QsLogging::FileDestination::write(const QString& message, Level level)
 		mOutputStream.setDevice(&mFile);
 	}
 
-	mOutputStream << message << endl;
+	// Stream is flushed once per batch of messages, see flush().
+	mOutputStream << message << '\n';
+}
+
+void QsLogging::FileDestination::flush()
+{
 	mOutputStream.flush();
 }
 
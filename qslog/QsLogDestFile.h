@@ -88,6 +88,7 @@ public:
 	FileDestination(const QString& filePath, RotationStrategyPtr rotationStrategy, Level level);
 	virtual void write(const QString& message, Level level);
 	virtual bool isValid();
+	virtual void flush();
 
 private:
 	QFile mFile;
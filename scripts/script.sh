@@ -37,7 +37,7 @@ $EXECUTOR bash -lc "{ [ -r /root/.bashrc ] && source /root/.bashrc || true ; } ;
 &&  make -k -j2 \
 && cd bin/x86-$CONFIG && ls "
 
-for t in trikKernelTests trikCameraPhotoTests trikCommunicatorTests trikScriptRunnerTests
+for t in trikKernelTests trikCameraPhotoTests trikCommunicatorTests trikScriptRunnerTests trikTelemetryTests
   do
     $EXECUTOR env DISPLAY=:0 LSAN_OPTIONS='suppressions=asan.supp fast_unwind_on_malloc=0' sh -c \
     "cd  $BUILDDIR/bin/x86-$CONFIG && \
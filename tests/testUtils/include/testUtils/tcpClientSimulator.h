@@ -35,11 +35,17 @@ public:
 	/// Returns latest received response from a server.
 	QString latestResponse() const;
 
+	/// Returns number of responses received from a server.
+	int responses() const;
+
 private:
 	void processData(const QByteArray &data) override;
 
 	/// Contains latest received response from a server.
 	QString mLatestResponse;
+
+	/// Number of responses received from a server.
+	int mResponses = 0;
 };
 
 }
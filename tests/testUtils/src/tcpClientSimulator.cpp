@@ -26,9 +26,15 @@ TcpClientSimulator::TcpClientSimulator(const QString &ip, int port)
 void TcpClientSimulator::processData(const QByteArray &data)
 {
 	mLatestResponse = QString::fromUtf8(data);
+	++mResponses;
 }
 
 QString TcpClientSimulator::latestResponse() const
 {
 	return mLatestResponse;
 }
+
+int TcpClientSimulator::responses() const
+{
+	return mResponses;
+}
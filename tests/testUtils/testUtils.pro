@@ -21,6 +21,7 @@ DEFINES += TESTUTILS_LIBRARY
 QT += network
 
 interfaceIncludes(trikNetwork)
+transitiveIncludes(trikKernel)
 links(trikNetwork)
 
 HEADERS += \
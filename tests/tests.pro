@@ -19,8 +19,10 @@ SUBDIRS = \
 	thirdparty \
 	trikCameraPhotoTests \
 	trikCommunicatorTests \
+	trikControlTests \
 	trikKernelTests \
 	trikScriptRunnerTests \
+	trikTelemetryTests \
 	testUtils \
 
 #	minimalCppApp
@@ -31,5 +33,7 @@ thirdparty.file = thirdparty/googletest.pro
 trikKernelTests.depends = thirdparty testUtils
 trikScriptRunnerTests.depends = thirdparty testUtils
 trikCommunicatorTests.depends = thirdparty testUtils
+trikControlTests.depends = thirdparty testUtils
 selftest.depends = thirdparty testUtils
 trikCameraPhotoTests.depends = thirdparty testUtils
+trikTelemetryTests.depends = thirdparty testUtils
@@ -0,0 +1,258 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <functional>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QtEndian>
+#include <QtNetwork/QUdpSocket>
+
+#include <trikKernel/configurer.h>
+#include <trikNetwork/mailboxFactory.h>
+#include <trikNetwork/mailboxInterface.h>
+#include <testUtils/tcpClientSimulator.h>
+#include <testUtils/wait.h>
+
+#include <gtest/gtest.h>
+
+#include "multicastTransport.h"
+
+using namespace trikNetwork;
+using namespace tests::utils;
+
+namespace {
+
+/// Port of a transport under test. Datagrams are sent to local host, so no multicast routing is needed.
+const int transportPort = 8895;
+
+/// Instance id and hull number of a simulated mailbox which sends datagrams to a transport under test.
+const quint32 senderInstance = 42;
+const qint32 senderHullNumber = 7;
+
+template<typename T>
+void appendLittleEndian(QByteArray &data, T value)
+{
+	uchar buffer[sizeof(T)];
+	qToLittleEndian(value, buffer);
+	data.append(reinterpret_cast<const char *>(buffer), sizeof(T));
+}
+
+/// Builds data datagram of a simulated mailbox, see MulticastTransport for format.
+QByteArray dataDatagram(quint32 sequence, const QList<QByteArray> &messages)
+{
+	QByteArray datagram("TM");
+	datagram.append(static_cast<char>(1));
+	datagram.append(static_cast<char>(0));
+	appendLittleEndian<quint32>(datagram, senderInstance);
+	appendLittleEndian<qint32>(datagram, senderHullNumber);
+	appendLittleEndian<quint32>(datagram, sequence);
+	for (const QByteArray &message : messages) {
+		appendLittleEndian<quint16>(datagram, static_cast<quint16>(message.size()));
+		datagram.append(message);
+	}
+
+	return datagram;
+}
+
+/// Processes events until condition holds, for 5 seconds at most. Returns final value of condition.
+bool waitFor(const std::function<bool()> &condition)
+{
+	QElapsedTimer timeout;
+	timeout.start();
+	while (!condition() && timeout.elapsed() < 5000) {
+		Wait::wait(1);
+	}
+
+	return condition();
+}
+
+/// Creates mailbox on port 8896 from a copy of test system config with given additional mailbox attributes.
+MailboxInterface *createMailbox(const QTemporaryDir &dir, const QString &attributes)
+{
+	QFile testSystemConfig("./test-system-config.xml");
+	testSystemConfig.open(QIODevice::ReadOnly);
+	QFile systemConfig(dir.path() + "/system-config.xml");
+	systemConfig.open(QIODevice::WriteOnly);
+	systemConfig.write(QString::fromUtf8(testSystemConfig.readAll())
+			.replace("<mailbox port=\"8889\" optional=\"true\" />"
+					, QString("<mailbox port=\"8896\" optional=\"true\" %1 />").arg(attributes)).toUtf8());
+	systemConfig.close();
+
+	const trikKernel::Configurer configurer(systemConfig.fileName(), "./test-model-config.xml");
+	MailboxInterface * const mailbox = MailboxFactory::create(configurer);
+
+	// Server is started in a thread of a mailbox.
+	Wait::wait(100);
+	return mailbox;
+}
+
+/// Connects a robot with hull number 2 to a mailbox created by createMailbox().
+bool connectRobot(TcpClientSimulator &robot)
+{
+	robot.send("register:20000:2");
+	const bool registered = waitFor([&robot]() { return robot.responses() > 0; });
+	Wait::wait(100);
+	return registered;
+}
+
+/// Transport receiving datagrams of a simulated mailbox.
+class MulticastTransportTest : public testing::Test
+{
+protected:
+	void start(bool reliable)
+	{
+		MulticastSettings settings;
+		settings.enabled = true;
+		settings.group = QHostAddress::LocalHost;
+		settings.port = transportPort;
+		settings.reliable = reliable;
+		mTransport.reset(new MulticastTransport(settings));
+		ASSERT_TRUE(mTransport->start());
+
+		QObject::connect(mTransport.data(), &MulticastTransport::newData
+				, [this](int hullNumber, const QByteArray &data) {
+					mReceived << QString("%1:%2").arg(hullNumber).arg(QString::fromUtf8(data));
+				});
+	}
+
+	void send(quint32 sequence, const QList<QByteArray> &messages)
+	{
+		mSocket.writeDatagram(dataDatagram(sequence, messages), QHostAddress::LocalHost, transportPort);
+	}
+
+	QScopedPointer<MulticastTransport> mTransport;
+	QUdpSocket mSocket;
+	QStringList mReceived;
+};
+
+}
+
+/// Messages batched into one datagram are delivered separately, datagrams are delivered in order of sequence numbers
+/// even if they arrive out of order.
+TEST_F(MulticastTransportTest, reassemblyTest)
+{
+	start(true);
+
+	// Receiver joins a stream in the middle.
+	send(5, {"a", "bb"});
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 2; }));
+
+	send(7, {QByteArray(1000, 'd')});
+	send(6, {"c"});
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 4; }));
+	EXPECT_EQ(QStringList({"7:a", "7:bb", "7:c", "7:" + QString(1000, 'd')}), mReceived);
+
+	// Duplicates, for example retransmissions requested by other receivers, are ignored.
+	send(6, {"c"});
+	send(8, {"e"});
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 5; }));
+	EXPECT_EQ("7:e", mReceived.last());
+	EXPECT_EQ(0, mTransport->lostDatagrams());
+}
+
+/// Truncated message of a datagram is not delivered, messages before it are.
+TEST_F(MulticastTransportTest, malformedDatagramTest)
+{
+	start(true);
+
+	QByteArray datagram = dataDatagram(0, {"a", "truncated"});
+	datagram.chop(3);
+	mSocket.writeDatagram(datagram, QHostAddress::LocalHost, transportPort);
+	send(1, {"b"});
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 2; }));
+	EXPECT_EQ(QStringList({"7:a", "7:b"}), mReceived);
+}
+
+/// Datagrams after a gap wait for it to be filled, and are delivered when gap is given up.
+TEST_F(MulticastTransportTest, gapTimerTest)
+{
+	start(true);
+
+	send(0, {"a"});
+	send(2, {"c"});
+	QElapsedTimer timer;
+	timer.start();
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 1; }));
+
+	// Gap is given up in 500 ms, there is no upper bound since timers may be late on a loaded machine.
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 2; }));
+	EXPECT_GE(timer.elapsed(), 400);
+	EXPECT_EQ(QStringList({"7:a", "7:c"}), mReceived);
+	EXPECT_EQ(1, mTransport->lostDatagrams());
+
+	// Datagram of a skipped gap is too late.
+	send(1, {"b"});
+	send(3, {"d"});
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 3; }));
+	EXPECT_EQ("7:d", mReceived.last());
+}
+
+/// Without reliability datagrams after a gap are delivered at once and the gap is counted as lost.
+TEST_F(MulticastTransportTest, unreliableTest)
+{
+	start(false);
+
+	send(0, {"a"});
+	send(3, {"d"});
+	ASSERT_TRUE(waitFor([this]() { return mReceived.size() == 2; }));
+	EXPECT_EQ(QStringList({"7:a", "7:d"}), mReceived);
+	EXPECT_EQ(2, mTransport->lostDatagrams());
+}
+
+/// Broadcasts too big for a datagram are sent through TCP connections, smaller ones are not.
+TEST(MulticastMailboxTest, bigMessageFallbackTest)
+{
+	QTemporaryDir dir;
+	ASSERT_TRUE(dir.isValid());
+	QScopedPointer<MailboxInterface> mailbox(createMailbox(dir
+			, "transport=\"multicast\" multicastGroup=\"127.0.0.1\" multicastPort=\"8897\""));
+
+	TcpClientSimulator robot("127.0.0.1", 8896);
+	ASSERT_TRUE(connectRobot(robot));
+
+	const int responses = robot.responses();
+	const QString message(MulticastTransport::maxMessageSize + 1, 'x');
+	mailbox->send(message);
+	ASSERT_TRUE(waitFor([&robot, responses]() { return robot.responses() > responses; }));
+	EXPECT_EQ("data:" + message, robot.latestResponse());
+
+	mailbox->send("small");
+	Wait::wait(200);
+	EXPECT_EQ(responses + 1, robot.responses());
+}
+
+/// Mailbox sends broadcasts through TCP connections if multicast transport can not start.
+TEST(MulticastMailboxTest, transportFailureFallbackTest)
+{
+	// Port of multicast transport is taken by a socket which does not share it.
+	QUdpSocket occupant;
+	ASSERT_TRUE(occupant.bind(QHostAddress::AnyIPv4, 8897, QUdpSocket::DontShareAddress));
+
+	QTemporaryDir dir;
+	ASSERT_TRUE(dir.isValid());
+	QScopedPointer<MailboxInterface> mailbox(createMailbox(dir
+			, "transport=\"multicast\" multicastGroup=\"127.0.0.1\" multicastPort=\"8897\""));
+
+	TcpClientSimulator robot("127.0.0.1", 8896);
+	ASSERT_TRUE(connectRobot(robot));
+
+	const int responses = robot.responses();
+	mailbox->send("small");
+	ASSERT_TRUE(waitFor([&robot, responses]() { return robot.responses() > responses; }));
+	EXPECT_EQ("data:small", robot.latestResponse());
+}
@@ -0,0 +1,56 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <gtest/gtest.h>
+
+#include "peerRegistry.h"
+
+using namespace trikNetwork;
+
+/// Connections are attributed to robots that opened them until they are closed, then registry forgets them.
+TEST(PeerRegistryTest, linkUnlinkTest)
+{
+	PeerRegistry registry;
+	const PeerRegistry::Endpoint robot{QHostAddress("192.168.1.2"), 8889};
+	const PeerRegistry::Endpoint otherRobot{QHostAddress("192.168.1.2"), 8890};
+	const PeerRegistry::Endpoint connection{QHostAddress("192.168.1.2"), 40000};
+	const PeerRegistry::Endpoint reconnection{QHostAddress("192.168.1.2"), 40001};
+
+	ASSERT_TRUE(registry.insert(1, robot));
+	ASSERT_TRUE(registry.insert(2, otherRobot));
+	registry.link(otherRobot, connection);
+	EXPECT_EQ(2, registry.snapshot()->senderHullNumber(connection));
+
+	// Connection that is linked again to another robot is not a route to the previous one.
+	registry.link(robot, connection);
+	const auto linked = registry.snapshot();
+	EXPECT_EQ(1, linked->senderHullNumber(connection));
+	EXPECT_TRUE(linked->route(robot) == connection);
+	EXPECT_TRUE(linked->route(otherRobot).ip.isNull());
+
+	// Closing a connection which was replaced by a reconnection does not affect the new one.
+	registry.link(robot, reconnection);
+	registry.unlink(connection);
+	EXPECT_TRUE(registry.snapshot()->route(robot) == reconnection);
+
+	registry.unlink(reconnection);
+	const auto unlinked = registry.snapshot();
+	EXPECT_TRUE(unlinked->route(robot).ip.isNull());
+	EXPECT_EQ(1, unlinked->hullNumber(robot));
+	EXPECT_TRUE(linked->route(robot) == connection);
+
+	// Unlinking unknown connection does not publish a new snapshot.
+	registry.unlink(connection);
+	EXPECT_EQ(unlinked, registry.snapshot());
+}
@@ -14,7 +14,25 @@
 
 #include "trikCommunicatorTest.h"
 
+#include <functional>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QVariantMap>
+#include <QtNetwork/QTcpSocket>
+#include <QtCore/QVector>
+
 #include <trikControl/brickFactory.h>
+#include <trikKernel/paths.h>
+#include <trikNetwork/connection.h>
+#include <trikNetwork/mailboxFactory.h>
+#include <trikNetwork/mailboxInterface.h>
+#include <trikNetwork/trikServer.h>
 #include <testUtils/tcpClientSimulator.h>
 #include <testUtils/wait.h>
 
@@ -23,6 +41,87 @@ using namespace tests::utils;
 
 static const int port = 8888;
 
+namespace {
+
+/// Server side of a framing test, counts received messages and bytes.
+class SinkConnection : public trikNetwork::Connection
+{
+public:
+	SinkConnection(QAtomicInt &messages, QAtomicInt &bytes)
+		: Connection(trikNetwork::Protocol::messageLength, trikNetwork::Heartbeat::dontUse)
+		, mMessages(messages)
+		, mBytes(bytes)
+	{
+	}
+
+private:
+	void processData(const QByteArray &data) override
+	{
+		mBytes.fetchAndAddRelaxed(data.size());
+		mMessages.ref();
+	}
+
+	QAtomicInt &mMessages;
+	QAtomicInt &mBytes;
+};
+
+/// Calls receive() of a mailbox with waiting in a separate thread.
+class ReceivingThread : public QThread
+{
+public:
+	explicit ReceivingThread(trikNetwork::MailboxInterface &mailbox)
+		: mMailbox(mailbox)
+	{
+	}
+
+private:
+	void run() override
+	{
+		mMailbox.receive();
+	}
+
+	trikNetwork::MailboxInterface &mMailbox;
+};
+
+/// Processes events until condition holds, for 10 seconds at most. Returns final value of condition.
+bool waitFor(const std::function<bool()> &condition)
+{
+	QElapsedTimer timeout;
+	timeout.start();
+	while (!condition() && timeout.elapsed() < 10000) {
+		Wait::wait(1);
+	}
+
+	return condition();
+}
+
+/// Connects given number of robots simulated by loopback clients to a mailbox and waits until they are registered.
+/// Robot with index i has hull number i + 1 and pretends to have mailbox server on port 20000 + i.
+QList<QSharedPointer<TcpClientSimulator>> connectRobots(int count, int mailboxPort)
+{
+	QList<QSharedPointer<TcpClientSimulator>> robots;
+	for (int i = 0; i < count; ++i) {
+		robots << QSharedPointer<TcpClientSimulator>(new TcpClientSimulator("127.0.0.1", mailboxPort));
+		robots.last()->send(QString("register:%1:%2").arg(20000 + i).arg(i + 1).toUtf8());
+	}
+
+	// Every robot gets information about robots registered before it and "self" reply.
+	const bool registered = waitFor([&robots]() {
+		for (int i = 0; i < robots.size(); ++i) {
+			if (robots[i]->responses() < i + 1) {
+				return false;
+			}
+		}
+
+		return true;
+	});
+
+	Wait::wait(100);
+	return registered ? robots : QList<QSharedPointer<TcpClientSimulator>>();
+}
+
+}
+
 void TrikCommunicatorTest::SetUp()
 {
 	mBrick.reset(trikControl::BrickFactory::create("./test-system-config.xml"
@@ -36,6 +135,11 @@ void TrikCommunicatorTest::TearDown()
 {
 }
 
+trikCommunicator::TrikCommunicator &TrikCommunicatorTest::communicator()
+{
+	return *mCommunicator;
+}
+
 TEST_F(TrikCommunicatorTest, configVersionTest)
 {
 	TcpClientSimulator client("127.0.0.1", port);
@@ -43,3 +147,365 @@ TEST_F(TrikCommunicatorTest, configVersionTest)
 	Wait::wait(500);
 	ASSERT_EQ("configVersion: model-test", client.latestResponse());
 }
+
+/// 1, 10 and 100 loopback clients connect and do request-response rounds, server shall keep its fixed number of I/O
+/// threads.
+TEST_F(TrikCommunicatorTest, connectionScalingTest)
+{
+	const int rounds = 3;
+	for (const int clientsCount : {1, 10, 100}) {
+		QList<QSharedPointer<TcpClientSimulator>> clients;
+		const auto waitForResponses = [&clients](int expected) {
+			return waitFor([&clients, expected]() {
+				for (const auto &client : clients) {
+					if (client->responses() < expected) {
+						return false;
+					}
+				}
+
+				return true;
+			});
+		};
+
+		for (int i = 0; i < clientsCount; ++i) {
+			clients << QSharedPointer<TcpClientSimulator>(new TcpClientSimulator("127.0.0.1", port));
+			clients.last()->send("configVersion");
+		}
+
+		ASSERT_TRUE(waitForResponses(1));
+		for (int round = 0; round < rounds; ++round) {
+			for (const auto &client : clients) {
+				client->send("configVersion");
+			}
+
+			ASSERT_TRUE(waitForResponses(round + 2));
+		}
+
+		EXPECT_GE(communicator().activeConnections(), clientsCount);
+		EXPECT_LE(communicator().ioThreads(), qMax(QThread::idealThreadCount(), 1));
+
+		clients.clear();
+		Wait::wait(100);
+	}
+}
+
+/// Many small messages and a few large messages are delivered over loopback intact, see network.connectionFraming*
+/// benchmarks for throughput.
+TEST_F(TrikCommunicatorTest, framingTest)
+{
+	QAtomicInt messages;
+	QAtomicInt bytes;
+	trikNetwork::TrikServer server([&messages, &bytes]() { return new SinkConnection(messages, bytes); });
+	server.startServer(port + 1);
+
+	TcpClientSimulator client("127.0.0.1", port + 1);
+
+	struct Case { int count; int size; };
+	for (const Case &testCase : {Case{1000, 16}, Case{100, 1024}, Case{2, 4 * 1024 * 1024}}) {
+		const QByteArray payload(testCase.size, 'x');
+		messages = 0;
+		bytes = 0;
+
+		for (int i = 0; i < testCase.count; ++i) {
+			client.send(payload);
+		}
+
+		ASSERT_TRUE(waitFor([&messages, &testCase]() { return messages.load() >= testCase.count; }));
+		EXPECT_EQ(testCase.count, messages.load());
+		EXPECT_EQ(qint64(testCase.count) * testCase.size, qint64(bytes.load()));
+	}
+}
+
+/// Mailbox routing with 50 robots simulated by loopback clients. All of them have the same IP, so messages can be
+/// attributed to their senders and delivered to their recipients only if routing uses connections robots opened.
+/// See network.mailboxRouting* benchmarks for throughput.
+TEST_F(TrikCommunicatorTest, mailboxRoutingTest)
+{
+	const int peersCount = 50;
+	const int messagesPerPeer = 10;
+	const int mailboxPort = port + 2;
+
+	QScopedPointer<trikNetwork::MailboxInterface> mailbox(trikNetwork::MailboxFactory::create(mailboxPort));
+	Wait::wait(100);
+
+	QVector<int> received(peersCount + 1, 0);
+	int misattributed = 0;
+	QObject::connect(mailbox.data(), &trikNetwork::MailboxInterface::newMessage
+			, [&received, &misattributed](int sender, const QString &message) {
+				if (sender > 0 && sender < received.size() && message == QString::number(sender)) {
+					++received[sender];
+				} else {
+					++misattributed;
+				}
+			});
+
+	const auto peers = connectRobots(peersCount, mailboxPort);
+	ASSERT_EQ(peersCount, peers.size());
+
+	QVector<int> baseline;
+	for (const auto &peer : peers) {
+		baseline << peer->responses();
+	}
+
+	for (int message = 0; message < messagesPerPeer; ++message) {
+		for (int i = 0; i < peersCount; ++i) {
+			peers[i]->send(QString("data:%1").arg(i + 1).toUtf8());
+		}
+	}
+
+	ASSERT_TRUE(waitFor([&received, &misattributed]() {
+		int total = misattributed;
+		for (const int count : received) {
+			total += count;
+		}
+
+		return total >= peersCount * messagesPerPeer;
+	}));
+
+	EXPECT_EQ(0, misattributed);
+	for (int hullNumber = 1; hullNumber <= peersCount; ++hullNumber) {
+		EXPECT_EQ(messagesPerPeer, received[hullNumber]);
+	}
+
+	for (int message = 0; message < messagesPerPeer; ++message) {
+		for (int hullNumber = 1; hullNumber <= peersCount; ++hullNumber) {
+			mailbox->send(hullNumber, QString::number(hullNumber));
+		}
+	}
+
+	ASSERT_TRUE(waitFor([&peers, &baseline]() {
+		for (int i = 0; i < peers.size(); ++i) {
+			if (peers[i]->responses() < baseline[i] + messagesPerPeer) {
+				return false;
+			}
+		}
+
+		return true;
+	}));
+
+	Wait::wait(100);
+	for (int i = 0; i < peersCount; ++i) {
+		EXPECT_EQ(baseline[i] + messagesPerPeer, peers[i]->responses());
+		EXPECT_EQ(QString("data:%1").arg(i + 1), peers[i]->latestResponse());
+	}
+
+	peers.clear();
+	Wait::wait(100);
+}
+
+/// Consuming mailbox messages from 10 robots one by one, in batches and by sender. Messages shall keep their senders
+/// and order of arrival. See network.mailboxReceive* benchmarks for throughput.
+TEST_F(TrikCommunicatorTest, mailboxInboxTest)
+{
+	const int robotsCount = 10;
+	const int messagesPerRobot = 50;
+	const int total = robotsCount * messagesPerRobot;
+	const int mailboxPort = port + 3;
+
+	QScopedPointer<trikNetwork::MailboxInterface> mailbox(trikNetwork::MailboxFactory::create(mailboxPort));
+	Wait::wait(100);
+
+	const auto robots = connectRobots(robotsCount, mailboxPort);
+	ASSERT_EQ(robotsCount, robots.size());
+
+	int arrived = 0;
+	QObject::connect(mailbox.data(), &trikNetwork::MailboxInterface::newMessage, [&arrived]() { ++arrived; });
+
+	const auto sendAll = [&robots, messagesPerRobot]() {
+		for (int message = 0; message < messagesPerRobot; ++message) {
+			for (int i = 0; i < robots.size(); ++i) {
+				robots[i]->send(QString("data:%1").arg(message).toUtf8());
+			}
+		}
+	};
+
+	// One by one, with waiting.
+	sendAll();
+	QElapsedTimer timer;
+	timer.start();
+	int received = 0;
+	while (received < total && timer.elapsed() < 10000) {
+		Wait::wait(0);
+		while (mailbox->hasMessages()) {
+			mailbox->receive();
+			++received;
+		}
+	}
+
+	ASSERT_EQ(total, received);
+
+	// In batches.
+	sendAll();
+	timer.restart();
+	QVector<int> nextMessage(robotsCount + 1, 0);
+	received = 0;
+	while (received < total && timer.elapsed() < 10000) {
+		Wait::wait(0);
+		const QVariantList batch = mailbox->receiveBatch(256);
+		for (const QVariant &item : batch) {
+			const QVariantMap message = item.toMap();
+			const int sender = message["sender"].toInt();
+			ASSERT_TRUE(sender > 0 && sender <= robotsCount);
+			EXPECT_EQ(QString::number(nextMessage[sender]++), message["message"].toString());
+			EXPECT_GT(message["timestamp"].toLongLong(), 0);
+		}
+
+		received += batch.size();
+	}
+
+	ASSERT_EQ(total, received);
+
+	// By sender, the last robot first.
+	arrived = 0;
+	sendAll();
+	ASSERT_TRUE(waitFor([&arrived, total]() { return arrived == total; }));
+	for (int hullNumber = robotsCount; hullNumber > 0; --hullNumber) {
+		for (int message = 0; message < messagesPerRobot; ++message) {
+			ASSERT_EQ(QString::number(message), mailbox->receiveFrom(hullNumber, false));
+		}
+
+		EXPECT_EQ(QString(), mailbox->receiveFrom(hullNumber, false));
+	}
+
+	EXPECT_FALSE(mailbox->hasMessages());
+}
+
+/// Interrupt is remembered until queue is cleared, so receive() called after stopWaiting() does not block.
+TEST_F(TrikCommunicatorTest, mailboxStopWaitingTest)
+{
+	QScopedPointer<trikNetwork::MailboxInterface> mailbox(trikNetwork::MailboxFactory::create(port + 4));
+	Wait::wait(100);
+
+	mailbox->stopWaiting();
+	QElapsedTimer timer;
+	timer.start();
+	EXPECT_EQ(QString(), mailbox->receive());
+	EXPECT_EQ(QString(), mailbox->receiveFrom(1));
+	EXPECT_LT(timer.elapsed(), 1000);
+
+	// Waiting consumer is woken up.
+	mailbox->clearQueue();
+	ReceivingThread consumer(*mailbox);
+	consumer.start();
+	Wait::wait(100);
+	EXPECT_FALSE(consumer.isFinished());
+	mailbox->stopWaiting();
+	EXPECT_TRUE(consumer.wait(1000));
+	mailbox->clearQueue();
+}
+
+/// Chunked upload: interrupted upload is resumed by other connection from received offset, file is saved only when
+/// its hash matches.
+TEST_F(TrikCommunicatorTest, chunkedUploadTest)
+{
+	QByteArray contents(1024 * 1024 + 17, Qt::Uninitialized);
+	for (int i = 0; i < contents.size(); ++i) {
+		contents[i] = static_cast<char>(i * 31 % 251);
+	}
+
+	const QString hash = QString::fromLatin1(QCryptographicHash::hash(contents, QCryptographicHash::Sha256).toHex());
+	const QString path = trikKernel::Paths::userScriptsPath() + "upload/test.bin";
+	QFile::remove(path);
+	QFile::remove(path + ".part");
+
+	const int chunkSize = 64 * 1024;
+	const auto sendChunks = [&contents, chunkSize](TcpClientSimulator &client, const QString &id, int from, int to) {
+		for (int offset = from; offset < to; offset += chunkSize) {
+			client.send(QString("chunk:%1:%2:").arg(id).arg(offset).toUtf8()
+					+ contents.mid(offset, qMin(chunkSize, to - offset)));
+		}
+	};
+
+	const auto expectResponse = [](TcpClientSimulator &client, const QString &response) {
+		return waitFor([&client, &response]() { return client.latestResponse() == response; });
+	};
+
+	const int half = 8 * chunkSize;
+	{
+		TcpClientSimulator client("127.0.0.1", port);
+		client.send(QString("upload:1:%1:%2:upload/test.bin").arg(contents.size()).arg(hash).toUtf8());
+		ASSERT_TRUE(expectResponse(client, "upload:1:offset:0"));
+
+		sendChunks(client, "1", 0, half);
+		ASSERT_TRUE(expectResponse(client, QString("upload:1:progress:%1:%2").arg(half).arg(contents.size())));
+		client.send("uploadAbort:1");
+		Wait::wait(100);
+	}
+
+	EXPECT_FALSE(QFile::exists(path));
+
+	TcpClientSimulator client("127.0.0.1", port);
+	client.send(QString("upload:2:%1:%2:upload/test.bin").arg(contents.size()).arg(hash).toUtf8());
+	ASSERT_TRUE(expectResponse(client, QString("upload:2:offset:%1").arg(half)));
+
+	// Chunk at wrong offset is not written, client is told where to continue.
+	client.send(QByteArray("chunk:2:0:") + contents.left(chunkSize));
+	ASSERT_TRUE(expectResponse(client, QString("upload:2:offset:%1").arg(half)));
+
+	sendChunks(client, "2", half, contents.size());
+	ASSERT_TRUE(expectResponse(client, "upload:2:done"));
+
+	QFile file(path);
+	ASSERT_TRUE(file.open(QIODevice::ReadOnly));
+	EXPECT_TRUE(file.readAll() == contents);
+	file.close();
+	EXPECT_FALSE(QFile::exists(path + ".part"));
+
+	// Corrupted data is rejected and the file is left intact.
+	client.send(QString("upload:3:4:%1:upload/test.bin").arg(hash).toUtf8());
+	ASSERT_TRUE(expectResponse(client, "upload:3:offset:0"));
+	client.send("chunk:3:0:abcd");
+	ASSERT_TRUE(waitFor([&client]() { return client.latestResponse().startsWith("upload:3:error:hash mismatch"); }));
+	EXPECT_EQ(contents.size(), QFileInfo(path).size());
+
+	QFile::remove(path);
+}
+
+/// Variables server: several clients at once, persistent connection and stream of changes of a running script.
+TEST_F(TrikCommunicatorTest, variablesServerTest)
+{
+	TcpClientSimulator runner("127.0.0.1", port);
+	runner.send("directScript:var web = {counter: 0, name: 'robot'};"
+			" while (true) { web.counter++; script.wait(20); }");
+	Wait::wait(300);
+
+	QTcpSocket polling;
+	QTcpSocket streaming;
+	polling.connectToHost("127.0.0.1", 10000);
+	streaming.connectToHost("127.0.0.1", 10000);
+	ASSERT_TRUE(waitFor([&polling, &streaming]() {
+		return polling.state() == QAbstractSocket::ConnectedState
+				&& streaming.state() == QAbstractSocket::ConnectedState;
+	}));
+
+	QByteArray polled;
+	QByteArray streamed;
+	QObject::connect(&polling, &QTcpSocket::readyRead, [&polling, &polled]() { polled += polling.readAll(); });
+	QObject::connect(&streaming, &QTcpSocket::readyRead, [&streaming, &streamed]() {
+		streamed += streaming.readAll();
+	});
+
+	streaming.write("GET /web/stream?rate=20 HTTP/1.1\r\n\r\n");
+	polling.write("GET /web/ HTTP/1.1\r\nHost: localhost\r\n\r\n");
+	ASSERT_TRUE(waitFor([&polled]() { return polled.contains("\"robot\""); }));
+
+	// Connection is kept alive, so the next request goes through the same socket.
+	polling.write("GET /web/ HTTP/1.1\r\nHost: localhost\r\n\r\n");
+	ASSERT_TRUE(waitFor([&polled]() { return polled.count("HTTP/1.1 200 OK") == 2; }));
+	EXPECT_EQ(QAbstractSocket::ConnectedState, polling.state());
+
+	// The first event contains all variables, next ones only the changed counter.
+	ASSERT_TRUE(waitFor([&streamed]() { return streamed.count("data: ") >= 3; }));
+	const QList<QByteArray> events = streamed.split('\n');
+	int dataEvents = 0;
+	for (const QByteArray &event : events) {
+		if (event.startsWith("data: ")) {
+			EXPECT_TRUE(event.contains("counter"));
+			EXPECT_EQ(dataEvents == 0, event.contains("robot"));
+			++dataEvents;
+		}
+	}
+
+	runner.send("stop");
+	Wait::wait(100);
+}
@@ -29,6 +29,8 @@ protected:
 	void SetUp() override;
 	void TearDown() override;
 
+	trikCommunicator::TrikCommunicator &communicator();
+
 private:
 	/// Does nothing, but ensures event processing at the time of destruction of test suite, to avoid
 	/// deleteLater()-related memleaks.
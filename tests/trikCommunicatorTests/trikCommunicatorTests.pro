@@ -22,6 +22,13 @@ HEADERS += \
 SOURCES += \
 	$$PWD/trikCommunicatorTest.cpp \
 
+# Multicast transport and peer registry are internal classes of trikNetwork, they are not exported from the library
+# on Windows.
+linux {
+	SOURCES += $$PWD/multicastTransportTest.cpp $$PWD/peerRegistryTest.cpp
+	INCLUDEPATH += $$PWD/../../trikNetwork/src
+}
+
 implementationIncludes(trikKernel trikControl trikScriptRunner trikCommunicator tests/testUtils)
 transitiveIncludes(trikNetwork)
 links(trikKernel trikControl trikScriptRunner trikNetwork trikHal trikCommunicator testUtils)
@@ -0,0 +1,96 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+namespace {
+
+/// Reads sensors by handles in a loop until stopped, like telemetry does.
+class ReadingThread : public QThread
+{
+public:
+	ReadingThread(BrickInterface &brick, const QVector<int> &handles)
+		: mBrick(brick)
+		, mHandles(handles)
+	{
+	}
+
+	void stop()
+	{
+		mStopped.storeRelease(1);
+	}
+
+	int passes() const
+	{
+		return mPasses.loadAcquire();
+	}
+
+private:
+	void run() override
+	{
+		QVector<int> values(mHandles.size());
+		while (!mStopped.loadAcquire()) {
+			mBrick.readAll(mHandles, values.data());
+			mPasses.fetchAndAddOrdered(1);
+		}
+	}
+
+	BrickInterface &mBrick;
+	const QVector<int> mHandles;
+	QAtomicInt mStopped;
+	QAtomicInt mPasses;
+};
+
+}
+
+/// Port is reconfigured while other thread reads it by handle, handle refers to a new device afterwards.
+TEST(BrickHandlesTest, configureWhileReadingTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	const int a1 = brick->handle("A1");
+	const int e1 = brick->handle("E1");
+	ASSERT_NE(-1, a1);
+	ASSERT_NE(-1, e1);
+
+	ReadingThread reader(*brick, {a1, e1, a1});
+	reader.start();
+	while (reader.passes() == 0) {
+		QThread::yieldCurrentThread();
+	}
+
+	for (int i = 0; i < 20; ++i) {
+		const int passes = reader.passes();
+		brick->configure("A1", i % 2 == 0 ? "lightSensor" : "sharpGP2Sensor");
+		while (reader.passes() == passes) {
+			QThread::yieldCurrentThread();
+		}
+	}
+
+	reader.stop();
+	ASSERT_TRUE(reader.wait(5000));
+
+	EXPECT_EQ(a1, brick->handle("A1"));
+	EXPECT_NE(nullptr, brick->sensor("A1"));
+	EXPECT_EQ(brick->sensor("A1")->read(), brick->read(a1));
+}
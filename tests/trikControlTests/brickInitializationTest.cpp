@@ -0,0 +1,79 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QFile>
+#include <QtCore/QScopedPointer>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+/// Brick with stub hardware abstraction creates all devices of the test model, and reports time of each of them.
+/// See control.brickCreation benchmark for time of creation.
+TEST(BrickInitializationTest, parallelInitializationTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+
+	const QString report = brick->initializationReport();
+	EXPECT_TRUE(report.startsWith("Brick initialized in"));
+	EXPECT_TRUE(report.contains("initScripts: started at"));
+	EXPECT_TRUE(report.contains("port S1: started at"));
+	EXPECT_TRUE(report.contains("port M1: started at"));
+	EXPECT_TRUE(report.contains("keys: started at"));
+	EXPECT_FALSE(report.contains("failed"));
+
+	EXPECT_EQ(6, brick->motorPorts(MotorInterface::Type::servoMotor).size());
+	EXPECT_EQ(4, brick->motorPorts(MotorInterface::Type::powerMotor).size());
+	EXPECT_EQ(4, brick->encoderPorts().size());
+	EXPECT_NE(nullptr, brick->motor("M1"));
+	EXPECT_NE(nullptr, brick->keys());
+	EXPECT_NE(nullptr, brick->battery());
+}
+
+/// Devices of a class marked as lazy are listed in ports, but created only on first access.
+TEST(BrickInitializationTest, lazyInitializationTest)
+{
+	QFile systemConfig("./test-system-config.xml");
+	ASSERT_TRUE(systemConfig.open(QIODevice::ReadOnly));
+	QByteArray config = systemConfig.readAll();
+	ASSERT_TRUE(config.contains("<encoder invert=\"false\" />"));
+	config.replace("<encoder invert=\"false\" />", "<encoder invert=\"false\" lazy=\"true\" />");
+
+	QFile lazySystemConfig("./lazy-system-config.xml");
+	ASSERT_TRUE(lazySystemConfig.open(QIODevice::WriteOnly | QIODevice::Truncate));
+	lazySystemConfig.write(config);
+	lazySystemConfig.close();
+
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./lazy-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+
+	EXPECT_TRUE(brick->initializationReport().contains("port E1: lazy, not created yet"));
+	EXPECT_FALSE(brick->initializationReport().contains("port E1: started at"));
+	EXPECT_EQ(4, brick->encoderPorts().size());
+
+	EncoderInterface * const encoder = brick->encoder("E1");
+	ASSERT_NE(nullptr, encoder);
+	EXPECT_EQ(encoder, brick->encoder("E1"));
+	EXPECT_TRUE(brick->initializationReport().contains("port E1: created on first access"));
+	EXPECT_FALSE(brick->initializationReport().contains("port E1: lazy"));
+	EXPECT_TRUE(brick->initializationReport().contains("port E2: lazy, not created yet"));
+	EXPECT_EQ(4, brick->encoderPorts().size());
+
+	brick.reset();
+	QFile::remove("./lazy-system-config.xml");
+}
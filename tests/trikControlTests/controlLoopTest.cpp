@@ -0,0 +1,180 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <chrono>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+/// Controller is called at configured rate with setpoint set by caller, and is not called after removal.
+TEST(ControlLoopTest, fixedRateTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	ControlLoopInterface * const loop = brick->controlLoop();
+	ASSERT_NE(nullptr, loop);
+
+	loop->setRate(500);
+	QAtomicInt calls;
+	QAtomicInt lastSetpoint;
+	const auto started = std::chrono::steady_clock::now();
+	const int controller = loop->addController([&calls, &lastSetpoint](qreal setpoint, qreal dt) {
+		Q_UNUSED(dt)
+		calls.fetchAndAddOrdered(1);
+		lastSetpoint.store(static_cast<int>(setpoint));
+	});
+
+	loop->setSetpoint(controller, 42);
+	QThread::msleep(200);
+	loop->removeController(controller);
+	const auto elapsed = std::chrono::steady_clock::now() - started;
+	const int callsAfterRemoval = calls.load();
+	QThread::msleep(20);
+
+	EXPECT_EQ(callsAfterRemoval, calls.load());
+	EXPECT_EQ(42, lastSetpoint.load());
+
+	// Scheduling on a loaded machine may delay cycles arbitrarily, but loop never runs ahead of its schedule.
+	const QVariantMap statistics = loop->statistics();
+	const qint64 periods = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 2;
+	EXPECT_EQ(callsAfterRemoval, statistics["cycles"].toInt());
+	EXPECT_GT(callsAfterRemoval, 0);
+	EXPECT_LE(callsAfterRemoval, periods + 5);
+	EXPECT_LE(statistics["missed"].toInt(), callsAfterRemoval);
+}
+
+/// Controller which takes longer than a period misses deadlines, and loop does not try to catch up.
+TEST(ControlLoopTest, overrunTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	ControlLoopInterface * const loop = brick->controlLoop();
+
+	loop->setRate(1000);
+	QAtomicInt calls;
+	const auto started = std::chrono::steady_clock::now();
+	loop->addController([&calls](qreal, qreal) {
+		calls.fetchAndAddOrdered(1);
+		QThread::msleep(3);
+	});
+
+	QThread::msleep(100);
+	loop->clear();
+	const auto elapsed = std::chrono::steady_clock::now() - started;
+
+	// Every step takes at least 3 periods, so every cycle misses its deadline by at least 2 periods. Without
+	// catching up there is at most one cycle per step, however late the loop thread is scheduled.
+	const QVariantMap statistics = loop->statistics();
+	const int cycles = statistics["cycles"].toInt();
+	const qint64 steps = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count() / 3;
+	EXPECT_GT(cycles, 0);
+	EXPECT_EQ(cycles, statistics["missed"].toInt());
+	EXPECT_GE(statistics["maxOverrun"].toInt(), 1000);
+	EXPECT_LE(calls.load(), steps + 2);
+}
+
+/// Controller may remove other controllers and itself, removed controllers are not called even in the same cycle.
+TEST(ControlLoopTest, removeFromControllerTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	ControlLoopInterface * const loop = brick->controlLoop();
+
+	loop->setRate(500);
+	QAtomicInt removedCalls;
+	const int removed = loop->addController([&removedCalls](qreal, qreal) { removedCalls.fetchAndAddOrdered(1); });
+
+	QAtomicInt removerId(-1);
+	QAtomicInt removerCalls;
+	QAtomicInt removedCallsAtRemoval(-1);
+	const int remover = loop->addController([&, loop, removed](qreal, qreal) {
+		// Controller may be called before its id is returned by addController().
+		if (removerId.load() >= 0 && removerCalls.fetchAndAddOrdered(1) == 0) {
+			removedCallsAtRemoval.store(removedCalls.load());
+			loop->removeController(removed);
+			loop->removeController(removerId.load());
+		}
+	});
+
+	removerId.store(remover);
+	for (int i = 0; i < 500 && removerCalls.load() == 0; ++i) {
+		QThread::msleep(10);
+	}
+
+	QThread::msleep(20);
+
+	EXPECT_EQ(1, removerCalls.load());
+	EXPECT_EQ(removedCallsAtRemoval.load(), removedCalls.load());
+}
+
+/// Controller may clear the loop, then the loop stops after the current cycle and can be started again.
+TEST(ControlLoopTest, clearFromControllerTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	ControlLoopInterface * const loop = brick->controlLoop();
+
+	QAtomicInt clearingCalls;
+	loop->addController([&clearingCalls, loop](qreal, qreal) {
+		clearingCalls.fetchAndAddOrdered(1);
+		loop->clear();
+	});
+
+	for (int i = 0; i < 500 && clearingCalls.load() == 0; ++i) {
+		QThread::msleep(10);
+	}
+
+	QThread::msleep(20);
+	EXPECT_EQ(1, clearingCalls.load());
+
+	QAtomicInt calls;
+	loop->addController([&calls](qreal, qreal) { calls.fetchAndAddOrdered(1); });
+	for (int i = 0; i < 500 && calls.load() == 0; ++i) {
+		QThread::msleep(10);
+	}
+
+	EXPECT_GT(calls.load(), 0);
+	loop->clear();
+}
+
+/// Built-in PID controller drives motor towards setpoint.
+TEST(ControlLoopTest, pidTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	ControlLoopInterface * const loop = brick->controlLoop();
+
+	EXPECT_EQ(-1, loop->addPid("E1", "noSuchPort", 1, 0, 0));
+
+	const int controller = loop->addPid("E1", "M1", 0.5, 0, 0);
+	ASSERT_NE(-1, controller);
+	loop->setSetpoint(controller, 100);
+	QThread::msleep(50);
+	EXPECT_GT(brick->motor("M1")->power(), 0);
+
+	loop->setSetpoint(controller, -100);
+	QThread::msleep(50);
+	EXPECT_LT(brick->motor("M1")->power(), 0);
+
+	brick->stop();
+	EXPECT_EQ(0, brick->motor("M1")->power());
+}
@@ -0,0 +1,58 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+/// Sampler estimates speed of a simulated motor of stub HAL and keeps history of its encoder.
+TEST(EncoderSamplerTest, speedTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	EncoderInterface * const encoder = brick->encoder("E1");
+	ASSERT_NE(nullptr, encoder);
+	encoder->reset();
+
+	// The first query starts sampling.
+	EXPECT_EQ(0, encoder->readSpeed());
+
+	brick->motor("M1")->setPower(50);
+	QThread::msleep(500);
+
+	// Stub wheel turns at 600 ticks per second at half power, E1 has 157 ticks per 100 degrees.
+	const qreal speed = encoder->readSpeed();
+	EXPECT_NEAR(600.0 * 100 / 157, qAbs(speed), 40);
+	EXPECT_NEAR(0, encoder->readAcceleration(), 200);
+
+	const QVariantList history = encoder->history(10);
+	ASSERT_EQ(10, history.size());
+	for (int i = 1; i < history.size(); ++i) {
+		const QVariantMap previous = history[i - 1].toMap();
+		const QVariantMap sample = history[i].toMap();
+		EXPECT_LT(previous["time"].toLongLong(), sample["time"].toLongLong());
+		EXPECT_LE(previous["position"].toDouble() * speed, sample["position"].toDouble() * speed);
+	}
+
+	EXPECT_TRUE(encoder->history(0).isEmpty());
+
+	brick->stop();
+	EXPECT_EQ(0, brick->motor("M1")->power());
+}
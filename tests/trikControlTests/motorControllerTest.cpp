@@ -0,0 +1,115 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QThread>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+/// Waits until controller settles, returns time it took in milliseconds or -1 if it did not settle in time.
+static int waitForSettling(MotorControllerInterface &controller, int timeout)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!controller.isSettled()) {
+		if (timer.elapsed() > timeout) {
+			return -1;
+		}
+
+		QThread::msleep(5);
+	}
+
+	return static_cast<int>(timer.elapsed());
+}
+
+/// Controller moves simulated motor of stub HAL to a given position and holds it there.
+TEST(MotorControllerTest, moveToTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	EXPECT_EQ(nullptr, brick->motorController("M1", "noSuchPort"));
+
+	MotorControllerInterface * const controller = brick->motorController("M1", "E1");
+	ASSERT_NE(nullptr, controller);
+	EXPECT_EQ(controller, brick->motorController("M1", "E1"));
+	brick->encoder("E1")->reset();
+
+	controller->moveTo(360);
+	ASSERT_NE(-1, waitForSettling(*controller, 3000));
+	EXPECT_NEAR(360, controller->position(), 5);
+
+	QThread::msleep(100);
+	EXPECT_TRUE(controller->isSettled());
+	EXPECT_NEAR(360, brick->encoder("E1")->read(), 5);
+
+	controller->moveTo(0, 360);
+	ASSERT_NE(-1, waitForSettling(*controller, 3000));
+	EXPECT_NEAR(0, controller->position(), 5);
+
+	brick->stop();
+	EXPECT_EQ(0, brick->motor("M1")->power());
+}
+
+/// Controller keeps speed of simulated motor, and stops it on stop().
+TEST(MotorControllerTest, setSpeedTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	MotorControllerInterface * const controller = brick->motorController("M2", "E2");
+	ASSERT_NE(nullptr, controller);
+
+	controller->setSpeed(300);
+	ASSERT_NE(-1, waitForSettling(*controller, 3000));
+	EXPECT_NEAR(300, controller->speed(), 30);
+
+	const int start = brick->encoder("E2")->read();
+	QThread::msleep(500);
+	EXPECT_NEAR(150, brick->encoder("E2")->read() - start, 30);
+
+	controller->setSpeed(-300);
+	EXPECT_FALSE(controller->isSettled());
+	ASSERT_NE(-1, waitForSettling(*controller, 3000));
+	EXPECT_NEAR(-300, controller->speed(), 30);
+
+	controller->stop();
+	EXPECT_EQ(0, brick->motor("M2")->power());
+}
+
+/// Power set to a controlled motor by others is overridden by controller, even if power it computes does not change.
+TEST(MotorControllerTest, externalPowerChangeTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	MotorControllerInterface * const controller = brick->motorController("M2", "E2");
+	ASSERT_NE(nullptr, controller);
+
+	controller->setSpeed(300);
+	ASSERT_NE(-1, waitForSettling(*controller, 3000));
+	const int power = brick->motor("M2")->power();
+	ASSERT_NE(0, power);
+
+	brick->motor("M2")->setPower(0);
+	QThread::msleep(100);
+	EXPECT_NE(0, brick->motor("M2")->power());
+	EXPECT_NEAR(300, controller->speed(), 30);
+
+	controller->stop();
+	EXPECT_EQ(0, brick->motor("M2")->power());
+}
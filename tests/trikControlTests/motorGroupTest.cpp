@@ -0,0 +1,64 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QScopedPointer>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+/// Group sets powers of all its motors and reports when each command was sent.
+TEST(MotorGroupTest, setPowersTest)
+{
+	QScopedPointer<BrickInterface> brick(BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+			, "./media/"));
+	EXPECT_EQ(nullptr, brick->motorGroup({"M1", "noSuchPort"}));
+
+	const QStringList ports = {"M1", "M2", "M3", "M4"};
+	MotorGroupInterface * const group = brick->motorGroup(ports);
+	ASSERT_NE(nullptr, group);
+	EXPECT_EQ(group, brick->motorGroup(ports));
+	EXPECT_EQ(ports, group->ports());
+	EXPECT_EQ(DeviceInterface::Status::ready, group->status());
+
+	group->setPowers({50, -50, 30, 0});
+	EXPECT_EQ(50, brick->motor("M1")->power());
+	EXPECT_EQ(-50, brick->motor("M2")->power());
+	EXPECT_EQ(30, brick->motor("M3")->power());
+	EXPECT_EQ(0, brick->motor("M4")->power());
+
+	const QVariantList times = group->commandTimes();
+	ASSERT_EQ(4, times.size());
+	for (int i = 1; i < times.size(); ++i) {
+		EXPECT_LE(times[i - 1].toLongLong(), times[i].toLongLong());
+	}
+
+	// Wrong number of powers is ignored.
+	group->setPowers({10});
+	EXPECT_EQ(50, brick->motor("M1")->power());
+
+	group->stopAll();
+	for (const QString &port : ports) {
+		EXPECT_EQ(0, brick->motor(port)->power());
+	}
+
+	group->setPowers({10, 20, 30, 40});
+	brick->stop();
+	for (const QString &port : ports) {
+		EXPECT_EQ(0, brick->motor(port)->power());
+	}
+}
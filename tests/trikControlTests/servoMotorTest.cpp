@@ -0,0 +1,92 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QTemporaryDir>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+#include <trikHal/hardwareAbstractionFactory.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+#ifdef Q_OS_LINUX
+
+static QByteArray readFile(const QString &fileName)
+{
+	QFile file(fileName);
+	file.open(QIODevice::ReadOnly);
+	return file.readAll();
+}
+
+/// Servo writes and PWM capture reads through fake sysfs, on tmpfs if there is one. See hal.fakeSysfs* benchmarks
+/// for their rate.
+TEST(ServoMotorTest, fakeSysfsTest)
+{
+	QTemporaryDir sysfs(QDir("/dev/shm").exists() ? "/dev/shm/trikSysfs-XXXXXX" : QString());
+	ASSERT_TRUE(sysfs.isValid());
+
+	// Sysfs files exist before anybody opens them.
+	const QString systemConfig = QString::fromUtf8(readFile("./test-system-config.xml"));
+	QRegularExpressionMatchIterator files = QRegularExpression("\"(/sys/[^\"]+)\"").globalMatch(systemConfig);
+	while (files.hasNext()) {
+		const QString fileName = sysfs.path() + files.next().captured(1);
+		QDir().mkpath(QFileInfo(fileName).path());
+		QFile(fileName).open(QIODevice::WriteOnly);
+	}
+
+	QFile frequencyFile(sysfs.path() + "/sys/class/pwm/ecap_cap.1/freq");
+	frequencyFile.open(QIODevice::WriteOnly);
+	frequencyFile.write("50:-3:1000\n");
+	frequencyFile.close();
+
+	// Capture on S2 instead of a servo.
+	QFile modelConfig(sysfs.path() + "/model-config.xml");
+	modelConfig.open(QIODevice::WriteOnly);
+	modelConfig.write(QString::fromUtf8(readFile("./test-model-config.xml"))
+			.replace(QRegularExpression("<S2>\\s*<angularServomotor />"), "<S2><pwmCapture />").toUtf8());
+	modelConfig.close();
+
+	const QSharedPointer<trikHal::HardwareAbstractionInterface> hardwareAbstraction
+			= trikHal::HardwareAbstractionFactory::createWithFakeSysfs(sysfs.path());
+	QScopedPointer<BrickInterface> brick(BrickFactory::create(*hardwareAbstraction, "./test-system-config.xml"
+			, modelConfig.fileName(), "./media/"));
+
+	MotorInterface * const servo = brick->motor("S1");
+	ASSERT_NE(nullptr, servo);
+	const QString servoPath = sysfs.path() + "/sys/class/pwm/ecap.2/";
+	EXPECT_EQ("20000000", readFile(servoPath + "period_ns"));
+
+	servo->setPower(0);
+	EXPECT_EQ("1425000", readFile(servoPath + "duty_ns"));
+	EXPECT_EQ("1", readFile(servoPath + "run"));
+
+	// Shorter value replaces longer one completely.
+	servo->powerOff();
+	EXPECT_EQ("0", readFile(servoPath + "duty_ns"));
+	EXPECT_EQ("0", readFile(servoPath + "run"));
+
+	PwmCaptureInterface * const capture = brick->pwmCapture("S2");
+	ASSERT_NE(nullptr, capture);
+	EXPECT_EQ(QVector<int>({50, -3, 1000}), capture->frequency());
+	EXPECT_EQ(0, capture->duty());
+}
+
+#endif
@@ -0,0 +1,150 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QTemporaryDir>
+#include <QtCore/QThread>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+#include <trikControl/sharedStateClient.h>
+#include <trikControl/sharedStateLayout.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikControl;
+
+/// Key of a segment in test system config.
+static const QString testKey = "trikRuntimeTestState";
+
+/// Creates a brick with shared state enabled in a copy of test model config.
+static BrickInterface *createPublishingBrick(const QTemporaryDir &dir)
+{
+	QFile testModelConfig("./test-model-config.xml");
+	testModelConfig.open(QIODevice::ReadOnly);
+	QFile modelConfig(dir.path() + "/model-config.xml");
+	modelConfig.open(QIODevice::WriteOnly);
+	modelConfig.write(QString::fromUtf8(testModelConfig.readAll())
+			.replace("<mailbox />", "<mailbox />\n<sharedState />").toUtf8());
+	modelConfig.close();
+
+	return BrickFactory::create("./test-system-config.xml", modelConfig.fileName(), "./media/");
+}
+
+/// Waits until a condition holds, returns false if it did not hold in a second.
+template<typename Condition>
+static bool waitFor(const Condition &condition)
+{
+	QElapsedTimer timer;
+	timer.start();
+	while (!condition()) {
+		if (timer.elapsed() > 1000) {
+			return false;
+		}
+
+		QThread::msleep(5);
+	}
+
+	return true;
+}
+
+/// Client reads snapshots published by a brick and commands its motors.
+TEST(SharedStateTest, publishTest)
+{
+	QTemporaryDir dir;
+	ASSERT_TRUE(dir.isValid());
+
+	SharedStateClient client(testKey);
+	EXPECT_FALSE(client.attach());
+
+	QScopedPointer<BrickInterface> brick(createPublishingBrick(dir));
+	ASSERT_TRUE(client.attach());
+	EXPECT_TRUE(client.sensorPorts().contains("E1"));
+	EXPECT_TRUE(client.motorPorts().contains("M1"));
+
+	sharedState::Snapshot snapshot;
+	ASSERT_TRUE(waitFor([&]() { return client.read(snapshot) && snapshot.frame > 0; }));
+	const quint32 firstFrame = snapshot.frame;
+	ASSERT_TRUE(waitFor([&]() { return client.read(snapshot) && snapshot.frame > firstFrame; }));
+
+	EXPECT_FALSE(client.setPower("noSuchPort", 30));
+	ASSERT_TRUE(client.setPower("M1", 30));
+	EXPECT_TRUE(waitFor([&]() { return brick->motor("M1")->power() == 30; }));
+
+	const int motor = client.motorPorts().indexOf("M1");
+	EXPECT_TRUE(waitFor([&]() { return client.read(snapshot) && snapshot.motors[motor] == 30; }));
+
+	// Publisher keeps working after brick is stopped.
+	brick->stop();
+	EXPECT_EQ(0, brick->motor("M1")->power());
+	ASSERT_TRUE(client.setPower("M1", -20));
+	EXPECT_TRUE(waitFor([&]() { return brick->motor("M1")->power() == -20; }));
+
+	brick->stop();
+}
+
+/// Client which claimed a slot in command ring and did not write a command does not block commands of others.
+TEST(SharedStateTest, unfinishedCommandTest)
+{
+	QTemporaryDir dir;
+	ASSERT_TRUE(dir.isValid());
+	QScopedPointer<BrickInterface> brick(createPublishingBrick(dir));
+
+	// Crashed client, it claims a slot the same way as SharedStateClient does and never writes it.
+	QSharedMemory memory(testKey);
+	ASSERT_TRUE(memory.attach());
+	sharedState::Segment * const segment = static_cast<sharedState::Segment *>(memory.data());
+	segment->commandHead.fetchAndAddOrdered(1);
+
+	SharedStateClient client(testKey);
+	ASSERT_TRUE(client.attach());
+	ASSERT_TRUE(client.setPower("M1", 40));
+	EXPECT_TRUE(waitFor([&]() { return brick->motor("M1")->power() == 40; }));
+
+	// Late write of a skipped command fails, so it is not executed and can not overwrite a command reusing the slot.
+	sharedState::Command &skipped = segment->commands[0];
+	const int motor = client.motorPorts().indexOf("M1");
+	EXPECT_FALSE(skipped.word.testAndSetRelease(sharedState::freeSlot(0), sharedState::writtenSlot(0, motor, -40)));
+	ASSERT_TRUE(client.setPower("M1", 50));
+	EXPECT_TRUE(waitFor([&]() { return brick->motor("M1")->power() == 50; }));
+	QThread::msleep(50);
+	EXPECT_EQ(50, brick->motor("M1")->power());
+
+	memory.detach();
+	brick->stop();
+}
+
+/// Commands are executed after the ring wraps around many times, with negative powers and powers out of range.
+TEST(SharedStateTest, commandRingWrapTest)
+{
+	QTemporaryDir dir;
+	ASSERT_TRUE(dir.isValid());
+	QScopedPointer<BrickInterface> brick(createPublishingBrick(dir));
+
+	SharedStateClient client(testKey);
+	ASSERT_TRUE(client.attach());
+	for (int i = 0; i < sharedState::commandRingSize * 3; ++i) {
+		const int power = i % 2 == 0 ? -(i % 100) : i % 100;
+		ASSERT_TRUE(waitFor([&]() { return client.setPower("M1", power); }));
+		ASSERT_TRUE(waitFor([&]() { return brick->motor("M1")->power() == power; })) << "Command " << i;
+	}
+
+	ASSERT_TRUE(client.setPower("M1", 100000));
+	EXPECT_TRUE(waitFor([&]() { return brick->motor("M1")->power() == 100; }));
+
+	brick->stop();
+}
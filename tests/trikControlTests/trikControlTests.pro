@@ -0,0 +1,28 @@
+# Copyright 2018 CyberTech Labs Ltd.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#     http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+include(../common.pri)
+
+SOURCES += \
+	$$PWD/brickHandlesTest.cpp \
+	$$PWD/brickInitializationTest.cpp \
+	$$PWD/controlLoopTest.cpp \
+	$$PWD/encoderSamplerTest.cpp \
+	$$PWD/motorControllerTest.cpp \
+	$$PWD/motorGroupTest.cpp \
+	$$PWD/servoMotorTest.cpp \
+	$$PWD/sharedStateTest.cpp \
+
+implementationIncludes(trikKernel trikControl trikHal)
+links(trikKernel trikControl trikHal)
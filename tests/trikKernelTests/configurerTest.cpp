@@ -0,0 +1,126 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QFile>
+#include <QtCore/QTemporaryDir>
+
+#include <trikKernel/configurer.h>
+#include <trikKernel/exceptions/malformedConfigException.h>
+
+#include <gtest/gtest.h>
+
+using namespace trikKernel;
+
+namespace {
+
+/// Copy of test configs in a temporary directory, so tests can modify them and do not share cache with others.
+class ConfigurerTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		ASSERT_TRUE(mDir.isValid());
+		mSystemConfig = mDir.filePath("system-config.xml");
+		mModelConfig = mDir.filePath("model-config.xml");
+		ASSERT_TRUE(QFile::copy("./test-system-config.xml", mSystemConfig));
+		ASSERT_TRUE(QFile::copy("./test-model-config.xml", mModelConfig));
+	}
+
+	/// Returns all attributes of all ports, to compare configurations.
+	static QStringList dump(const Configurer &configurer)
+	{
+		const QStringList attributes = {"invert", "min", "max", "deviceFile", "i2cCommandNumber", "period"};
+		QStringList result;
+		for (const QString &port : configurer.ports()) {
+			const QString deviceClass = configurer.deviceClass(port);
+			result << port + ":" + deviceClass;
+			for (const QString &attribute : attributes) {
+				try {
+					result << attribute + "=" + configurer.attributeByPort(port, attribute);
+				} catch (const MalformedConfigException &) {
+					result << attribute + " is not set";
+				}
+			}
+		}
+
+		result.sort();
+		return result;
+	}
+
+	QTemporaryDir mDir;
+	QString mSystemConfig;
+	QString mModelConfig;
+};
+
+}
+
+/// Configuration loaded from cache is the same as parsed one, and overriding rules are respected.
+TEST_F(ConfigurerTest, cachedModelTest)
+{
+	QStringList parsed;
+	{
+		const Configurer configurer(mSystemConfig, mModelConfig);
+		parsed = dump(configurer);
+		EXPECT_EQ("model-test", configurer.version());
+		EXPECT_EQ("servoMotor", configurer.deviceClass("S1"));
+		EXPECT_EQ("700000", configurer.attributeByPort("S1", "min"));
+		EXPECT_EQ("/sys/class/pwm/ecap.2/duty_ns", configurer.attributeByPort("S1", "deviceFile"));
+		EXPECT_EQ("100", configurer.attributeByPort("S6", "controlMax"));
+		EXPECT_EQ("90", configurer.attributeByPort("S1", "controlMax"));
+		EXPECT_EQ("8889", configurer.attributeByDevice("mailbox", "port"));
+		EXPECT_FALSE(configurer.hasAttributeByDevice("mailbox", "noSuchAttribute"));
+		EXPECT_THROW(configurer.attributeByPort("S1", "noSuchAttribute"), MalformedConfigException);
+		EXPECT_THROW(configurer.attributeByPort("X1", "min"), MalformedConfigException);
+	}
+
+	ASSERT_TRUE(QFile::exists(mDir.filePath("model-config.cache")));
+
+	const Configurer cached(mSystemConfig, mModelConfig);
+	EXPECT_EQ(parsed, dump(cached));
+	EXPECT_EQ("model-test", cached.version());
+}
+
+/// Cache made from other contents of config files is not used.
+TEST_F(ConfigurerTest, staleCacheTest)
+{
+	{
+		const Configurer configurer(mSystemConfig, mModelConfig);
+		EXPECT_EQ("700000", configurer.attributeByPort("S1", "min"));
+	}
+
+	QFile systemConfig(mSystemConfig);
+	ASSERT_TRUE(systemConfig.open(QIODevice::ReadOnly));
+	QByteArray contents = systemConfig.readAll();
+	systemConfig.close();
+	ASSERT_TRUE(contents.contains("min=\"700000\""));
+	contents.replace("min=\"700000\"", "min=\"800000\"");
+	ASSERT_TRUE(systemConfig.open(QIODevice::WriteOnly | QIODevice::Truncate));
+	systemConfig.write(contents);
+	systemConfig.close();
+
+	const Configurer configurer(mSystemConfig, mModelConfig);
+	EXPECT_EQ("800000", configurer.attributeByPort("S1", "min"));
+}
+
+/// Configurers share a model, but changing configuration of one of them does not affect others.
+TEST_F(ConfigurerTest, configureTest)
+{
+	Configurer first(mSystemConfig, mModelConfig);
+	const Configurer second(mSystemConfig, mModelConfig);
+
+	first.configure("S1", "continuousRotationServomotor");
+	EXPECT_EQ("2300000", first.attributeByPort("S1", "max"));
+	EXPECT_EQ("2150000", second.attributeByPort("S1", "max"));
+	EXPECT_EQ("/sys/class/pwm/ecap.2/duty_ns", first.attributeByPort("S1", "deviceFile"));
+}
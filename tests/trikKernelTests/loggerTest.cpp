@@ -0,0 +1,177 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/QThread>
+
+#include <QsLog.h>
+#include <QsLogDest.h>
+#include <trikKernel/loggingHelper.h>
+
+#include <gtest/gtest.h>
+
+using namespace QsLogging;
+
+namespace {
+
+/// Destination that remembers messages and can pretend to be slow storage.
+class TestDestination : public Destination
+{
+public:
+	explicit TestDestination(int delayUs = 0)
+		: mDelayUs(delayUs)
+	{
+	}
+
+	void write(const QString &message, Level level) override
+	{
+		Q_UNUSED(level)
+		if (mDelayUs > 0) {
+			QThread::usleep(static_cast<unsigned long>(mDelayUs));
+		}
+
+		QMutexLocker locker(&mMutex);
+		mMessages << message;
+	}
+
+	bool isValid() override
+	{
+		return true;
+	}
+
+	void flush() override
+	{
+		mFlushes.ref();
+	}
+
+	QStringList messages() const
+	{
+		QMutexLocker locker(&mMutex);
+		return mMessages;
+	}
+
+	int flushes() const
+	{
+		return mFlushes.load();
+	}
+
+private:
+	const int mDelayUs;
+	QStringList mMessages;
+	QAtomicInt mFlushes;
+	mutable QMutex mMutex;
+};
+
+/// Adds a destination to the logger for the lifetime of a test and restores levels after it.
+class DestinationGuard
+{
+public:
+	explicit DestinationGuard(const QSharedPointer<TestDestination> &destination)
+		: mDestination(destination)
+		, mLevel(Logger::instance().loggingLevel())
+	{
+		Logger::instance().addDestination(mDestination);
+	}
+
+	~DestinationGuard()
+	{
+		Logger::instance().removeDestination(mDestination);
+		Logger::instance().resetCategoryLevels();
+		Logger::instance().setLoggingLevel(mLevel);
+	}
+
+private:
+	DestinationPtr mDestination;
+	Level mLevel;
+};
+
+int countContaining(const QStringList &messages, const QString &text)
+{
+	return messages.filter(text).size();
+}
+
+}
+
+TEST(LoggerTest, batchedWriteTest)
+{
+	QSharedPointer<TestDestination> destination(new TestDestination());
+	DestinationGuard guard(destination);
+
+	for (int i = 0; i < 100; ++i) {
+		QLOG_INFO() << "batchedWriteTest message" << i;
+	}
+
+	Logger::instance().flush();
+
+	const QStringList messages = destination->messages();
+	ASSERT_EQ(100, countContaining(messages, "batchedWriteTest message"));
+	EXPECT_TRUE(messages.filter("batchedWriteTest message").first().startsWith("INFO "));
+	EXPECT_TRUE(messages.filter("batchedWriteTest message").last().contains("message 99"));
+
+	// Messages logged in a burst are written in a few batches, not one by one.
+	EXPECT_GE(destination->flushes(), 1);
+	EXPECT_LT(destination->flushes(), 100);
+}
+
+TEST(LoggerTest, categoryLevelsTest)
+{
+	QSharedPointer<TestDestination> destination(new TestDestination());
+	DestinationGuard guard(destination);
+	Logger::instance().setLoggingLevel(TraceLevel);
+
+	// This file is tests/trikKernelTests/loggerTest.cpp, both directory and file name are categories.
+	ASSERT_TRUE(trikKernel::LoggingHelper::setCategoryLevels("trikKernelTests=warn"));
+	QLOG_INFO() << "categoryLevelsTest hidden by directory";
+	QLOG_WARN() << "categoryLevelsTest shown by directory";
+
+	// File name is more specific than a directory.
+	Logger::instance().setCategoryLevel("loggerTest", DebugLevel);
+	QLOG_DEBUG() << "categoryLevelsTest shown by file";
+	QLOG_TRACE() << "categoryLevelsTest hidden by file";
+
+	Logger::instance().resetCategoryLevels();
+	QLOG_TRACE() << "categoryLevelsTest shown after reset";
+
+	EXPECT_FALSE(trikKernel::LoggingHelper::setCategoryLevels("trikKernelTests=loud"));
+
+	Logger::instance().flush();
+	const QStringList messages = destination->messages();
+	EXPECT_EQ(0, countContaining(messages, "hidden"));
+	EXPECT_EQ(1, countContaining(messages, "categoryLevelsTest shown by directory"));
+	EXPECT_EQ(1, countContaining(messages, "categoryLevelsTest shown by file"));
+	EXPECT_EQ(1, countContaining(messages, "categoryLevelsTest shown after reset"));
+}
+
+TEST(LoggerTest, dropWhenFullTest)
+{
+	// 200 us per message, so the writer can not keep up and the queue overflows.
+	QSharedPointer<TestDestination> destination(new TestDestination(200));
+	DestinationGuard guard(destination);
+
+	const int count = 20000;
+	const int droppedBefore = Logger::instance().droppedCount();
+	for (int i = 0; i < count; ++i) {
+		QLOG_INFO() << "dropWhenFullTest message" << i;
+	}
+
+	Logger::instance().flush();
+
+	const int dropped = Logger::instance().droppedCount() - droppedBefore;
+	const QStringList messages = destination->messages();
+	EXPECT_GT(dropped, 0);
+	EXPECT_EQ(count, countContaining(messages, "dropWhenFullTest message") + dropped);
+	EXPECT_GE(countContaining(messages, "messages were dropped, log queue is full"), 1);
+}
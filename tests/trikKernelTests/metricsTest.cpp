@@ -0,0 +1,151 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <trikKernel/metrics.h>
+
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QThread>
+
+#include <gtest/gtest.h>
+
+using namespace trikKernel;
+
+TEST(MetricsTest, counterTest)
+{
+	Metrics::Counter &counter = Metrics::counter("test.counter");
+	EXPECT_EQ(&counter, &Metrics::counter("test.counter"));
+
+	Metrics::setEnabled(false);
+	Metrics::reset();
+	counter.add(5);
+	EXPECT_EQ(0, counter.value());
+
+	Metrics::setEnabled(true);
+	counter.add(5);
+	counter.add();
+	EXPECT_EQ(6, counter.value());
+	EXPECT_TRUE(Metrics::report().contains("test.counter 6"));
+
+	Metrics::reset();
+	EXPECT_EQ(0, counter.value());
+	Metrics::setEnabled(false);
+}
+
+TEST(MetricsTest, histogramTest)
+{
+	Metrics::Histogram &histogram = Metrics::histogram("test.histogram");
+	Metrics::setEnabled(true);
+	Metrics::reset();
+
+	for (int i = 1; i <= 100; ++i) {
+		histogram.record(i);
+	}
+
+	EXPECT_EQ(100, histogram.count());
+	EXPECT_EQ(5050, histogram.sum());
+	EXPECT_EQ(100, histogram.max());
+
+	// Percentiles are upper bounds of power of 2 buckets.
+	EXPECT_EQ(63, histogram.percentile(0.5));
+	EXPECT_EQ(100, histogram.percentile(0.99));
+	EXPECT_LE(histogram.percentile(0.1), 15);
+	Metrics::setEnabled(false);
+}
+
+/// Thread which updates a counter and a histogram.
+class UpdatingThread : public QThread
+{
+public:
+	UpdatingThread(Metrics::Counter &counter, Metrics::Histogram &histogram, int iterations)
+		: mCounter(counter)
+		, mHistogram(histogram)
+		, mIterations(iterations)
+	{
+	}
+
+private:
+	void run() override
+	{
+		for (int i = 0; i < mIterations; ++i) {
+			mCounter.add();
+			mHistogram.record(i);
+		}
+	}
+
+	Metrics::Counter &mCounter;
+	Metrics::Histogram &mHistogram;
+	const int mIterations;
+};
+
+/// Counters and histograms updated from several threads do not lose updates.
+TEST(MetricsTest, concurrencyTest)
+{
+	Metrics::Counter &counter = Metrics::counter("test.concurrentCounter");
+	Metrics::Histogram &histogram = Metrics::histogram("test.concurrentHistogram");
+	Metrics::setEnabled(true);
+	Metrics::reset();
+
+	const int threadCount = 4;
+	const int iterations = 100000;
+	QList<UpdatingThread *> threads;
+	for (int i = 0; i < threadCount; ++i) {
+		threads << new UpdatingThread(counter, histogram, iterations);
+		threads.last()->start();
+	}
+
+	for (UpdatingThread * const thread : threads) {
+		thread->wait();
+		delete thread;
+	}
+
+	EXPECT_EQ(threadCount * iterations, counter.value());
+	EXPECT_EQ(threadCount * iterations, histogram.count());
+	EXPECT_EQ(iterations - 1, histogram.max());
+	Metrics::setEnabled(false);
+}
+
+/// Timed sections get to a histogram and to a trace in Chrome trace event format.
+TEST(MetricsTest, traceTest)
+{
+	Metrics::Histogram &histogram = Metrics::histogram("test.timer");
+	Metrics::setEnabled(true);
+	Metrics::reset();
+
+	{
+		Metrics::ScopedTimer timer(histogram);
+		QThread::msleep(10);
+	}
+
+	EXPECT_EQ(1, histogram.count());
+	EXPECT_GE(histogram.max(), 10000);
+
+	const QJsonDocument trace = QJsonDocument::fromJson(Metrics::chromeTrace());
+	ASSERT_TRUE(trace.isObject());
+	const QJsonArray events = trace.object()["traceEvents"].toArray();
+	ASSERT_EQ(1, events.size());
+	const QJsonObject event = events.first().toObject();
+	EXPECT_EQ("test.timer", event["name"].toString());
+	EXPECT_EQ("X", event["ph"].toString());
+	EXPECT_GE(event["dur"].toDouble(), 10000);
+
+	// Timer created while metrics are disabled records nothing.
+	Metrics::setEnabled(false);
+	{
+		Metrics::ScopedTimer timer(histogram);
+	}
+
+	EXPECT_EQ(1, histogram.count());
+}
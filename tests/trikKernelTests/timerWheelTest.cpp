@@ -0,0 +1,158 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <trikKernel/timerWheel.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+#include <QtCore/QThread>
+#include <QtCore/QVector>
+
+#include <gtest/gtest.h>
+
+using namespace trikKernel;
+
+/// Timers do not fire earlier than they are due and periodic timer fires in order. Timers may be arbitrarily late on
+/// a loaded machine, so there are no upper bounds on firing times.
+TEST(TimerWheelTest, singleShotAndPeriodicTest)
+{
+	TimerWheel wheel;
+	QElapsedTimer clock;
+	QMutex lock;
+	QVector<qint64> singleShots;
+	QVector<qint64> periodic;
+
+	const auto record = [&clock, &lock](QVector<qint64> &times) {
+		QMutexLocker locker(&lock);
+		times << clock.nsecsElapsed() / 1000;
+	};
+
+	clock.start();
+	const auto singleShotId = wheel.start(20, [&record, &singleShots]() { record(singleShots); }, true);
+	const auto periodicId = wheel.start(10, [&record, &periodic]() { record(periodic); });
+	const auto cancelledId = wheel.start(30, []() { ADD_FAILURE() << "Stopped timer shall not fire"; }, true);
+	wheel.stop(cancelledId);
+
+	const auto fired = [&lock, &singleShots, &periodic]() {
+		QMutexLocker locker(&lock);
+		return !singleShots.isEmpty() && periodic.size() >= 5;
+	};
+
+	while (!fired() && clock.elapsed() < 5000) {
+		QThread::msleep(10);
+	}
+
+	QThread::msleep(50);
+	wheel.stop(periodicId);
+	wheel.stop(singleShotId);
+	const qint64 stopped = clock.nsecsElapsed() / 1000;
+	const qint64 tolerance = wheel.tickMicroseconds();
+
+	QMutexLocker locker(&lock);
+	ASSERT_EQ(1, singleShots.size());
+	EXPECT_GE(singleShots.first(), 20000 - tolerance);
+
+	// Periodic timer keeps its phase, so its n-th expiration is not earlier than n periods.
+	ASSERT_GE(periodic.size(), 5);
+	EXPECT_LE(periodic.size(), stopped / 10000 + 1);
+	for (int i = 0; i < periodic.size(); ++i) {
+		EXPECT_GE(periodic[i], (i + 1) * 10000 - tolerance);
+		if (i > 0) {
+			EXPECT_GE(periodic[i], periodic[i - 1]);
+		}
+	}
+
+	EXPECT_EQ(0, wheel.activeTimers());
+}
+
+TEST(TimerWheelTest, restartTest)
+{
+	TimerWheel wheel;
+	QAtomicInt fired;
+
+	const auto id = wheel.start(50, [&fired]() { fired.ref(); }, true);
+	for (int i = 0; i < 5; ++i) {
+		QThread::msleep(20);
+		ASSERT_TRUE(wheel.restart(id));
+	}
+
+	EXPECT_EQ(0, fired.load());
+	QThread::msleep(80);
+	EXPECT_EQ(1, fired.load());
+
+	// Expired single-shot timer is forgotten, stopping it does nothing.
+	EXPECT_FALSE(wheel.restart(id));
+	wheel.stop(id);
+	EXPECT_EQ(0, wheel.activeTimers());
+}
+
+/// Single-shot timer which callback stops or restarts it does not break the wheel, and other timers keep working.
+TEST(TimerWheelTest, expiredSingleShotTest)
+{
+	TimerWheel wheel;
+	QAtomicInt fired;
+	std::atomic<TimerWheel::TimerId> id(0);
+
+	id = wheel.start(10, [&]() {
+		EXPECT_FALSE(wheel.restart(id));
+		wheel.stop(id);
+		fired.ref();
+	}, true);
+
+	const auto other = wheel.start(30, [&fired]() { fired.ref(); }, true);
+	QThread::msleep(100);
+	EXPECT_EQ(2, fired.load());
+
+	wheel.stop(id);
+	wheel.stop(other);
+	EXPECT_EQ(0, wheel.activeTimers());
+}
+
+/// Many simultaneously active timers with different intervals all expire, none of them earlier than it is due.
+TEST(TimerWheelTest, manyTimersTest)
+{
+	const int timers = 1000;
+	TimerWheel wheel;
+	QElapsedTimer clock;
+	QVector<qint64> lateness(timers, 0);
+	QAtomicInt fired;
+
+	clock.start();
+	QVector<TimerWheel::TimerId> ids;
+	for (int i = 0; i < timers; ++i) {
+		const int interval = 10 + (i % 40) * 5;
+		const qint64 started = clock.nsecsElapsed();
+		ids << wheel.start(interval, [&, i, interval, started]() {
+			lateness[i] = (clock.nsecsElapsed() - started) / 1000 - interval * 1000;
+			fired.fetchAndAddOrdered(1);
+		}, true);
+	}
+
+	while (fired.loadAcquire() < timers && clock.elapsed() < 10000) {
+		QThread::msleep(10);
+	}
+
+	for (const auto id : ids) {
+		wheel.stop(id);
+	}
+
+	ASSERT_EQ(timers, fired.loadAcquire());
+
+	// Timer may fire at most one tick earlier due to rounding to ticks.
+	EXPECT_GE(*std::min_element(lateness.constBegin(), lateness.constEnd()), -wheel.tickMicroseconds());
+}
@@ -14,12 +14,18 @@
 
 include(../common.pri)
 
+QT += xml
+
 HEADERS += \
 	$$PWD/synchronizedVarTest.h \
 
 SOURCES += \
+	$$PWD/configurerTest.cpp \
 	$$PWD/synchronizedVarTest.cpp \
 	$$PWD/differentOwnedPointerTest.cpp \
+	$$PWD/loggerTest.cpp \
+	$$PWD/metricsTest.cpp \
+	$$PWD/timerWheelTest.cpp \
 
 implementationIncludes(trikKernel)
-links(trikKernel)
+links(trikKernel qslog)
@@ -16,9 +16,15 @@
 
 #include <QtCore/QEventLoop>
 #include <QtCore/QFile>
+#include <QtCore/QTimer>
+
+#include <functional>
 
 #include <trikControl/brickFactory.h>
 #include <trikKernel/fileUtils.h>
+#include <trikNetwork/mailboxFactory.h>
+#include <trikNetwork/mailboxInterface.h>
+#include <testUtils/tcpClientSimulator.h>
 #include <testUtils/wait.h>
 
 using namespace tests;
@@ -80,6 +86,22 @@ void TrikScriptRunnerTest::runFromFile(const QString &fileName)
 	run(fileContents);
 }
 
+QString TrikScriptRunnerTest::runPython(const QString &script)
+{
+	QString error;
+	QEventLoop waitingLoop;
+	const auto connection = QObject::connect(mScriptRunner.data(), &trikScriptRunner::TrikScriptRunner::completed
+			, [&error, &waitingLoop](const QString &message, int) {
+				error = message;
+				waitingLoop.quit();
+			});
+
+	mScriptRunner->run(script, "test.py");
+	waitingLoop.exec();
+	QObject::disconnect(connection);
+	return error;
+}
+
 trikScriptRunner::TrikScriptRunner &TrikScriptRunnerTest::scriptRunner()
 {
 	return *mScriptRunner;
@@ -162,3 +184,171 @@ TEST_F(TrikScriptRunnerTest, twoProgramsTest)
 	scriptRunner().run("script.wait(500);");
 	tests::utils::Wait::wait(600);
 }
+
+TEST_F(TrikScriptRunnerTest, tasksOrderTest)
+{
+	run("var log = [];"
+		"tasks.after(60, function() { log.push(3); assert(log.join() == '1,2,3'); script.quit(); });"
+		"tasks.after(20, function() { log.push(2); });"
+		"tasks.post(function() { log.push(1); });"
+		"var cancelled = tasks.after(10, function() { assert(false); });"
+		"tasks.cancel(cancelled);"
+		"assert(!tasks.isPending(cancelled));"
+		"script.run();");
+}
+
+TEST_F(TrikScriptRunnerTest, periodicTaskTest)
+{
+	run("var count = 0;"
+		"var id = tasks.every(10, function() {"
+		"	++count;"
+		"	if (count == 5) {"
+		"		tasks.cancel(id);"
+		"		tasks.after(50, function() { assert(count == 5); script.quit(); });"
+		"	}"
+		"});"
+		"script.run();");
+}
+
+/// Python script which does not respond is stopped, and restarted script does not see variables of a previous one,
+/// though they share one interpreter.
+TEST_F(TrikScriptRunnerTest, pythonStartStopRestartTest)
+{
+	const auto waitForCompletion = [this](const std::function<void()> &action) {
+		QEventLoop waitingLoop;
+		QString result = "not completed";
+		QObject::connect(&scriptRunner(), &trikScriptRunner::TrikScriptRunner::completed, &waitingLoop
+				, [&waitingLoop, &result](const QString &error) {
+					result = error;
+					waitingLoop.quit();
+				});
+
+		QTimer::singleShot(5000, &waitingLoop, SLOT(quit()));
+		action();
+		waitingLoop.exec();
+		return result;
+	};
+
+	EXPECT_EQ("", waitForCompletion([this]() { scriptRunner().run("x = 1", "test.py"); }));
+
+	scriptRunner().run("while True:\n    pass\n", "test.py");
+	tests::utils::Wait::wait(200);
+	EXPECT_EQ("", waitForCompletion([this]() { scriptRunner().abort(); }));
+
+	EXPECT_EQ("", waitForCompletion([this]() { scriptRunner().run("assert 'x' not in globals()", "test.py"); }));
+}
+
+TEST_F(TrikScriptRunnerTest, portHandlesTest)
+{
+	run("var a1 = brick.handle('A1');"
+			"var e1 = brick.handle('E1');"
+			"assert(a1 >= 0 && e1 >= 0 && a1 != e1);"
+			"assert(brick.handle('A1') == a1);"
+			"assert(brick.handle('NoSuchPort') == -1);"
+			"var values = brick.readAll([a1, e1, -1]);"
+			"assert(values.length == 3);"
+			"assert(values[2] == 0);"
+			"assert(brick.read(-1) == 0);"
+			);
+}
+
+TEST_F(TrikScriptRunnerTest, pythonVectorBufferTest)
+{
+	const QString error = runPython(
+			"v = brick.accelerometer().read()\n"
+			"m = memoryview(v)\n"
+			"assert m.format == 'i' and m.readonly and m.itemsize == 4\n"
+			"assert len(m) == len(v) and m.tolist() == v.tolist() == list(v)\n"
+			);
+
+	EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+}
+
+TEST_F(TrikScriptRunnerTest, pythonVectorAsListTest)
+{
+	const QString error = runPython(
+			"v = brick.accelerometer().read()\n"
+			"l = v.tolist()\n"
+			"assert v == l and l == v and not v != l and v != l + [1] and v < l + [1]\n"
+			"assert v[0:2] == l[0:2] and v[::-1] == l[::-1] and v[-1] == l[-1]\n"
+			"assert v + [1] == l + [1] and [1] + v == [1] + l and v + v == l + l and v * 2 == l * 2\n"
+			"v[0] = 5\n"
+			"v.append(7)\n"
+			"v[1:2] = [8, 9]\n"
+			"del v[2]\n"
+			"assert v == [5, 8] + l[2:] + [7] and len(v) == len(l) + 1 and memoryview(v).tolist() == v\n"
+			"m = memoryview(v)\n"
+			"try:\n"
+			"    v.append(1)\n"
+			"    assert False\n"
+			"except BufferError:\n"
+			"    pass\n"
+			"m.release()\n"
+			"v.append(1)\n"
+			"try:\n"
+			"    v[0] = 1 << 40\n"
+			"    assert False\n"
+			"except ValueError:\n"
+			"    pass\n"
+			);
+
+	EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+}
+
+TEST_F(TrikScriptRunnerTest, pythonThreadsTest)
+{
+	const QString error = runPython(
+			"counter = [0]\n"
+			"def poll():\n"
+			"    while True:\n"
+			"        brick.accelerometer().read()\n"
+			"        counter[0] += 1\n"
+			"        script.wait(1)\n"
+			"script.startThread('poller', poll)\n"
+			"script.wait(200)\n"
+			"assert script.isThreadRunning('poller') and counter[0] > 0\n"
+			"script.killThread('poller')\n"
+			"assert script.joinThread('poller', 1000)\n"
+			);
+
+	EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+}
+
+TEST_F(TrikScriptRunnerTest, pythonSysExitTest)
+{
+	const QString error = runPython("import sys\nsys.exit(1)\nraise RuntimeError('not stopped')\n");
+	EXPECT_TRUE(error.isEmpty()) << error.toStdString();
+}
+
+/// Script which is run over a script waiting for a message stops waiting of a previous one, but waits for messages
+/// itself.
+TEST(TrikScriptRunnerMailboxTest, receiveAfterRunOverTest)
+{
+	trikKernel::DeinitializationHelper helper;
+	Q_UNUSED(helper);
+
+	QScopedPointer<trikControl::BrickInterface> brick(trikControl::BrickFactory::create("./", "./"));
+	QScopedPointer<trikNetwork::MailboxInterface> mailbox(trikNetwork::MailboxFactory::create(8898));
+	trikScriptRunner::TrikScriptRunner runner(*brick, mailbox.data());
+	tests::utils::Wait::wait(100);
+
+	tests::utils::TcpClientSimulator robot("127.0.0.1", 8898);
+	robot.send("register:20000:1");
+	tests::utils::Wait::wait(200);
+	const int responses = robot.responses();
+
+	runner.run("mailbox.receive();");
+	tests::utils::Wait::wait(200);
+	runner.run("mailbox.send(1, 'second ' + mailbox.receive());");
+
+	// Second script waits for a message instead of sending an empty one.
+	tests::utils::Wait::wait(300);
+	EXPECT_EQ(responses, robot.responses());
+
+	robot.send("data:hello");
+	for (int i = 0; i < 100 && robot.responses() == responses; ++i) {
+		tests::utils::Wait::wait(10);
+	}
+
+	EXPECT_EQ("data:second hello", robot.latestResponse());
+}
@@ -33,6 +33,9 @@ protected:
 	void runDirectCommandAndWaitForQuit(const QString &script);
 	void runFromFile(const QString &fileName);
 
+	/// Runs Python script and waits for its completion, returns error message (empty if there was no error).
+	QString runPython(const QString &script);
+
 	trikScriptRunner::TrikScriptRunner &scriptRunner();
 
 private:
@@ -25,7 +25,7 @@ SOURCES += \
 OTHER_FILES += \
 	$$PWD/data/file-test.js \
 
-implementationIncludes(trikKernel trikControl trikScriptRunner tests/testUtils)
+implementationIncludes(trikKernel trikControl trikNetwork trikScriptRunner tests/testUtils)
 links(trikKernel trikControl trikScriptRunner trikNetwork trikHal testUtils)
 
 copyToDestdir($$PWD/data/, now)
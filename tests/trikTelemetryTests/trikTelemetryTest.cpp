@@ -0,0 +1,254 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include <functional>
+#include <limits>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QScopedPointer>
+
+#include <trikControl/brickFactory.h>
+#include <trikControl/brickInterface.h>
+#include <trikKernel/deinitializationHelper.h>
+#include <trikNetwork/connection.h>
+#include <trikTelemetry/trikTelemetry.h>
+#include <testUtils/wait.h>
+
+#include <gtest/gtest.h>
+
+#include "subscription.h"
+
+using namespace trikTelemetry;
+using namespace tests::utils;
+
+namespace {
+
+const int telemetryPort = 9001;
+
+/// Processes events until condition holds, for 5 seconds at most. Returns final value of condition.
+bool waitFor(const std::function<bool()> &condition)
+{
+	QElapsedTimer timeout;
+	timeout.start();
+	while (!condition() && timeout.elapsed() < 5000) {
+		Wait::wait(1);
+	}
+
+	return condition();
+}
+
+/// Telemetry client that keeps text answers and binary frames it receives.
+class TelemetryClient : public trikNetwork::Connection
+{
+public:
+	TelemetryClient()
+		: Connection(trikNetwork::Protocol::messageLength, trikNetwork::Heartbeat::use)
+	{
+		init(QHostAddress::LocalHost, telemetryPort);
+	}
+
+	QStringList answers() const
+	{
+		return mAnswers;
+	}
+
+	QList<QByteArray> frames() const
+	{
+		return mFrames;
+	}
+
+private:
+	void processData(const QByteArray &data) override
+	{
+		if (data.startsWith("TF")) {
+			mFrames << data;
+		} else {
+			mAnswers << QString::fromUtf8(data);
+		}
+	}
+
+	QStringList mAnswers;
+	QList<QByteArray> mFrames;
+};
+
+/// Telemetry server on a brick with test configs and a client connected to it.
+class TrikTelemetryTest : public testing::Test
+{
+protected:
+	void SetUp() override
+	{
+		mBrick.reset(trikControl::BrickFactory::create("./test-system-config.xml", "./test-model-config.xml"
+				, "./media/"));
+		mTelemetry.reset(new TrikTelemetry(*mBrick));
+		mTelemetry->startServer(telemetryPort);
+		mClient.reset(new TelemetryClient());
+	}
+
+	void TearDown() override
+	{
+		mClient.reset();
+		mTelemetry.reset();
+		mBrick.reset();
+	}
+
+	/// Sends a command and returns an answer to it, or empty string if there was no answer.
+	QString request(const QString &command)
+	{
+		const int answers = mClient->answers().size();
+		mClient->send(command.toUtf8());
+		return waitFor([this, answers]() { return mClient->answers().size() > answers; })
+				? mClient->answers().last()
+				: QString();
+	}
+
+	/// Waits until client gets given number of frames in total.
+	bool waitForFrames(int count)
+	{
+		return waitFor([this, count]() { return mClient->frames().size() >= count; });
+	}
+
+	/// Does nothing, but ensures event processing at the time of destruction of test suite, to avoid
+	/// deleteLater()-related memleaks.
+	trikKernel::DeinitializationHelper mHelper;
+
+	QScopedPointer<trikControl::BrickInterface> mBrick;
+	QScopedPointer<TrikTelemetry> mTelemetry;
+	QScopedPointer<TelemetryClient> mClient;
+};
+
+}
+
+/// Frame header is laid out as documented, values are zigzag varints of deltas and are restored by decoder.
+TEST(SubscriptionTest, frameLayoutTest)
+{
+	const int minInt = std::numeric_limits<int>::min();
+	const int maxInt = std::numeric_limits<int>::max();
+	const QVector<int> previous = {0, 0, 100, maxInt};
+	const QVector<int> values = {1, -2, 300, minInt};
+	const QByteArray frame = Subscription::encodeFrame(5, 0x0102030405ULL, false, values, previous);
+
+	const QByteArray expected = QByteArray("TF\x01\x00", 4)
+			+ QByteArray("\x05\x00\x00\x00", 4)
+			+ QByteArray("\x05\x04\x03\x02\x01\x00\x00\x00", 8)
+			+ QByteArray("\x04\x00", 2)
+			// Deltas 1, -2, 200 and 1 (overflow wraps around).
+			+ QByteArray("\x02\x03\x90\x03\x02", 5);
+	EXPECT_EQ(expected.toHex(), frame.toHex());
+
+	QVector<int> decoded = previous;
+	quint32 sequence = 0;
+	quint64 timestamp = 0;
+	bool keyFrame = true;
+	ASSERT_TRUE(Subscription::decodeFrame(frame, sequence, timestamp, keyFrame, decoded));
+	EXPECT_EQ(5u, sequence);
+	EXPECT_EQ(0x0102030405ULL, timestamp);
+	EXPECT_FALSE(keyFrame);
+	EXPECT_EQ(values, decoded);
+
+	// Key frame does not depend on previous values.
+	const QByteArray key = Subscription::encodeFrame(6, 0, true, values, previous);
+	decoded.clear();
+	ASSERT_TRUE(Subscription::decodeFrame(key, sequence, timestamp, keyFrame, decoded));
+	EXPECT_TRUE(keyFrame);
+	EXPECT_EQ(values, decoded);
+
+	// Delta frame needs values of all channels, and truncated frame is rejected.
+	decoded.clear();
+	EXPECT_FALSE(Subscription::decodeFrame(frame, sequence, timestamp, keyFrame, decoded));
+	decoded = previous;
+	EXPECT_FALSE(Subscription::decodeFrame(frame.left(frame.size() - 1), sequence, timestamp, keyFrame, decoded));
+}
+
+/// Subscription streams frames of known channels, starting from a key frame.
+TEST_F(TrikTelemetryTest, subscribeTest)
+{
+	EXPECT_EQ("subscribed:100:A1,E1", request("subscribe:100:A1,NoSuchPort,E1"));
+	ASSERT_TRUE(waitForFrames(5));
+
+	const QList<QByteArray> frames = mClient->frames();
+	QVector<int> values;
+	quint64 previousTimestamp = 0;
+	for (int i = 0; i < frames.size(); ++i) {
+		quint32 sequence = 0;
+		quint64 timestamp = 0;
+		bool keyFrame = false;
+		ASSERT_TRUE(Subscription::decodeFrame(frames[i], sequence, timestamp, keyFrame, values));
+		EXPECT_EQ(static_cast<quint32>(i), sequence);
+		EXPECT_EQ(i == 0, keyFrame);
+		EXPECT_EQ(2, values.size());
+		EXPECT_TRUE(i == 0 || timestamp > previousTimestamp);
+		previousTimestamp = timestamp;
+	}
+
+	// New subscription replaces the old one and starts a new stream.
+	const int framesBefore = mClient->frames().size();
+	EXPECT_EQ("subscribed:100:E1", request("subscribe:100:E1"));
+	ASSERT_TRUE(waitFor([this, framesBefore]() {
+		QVector<int> streamValues;
+		quint32 sequence = 0;
+		quint64 timestamp = 0;
+		bool keyFrame = false;
+		const QList<QByteArray> received = mClient->frames();
+		for (int i = framesBefore; i < received.size(); ++i) {
+			if (Subscription::decodeFrame(received[i], sequence, timestamp, keyFrame, streamValues) && sequence == 0
+					&& streamValues.size() == 1)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}));
+}
+
+/// No frames are sent after unsubscribe.
+TEST_F(TrikTelemetryTest, unsubscribeTest)
+{
+	EXPECT_EQ("subscribed:200:E1", request("subscribe:200:E1"));
+	ASSERT_TRUE(waitForFrames(3));
+
+	mClient->send("unsubscribe");
+
+	// Frames which were already sent may still arrive.
+	Wait::wait(100);
+	const int frames = mClient->frames().size();
+	Wait::wait(200);
+	EXPECT_EQ(frames, mClient->frames().size());
+}
+
+/// Rate is clamped to 1000 Hz, incorrect rates are rejected.
+TEST_F(TrikTelemetryTest, rateClampingTest)
+{
+	EXPECT_EQ("subscribed:1000:E1", request("subscribe:5000:E1"));
+	EXPECT_EQ("subscribed:0:", request("subscribe:0:E1"));
+	EXPECT_EQ("subscribed:0:", request("subscribe:-5:E1"));
+	EXPECT_EQ("subscribed:0:", request("subscribe:fast:E1"));
+}
+
+/// Rate that does not divide 1000 is kept on average: frame timestamps do not run ahead of their deadlines.
+TEST_F(TrikTelemetryTest, fractionalPeriodTest)
+{
+	EXPECT_EQ("subscribed:300:E1", request("subscribe:300:E1"));
+	ASSERT_TRUE(waitForFrames(60));
+
+	QVector<int> values;
+	quint32 sequence = 0;
+	quint64 timestamp = 0;
+	bool keyFrame = false;
+	ASSERT_TRUE(Subscription::decodeFrame(mClient->frames().last(), sequence, timestamp, keyFrame, values));
+
+	// Frames are late on a loaded machine, but with 3 ms period they would be 20 ms ahead of deadline at frame 60.
+	const quint64 deadline = static_cast<quint64>(sequence) * 1000000 / 300;
+	EXPECT_GE(timestamp + 1000, deadline);
+}
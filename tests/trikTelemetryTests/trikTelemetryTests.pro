@@ -0,0 +1,28 @@
+# Copyright 2018 CyberTech Labs Ltd.
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+
+#     http://www.apache.org/licenses/LICENSE-2.0
+
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+include(../common.pri)
+
+QT += network
+
+# Frames are decoded by Subscription, which is an internal class of trikTelemetry, it is not exported from the library
+# on Windows.
+linux {
+	SOURCES += $$PWD/trikTelemetryTest.cpp
+	INCLUDEPATH += $$PWD/../../trikTelemetry/src
+}
+
+implementationIncludes(trikKernel trikControl trikTelemetry tests/testUtils)
+transitiveIncludes(trikNetwork)
+links(trikKernel trikControl trikNetwork trikHal trikTelemetry testUtils)
@@ -12,10 +12,13 @@
  * See the License for the specific language governing permissions and
  * limitations under the License. */
 
+#include <QtCore/QStringList>
+
 #include <trikKernel/fileUtils.h>
 #include <trikScriptRunner/trikScriptRunner.h>
 
 #include "src/connection.h"
+#include "src/fileUpload.h"
 
 #include <trikKernel/paths.h>
 #include <QsLog.h>
@@ -31,6 +34,12 @@ Connection::Connection(trikScriptRunner::TrikScriptRunner &trikScriptRunner, con
 
 void Connection::processData(const QByteArray &data)
 {
+	if (data.startsWith("chunk:")) {
+		// Chunks are binary and may be big, so they are not converted to strings and logged.
+		processChunk(data);
+		return;
+	}
+
 	QString command = QString::fromUtf8(data.data());
 
 	if (!command.startsWith("keepalive")) {
@@ -67,5 +76,95 @@ void Connection::processData(const QByteArray &data)
 				, Q_ARG(QString, command));
 	} else if (command == "configVersion") {
 		send("configVersion: " + mConfigVersion.toUtf8());
+	} else if (command.startsWith("upload:")) {
+		startUpload(command.mid(QString("upload:").length()));
+	} else if (command.startsWith("uploadAbort:")) {
+		mUploads.remove(command.mid(QString("uploadAbort:").length()));
+	}
+}
+
+void Connection::startUpload(const QString &arguments)
+{
+	const QStringList parts = arguments.split(':');
+	if (parts.size() < 4) {
+		QLOG_ERROR() << "Malformed 'upload' command";
+		return;
+	}
+
+	const QString id = parts[0];
+	bool ok = false;
+	const qint64 size = parts[1].toLongLong(&ok);
+	const QString fileName = parts.mid(3).join(':');
+	if (!ok) {
+		replyToUpload(id, "error:incorrect file size");
+		return;
+	}
+
+	// Restarting upload with the same id, previous one is closed first so it does not lock the file.
+	mUploads.remove(id);
+
+	const QSharedPointer<FileUpload> upload(new FileUpload(fileName, size, parts[2].toLatin1()));
+	QString error;
+	if (!upload->open(error)) {
+		replyToUpload(id, "error:" + error);
+		return;
+	}
+
+	mUploads.insert(id, upload);
+	replyToUpload(id, QString("offset:%1").arg(upload->offset()));
+
+	if (upload->isComplete()) {
+		// Empty file, or all data was received before, but upload was interrupted before it was finished.
+		processChunk(QString("chunk:%1:%2:").arg(id).arg(upload->offset()).toUtf8());
+	}
+}
+
+void Connection::processChunk(const QByteArray &data)
+{
+	const int headerStart = QByteArray("chunk:").size();
+	const int idEnd = data.indexOf(':', headerStart);
+	const int offsetEnd = idEnd == -1 ? -1 : data.indexOf(':', idEnd + 1);
+	if (offsetEnd == -1) {
+		QLOG_ERROR() << "Malformed 'chunk' command";
+		return;
+	}
+
+	const QString id = QString::fromUtf8(data.constData() + headerStart, idEnd - headerStart);
+	const QSharedPointer<FileUpload> upload = mUploads.value(id);
+	if (upload.isNull()) {
+		replyToUpload(id, "error:unknown upload");
+		return;
+	}
+
+	bool ok = false;
+	const qint64 offset = data.mid(idEnd + 1, offsetEnd - idEnd - 1).toLongLong(&ok);
+	if (!ok || offset != upload->offset()) {
+		replyToUpload(id, QString("offset:%1").arg(upload->offset()));
+		return;
+	}
+
+	QString error;
+	if (!upload->write(data.constData() + offsetEnd + 1, data.size() - offsetEnd - 1, error)) {
+		mUploads.remove(id);
+		replyToUpload(id, "error:" + error);
+		return;
+	}
+
+	replyToUpload(id, QString("progress:%1:%2").arg(upload->offset()).arg(upload->size()));
+
+	if (upload->isComplete()) {
+		mUploads.remove(id);
+		if (upload->finish(error)) {
+			QLOG_INFO() << "Upload" << id << "finished," << upload->size() << "bytes";
+			replyToUpload(id, "done");
+			QMetaObject::invokeMethod(&mTrikScriptRunner, "brickBeep");
+		} else {
+			replyToUpload(id, "error:" + error);
+		}
 	}
 }
+
+void Connection::replyToUpload(const QString &id, const QString &reply)
+{
+	send(QString("upload:%1:%2").arg(id, reply).toUtf8());
+}
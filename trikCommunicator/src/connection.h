@@ -14,8 +14,10 @@
 
 #pragma once
 
+#include <QtCore/QHash>
 #include <QtCore/QObject>
 #include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
 #include <QtNetwork/QTcpSocket>
 #include <trikNetwork/connection.h>
 
@@ -25,6 +27,8 @@ class TrikScriptRunner;
 
 namespace trikCommunicator {
 
+class FileUpload;
+
 /// Class that serves one client of TrikCommunicator. Meant to work in separate thread. Creates its own socket and
 /// handles all incoming messages, calling ScriptRunnerWrapper for brick functionality.
 ///
@@ -34,6 +38,17 @@ namespace trikCommunicator {
 /// - stop --- stop current script execution and a robot.
 /// - direct:<command> --- execute given script without saving it to a file.
 /// - keepalive --- do nothing, used to check the availability of connection.
+///
+/// Big files are uploaded in chunks, several uploads may go at once:
+/// - upload:<id>:<size>:<sha256>:<file name> --- start or resume upload of a file with given size and SHA-256 hash
+///   (hex string, may be empty to skip check), id is any string without ':' chosen by a client to refer to upload.
+///   Replied with "upload:<id>:offset:<bytes>", the number of bytes already received in previous attempts.
+/// - chunk:<id>:<offset>:<binary data> --- data of a file starting at given offset, which shall be equal to the number
+///   of bytes received so far. Replied with "upload:<id>:progress:<received>:<size>", or with
+///   "upload:<id>:offset:<bytes>" if offset is wrong, so client shall continue from there.
+/// - uploadAbort:<id> --- stop upload, received data is kept to be resumed later.
+/// When all data is received, file is checked and saved, reply is "upload:<id>:done". Errors are replied with
+/// "upload:<id>:error:<reason>".
 class Connection : public trikNetwork::Connection
 {
 	Q_OBJECT
@@ -54,11 +69,22 @@ signals:
 private:
 	void processData(const QByteArray &data) override;
 
+	/// Handles "upload:" command.
+	void startUpload(const QString &arguments);
+
+	/// Handles binary "chunk:" command without converting data.
+	void processChunk(const QByteArray &data);
+
+	void replyToUpload(const QString &id, const QString &reply);
+
 	/// Common script runner object, located in another thread.
 	trikScriptRunner::TrikScriptRunner &mTrikScriptRunner;
 
 	/// Version of a system configuration file.
 	const QString &mConfigVersion;
+
+	/// Uploads in progress by their ids.
+	QHash<QString, QSharedPointer<FileUpload>> mUploads;
 };
 
 }
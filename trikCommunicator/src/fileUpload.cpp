@@ -0,0 +1,158 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "src/fileUpload.h"
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QSet>
+
+#include <trikKernel/fileUtils.h>
+#include <trikKernel/paths.h>
+#include <QsLog.h>
+
+using namespace trikCommunicator;
+
+/// Size of a block in which existing partial file is read to restore its hash.
+static const int hashBlockSize = 64 * 1024;
+
+/// Paths of files being uploaded at the moment, by all connections.
+static QSet<QString> activeUploads;
+static QMutex activeUploadsLock;
+
+FileUpload::FileUpload(const QString &fileName, qint64 size, const QByteArray &sha256)
+	: mSize(size)
+	, mExpectedHash(sha256.toLower())
+	, mHash(QCryptographicHash::Sha256)
+{
+	const QString cleanName = QDir::cleanPath(fileName);
+	if (!cleanName.isEmpty() && !QDir::isAbsolutePath(cleanName) && !cleanName.startsWith("..")) {
+		mPath = trikKernel::FileUtils::normalizePath(trikKernel::Paths::userScriptsPath()) + cleanName;
+	}
+}
+
+FileUpload::~FileUpload()
+{
+	mPartFile.close();
+	if (mLocked) {
+		QMutexLocker locker(&activeUploadsLock);
+		activeUploads.remove(mPath);
+	}
+}
+
+bool FileUpload::open(QString &error)
+{
+	if (mPath.isEmpty()) {
+		error = "incorrect file name";
+		return false;
+	}
+
+	if (mSize < 0) {
+		error = "incorrect file size";
+		return false;
+	}
+
+	{
+		QMutexLocker locker(&activeUploadsLock);
+		if (activeUploads.contains(mPath)) {
+			error = "file is being uploaded already";
+			return false;
+		}
+
+		activeUploads.insert(mPath);
+		mLocked = true;
+	}
+
+	QFileInfo(mPath).dir().mkpath(".");
+	mPartFile.setFileName(mPath + ".part");
+	if (!mPartFile.open(QIODevice::ReadWrite)) {
+		error = mPartFile.errorString();
+		return false;
+	}
+
+	if (mPartFile.size() > mSize) {
+		// Left from upload of other version of a file.
+		mPartFile.resize(0);
+	}
+
+	// Restoring hash of already received data to continue previous upload.
+	QByteArray block;
+	while (!mPartFile.atEnd()) {
+		block = mPartFile.read(hashBlockSize);
+		if (block.isEmpty()) {
+			error = mPartFile.errorString();
+			return false;
+		}
+
+		mHash.addData(block);
+	}
+
+	if (mPartFile.pos() > 0) {
+		QLOG_INFO() << "Resuming upload of" << mPath << "from" << mPartFile.pos() << "of" << mSize << "bytes";
+	}
+
+	return true;
+}
+
+qint64 FileUpload::offset() const
+{
+	return mPartFile.pos();
+}
+
+qint64 FileUpload::size() const
+{
+	return mSize;
+}
+
+bool FileUpload::isComplete() const
+{
+	return offset() == mSize;
+}
+
+bool FileUpload::write(const char *data, qint64 length, QString &error)
+{
+	if (offset() + length > mSize) {
+		error = "data exceeds file size";
+		return false;
+	}
+
+	if (mPartFile.write(data, length) != length) {
+		error = mPartFile.errorString();
+		return false;
+	}
+
+	mHash.addData(data, static_cast<int>(length));
+	return true;
+}
+
+bool FileUpload::finish(QString &error)
+{
+	mPartFile.close();
+
+	const QByteArray hash = mHash.result().toHex();
+	if (!mExpectedHash.isEmpty() && hash != mExpectedHash) {
+		error = QString("hash mismatch, received data has SHA-256 %1").arg(QString::fromLatin1(hash));
+		mPartFile.remove();
+		return false;
+	}
+
+	QFile::remove(mPath);
+	if (!mPartFile.rename(mPath)) {
+		error = mPartFile.errorString();
+		return false;
+	}
+
+	return true;
+}
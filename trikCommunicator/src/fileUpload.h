@@ -0,0 +1,72 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QFile>
+#include <QtCore/QString>
+
+namespace trikCommunicator {
+
+/// One file being uploaded in chunks. Data is written to "<file name>.part" as it arrives, so interrupted upload
+/// can be resumed from the size of a partial file, and the file is moved in place only when all data is received
+/// and its SHA-256 hash matches the expected one. Only one upload of a file may be active at a time, even from
+/// different connections.
+class FileUpload
+{
+public:
+	/// Constructor.
+	/// @param fileName - name of a file relative to user scripts directory, subdirectories are created if needed.
+	/// @param size - full size of a file.
+	/// @param sha256 - expected SHA-256 hash of a file as a hex string, or empty string to skip verification.
+	FileUpload(const QString &fileName, qint64 size, const QByteArray &sha256);
+
+	~FileUpload();
+
+	/// Opens partial file, continuing previous upload if there is one. Returns false if upload can not be started,
+	/// with a reason in "error".
+	bool open(QString &error);
+
+	/// Returns number of bytes already received, the next chunk shall start at this offset.
+	qint64 offset() const;
+
+	/// Returns full size of a file.
+	qint64 size() const;
+
+	/// Returns true if all data is received.
+	bool isComplete() const;
+
+	/// Appends a chunk of data. Returns false on write error or if data exceeds file size.
+	bool write(const char *data, qint64 length, QString &error);
+
+	/// Checks hash and moves completely received file in place. Returns false if hash does not match (partial file
+	/// is removed then, so next upload starts from scratch) or file can not be moved.
+	bool finish(QString &error);
+
+private:
+	/// Full path of a target file.
+	QString mPath;
+
+	QFile mPartFile;
+	const qint64 mSize;
+	const QByteArray mExpectedHash;
+	QCryptographicHash mHash;
+
+	/// True if this upload holds a lock on a target file.
+	bool mLocked = false;
+};
+
+}
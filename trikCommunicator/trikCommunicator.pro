@@ -21,10 +21,12 @@ PUBLIC_HEADERS += \
 
 HEADERS += \
 	$$PWD/src/connection.h \
+	$$PWD/src/fileUpload.h \
 
 SOURCES += \
 	$$PWD/src/trikCommunicator.cpp \
 	$$PWD/src/connection.cpp \
+	$$PWD/src/fileUpload.cpp \
 
 QT += network
 
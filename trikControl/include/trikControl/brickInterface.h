@@ -18,6 +18,7 @@
 
 #include "batteryInterface.h"
 #include "colorSensorInterface.h"
+#include "controlLoopInterface.h"
 #include "displayInterface.h"
 #include "encoderInterface.h"
 #include "eventDeviceInterface.h"
@@ -29,6 +30,8 @@
 #include "lineSensorInterface.h"
 #include "motorInterface.h"
 #include "markerInterface.h"
+#include "motorControllerInterface.h"
+#include "motorGroupInterface.h"
 #include "objectSensorInterface.h"
 #include "pwmCaptureInterface.h"
 #include "sensorInterface.h"
@@ -58,6 +61,15 @@ public:
 	/// Returns version of system configuration file.
 	virtual QString configVersion() const = 0;
 
+	/// Returns a report on brick initialization: time it took to create every device, and lazy devices that are not
+	/// created yet, one device per line.
+	virtual QString initializationReport() const = 0;
+
+	/// Reads all sensors and encoders with given handles (see handle()) in one pass and puts their values into
+	/// caller-provided array of handles.size() elements. Reading by invalid handle yields 0.
+	/// @param rawData - read raw data of devices instead of their values.
+	virtual void readAll(const QVector<int> &handles, int *values, bool rawData = false) = 0;
+
 public slots:
 	/// Configures given device on given port. Port must be listed in model-config.xml, device shall be listed
 	/// in system-config.xml, and device shall be able to be configured on a port (it is also described
@@ -100,6 +112,17 @@ public slots:
 	/// Returns list of encoder ports
 	virtual QStringList encoderPorts() const = 0;
 
+	/// Returns handle of a sensor or an encoder on a given port, or -1 if there is no such port. Handle is resolved
+	/// once and stays valid for a lifetime of a brick (if port is reconfigured, handle refers to a new device and is
+	/// read as 0 while device is replaced), so read() and readAll() by handle do not look devices up by port name.
+	virtual int handle(const QString &port) = 0;
+
+	/// Returns reading of a sensor or an encoder with given handle, or 0 if handle is invalid.
+	virtual int read(int handle) = 0;
+
+	/// Returns readings of sensors and encoders with given handles.
+	virtual QVector<int> readAll(const QVector<int> &handles) = 0;
+
 	/// Returns on-board accelerometer.
 	virtual VectorSensorInterface *accelerometer() = 0;
 
@@ -148,6 +171,19 @@ public slots:
 	/// Returns marker.
 	virtual MarkerInterface *marker() = 0;
 
+	/// Returns executor of control loops which runs controllers of motors at a fixed rate.
+	virtual ControlLoopInterface *controlLoop() = 0;
+
+	/// Returns closed-loop controller of a power motor on given port using encoder on given port as feedback.
+	/// Controller is created on first access and is replaced if it is requested with another encoder.
+	/// Returns nullptr if there is no such motor or encoder. Ownership retained by brick.
+	virtual MotorControllerInterface *motorController(const QString &motorPort, const QString &encoderPort) = 0;
+
+	/// Returns group of power motors on given ports which are commanded together with minimal skew.
+	/// Group is created on first access. Returns nullptr if there is no power motor on some of given ports.
+	/// Ownership retained by brick.
+	virtual MotorGroupInterface *motorGroup(const QStringList &ports) = 0;
+
 	/// Returns custom event device that can be used as a sensor, for example, for custom gamepad support.
 	/// Creates new event device on first access to a file, then returns already opened device.
 	/// Ownership retained by brick.
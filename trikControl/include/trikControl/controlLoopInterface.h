@@ -0,0 +1,81 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <functional>
+
+#include <QtCore/QObject>
+#include <QtCore/QVariantMap>
+
+#include "declSpec.h"
+
+namespace trikControl {
+
+/// Executor of control loops. Runs controllers at a fixed rate on a dedicated thread (with real-time SCHED_FIFO
+/// priority if it is configured and allowed), so scripts only change setpoints of controllers and do not have to
+/// run control loops themselves. Thread is running only while there are controllers.
+///
+/// Every cycle starts at a fixed deadline, all controllers are called one after another and shall finish before the
+/// next deadline, otherwise the cycle is counted as missed and next cycle starts right away, without catching up.
+class TRIKCONTROL_EXPORT ControlLoopInterface : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Step of a controller, called by the loop every cycle in the loop thread. Gets current setpoint and time since
+	/// previous call in seconds. Shall not block.
+	typedef std::function<void(qreal setpoint, qreal dt)> Step;
+
+	/// Adds a controller, returns its id.
+	virtual int addController(const Step &step) = 0;
+
+public slots:
+	/// Adds built-in PID controller which keeps reading of an encoder at setpoint by changing power of a motor.
+	/// Returns id of a controller or -1 if there is no such encoder or motor. Initial setpoint is 0.
+	/// @param kp - proportional gain, in motor power per degree.
+	/// @param ki - integral gain.
+	/// @param kd - derivative gain.
+	virtual int addPid(const QString &encoderPort, const QString &motorPort, qreal kp, qreal ki, qreal kd) = 0;
+
+	/// Changes setpoint of a controller, it is used starting from the next cycle.
+	virtual void setSetpoint(int controller, qreal setpoint) = 0;
+
+	/// Removes a controller. When method returns, controller is not called anymore. May be called from a controller,
+	/// including a controller being removed.
+	virtual void removeController(int controller) = 0;
+
+	/// Removes all controllers and stops the loop thread. When called from a controller, the loop thread stops after
+	/// the current cycle.
+	virtual void clear() = 0;
+
+	/// Returns rate of the loop, in cycles per second.
+	virtual int rate() const = 0;
+
+	/// Changes rate of the loop, in cycles per second.
+	virtual void setRate(int rate) = 0;
+
+	/// Returns timing of the loop since start or since resetStatistics():
+	/// "cycles" --- number of cycles, "missed" --- cycles that have not finished before next deadline,
+	/// "maxJitter", "meanJitter" --- lateness of cycle start comparing to deadline, in microseconds,
+	/// "maxStep" --- longest time of all controllers steps in one cycle, in microseconds,
+	/// "maxOverrun" --- longest time by which a cycle missed next deadline, in microseconds,
+	/// "realtime" --- true if loop thread runs with real-time priority.
+	virtual QVariantMap statistics() const = 0;
+
+	/// Resets timing statistics.
+	virtual void resetStatistics() = 0;
+};
+
+}
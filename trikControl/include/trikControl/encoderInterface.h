@@ -15,6 +15,7 @@
 #pragma once
 
 #include <QtCore/QObject>
+#include <QtCore/QVariantList>
 
 #include "deviceInterface.h"
 
@@ -36,6 +37,17 @@ public slots:
 
 	/// Resets encoder by setting current reading to 0.
 	virtual void reset() = 0;
+
+	/// Returns current speed of encoder (in degrees per second), estimated from readings taken in every cycle of
+	/// control loop. The first call starts sampling, so it returns 0 until a couple of cycles pass.
+	virtual qreal readSpeed() = 0;
+
+	/// Returns current acceleration of encoder (in degrees per second squared), estimated like speed.
+	virtual qreal readAcceleration() = 0;
+
+	/// Returns up to given number of the latest samples of encoder, the oldest first. Each sample is a map with "time"
+	/// (in microseconds of monotonic clock), "position" (in degrees), "speed" and "acceleration" keys.
+	virtual QVariantList history(int count) = 0;
 };
 
 }
@@ -0,0 +1,54 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QObject>
+
+#include "deviceInterface.h"
+
+#include "declSpec.h"
+
+namespace trikControl {
+
+/// Closed-loop controller of a power motor with an encoder. Keeps speed or moves to a position by trapezoidal
+/// profile (accelerating, cruising and decelerating with configured acceleration), using feedback from encoder.
+/// Runs in control loop of a brick, so scripts only give commands and check whether motor has settled.
+/// Speeds are in degrees per second, positions are encoder readings in degrees.
+class TRIKCONTROL_EXPORT MotorControllerInterface : public QObject, public DeviceInterface
+{
+	Q_OBJECT
+
+public slots:
+	/// Accelerates or decelerates motor to given speed and keeps it.
+	virtual void setSpeed(qreal speed) = 0;
+
+	/// Moves motor to given position and holds it there.
+	/// @param speed - cruise speed, 0 for maximal speed from configuration.
+	virtual void moveTo(qreal position, qreal speed = 0) = 0;
+
+	/// Returns true if motor reached position given to moveTo() or speed given to setSpeed() and stays there.
+	virtual bool isSettled() const = 0;
+
+	/// Returns position of a motor measured by controller.
+	virtual qreal position() const = 0;
+
+	/// Returns speed of a motor measured by controller.
+	virtual qreal speed() const = 0;
+
+	/// Stops controlling a motor and powers it off.
+	virtual void stop() = 0;
+};
+
+}
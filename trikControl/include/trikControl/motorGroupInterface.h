@@ -0,0 +1,50 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QVariantList>
+#include <QtCore/QVector>
+
+#include "deviceInterface.h"
+
+#include "declSpec.h"
+
+namespace trikControl {
+
+/// Group of power motors which are commanded together, for example, wheels of a differential or omni drive.
+/// Commands for all motors of a group are sent to a bus in one burst, so motors start and stop with minimal skew.
+class TRIKCONTROL_EXPORT MotorGroupInterface : public QObject, public DeviceInterface
+{
+	Q_OBJECT
+
+public slots:
+	/// Returns ports of motors in a group, in the order used by setPowers().
+	virtual QStringList ports() const = 0;
+
+	/// Sets powers of all motors of a group at once.
+	/// @param powers - powers of motors in the order of ports(), from -100 to 100 each.
+	virtual void setPowers(const QVector<int> &powers) = 0;
+
+	/// Turns off all motors of a group at once.
+	virtual void stopAll() = 0;
+
+	/// Returns times when commands of the last setPowers() or stopAll() were sent to each motor, in microseconds of
+	/// monotonic clock, in the order of ports(). Difference between them is a skew between motors.
+	virtual QVariantList commandTimes() const = 0;
+};
+
+}
@@ -0,0 +1,70 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QStringList>
+
+#include "sharedStateLayout.h"
+
+#include "declSpec.h"
+
+namespace trikControl {
+
+/// Access to state of devices published by runtime in shared memory, for local processes that do not own a brick.
+/// Snapshots are read without locks and without blocking runtime, motor commands are put into a lock-free ring and
+/// are executed by runtime in the next cycle of its control loop. Runtime publishes state only if "sharedState"
+/// device is enabled in model config.
+///
+/// Client is not thread-safe, but any number of clients in any number of processes may be used at the same time.
+class TRIKCONTROL_EXPORT SharedStateClient
+{
+public:
+	/// Constructor.
+	/// @param key - key of a segment, "key" attribute of "sharedState" device class in system config.
+	explicit SharedStateClient(const QString &key = sharedState::defaultKey);
+
+	~SharedStateClient();
+
+	/// Attaches to a segment published by runtime. Returns false if there is no segment or it has incompatible layout.
+	bool attach();
+
+	/// Returns true if client is attached to a segment.
+	bool isAttached() const;
+
+	/// Returns sensor and encoder ports, in order of Snapshot::sensors.
+	QStringList sensorPorts() const;
+
+	/// Returns power motor ports, in order of Snapshot::motors.
+	QStringList motorPorts() const;
+
+	/// Copies the latest snapshot. Returns false if client is not attached or if snapshot was being rewritten during
+	/// all attempts to copy it (it means that runtime stalled in the middle of writing).
+	bool read(sharedState::Snapshot &snapshot) const;
+
+	/// Asks runtime to set power of a motor on given port. Returns false if client is not attached, if there is no
+	/// such port or if command ring is full.
+	bool setPower(const QString &port, int power);
+
+	/// Asks runtime to set power of a motor with given index in motorPorts().
+	bool setPower(int motor, int power);
+
+private:
+	QSharedMemory mMemory;
+	sharedState::Segment *mSegment = nullptr;
+};
+
+}
@@ -0,0 +1,169 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QAtomicInteger>
+
+namespace trikControl {
+namespace sharedState {
+
+/// Layout of a shared memory segment where runtime publishes state of devices for local processes (see
+/// SharedStateClient). Segment is created by runtime and is zero-filled, so all fields are plain data and atomics
+/// without constructors. Layout is the same for all processes built for the same platform; any change of it shall
+/// increase "version".
+
+/// "TRSS" in little-endian.
+static const quint32 magic = 0x53535254;
+
+/// Version of segment layout.
+static const quint32 version = 3;
+
+/// Key of a segment used when it is not configured.
+static const char defaultKey[] = "trikRuntimeState";
+
+/// Maximal number of published sensor and encoder ports.
+static const int maxSensors = 32;
+
+/// Maximal number of published power motor ports.
+static const int maxMotors = 16;
+
+/// Maximal length of port name, including terminating zero.
+static const int portNameSize = 16;
+
+/// Number of commands in command ring, shall be a power of 2.
+static const int commandRingSize = 64;
+
+/// Number of gyroscope values, see GyroSensorInterface::read().
+static const int gyroscopeSize = 7;
+
+/// Number of gamepad buttons, buttons are numbered from 1.
+static const int gamepadButtons = 5;
+
+/// Names of published ports, written once when a segment is created.
+struct Ports
+{
+	/// Number of sensor and encoder ports.
+	qint32 sensorCount;
+
+	/// Number of power motor ports.
+	qint32 motorCount;
+
+	char sensors[maxSensors][portNameSize];
+	char motors[maxMotors][portNameSize];
+};
+
+/// State of gamepad, as returned by GamepadInterface.
+struct Gamepad
+{
+	qint32 isConnected;
+	qint32 wheel;
+
+	/// Bit i is set if button i + 1 is pressed.
+	qint32 buttons;
+
+	/// Pads 1 and 2.
+	qint32 padPressed[2];
+	qint32 padX[2];
+	qint32 padY[2];
+};
+
+/// Snapshot of state of all published devices, taken at once.
+struct Snapshot
+{
+	/// Number of a snapshot, starting from 1.
+	quint32 frame;
+
+	/// Time when snapshot was taken, in microseconds of monotonic clock.
+	qint64 time;
+
+	/// Readings of sensors and encoders, in order of Ports::sensors.
+	qint32 sensors[maxSensors];
+
+	/// Powers of motors, in order of Ports::motors.
+	qint32 motors[maxMotors];
+
+	qint32 accelerometer[3];
+	qint32 gyroscope[gyroscopeSize];
+	Gamepad gamepad;
+};
+
+/// Command which sets power of a motor, a slot of command ring. Command is written together with a state of a slot by
+/// one compare-and-swap, so a client which was skipped by runtime (it may have crashed or stalled between claiming
+/// a slot and writing a command) fails to write and can never overwrite a command of a client which reused the slot.
+struct Command
+{
+	/// Higher 32 bits are state of a slot, see freeSlot() and writtenSlot(). Lower 32 bits are an index of a motor
+	/// in Ports::motors (higher 16 bits) and power (lower 16 bits, signed).
+	QBasicAtomicInteger<quint64> word;
+};
+
+/// Returns word of a slot which waits for a command with given number. Slots of zero-filled segment wait for
+/// commands 0 to commandRingSize - 1.
+inline quint64 freeSlot(quint32 number)
+{
+	return static_cast<quint64>(number / commandRingSize * 2) << 32;
+}
+
+/// Returns word of a slot with written command with given number.
+inline quint64 writtenSlot(quint32 number, int motor, int power)
+{
+	const quint32 command = (static_cast<quint32>(motor) << 16) | static_cast<quint16>(static_cast<qint16>(power));
+	return freeSlot(number) + (Q_UINT64_C(1) << 32) + command;
+}
+
+/// Returns true if a slot contains written command with given number.
+inline bool isWritten(quint64 word, quint32 number)
+{
+	return (word >> 32) == (freeSlot(number) >> 32) + 1;
+}
+
+/// Returns index of a motor of a written command.
+inline int commandMotor(quint64 word)
+{
+	return static_cast<int>((word >> 16) & 0xFFFF);
+}
+
+/// Returns power of a written command.
+inline int commandPower(quint64 word)
+{
+	return static_cast<qint16>(static_cast<quint16>(word & 0xFFFF));
+}
+
+/// Whole segment.
+struct Segment
+{
+	quint32 magic;
+	quint32 version;
+
+	/// sizeof(Segment) in a process that created a segment.
+	quint32 size;
+
+	Ports ports;
+
+	/// Sequence counter of seqlock protecting snapshot: odd while snapshot is being written, increased by 2 with every
+	/// snapshot. Reader copies snapshot and checks that counter was even and did not change meanwhile.
+	QBasicAtomicInteger<quint32> sequence;
+
+	Snapshot snapshot;
+
+	/// Command ring, with multiple producers (clients) and one consumer (runtime). Head is a number of commands
+	/// claimed by clients, tail is a number of commands executed by runtime, both wrap around.
+	QBasicAtomicInteger<quint32> commandHead;
+	QBasicAtomicInteger<quint32> commandTail;
+	Command commands[commandRingSize];
+};
+
+}
+}
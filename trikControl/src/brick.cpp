@@ -20,6 +20,7 @@
 	#include <QtWidgets/QApplication>
 #endif
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QFileInfo>
 #include <QtMultimedia/QCamera>
 #include <QtMultimedia/QCameraImageCapture>
@@ -33,9 +34,11 @@
 #include "analogSensor.h"
 #include "battery.h"
 #include "colorSensor.h"
+#include "controlLoop.h"
 #include "digitalSensor.h"
 #include "display.h"
 #include "encoder.h"
+#include "encoderSampler.h"
 #include "eventDevice.h"
 #include "fifo.h"
 #include "gamepad.h"
@@ -43,11 +46,14 @@
 #include "keys.h"
 #include "led.h"
 #include "lineSensor.h"
+#include "motorController.h"
+#include "motorGroup.h"
 #include "objectSensor.h"
 #include "powerMotor.h"
 #include "pwmCapture.h"
 #include "rangeSensor.h"
 #include "servoMotor.h"
+#include "sharedStatePublisher.h"
 #include "soundSensor.h"
 #include "tonePlayer.h"
 #include "vectorSensor.h"
@@ -57,6 +63,7 @@
 #include "mspI2cCommunicator.h"
 #include "i2cCommunicator.h"
 
+#include "initializationGraph.h"
 #include "mspBusAutoDetector.h"
 #include "moduleLoader.h"
 
@@ -67,6 +74,9 @@ using namespace trikControl;
 using namespace trikKernel;
 using namespace trikHal;
 
+/// Maximal number of devices initialized in parallel. Initialization mostly waits for drivers and files, not CPU.
+static const int initializationThreads = 8;
+
 Brick::Brick(trikHal::HardwareAbstractionInterface &hardwareAbstraction
 		, const QString &systemConfig, const QString &modelConfig, const QString &mediaPath)
 	: Brick(createDifferentOwnerPointer(hardwareAbstraction), systemConfig, modelConfig, mediaPath)
@@ -92,49 +102,126 @@ Brick::Brick(const trikKernel::DifferentOwnerPointer<trikHal::HardwareAbstractio
 
 	const bool hasGui = (qobject_cast<QApplication *>(QCoreApplication::instance()) != nullptr);
 
+	mModuleLoader.reset(new ModuleLoader(mHardwareAbstraction->systemConsole()));
+
+	// Encoders are registered in sampler, which runs in control loop, so both are created before devices.
+	mControlLoop.reset(new ControlLoop(mConfigurer, *this));
+	mEncoderSampler.reset(new EncoderSampler(mConfigurer, *mControlLoop));
+
+	// Devices are created in parallel as soon as what they need is ready. Most of them only open their files and start
+	// their own threads, so they are moved to the brick thread after creation; devices that rely on an event loop of
+	// a thread where they are created, like keys and fifos, and GUI are created in the brick thread.
+	InitializationGraph graph;
+
 	if (hasGui) {
-		mDisplay.reset(new Display(mediaPath));
+		graph.addTask("display", [this, mediaPath]() { mDisplay.reset(new Display(mediaPath)); }, {}, true);
 	} else {
 		QLOG_INFO() << "Running in no GUI mode";
 	}
 
-	for (const QString &initScript : mConfigurer.initScripts()) {
-		if (mHardwareAbstraction->systemConsole().system(initScript) != 0) {
-			QLOG_ERROR() << "Init script failed";
+	graph.addTask("initScripts", [this]() {
+		// Scripts may depend on each other, so they are run in order.
+		for (const QString &initScript : mConfigurer.initScripts()) {
+			if (mHardwareAbstraction->systemConsole().system(initScript) != 0) {
+				QLOG_ERROR() << "Init script failed";
+			}
 		}
-	}
+	});
 
-	mMspCommunicator.reset(MspBusAutoDetector::createCommunicator(mConfigurer, *mHardwareAbstraction));
-	mModuleLoader.reset(new ModuleLoader(mHardwareAbstraction->systemConsole()));
+	graph.addTask("msp", [this]() {
+		mMspCommunicator.reset(inBrickThread(MspBusAutoDetector::createCommunicator(mConfigurer
+				, *mHardwareAbstraction)));
+	}, {"initScripts"});
 
 	for (const QString &port : mConfigurer.ports()) {
-		createDevice(port);
+		QString deviceClass;
+		try {
+			deviceClass = mConfigurer.deviceClass(port);
+		} catch (MalformedConfigException &) {
+			QLOG_ERROR() << "Ignoring device on port" << port;
+			continue;
+		}
+
+		const bool inBrickThreadOnly = deviceClass == "fifo" || deviceClass == "camera";
+		if (!inBrickThreadOnly && mConfigurer.hasAttributeByDevice(deviceClass, "lazy")
+				&& mConfigurer.attributeByDevice(deviceClass, "lazy") == "true")
+		{
+			mLazyPorts.insert(port, deviceClass);
+			continue;
+		}
+
+		const bool usesMsp = deviceClass == "powerMotor" || deviceClass == "analogSensor" || deviceClass == "encoder";
+		graph.addTask("port " + port, [this, port]() { createDevice(port); }
+				, usesMsp ? QStringList{"initScripts", "msp"} : QStringList{"initScripts"}, inBrickThreadOnly);
 	}
 
-	mBattery.reset(new Battery(*mMspCommunicator));
+	mLazyPortsCount.store(mLazyPorts.size());
+
+	graph.addTask("battery", [this]() { mBattery.reset(inBrickThread(new Battery(*mMspCommunicator))); }, {"msp"});
 
 	if (mConfigurer.isEnabled("accelerometer")) {
-		mAccelerometer.reset(new VectorSensor("accelerometer", mConfigurer, *mHardwareAbstraction));
+		graph.addTask("accelerometer", [this]() {
+			mAccelerometer.reset(inBrickThread(new VectorSensor("accelerometer", mConfigurer, *mHardwareAbstraction)));
+		}, {"initScripts"});
 	}
 
 	if (mConfigurer.isEnabled("gyroscope")) {
-		mGyroscope.reset(new GyroSensor("gyroscope", mConfigurer, *mHardwareAbstraction, mAccelerometer.data()));
+		graph.addTask("gyroscope", [this]() {
+			mGyroscope.reset(inBrickThread(new GyroSensor("gyroscope", mConfigurer, *mHardwareAbstraction
+					, mAccelerometer.data())));
+		}, mConfigurer.isEnabled("accelerometer") ? QStringList{"initScripts", "accelerometer"}
+				: QStringList{"initScripts"});
 	}
 
-	mKeys.reset(new Keys(mConfigurer, *mHardwareAbstraction));
+	// Keys worker reads its event file in a thread where it was created.
+	graph.addTask("keys", [this]() { mKeys.reset(new Keys(mConfigurer, *mHardwareAbstraction)); }
+			, {"initScripts"}, true);
 
-	mLed.reset(new Led(mConfigurer, *mHardwareAbstraction));
+	graph.addTask("led", [this]() { mLed.reset(inBrickThread(new Led(mConfigurer, *mHardwareAbstraction))); }
+			, {"initScripts"});
 
 	if (mConfigurer.isEnabled("gamepad")) {
-		mGamepad.reset(new Gamepad(mConfigurer, *mHardwareAbstraction));
+		// Gamepad fifo is read in a thread where it was created.
+		graph.addTask("gamepad", [this]() { mGamepad.reset(new Gamepad(mConfigurer, *mHardwareAbstraction)); }
+				, {"initScripts"}, true);
+	}
+
+	graph.run(initializationThreads);
+
+	mInitializationReport << QString("Brick initialized in %1 ms").arg(graph.totalTime());
+	for (const InitializationGraph::Timing &timing : graph.timings()) {
+		mInitializationReport << QString("%1: started at %2 ms, took %3 ms%4").arg(timing.name).arg(timing.start)
+				.arg(timing.duration).arg(timing.failed ? ", failed" : "");
+	}
+
+	for (const QString &report : mInitializationReport) {
+		QLOG_INFO() << report;
 	}
 
 	mPlayWavFileCommand = mConfigurer.attributeByDevice("playWavFile", "command");
 	mPlayMp3FileCommand = mConfigurer.attributeByDevice("playMp3File", "command");
+
+	if (mConfigurer.isEnabled("sharedState")) {
+		// Lazy devices are not published, so publishing does not create them.
+		QStringList sensorPorts = mAnalogSensors.keys() + mDigitalSensors.keys() + mRangeSensors.keys()
+				+ mEncoders.keys();
+		QStringList motorPorts = mPowerMotors.keys();
+		sensorPorts.sort();
+		motorPorts.sort();
+		mSharedState.reset(new SharedStatePublisher(mConfigurer, *this, *mControlLoop, sensorPorts, motorPorts));
+		mSharedState->start();
+	}
 }
 
 Brick::~Brick()
 {
+	// Controllers and shared state publisher use motors and encoders, so they are stopped first.
+	mSharedState.reset();
+	qDeleteAll(mMotorControllers);
+	mEncoderSampler->clear();
+	mControlLoop.reset();
+	qDeleteAll(mMotorGroups);
+
 	qDeleteAll(mServoMotors);
 	qDeleteAll(mPwmCaptures);
 	qDeleteAll(mPowerMotors);
@@ -177,13 +264,73 @@ QString Brick::configVersion() const
 	return mConfigurer.version();
 }
 
+template<typename T>
+T *Brick::inBrickThread(T *object)
+{
+	object->moveToThread(thread());
+	return object;
+}
+
+template<typename T>
+void Brick::insertDevice(QHash<QString, T *> &devices, const QString &port, T *device)
+{
+	inBrickThread(device);
+	QWriteLocker locker(&mDevicesLock);
+	devices.insert(port, device);
+}
+
+template<typename T>
+T *Brick::takeDevice(QHash<QString, T *> &devices, const QString &port)
+{
+	QWriteLocker locker(&mDevicesLock);
+	return devices.take(port);
+}
+
+template<typename T>
+T *Brick::findDevice(const QHash<QString, T *> &devices, const QString &port) const
+{
+	QReadLocker locker(&mDevicesLock);
+	return devices.value(port, nullptr);
+}
+
+template<typename T>
+QList<T *> Brick::devicesList(const QHash<QString, T *> &devices) const
+{
+	QReadLocker locker(&mDevicesLock);
+	return devices.values();
+}
+
+template<typename T>
+QStringList Brick::devicePorts(const QHash<QString, T *> &devices) const
+{
+	QReadLocker locker(&mDevicesLock);
+	return devices.keys();
+}
+
+QString Brick::initializationReport() const
+{
+	QMutexLocker locker(&mLazyPortsLock);
+	QStringList result = mInitializationReport;
+	for (const QString &port : mLazyPorts.keys()) {
+		result << QString("port %1: lazy, not created yet").arg(port);
+	}
+
+	return result.join('\n');
+}
+
 void Brick::configure(const QString &portName, const QString &deviceName)
 {
-	shutdownDevice(portName);
+	if (!removeLazyPort(portName)) {
+		// Handle shall not point to a device being deleted, readAll() from other threads reads 0 until new device
+		// is created.
+		invalidateHandle(portName);
+		shutdownDevice(portName);
+	}
 
 	mConfigurer.configure(portName, deviceName);
 
 	createDevice(portName);
+	updateHandle(portName);
 }
 
 void Brick::reset()
@@ -199,7 +346,7 @@ void Brick::reset()
 	}
 
 	/// @todo Temporary, we need more carefully init/deinit range sensors.
-	for (RangeSensor * const rangeSensor : mRangeSensors.values()) {
+	for (RangeSensor * const rangeSensor : devicesList(mRangeSensors)) {
 		rangeSensor->init();
 	}
 }
@@ -251,12 +398,35 @@ void Brick::stop()
 
 	mTonePlayer->stop();
 
-	for (ServoMotor * const servoMotor : mServoMotors.values()) {
+	// Controllers and commands from shared state clients would turn motors on again.
+	if (mSharedState) {
+		mSharedState->stop();
+	}
+
+	for (MotorController * const controller : mMotorControllers) {
+		controller->stop();
+	}
+
+	mEncoderSampler->clear();
+	mControlLoop->clear();
+
+	for (ServoMotor * const servoMotor : devicesList(mServoMotors)) {
 		servoMotor->powerOff();
 	}
 
-	for (PowerMotor * const powerMotor : mPowerMotors.values()) {
-		powerMotor->powerOff();
+	// Power motors are turned off by one burst of bus commands, so they stop at the same time.
+	QVector<QByteArray> powerOffCommands;
+	const QList<PowerMotor *> powerMotors = devicesList(mPowerMotors);
+	for (PowerMotor * const powerMotor : powerMotors) {
+		powerOffCommands.append(powerMotor->powerCommand(0, false));
+	}
+
+	if (!powerOffCommands.isEmpty()) {
+		mMspCommunicator->sendBurst(powerOffCommands);
+	}
+
+	for (PowerMotor * const powerMotor : powerMotors) {
+		powerMotor->commandSent(0, false);
 	}
 
 	if (mDisplay) {
@@ -264,64 +434,69 @@ void Brick::stop()
 	}
 
 	/// @todo: Also be able to stop initializing sensor.
-	for (LineSensor * const lineSensor : mLineSensors) {
+	for (LineSensor * const lineSensor : devicesList(mLineSensors)) {
 		if (lineSensor->status() == DeviceInterface::Status::ready) {
 			lineSensor->stop();
 		}
 	}
 
-	for (ColorSensor * const colorSensor : mColorSensors) {
+	for (ColorSensor * const colorSensor : devicesList(mColorSensors)) {
 		if (colorSensor->status() == DeviceInterface::Status::ready) {
 			colorSensor->stop();
 		}
 	}
 
-	for (ObjectSensor * const objectSensor : mObjectSensors) {
+	for (ObjectSensor * const objectSensor : devicesList(mObjectSensors)) {
 		if (objectSensor->status() == DeviceInterface::Status::ready) {
 			objectSensor->stop();
 		}
 	}
 
-	for (SoundSensor * const soundSensor : mSoundSensors) {
+	for (SoundSensor * const soundSensor : devicesList(mSoundSensors)) {
 		if (soundSensor->status() == DeviceInterface::Status::ready) {
 			soundSensor->stop();
 		}
 	}
 
-	for (RangeSensor * const rangeSensor : mRangeSensors.values()) {
+	for (RangeSensor * const rangeSensor : devicesList(mRangeSensors)) {
 		rangeSensor->stop();
 	}
 
 	qDeleteAll(mEventDevices);
 	mEventDevices.clear();
+
+	if (mSharedState) {
+		mSharedState->start();
+	}
 }
 
 MotorInterface *Brick::motor(const QString &port)
 {
+	createLazyDevice(port);
+	QReadLocker locker(&mDevicesLock);
 	if (mPowerMotors.contains(port)) {
-		return mPowerMotors[port];
-	} else if (mServoMotors.contains(port)) {
-		return mServoMotors[port];
+		return mPowerMotors.value(port);
 	} else {
-		return nullptr;
+		return mServoMotors.value(port, nullptr);
 	}
 }
 
 PwmCaptureInterface *Brick::pwmCapture(const QString &port)
 {
-	return mPwmCaptures.value(port, nullptr);
+	createLazyDevice(port);
+	return findDevice(mPwmCaptures, port);
 }
 
 SensorInterface *Brick::sensor(const QString &port)
 {
+	createLazyDevice(port);
+	QReadLocker locker(&mDevicesLock);
 	if (mAnalogSensors.contains(port)) {
-		return mAnalogSensors[port];
+		return mAnalogSensors.value(port);
 	} else if (mDigitalSensors.contains(port)) {
-		return mDigitalSensors[port];
-	} else if (mRangeSensors.contains(port)) {
-		return mRangeSensors[port];
+		return mDigitalSensors.value(port);
 	} else {
-		return nullptr;
+		return mRangeSensors.value(port, nullptr);
 	}
 }
 
@@ -329,10 +504,10 @@ QStringList Brick::motorPorts(MotorInterface::Type type) const
 {
 	switch (type) {
 	case MotorInterface::Type::powerMotor: {
-		return mPowerMotors.keys();
+		return devicePorts(mPowerMotors) + lazyPorts({"powerMotor"});
 	}
 	case MotorInterface::Type::servoMotor: {
-		return mServoMotors.keys();
+		return devicePorts(mServoMotors) + lazyPorts({"servoMotor"});
 	}
 	}
 
@@ -341,17 +516,18 @@ QStringList Brick::motorPorts(MotorInterface::Type type) const
 
 QStringList Brick::pwmCapturePorts() const
 {
-	return mPwmCaptures.keys();
+	return devicePorts(mPwmCaptures) + lazyPorts({"pwmCapture"});
 }
 
 QStringList Brick::sensorPorts(SensorInterface::Type type) const
 {
 	switch (type) {
 	case SensorInterface::Type::analogSensor: {
-		return mAnalogSensors.keys();
+		return devicePorts(mAnalogSensors) + lazyPorts({"analogSensor"});
 	}
 	case SensorInterface::Type::digitalSensor: {
-		return mDigitalSensors.keys() + mRangeSensors.keys();
+		return devicePorts(mDigitalSensors) + devicePorts(mRangeSensors)
+				+ lazyPorts({"digitalSensor", "rangeSensor"});
 	}
 	case SensorInterface::Type::specialSensor: {
 		// Special sensors can not be connected to standard ports, they have their own methods to access them.
@@ -364,7 +540,93 @@ QStringList Brick::sensorPorts(SensorInterface::Type type) const
 
 EncoderInterface *Brick::encoder(const QString &port)
 {
-	return mEncoders.value(port, nullptr);
+	createLazyDevice(port);
+	return findDevice(mEncoders, port);
+}
+
+int Brick::handle(const QString &port)
+{
+	// Handles are requested and read by telemetry and scripts from different threads, existing ones are looked up
+	// without blocking each other.
+	{
+		QReadLocker locker(&mHandlesLock);
+		const auto it = mPortHandles.constFind(port);
+		if (it != mPortHandles.constEnd()) {
+			return it.value();
+		}
+	}
+
+	QWriteLocker locker(&mHandlesLock);
+
+	// Other thread may have added a handle while the lock was released.
+	const auto it = mPortHandles.constFind(port);
+	if (it != mPortHandles.constEnd()) {
+		return it.value();
+	}
+
+	if (!sensor(port) && !encoder(port)) {
+		return -1;
+	}
+
+	const int result = mHandles.size();
+	mHandles.append({nullptr, nullptr});
+	mPortHandles.insert(port, result);
+	mHandles[result] = {sensor(port), encoder(port)};
+	return result;
+}
+
+int Brick::read(int handle)
+{
+	int result = 0;
+	readAll({handle}, &result);
+	return result;
+}
+
+QVector<int> Brick::readAll(const QVector<int> &handles)
+{
+	QVector<int> result(handles.size());
+	readAll(handles, result.data());
+	return result;
+}
+
+void Brick::readAll(const QVector<int> &handles, int *values, bool rawData)
+{
+	// Lock is held while devices are read, so configure() can not delete a device until reading of it is finished.
+	QReadLocker locker(&mHandlesLock);
+	for (int i = 0; i < handles.size(); ++i) {
+		const int handle = handles[i];
+		if (handle < 0 || handle >= mHandles.size()) {
+			values[i] = 0;
+			continue;
+		}
+
+		const PortHandle &device = mHandles[handle];
+		if (device.sensor) {
+			values[i] = rawData ? device.sensor->readRawData() : device.sensor->read();
+		} else if (device.encoder) {
+			values[i] = rawData ? device.encoder->readRawData() : device.encoder->read();
+		} else {
+			values[i] = 0;
+		}
+	}
+}
+
+void Brick::invalidateHandle(const QString &port)
+{
+	QWriteLocker locker(&mHandlesLock);
+	const auto it = mPortHandles.constFind(port);
+	if (it != mPortHandles.constEnd()) {
+		mHandles[it.value()] = {nullptr, nullptr};
+	}
+}
+
+void Brick::updateHandle(const QString &port)
+{
+	QWriteLocker locker(&mHandlesLock);
+	const auto it = mPortHandles.constFind(port);
+	if (it != mPortHandles.constEnd()) {
+		mHandles[it.value()] = {sensor(port), encoder(port)};
+	}
 }
 
 BatteryInterface *Brick::battery()
@@ -384,17 +646,20 @@ GyroSensorInterface *Brick::gyroscope()
 
 LineSensorInterface *Brick::lineSensor(const QString &port)
 {
-	return mLineSensors.contains(port) ? mLineSensors[port] : nullptr;
+	createLazyDevice(port);
+	return findDevice(mLineSensors, port);
 }
 
 ColorSensorInterface *Brick::colorSensor(const QString &port)
 {
-	return mColorSensors.contains(port) ? mColorSensors[port] : nullptr;
+	createLazyDevice(port);
+	return findDevice(mColorSensors, port);
 }
 
 ObjectSensorInterface *Brick::objectSensor(const QString &port)
 {
-	return mObjectSensors.contains(port) ? mObjectSensors[port] : nullptr;
+	createLazyDevice(port);
+	return findDevice(mObjectSensors, port);
 }
 
 I2cDeviceInterface *Brick::i2c(int bus, int address)
@@ -422,7 +687,8 @@ QVector<uint8_t> Brick::getStillImage()
 
 SoundSensorInterface *Brick::soundSensor(const QString &port)
 {
-	return mSoundSensors.contains(port) ? mSoundSensors[port] : nullptr;
+	createLazyDevice(port);
+	return findDevice(mSoundSensors, port);
 }
 
 KeysInterface* Brick::keys()
@@ -432,7 +698,7 @@ KeysInterface* Brick::keys()
 
 QStringList Brick::encoderPorts() const
 {
-	return mEncoders.keys();
+	return devicePorts(mEncoders) + lazyPorts({"encoder"});
 }
 
 DisplayInterface *Brick::display()
@@ -452,7 +718,7 @@ GamepadInterface *Brick::gamepad()
 
 trikControl::FifoInterface *Brick::fifo(const QString &port)
 {
-	return mFifos[port];
+	return findDevice(mFifos, port);
 }
 
 MarkerInterface *Brick::marker()
@@ -460,6 +726,35 @@ MarkerInterface *Brick::marker()
 	return nullptr;
 }
 
+ControlLoopInterface *Brick::controlLoop()
+{
+	return mControlLoop.data();
+}
+
+MotorControllerInterface *Brick::motorController(const QString &motorPort, const QString &encoderPort)
+{
+	createLazyDevice(motorPort);
+	PowerMotor * const motor = findDevice(mPowerMotors, motorPort);
+	EncoderInterface * const motorEncoder = encoder(encoderPort);
+	if (motor == nullptr || motorEncoder == nullptr) {
+		QLOG_ERROR() << "Can not create motor controller, no power motor" << motorPort << "or encoder" << encoderPort;
+		return nullptr;
+	}
+
+	MotorController *controller = mMotorControllers.value(motorPort, nullptr);
+	if (controller != nullptr && !controller->usesEncoder(*motorEncoder)) {
+		delete controller;
+		controller = nullptr;
+	}
+
+	if (controller == nullptr) {
+		controller = new MotorController(*motor, *motorEncoder, *mControlLoop, mConfigurer);
+		mMotorControllers.insert(motorPort, controller);
+	}
+
+	return controller;
+}
+
 EventDeviceInterface *Brick::eventDevice(const QString &deviceFile)
 {
 	if (!mEventDevices.contains(deviceFile)) {
@@ -480,48 +775,107 @@ void Brick::stopEventDevice(const QString &deviceFile)
 	}
 }
 
+MotorGroupInterface *Brick::motorGroup(const QStringList &ports)
+{
+	const QString key = ports.join(",");
+	MotorGroup *group = mMotorGroups.value(key, nullptr);
+	if (group != nullptr) {
+		return group;
+	}
+
+	QList<PowerMotor *> motors;
+	for (const QString &port : ports) {
+		createLazyDevice(port);
+		PowerMotor * const motor = findDevice(mPowerMotors, port);
+		if (motor == nullptr) {
+			QLOG_ERROR() << "Can not create motor group, no power motor" << port;
+			return nullptr;
+		}
+
+		motors.append(motor);
+	}
+
+	group = new MotorGroup(ports, motors, *mMspCommunicator);
+	mMotorGroups.insert(key, group);
+	return group;
+}
+
 void Brick::shutdownDevice(const QString &port)
 {
+	// Motor controllers refer to motors and encoders, so they shall not outlive them.
+	Encoder * const portEncoder = findDevice(mEncoders, port);
+	for (auto it = mMotorControllers.begin(); it != mMotorControllers.end(); ) {
+		if (it.key() == port || (portEncoder != nullptr && it.value()->usesEncoder(*portEncoder))) {
+			delete it.value();
+			it = mMotorControllers.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	for (auto it = mMotorGroups.begin(); it != mMotorGroups.end(); ) {
+		if (it.value()->hasPort(port)) {
+			delete it.value();
+			it = mMotorGroups.erase(it);
+		} else {
+			++it;
+		}
+	}
+
+	// Device is removed from collections before it is shut down, so other threads do not get it anymore.
 	const QString &deviceClass = mConfigurer.deviceClass(port);
 	if (deviceClass == "servoMotor") {
-		mServoMotors[port]->powerOff();
-		delete mServoMotors[port];
-		mServoMotors.remove(port);
+		ServoMotor * const servoMotor = takeDevice(mServoMotors, port);
+		if (servoMotor) {
+			servoMotor->powerOff();
+		}
+
+		delete servoMotor;
 	} else if (deviceClass == "pwmCapture") {
-		delete mPwmCaptures[port];
-		mPwmCaptures.remove(port);
+		delete takeDevice(mPwmCaptures, port);
 	} else if (deviceClass == "powerMotor") {
-		mPowerMotors[port]->powerOff();
-		delete mPowerMotors[port];
-		mPowerMotors.remove(port);
+		PowerMotor * const powerMotor = takeDevice(mPowerMotors, port);
+		if (powerMotor) {
+			powerMotor->powerOff();
+		}
+
+		delete powerMotor;
 	} else if (deviceClass == "analogSensor") {
-		delete mAnalogSensors[port];
-		mAnalogSensors.remove(port);
+		delete takeDevice(mAnalogSensors, port);
 	} else if (deviceClass == "digitalSensor") {
-		delete mDigitalSensors[port];
-		mDigitalSensors.remove(port);
+		delete takeDevice(mDigitalSensors, port);
 	} else if (deviceClass == "rangeSensor") {
-		mRangeSensors[port]->stop();
-		delete mRangeSensors[port];
-		mRangeSensors.remove(port);
+		RangeSensor * const rangeSensor = takeDevice(mRangeSensors, port);
+		if (rangeSensor) {
+			rangeSensor->stop();
+		}
+
+		delete rangeSensor;
 	} else if (deviceClass == "encoder") {
-		delete mEncoders[port];
-		mEncoders.remove(port);
+		delete takeDevice(mEncoders, port);
 	} else if (deviceClass == "lineSensor") {
-		mLineSensors[port]->stop();
-		delete mLineSensors[port];
-		mLineSensors.remove(port);
+		LineSensor * const lineSensor = takeDevice(mLineSensors, port);
+		if (lineSensor) {
+			lineSensor->stop();
+		}
+
+		delete lineSensor;
 	} else if (deviceClass == "objectSensor") {
-		mObjectSensors[port]->stop();
-		delete mObjectSensors[port];
-		mObjectSensors.remove(port);
+		ObjectSensor * const objectSensor = takeDevice(mObjectSensors, port);
+		if (objectSensor) {
+			objectSensor->stop();
+		}
+
+		delete objectSensor;
 	} else if (deviceClass == "colorSensor") {
-		mColorSensors[port]->stop();
-		delete mColorSensors[port];
-		mColorSensors.remove(port);
+		ColorSensor * const colorSensor = takeDevice(mColorSensors, port);
+		if (colorSensor) {
+			colorSensor->stop();
+		}
+
+		delete colorSensor;
 	} else if (deviceClass == "fifo") {
-		delete mFifos[port];
-		mFifos.remove(port);
+		delete takeDevice(mFifos, port);
 	}
 }
 
@@ -530,44 +884,50 @@ void Brick::createDevice(const QString &port)
 	try {
 		const QString &deviceClass = mConfigurer.deviceClass(port);
 		if (deviceClass == "servoMotor") {
-			mServoMotors.insert(port, new ServoMotor(port, mConfigurer, *mHardwareAbstraction));
+			insertDevice(mServoMotors, port, new ServoMotor(port, mConfigurer, *mHardwareAbstraction));
 		} else if (deviceClass == "pwmCapture") {
-			mPwmCaptures.insert(port, new PwmCapture(port, mConfigurer, *mHardwareAbstraction));
+			insertDevice(mPwmCaptures, port, new PwmCapture(port, mConfigurer, *mHardwareAbstraction));
 		} else if (deviceClass == "powerMotor") {
-			mPowerMotors.insert(port, new PowerMotor(port, mConfigurer, *mMspCommunicator));
+			insertDevice(mPowerMotors, port, new PowerMotor(port, mConfigurer, *mMspCommunicator));
 		} else if (deviceClass == "analogSensor") {
-			mAnalogSensors.insert(port, new AnalogSensor(port, mConfigurer, *mMspCommunicator));
+			insertDevice(mAnalogSensors, port, new AnalogSensor(port, mConfigurer, *mMspCommunicator));
 		} else if (deviceClass == "digitalSensor") {
-			mDigitalSensors.insert(port, new DigitalSensor(port, mConfigurer, *mHardwareAbstraction));
+			insertDevice(mDigitalSensors, port, new DigitalSensor(port, mConfigurer, *mHardwareAbstraction));
 		} else if (deviceClass == "rangeSensor") {
-			mRangeSensors.insert(port, new RangeSensor(port, mConfigurer, *mModuleLoader, *mHardwareAbstraction));
+			RangeSensor * const rangeSensor = new RangeSensor(port, mConfigurer, *mModuleLoader
+					, *mHardwareAbstraction);
 
 			/// @todo Range sensor shall be turned on only when needed.
-			mRangeSensors[port]->init();
+			rangeSensor->init();
+			insertDevice(mRangeSensors, port, rangeSensor);
 		} else if (deviceClass == "encoder") {
-			mEncoders.insert(port, new Encoder(port, mConfigurer, *mMspCommunicator));
+			insertDevice(mEncoders, port, new Encoder(port, mConfigurer, *mMspCommunicator, *mEncoderSampler));
 		} else if (deviceClass == "lineSensor") {
-			mLineSensors.insert(port, new LineSensor(port, mConfigurer, *mHardwareAbstraction));
+			LineSensor * const lineSensor = new LineSensor(port, mConfigurer, *mHardwareAbstraction);
 
 			/// @todo This will work only in case when there can be only one video sensor launched at a time.
-			connect(mLineSensors[port], SIGNAL(stopped()), this, SIGNAL(stopped()));
+			connect(lineSensor, SIGNAL(stopped()), this, SIGNAL(stopped()));
+			insertDevice(mLineSensors, port, lineSensor);
 		} else if (deviceClass == "objectSensor") {
-			mObjectSensors.insert(port, new ObjectSensor(port, mConfigurer, *mHardwareAbstraction));
+			ObjectSensor * const objectSensor = new ObjectSensor(port, mConfigurer, *mHardwareAbstraction);
 
 			/// @todo This will work only in case when there can be only one video sensor launched at a time.
-			connect(mObjectSensors[port], SIGNAL(stopped()), this, SIGNAL(stopped()));
+			connect(objectSensor, SIGNAL(stopped()), this, SIGNAL(stopped()));
+			insertDevice(mObjectSensors, port, objectSensor);
 		} else if (deviceClass == "colorSensor") {
-			mColorSensors.insert(port, new ColorSensor(port, mConfigurer, *mHardwareAbstraction));
+			ColorSensor * const colorSensor = new ColorSensor(port, mConfigurer, *mHardwareAbstraction);
 
 			/// @todo This will work only in case when there can be only one video sensor launched at a time.
-			connect(mColorSensors[port], SIGNAL(stopped()), this, SIGNAL(stopped()));
+			connect(colorSensor, SIGNAL(stopped()), this, SIGNAL(stopped()));
+			insertDevice(mColorSensors, port, colorSensor);
 		} else if (deviceClass == "soundSensor") {
-			mSoundSensors.insert(port, new SoundSensor(port, mConfigurer, *mHardwareAbstraction));
+			SoundSensor * const soundSensor = new SoundSensor(port, mConfigurer, *mHardwareAbstraction);
 
 			/// @todo This will work only in case when there can be only one sound sensor launched at a time.
-			connect(mSoundSensors[port], SIGNAL(stopped()), this, SIGNAL(stopped()));
+			connect(soundSensor, SIGNAL(stopped()), this, SIGNAL(stopped()));
+			insertDevice(mSoundSensors, port, soundSensor);
 		} else if (deviceClass == "fifo") {
-			mFifos.insert(port, new Fifo(port, mConfigurer, *mHardwareAbstraction));
+			insertDevice(mFifos, port, new Fifo(port, mConfigurer, *mHardwareAbstraction));
 		} else if (deviceClass == "camera") {
 			QScopedPointer<CameraDeviceInterface> tmp (
 						new CameraDevice(mMediaPath, mConfigurer, *mHardwareAbstraction)
@@ -579,3 +939,45 @@ void Brick::createDevice(const QString &port)
 		QLOG_ERROR() << "Ignoring device";
 	}
 }
+
+void Brick::createLazyDevice(const QString &port)
+{
+	if (mLazyPortsCount.load() == 0) {
+		return;
+	}
+
+	QMutexLocker locker(&mLazyPortsLock);
+	if (!mLazyPorts.contains(port)) {
+		return;
+	}
+
+	QElapsedTimer timer;
+	timer.start();
+	createDevice(port);
+	mLazyPorts.remove(port);
+	mLazyPortsCount.store(mLazyPorts.size());
+
+	mInitializationReport << QString("port %1: created on first access, took %2 ms").arg(port).arg(timer.elapsed());
+	QLOG_INFO() << mInitializationReport.last();
+}
+
+bool Brick::removeLazyPort(const QString &port)
+{
+	QMutexLocker locker(&mLazyPortsLock);
+	const bool result = mLazyPorts.remove(port) > 0;
+	mLazyPortsCount.store(mLazyPorts.size());
+	return result;
+}
+
+QStringList Brick::lazyPorts(const QStringList &deviceClasses) const
+{
+	QMutexLocker locker(&mLazyPortsLock);
+	QStringList result;
+	for (auto it = mLazyPorts.constBegin(); it != mLazyPorts.constEnd(); ++it) {
+		if (deviceClasses.contains(it.value())) {
+			result << it.key();
+		}
+	}
+
+	return result;
+}
@@ -14,8 +14,12 @@
 
 #pragma once
 
+#include <QtCore/QAtomicInt>
 #include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QReadWriteLock>
 #include <QtCore/QScopedPointer>
+#include <QtCore/QVector>
 
 #include <trikKernel/configurer.h>
 #include <trikKernel/differentOwnerPointer.h>
@@ -31,9 +35,11 @@ namespace trikControl {
 class AnalogSensor;
 class Battery;
 class ColorSensor;
+class ControlLoop;
 class DigitalSensor;
 class Display;
 class Encoder;
+class EncoderSampler;
 class EventDevice;
 class Fifo;
 class Gamepad;
@@ -43,12 +49,15 @@ class Keys;
 class Led;
 class LineSensor;
 class ModuleLoader;
+class MotorController;
+class MotorGroup;
 class ObjectSensor;
 class SoundSensor;
 class PowerMotor;
 class PwmCapture;
 class RangeSensor;
 class ServoMotor;
+class SharedStatePublisher;
 class TonePlayer;
 class VectorSensor;
 class CameraDeviceInterface;
@@ -56,6 +65,8 @@ class I2cCommunicator;
 
 /// Class representing TRIK controller board and devices installed on it, also provides access
 /// to peripherals like motors and sensors.
+/// Devices are created in parallel when brick is constructed; devices of classes with "lazy" attribute set to "true"
+/// are created on first access to their ports instead.
 /// Is NOT thread-safe.
 class /* TRIKCONTROL_EXPORT for ScriptRunner/PythonQt */ TRIKCONTROL_EXPORT Brick : public BrickInterface
 {
@@ -84,6 +95,10 @@ public:
 
 	QString configVersion() const override;
 
+	QString initializationReport() const override;
+
+	void readAll(const QVector<int> &handles, int *values, bool rawData = false) override;
+
 public slots:
 	void configure(const QString &portName, const QString &deviceName) override;
 
@@ -109,6 +124,12 @@ public slots:
 
 	QStringList encoderPorts() const override;
 
+	int handle(const QString &port) override;
+
+	int read(int handle) override;
+
+	QVector<int> readAll(const QVector<int> &handles) override;
+
 	VectorSensorInterface *accelerometer() override;
 
 	GyroSensorInterface *gyroscope() override;
@@ -141,6 +162,12 @@ public slots:
 
 	MarkerInterface *marker() override;
 
+	ControlLoopInterface *controlLoop() override;
+
+	MotorControllerInterface *motorController(const QString &motorPort, const QString &encoderPort) override;
+
+	MotorGroupInterface *motorGroup(const QStringList &ports) override;
+
 	EventDeviceInterface *eventDevice(const QString &deviceFile) override;
 
 	void stopEventDevice(const QString &deviceFile) override;
@@ -154,9 +181,54 @@ private:
 	/// Deinitializes and properly shuts down device on a given port.
 	void shutdownDevice(const QString &port);
 
-	/// Creates and configures a device on a given port.
+	/// Creates and configures a device on a given port. Can be called from any thread.
 	void createDevice(const QString &port);
 
+	/// Moves an object created by a parallel initialization task to the brick thread.
+	template<typename T>
+	T *inBrickThread(T *object);
+
+	/// Moves a device to the brick thread and adds it to a given collection.
+	template<typename T>
+	void insertDevice(QHash<QString, T *> &devices, const QString &port, T *device);
+
+	/// Removes a device from a given collection and returns it, or nullptr if there is no device on a given port.
+	template<typename T>
+	T *takeDevice(QHash<QString, T *> &devices, const QString &port);
+
+	/// Returns a device from a given collection, or nullptr if there is no device on a given port.
+	template<typename T>
+	T *findDevice(const QHash<QString, T *> &devices, const QString &port) const;
+
+	/// Returns a copy of a given collection, to iterate over devices without a lock.
+	template<typename T>
+	QList<T *> devicesList(const QHash<QString, T *> &devices) const;
+
+	/// Returns ports of devices in a given collection.
+	template<typename T>
+	QStringList devicePorts(const QHash<QString, T *> &devices) const;
+
+	/// Creates a device on a given port if it is lazy and not created yet.
+	void createLazyDevice(const QString &port);
+
+	/// Forgets a lazy port that is not created yet, returns false if there was no such port.
+	bool removeLazyPort(const QString &port);
+
+	/// Returns lazy ports that are not created yet and have devices of given classes.
+	QStringList lazyPorts(const QStringList &deviceClasses) const;
+
+	/// Makes handle of a given port, if there is one, point to no device, so it is read as 0.
+	void invalidateHandle(const QString &port);
+
+	/// Points handle of a given port, if there is one, to a device currently configured on this port.
+	void updateHandle(const QString &port);
+
+	/// Sensor or encoder resolved by handle() call.
+	struct PortHandle {
+		SensorInterface *sensor;
+		EncoderInterface *encoder;
+	};
+
 	/// Hardware absraction object that is used to provide communication with real robot hardware or to simulate it.
 	/// Has or hasn't ownership depending on whether it was created by Brick itself or passed from outside.
 	trikKernel::DifferentOwnerPointer<trikHal::HardwareAbstractionInterface> mHardwareAbstraction;
@@ -173,6 +245,9 @@ private:
 	QScopedPointer<Gamepad> mGamepad;
 	QScopedPointer<TonePlayer> mTonePlayer;
 	QScopedPointer<CameraDeviceInterface> mCamera;
+	QScopedPointer<ControlLoop> mControlLoop;
+	QScopedPointer<EncoderSampler> mEncoderSampler;
+	QScopedPointer<SharedStatePublisher> mSharedState;
 
 	QHash<QString, ServoMotor *> mServoMotors;  // Has ownership.
 	QHash<QString, PwmCapture *> mPwmCaptures;  // Has ownership.
@@ -188,6 +263,32 @@ private:
 	QHash<QString, Fifo *> mFifos;  // Has ownership.
 	QHash<QString, EventDeviceInterface *> mEventDevices;  // Has ownership.
 	QHash<uint16_t, I2cDeviceInterface *> mI2cDevices;  // Has ownership.
+	QHash<QString, MotorController *> mMotorControllers;  // Has ownership, indexed by motor port.
+	QHash<QString, MotorGroup *> mMotorGroups;  // Has ownership, indexed by comma-separated ports.
+
+	/// Handles given by handle(), indexed by handle.
+	QVector<PortHandle> mHandles;
+
+	/// Maps port name to its handle.
+	QHash<QString, int> mPortHandles;
+
+	/// Guards handles, since they are used from different threads.
+	QReadWriteLock mHandlesLock;
+
+	/// Guards collections of devices, since devices are created in parallel and lazy devices are created on first
+	/// access from any thread. Destructor does not take it, all other accesses do.
+	mutable QReadWriteLock mDevicesLock;
+
+	/// Lazy ports that are not created yet, mapped to device classes.
+	QHash<QString, QString> mLazyPorts;
+
+	/// Size of mLazyPorts, to skip locking when all lazy devices are created.
+	QAtomicInt mLazyPortsCount;
+
+	mutable QMutex mLazyPortsLock;
+
+	/// Startup timings of devices, filled by constructor and by creation of lazy devices.
+	QStringList mInitializationReport;
 
 	QString mPlayWavFileCommand;
 	QString mPlayMp3FileCommand;
@@ -0,0 +1,400 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "controlLoop.h"
+
+#include <chrono>
+#include <thread>
+
+#include <QtCore/QVector>
+
+#ifdef Q_OS_LINUX
+	#include <pthread.h>
+	#include <sched.h>
+	#include <string.h>
+	#include <time.h>
+	#include <errno.h>
+#endif
+
+#include <trikKernel/configurer.h>
+#include <QsLog.h>
+
+#include "brickInterface.h"
+
+using namespace trikControl;
+
+typedef std::chrono::steady_clock Clock;
+
+static const int defaultRate = 100;
+static const int maxRate = 10000;
+
+/// Limit of motor power set by built-in PID controller.
+static const qreal maxPower = 100;
+
+/// Thread that runs ControlLoop::run().
+class ControlLoop::LoopThread : public QThread
+{
+public:
+	explicit LoopThread(ControlLoop &loop)
+		: mLoop(loop)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		mLoop.run();
+	}
+
+private:
+	ControlLoop &mLoop;
+};
+
+namespace {
+
+/// Built-in PID controller keeping encoder reading at setpoint by motor power. Integral is limited so that integral
+/// term alone never exceeds full power, to avoid windup while motor is saturated.
+class PidController
+{
+public:
+	PidController(EncoderInterface &encoder, MotorInterface &motor, qreal kp, qreal ki, qreal kd)
+		: mEncoder(encoder)
+		, mMotor(motor)
+		, mKp(kp)
+		, mKi(ki)
+		, mKd(kd)
+	{
+	}
+
+	void operator()(qreal setpoint, qreal dt)
+	{
+		const qreal error = setpoint - mEncoder.read();
+		if (mKi != 0) {
+			const qreal integralLimit = maxPower / qAbs(mKi);
+			mIntegral = qBound(-integralLimit, mIntegral + error * dt, integralLimit);
+		}
+
+		const qreal derivative = mHasPreviousError && dt > 0 ? (error - mPreviousError) / dt : 0;
+		mPreviousError = error;
+		mHasPreviousError = true;
+
+		const qreal power = qBound(-maxPower, mKp * error + mKi * mIntegral + mKd * derivative, maxPower);
+		mMotor.setPower(qRound(power));
+	}
+
+private:
+	EncoderInterface &mEncoder;
+	MotorInterface &mMotor;
+	const qreal mKp;
+	const qreal mKi;
+	const qreal mKd;
+	qreal mIntegral = 0;
+	qreal mPreviousError = 0;
+	bool mHasPreviousError = false;
+};
+
+}
+
+/// Sleeps until given moment of steady clock.
+static void sleepUntil(const Clock::time_point &time)
+{
+#ifdef Q_OS_LINUX
+	// Steady clock is CLOCK_MONOTONIC, absolute sleep does not accumulate errors of computing relative intervals.
+	const qint64 nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time.time_since_epoch()).count();
+	timespec deadline;
+	deadline.tv_sec = static_cast<time_t>(nanoseconds / 1000000000);
+	deadline.tv_nsec = static_cast<long>(nanoseconds % 1000000000);
+	while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, nullptr) == EINTR) {
+	}
+#else
+	std::this_thread::sleep_until(time);
+#endif
+}
+
+static qint64 toNanoseconds(const Clock::duration &duration)
+{
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count();
+}
+
+ControlLoop::ControlLoop(const trikKernel::Configurer &configurer, BrickInterface &brick)
+	: mBrick(brick)
+	, mRate(configurer.hasAttributeByDevice("controlLoop", "rate")
+			? configurer.attributeByDevice("controlLoop", "rate").toInt() : defaultRate)
+	, mPriority(configurer.hasAttributeByDevice("controlLoop", "priority")
+			? configurer.attributeByDevice("controlLoop", "priority").toInt() : 0)
+{
+	if (mRate <= 0 || mRate > maxRate) {
+		QLOG_ERROR() << "Incorrect control loop rate" << mRate << ", using" << defaultRate;
+		mRate = defaultRate;
+	}
+}
+
+ControlLoop::~ControlLoop()
+{
+	clear();
+}
+
+int ControlLoop::addController(const Step &step)
+{
+	int id = 0;
+	{
+		QMutexLocker locker(&mLock);
+		id = mNextId++;
+		mControllers.insert(id, QSharedPointer<Controller>(new Controller{step, 0, 0}));
+	}
+
+	startThread();
+	return id;
+}
+
+int ControlLoop::addPid(const QString &encoderPort, const QString &motorPort, qreal kp, qreal ki, qreal kd)
+{
+	EncoderInterface * const encoder = mBrick.encoder(encoderPort);
+	MotorInterface * const motor = mBrick.motor(motorPort);
+	if (encoder == nullptr || motor == nullptr) {
+		QLOG_ERROR() << "Can not add PID controller, no encoder" << encoderPort << "or motor" << motorPort;
+		return -1;
+	}
+
+	return addController(PidController(*encoder, *motor, kp, ki, kd));
+}
+
+void ControlLoop::setSetpoint(int controller, qreal setpoint)
+{
+	QMutexLocker locker(&mLock);
+	const auto it = mControllers.find(controller);
+	if (it != mControllers.end()) {
+		it.value()->setpoint = setpoint;
+	}
+}
+
+void ControlLoop::removeController(int controller)
+{
+	bool isEmpty = false;
+	{
+		QMutexLocker locker(&mLock);
+		const auto it = mControllers.find(controller);
+		if (it != mControllers.end()) {
+			it.value()->removed.store(1);
+			mControllers.erase(it);
+		}
+
+		isEmpty = mControllers.isEmpty();
+	}
+
+	if (isEmpty) {
+		stopThread();
+	} else if (!isLoopThread()) {
+		// Waiting for current cycle, next one will not call removed controller. Controller which removes other one
+		// is itself in the current cycle, so it does not wait, and removed controller is skipped by its flag.
+		QMutexLocker cycleLocker(&mCycleLock);
+	}
+}
+
+void ControlLoop::clear()
+{
+	{
+		QMutexLocker locker(&mLock);
+		for (const QSharedPointer<Controller> &controller : mControllers) {
+			controller->removed.store(1);
+		}
+
+		mControllers.clear();
+	}
+
+	stopThread();
+}
+
+int ControlLoop::rate() const
+{
+	QMutexLocker locker(&mLock);
+	return mRate;
+}
+
+void ControlLoop::setRate(int rate)
+{
+	if (rate <= 0 || rate > maxRate) {
+		QLOG_ERROR() << "Incorrect control loop rate" << rate << ", ignoring";
+		return;
+	}
+
+	QMutexLocker locker(&mLock);
+	mRate = rate;
+}
+
+QVariantMap ControlLoop::statistics() const
+{
+	QMutexLocker locker(&mLock);
+	QVariantMap result;
+	result["cycles"] = mStatistics.cycles;
+	result["missed"] = mStatistics.missed;
+	result["maxJitter"] = mStatistics.maxJitter / 1000;
+	result["meanJitter"] = mStatistics.cycles > 0
+			? static_cast<qint64>(mStatistics.totalJitter / mStatistics.cycles / 1000) : 0;
+	result["maxStep"] = mStatistics.maxStep / 1000;
+	result["maxOverrun"] = mStatistics.maxOverrun / 1000;
+	result["realtime"] = mRealtime;
+	return result;
+}
+
+void ControlLoop::resetStatistics()
+{
+	QMutexLocker locker(&mLock);
+	mStatistics = Statistics();
+}
+
+void ControlLoop::startThread()
+{
+	if (isLoopThread()) {
+		// Controller added by a controller, thread is running, but may have been asked to stop in this cycle.
+		mStopRequested.store(0);
+		return;
+	}
+
+	QMutexLocker locker(&mThreadLock);
+	if (mThread) {
+		if (mStopRequested.load() == 0) {
+			return;
+		}
+
+		// Thread was stopped by its own controller and is finishing or finished.
+		mThread->wait();
+	}
+
+	mStopRequested.store(0);
+	mThread.reset(new LoopThread(*this));
+	mThread->start();
+}
+
+void ControlLoop::stopThread()
+{
+	if (isLoopThread()) {
+		// Loop thread can not wait for itself, and mThreadLock may be held by other thread which waits for it. Thread
+		// is joined by the next startThread() or stopThread().
+		QMutexLocker controllersLocker(&mLock);
+		if (mControllers.isEmpty()) {
+			mStopRequested.store(1);
+		}
+
+		return;
+	}
+
+	QMutexLocker locker(&mThreadLock);
+	if (!mThread) {
+		return;
+	}
+
+	{
+		// Controller may be added concurrently, then the thread shall keep running.
+		QMutexLocker controllersLocker(&mLock);
+		if (!mControllers.isEmpty()) {
+			return;
+		}
+	}
+
+	mStopRequested.store(1);
+	mThread->wait();
+	mThread.reset();
+}
+
+bool ControlLoop::isLoopThread() const
+{
+	return mRunningThread.load() == QThread::currentThread();
+}
+
+void ControlLoop::run()
+{
+	mRunningThread.store(QThread::currentThread());
+
+	bool realtime = false;
+#ifdef Q_OS_LINUX
+	if (mPriority > 0) {
+		sched_param parameters;
+		parameters.sched_priority = mPriority;
+		const int result = pthread_setschedparam(pthread_self(), SCHED_FIFO, &parameters);
+		if (result == 0) {
+			realtime = true;
+		} else {
+			QLOG_WARN() << "Can not set real-time priority" << mPriority << "of control loop:" << strerror(result);
+		}
+	}
+#endif
+
+	{
+		QMutexLocker locker(&mLock);
+		mRealtime = realtime;
+	}
+
+	QVector<QPair<QSharedPointer<Controller>, qreal>> cycle;
+	Clock::time_point deadline = Clock::now();
+	Clock::time_point previousStart = deadline;
+	Clock::duration period;
+	{
+		QMutexLocker locker(&mLock);
+		period = std::chrono::nanoseconds(1000000000 / mRate);
+	}
+
+	while (mStopRequested.load() == 0) {
+		deadline += period;
+		sleepUntil(deadline);
+
+		QMutexLocker cycleLocker(&mCycleLock);
+		if (mStopRequested.load() != 0) {
+			break;
+		}
+
+		cycle.clear();
+		{
+			QMutexLocker locker(&mLock);
+			for (const QSharedPointer<Controller> &controller : mControllers) {
+				cycle.append({controller, controller->setpoint});
+			}
+		}
+
+		const Clock::time_point start = Clock::now();
+		const qreal dt = toNanoseconds(start - previousStart) / 1e9;
+		previousStart = start;
+
+		for (const auto &controller : cycle) {
+			if (controller.first->removed.load() == 0) {
+				controller.first->step(controller.second, dt);
+			}
+		}
+
+		cycleLocker.unlock();
+
+		const Clock::time_point end = Clock::now();
+		const Clock::time_point nextDeadline = deadline + period;
+		const qint64 jitter = toNanoseconds(start - deadline);
+		const qint64 step = toNanoseconds(end - start);
+
+		QMutexLocker locker(&mLock);
+		++mStatistics.cycles;
+		mStatistics.totalJitter += jitter;
+		mStatistics.maxJitter = qMax(mStatistics.maxJitter, jitter);
+		mStatistics.maxStep = qMax(mStatistics.maxStep, step);
+
+		// Rate change takes effect from the next cycle.
+		period = std::chrono::nanoseconds(1000000000 / mRate);
+
+		if (end > nextDeadline) {
+			// Deadline is missed, next cycle starts right away without catching up, and schedule continues from it.
+			++mStatistics.missed;
+			mStatistics.maxOverrun = qMax(mStatistics.maxOverrun, toNanoseconds(end - nextDeadline));
+			deadline = end - period;
+		}
+	}
+
+	mRunningThread.store(nullptr);
+}
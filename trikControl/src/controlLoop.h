@@ -0,0 +1,129 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QAtomicPointer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+
+#include "controlLoopInterface.h"
+
+namespace trikKernel {
+class Configurer;
+}
+
+namespace trikControl {
+
+class BrickInterface;
+
+/// Implementation of control loop executor. Rate and real-time priority of a loop thread are configured by "rate" and
+/// "priority" attributes of "controlLoop" device class in system config, priority 0 means normal scheduling.
+class ControlLoop : public ControlLoopInterface
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.
+	/// @param configurer - configurer object containing preparsed XML files with loop parameters.
+	/// @param brick - brick which provides encoders and motors for built-in controllers.
+	ControlLoop(const trikKernel::Configurer &configurer, BrickInterface &brick);
+
+	~ControlLoop() override;
+
+	int addController(const Step &step) override;
+
+public slots:
+	int addPid(const QString &encoderPort, const QString &motorPort, qreal kp, qreal ki, qreal kd) override;
+
+	void setSetpoint(int controller, qreal setpoint) override;
+
+	void removeController(int controller) override;
+
+	void clear() override;
+
+	int rate() const override;
+
+	void setRate(int rate) override;
+
+	QVariantMap statistics() const override;
+
+	void resetStatistics() override;
+
+private:
+	class LoopThread;
+
+	struct Controller {
+		Step step;
+		qreal setpoint;
+
+		/// Set when controller is removed, so it is not called even in a cycle which has already started.
+		QAtomicInt removed;
+	};
+
+	/// Timing of the loop, in nanoseconds.
+	struct Statistics {
+		quint64 cycles = 0;
+		quint64 missed = 0;
+		qint64 maxJitter = 0;
+		qint64 totalJitter = 0;
+		qint64 maxStep = 0;
+		qint64 maxOverrun = 0;
+	};
+
+	/// Body of the loop thread.
+	void run();
+
+	/// Starts the loop thread if it is not running.
+	void startThread();
+
+	/// Stops the loop thread if there are no controllers and waits for it to finish. When called from the loop
+	/// thread, only requests it to stop after the current cycle.
+	void stopThread();
+
+	/// Returns true if called from a controller, i.e. in the loop thread.
+	bool isLoopThread() const;
+
+	BrickInterface &mBrick;
+
+	/// Controllers by their ids.
+	QHash<int, QSharedPointer<Controller>> mControllers;
+	int mNextId = 0;
+
+	int mRate;
+	const int mPriority;
+	Statistics mStatistics;
+	bool mRealtime = false;
+
+	/// Guards controllers, setpoints, rate and statistics. Held only for a short time, never during controller steps.
+	mutable QMutex mLock;
+
+	/// Held by the loop thread while controllers are called, so removed controllers are not called after removal.
+	QMutex mCycleLock;
+
+	/// Guards start and stop of the loop thread.
+	QMutex mThreadLock;
+
+	QScopedPointer<QThread> mThread;
+	QAtomicInt mStopRequested;
+
+	/// Thread which runs the loop now, or nullptr. Unlike mThread, can be read without mThreadLock.
+	QAtomicPointer<QThread> mRunningThread;
+};
+
+}
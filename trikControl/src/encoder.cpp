@@ -19,11 +19,14 @@
 
 #include "mspI2cCommunicator.h"
 #include "configurerHelper.h"
+#include "encoderSampler.h"
 
 using namespace trikControl;
 
-Encoder::Encoder(const QString &port, const trikKernel::Configurer &configurer, MspCommunicatorInterface &communicator)
+Encoder::Encoder(const QString &port, const trikKernel::Configurer &configurer, MspCommunicatorInterface &communicator
+		, EncoderSampler &sampler)
 	: mCommunicator(communicator)
+	, mSampler(sampler)
 	, mInvert(configurer.attributeByPort(port, "invert") == "false")
 	, mState("Encoder on" + port)
 {
@@ -39,15 +42,16 @@ Encoder::Encoder(const QString &port, const trikKernel::Configurer &configurer,
 	mState.ready();
 }
 
+Encoder::~Encoder()
+{
+	mSampler.remove(*this);
+}
+
 void Encoder::reset()
 {
 	if (status() == DeviceInterface::Status::ready) {
-		QByteArray command(3, '\0');
-		command[0] = static_cast<char>(mI2cCommandNumber & 0xFF);
-		command[1] = static_cast<char>((mI2cCommandNumber >> 8) & 0xFF);
-		command[2] = static_cast<char>(0x00);
-
-		mCommunicator.send(command);
+		mCommunicator.send(resetCommand());
+		mSampler.restart(*this);
 	}
 }
 
@@ -56,21 +60,58 @@ Encoder::Status Encoder::status() const
 	return combine(mCommunicator, mState.status());
 }
 
+MspCommunicatorInterface &Encoder::communicator()
+{
+	return mCommunicator;
+}
+
+QByteArray Encoder::readCommand() const
+{
+	// Read request is the same register write command, but sent through read(), so payload is ignored.
+	return resetCommand();
+}
+
+qreal Encoder::toDegrees(int rawData) const
+{
+	return static_cast<qreal>(rawData) * mPassedDegrees / mPassedTicks * (mInvert ? -1 : 1);
+}
+
 int Encoder::read()
 {
 	return readRawData() * mPassedDegrees / mPassedTicks * (mInvert ? -1 : 1);
 }
 
+QByteArray Encoder::resetCommand() const
+{
+	QByteArray command(3, '\0');
+	command[0] = static_cast<char>(mI2cCommandNumber & 0xFF);
+	command[1] = static_cast<char>((mI2cCommandNumber >> 8) & 0xFF);
+
+	// New value of encoder register.
+	command[2] = static_cast<char>(0x00);
+	return command;
+}
+
 int Encoder::readRawData()
 {
 	if (status() == DeviceInterface::Status::ready) {
-		QByteArray command(3, '\0');
-		command[0] = static_cast<char>(mI2cCommandNumber & 0xFF);
-		command[1] = static_cast<char>((mI2cCommandNumber >> 8) & 0xFF);
-		command[2] = static_cast<char>(0x00);
-
-		return mCommunicator.read(command);
+		return mCommunicator.read(readCommand());
 	} else {
 		return 0;
 	}
 }
+
+qreal Encoder::readSpeed()
+{
+	return status() == DeviceInterface::Status::ready ? mSampler.last(*this).speed : 0;
+}
+
+qreal Encoder::readAcceleration()
+{
+	return status() == DeviceInterface::Status::ready ? mSampler.last(*this).acceleration : 0;
+}
+
+QVariantList Encoder::history(int count)
+{
+	return status() == DeviceInterface::Status::ready ? mSampler.history(*this, count) : QVariantList();
+}
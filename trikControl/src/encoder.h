@@ -24,6 +24,7 @@ class Configurer;
 
 namespace trikControl {
 
+class EncoderSampler;
 class MspCommunicatorInterface;
 
 /// Implementation of encoder for real robot.
@@ -36,11 +37,23 @@ public:
 	/// @param port - port on which this encoder is configured.
 	/// @param configurer - configurer object containing preparsed XML files with encoder parameters.
 	/// @param communicator - I2C communicator to use to query encoder.
+	/// @param sampler - sampler which estimates speed and keeps history of encoder readings.
 	Encoder(const QString &port, const trikKernel::Configurer &configurer
-			, trikControl::MspCommunicatorInterface &communicator);
+			, trikControl::MspCommunicatorInterface &communicator, EncoderSampler &sampler);
+
+	~Encoder() override;
 
 	Status status() const override;
 
+	/// Returns MSP communicator used to query encoder.
+	MspCommunicatorInterface &communicator();
+
+	/// Returns MSP command which reads raw data of encoder.
+	QByteArray readCommand() const;
+
+	/// Converts raw data of encoder to degrees.
+	qreal toDegrees(int rawData) const;
+
 public slots:
 	int read() override;
 
@@ -48,8 +61,18 @@ public slots:
 
 	void reset() override;
 
+	qreal readSpeed() override;
+
+	qreal readAcceleration() override;
+
+	QVariantList history(int count) override;
+
 private:
+	/// Returns MSP command which resets encoder by writing zero to its register.
+	QByteArray resetCommand() const;
+
 	MspCommunicatorInterface &mCommunicator;
+	EncoderSampler &mSampler;
 	int mI2cCommandNumber;
 	int mPassedTicks;
 	int mPassedDegrees;
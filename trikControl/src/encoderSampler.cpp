@@ -0,0 +1,198 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "encoderSampler.h"
+
+#include <trikKernel/configurer.h>
+#include <QsLog.h>
+
+#include "controlLoopInterface.h"
+#include "encoder.h"
+#include "mspCommunicatorInterface.h"
+
+using namespace trikControl;
+
+/// Reads parameter of encoder sampler, or returns default value if it is not configured.
+static qreal parameter(const trikKernel::Configurer &configurer, const QString &name, qreal defaultValue)
+{
+	return configurer.hasAttributeByDevice("encoderSampler", name)
+			? configurer.attributeByDevice("encoderSampler", name).toDouble()
+			: defaultValue;
+}
+
+EncoderSampler::EncoderSampler(const trikKernel::Configurer &configurer, ControlLoopInterface &loop)
+	: mLoop(loop)
+	, mFilterTime(qMax(0.0, parameter(configurer, "speedFilterTime", 0.05)))
+	, mHistorySize(qMax(2, static_cast<int>(parameter(configurer, "historySize", 256))))
+{
+}
+
+EncoderSampler::~EncoderSampler()
+{
+	clear();
+}
+
+EncoderSampler::Sample EncoderSampler::last(Encoder &encoder)
+{
+	Sample result;
+	{
+		QMutexLocker locker(&mLock);
+		const Entry &sampled = entry(encoder);
+		if (sampled.size > 0) {
+			result = sampled.history[(sampled.head + mHistorySize - 1) % mHistorySize];
+		}
+	}
+
+	updateRegistration();
+	return result;
+}
+
+QVariantList EncoderSampler::history(Encoder &encoder, int count)
+{
+	QVariantList result;
+	{
+		QMutexLocker locker(&mLock);
+		const Entry &sampled = entry(encoder);
+		const int size = qBound(0, count, sampled.size);
+		for (int i = size; i > 0; --i) {
+			const Sample &sample = sampled.history[(sampled.head + mHistorySize - i) % mHistorySize];
+			result.append(QVariantMap{
+					{"time", sample.time}
+					, {"position", sample.position}
+					, {"speed", sample.speed}
+					, {"acceleration", sample.acceleration}
+			});
+		}
+	}
+
+	updateRegistration();
+	return result;
+}
+
+void EncoderSampler::restart(const Encoder &encoder)
+{
+	QMutexLocker locker(&mLock);
+	if (mEntries.contains(&encoder)) {
+		mEntries[&encoder].size = 0;
+	}
+}
+
+void EncoderSampler::remove(const Encoder &encoder)
+{
+	{
+		QMutexLocker locker(&mLock);
+		mEntries.remove(&encoder);
+	}
+
+	updateRegistration();
+}
+
+void EncoderSampler::clear()
+{
+	{
+		QMutexLocker locker(&mLock);
+		mEntries.clear();
+	}
+
+	updateRegistration();
+}
+
+EncoderSampler::Entry &EncoderSampler::entry(Encoder &encoder)
+{
+	auto it = mEntries.find(&encoder);
+	if (it == mEntries.end()) {
+		Entry newEntry;
+		newEntry.encoder = &encoder;
+		newEntry.history.resize(mHistorySize);
+		it = mEntries.insert(&encoder, newEntry);
+	}
+
+	return it.value();
+}
+
+void EncoderSampler::updateRegistration()
+{
+	// Control loop waits for a cycle to finish when sampler is removed, and the cycle takes mLock, so mLock shall not
+	// be held here for longer than it takes to check entries.
+	QMutexLocker registrationLocker(&mRegistrationLock);
+	bool isEmpty = true;
+	{
+		QMutexLocker locker(&mLock);
+		isEmpty = mEntries.isEmpty();
+	}
+
+	if (!isEmpty && mControllerId == -1) {
+		mControllerId = mLoop.addController([this](qreal, qreal) { sweep(); });
+	} else if (isEmpty && mControllerId != -1) {
+		mLoop.removeController(mControllerId);
+		mControllerId = -1;
+	}
+}
+
+void EncoderSampler::sweep()
+{
+	QMutexLocker locker(&mLock);
+
+	// Encoders are usually connected to one communicator, but are grouped anyway to read each bus in one burst.
+	QHash<MspCommunicatorInterface *, QVector<Entry *>> entriesByCommunicator;
+	for (Entry &sampled : mEntries) {
+		if (sampled.encoder->status() == DeviceInterface::Status::ready) {
+			entriesByCommunicator[&sampled.encoder->communicator()].append(&sampled);
+		}
+	}
+
+	for (auto it = entriesByCommunicator.begin(); it != entriesByCommunicator.end(); ++it) {
+		QVector<QByteArray> commands;
+		commands.reserve(it.value().size());
+		for (const Entry * const sampled : it.value()) {
+			commands.append(sampled->encoder->readCommand());
+		}
+
+		QVector<qint64> times;
+		const QVector<int> readings = it.key()->readBurst(commands, times);
+		if (readings.size() != commands.size() || times.size() != commands.size()) {
+			continue;
+		}
+
+		for (int i = 0; i < readings.size(); ++i) {
+			Entry &sampled = *it.value()[i];
+			addSample(sampled, times[i], sampled.encoder->toDegrees(readings[i]));
+		}
+	}
+}
+
+void EncoderSampler::addSample(Entry &entry, qint64 time, qreal position)
+{
+	Sample sample;
+	sample.time = time;
+	sample.position = position;
+
+	if (entry.size > 0) {
+		const Sample &previous = entry.history[(entry.head + mHistorySize - 1) % mHistorySize];
+		const qreal dt = (time - previous.time) / 1000000.0;
+		if (dt <= 0) {
+			return;
+		}
+
+		// First-order low-pass filters of differences, discretized for a varying sampling period.
+		const qreal alpha = dt / (mFilterTime + dt);
+		sample.speed = previous.speed + alpha * ((position - previous.position) / dt - previous.speed);
+		sample.acceleration = previous.acceleration
+				+ alpha * ((sample.speed - previous.speed) / dt - previous.acceleration);
+	}
+
+	entry.history[entry.head] = sample;
+	entry.head = (entry.head + 1) % mHistorySize;
+	entry.size = qMin(entry.size + 1, mHistorySize);
+}
@@ -0,0 +1,113 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QVariantList>
+#include <QtCore/QVector>
+
+namespace trikKernel {
+class Configurer;
+}
+
+namespace trikControl {
+
+class ControlLoopInterface;
+class Encoder;
+
+/// Samples encoders in every cycle of a control loop, reading all of them in one burst of bus commands. Every sample
+/// is timestamped by the time its command was sent, speed and acceleration are estimated from samples by low-pass
+/// filtered differences, and last samples are kept in a ring for history queries.
+/// Encoder is sampled from its first speed or history query until it is removed or sampler is cleared.
+/// Parameters are "speedFilterTime" (time constant of filters, in seconds) and "historySize" (number of samples
+/// kept for every encoder) attributes of "encoderSampler" device class in system config.
+class EncoderSampler
+{
+public:
+	/// Sample of an encoder.
+	struct Sample {
+		/// Time of reading, in microseconds of monotonic clock.
+		qint64 time = 0;
+
+		/// Position in degrees.
+		qreal position = 0;
+
+		/// Speed in degrees per second.
+		qreal speed = 0;
+
+		/// Acceleration in degrees per second squared.
+		qreal acceleration = 0;
+	};
+
+	/// Constructor.
+	/// @param configurer - configurer object containing preparsed XML files with sampler parameters.
+	/// @param loop - control loop which runs sampling.
+	EncoderSampler(const trikKernel::Configurer &configurer, ControlLoopInterface &loop);
+
+	~EncoderSampler();
+
+	/// Returns the last sample of an encoder, starting to sample it if it is not sampled yet.
+	Sample last(Encoder &encoder);
+
+	/// Returns up to given number of last samples of an encoder, the oldest first, as maps with "time", "position",
+	/// "speed" and "acceleration" keys. Starts to sample an encoder if it is not sampled yet.
+	QVariantList history(Encoder &encoder, int count);
+
+	/// Forgets samples of an encoder, for example, when it is reset.
+	void restart(const Encoder &encoder);
+
+	/// Stops sampling an encoder.
+	void remove(const Encoder &encoder);
+
+	/// Stops sampling all encoders.
+	void clear();
+
+private:
+	/// Sampling state of one encoder.
+	struct Entry {
+		Encoder *encoder;
+		QVector<Sample> history;
+		int head = 0;
+		int size = 0;
+	};
+
+	/// Starts sampling an encoder if it is not sampled yet, returns its entry. Shall be called under mLock, and
+	/// updateRegistration() shall be called after mLock is released.
+	Entry &entry(Encoder &encoder);
+
+	/// Registers sampler in control loop if there are encoders to sample, or unregisters it otherwise.
+	void updateRegistration();
+
+	/// Reads all encoders, called by control loop.
+	void sweep();
+
+	/// Appends a new reading to an entry, estimating speed and acceleration.
+	void addSample(Entry &entry, qint64 time, qreal position);
+
+	ControlLoopInterface &mLoop;
+	const qreal mFilterTime;
+	const int mHistorySize;
+
+	/// Guards entries, held during a sweep.
+	mutable QMutex mLock;
+	QHash<const Encoder *, Entry> mEntries;
+
+	/// Id of sampler in control loop, -1 if it is not registered. Guarded by mRegistrationLock.
+	int mControllerId = -1;
+	QMutex mRegistrationLock;
+};
+
+}
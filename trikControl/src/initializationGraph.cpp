@@ -0,0 +1,169 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "initializationGraph.h"
+
+#include <algorithm>
+
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+#include <QsLog.h>
+
+using namespace trikControl;
+
+class InitializationGraph::Runnable : public QRunnable
+{
+public:
+	Runnable(InitializationGraph &graph, int index)
+		: mGraph(graph)
+		, mIndex(index)
+	{
+	}
+
+	void run() override
+	{
+		mGraph.execute(mIndex);
+	}
+
+private:
+	InitializationGraph &mGraph;
+	const int mIndex;
+};
+
+void InitializationGraph::addTask(const QString &name, const std::function<void()> &task
+		, const QStringList &dependencies, bool inCallerThread)
+{
+	const int index = mTasks.size();
+	mTasks.append({task, {}, 0, inCallerThread, {name, 0, 0, false}});
+	mIndices.insert(name, index);
+
+	for (const QString &dependency : dependencies) {
+		const auto it = mIndices.constFind(dependency);
+		if (it == mIndices.constEnd()) {
+			QLOG_ERROR() << "Initialization task" << name << "depends on unknown task" << dependency;
+			continue;
+		}
+
+		mTasks[it.value()].dependents.append(index);
+		++mTasks[index].pendingDependencies;
+	}
+}
+
+void InitializationGraph::run(int maxThreads)
+{
+	QThreadPool pool;
+	pool.setMaxThreadCount(maxThreads);
+
+	mClock.start();
+	mFinished = 0;
+	mError = nullptr;
+
+	QMutexLocker locker(&mMutex);
+	mPool = &pool;
+	for (int i = 0; i < mTasks.size(); ++i) {
+		if (mTasks[i].pendingDependencies == 0) {
+			schedule(i);
+		}
+	}
+
+	forever {
+		while (mCallerQueue.isEmpty() && mFinished < mTasks.size()) {
+			mCondition.wait(&mMutex);
+		}
+
+		if (mCallerQueue.isEmpty()) {
+			break;
+		}
+
+		const int index = mCallerQueue.dequeue();
+		locker.unlock();
+		execute(index);
+		locker.relock();
+	}
+
+	mPool = nullptr;
+	locker.unlock();
+
+	pool.waitForDone();
+	mTotalTime = mClock.elapsed();
+
+	if (mError) {
+		std::rethrow_exception(mError);
+	}
+}
+
+QList<InitializationGraph::Timing> InitializationGraph::timings() const
+{
+	QList<Timing> result;
+	for (const Task &task : mTasks) {
+		result << task.timing;
+	}
+
+	std::stable_sort(result.begin(), result.end(), [](const Timing &left, const Timing &right) {
+		return left.start < right.start;
+	});
+
+	return result;
+}
+
+qint64 InitializationGraph::totalTime() const
+{
+	return mTotalTime;
+}
+
+void InitializationGraph::execute(int index)
+{
+	Task &task = mTasks[index];
+	task.timing.start = mClock.elapsed();
+	if (!task.timing.failed) {
+		try {
+			task.function();
+		} catch (...) {
+			QLOG_ERROR() << "Initialization task" << task.timing.name << "failed";
+			QMutexLocker locker(&mMutex);
+			if (!mError) {
+				mError = std::current_exception();
+			}
+
+			task.timing.failed = true;
+		}
+	}
+
+	task.timing.duration = mClock.elapsed() - task.timing.start;
+
+	QMutexLocker locker(&mMutex);
+	for (const int dependent : task.dependents) {
+		if (task.timing.failed) {
+			mTasks[dependent].timing.failed = true;
+		}
+
+		if (--mTasks[dependent].pendingDependencies == 0) {
+			schedule(dependent);
+		}
+	}
+
+	++mFinished;
+	mCondition.wakeAll();
+}
+
+void InitializationGraph::schedule(int index)
+{
+	if (mTasks[index].inCallerThread) {
+		mCallerQueue.enqueue(index);
+		mCondition.wakeAll();
+	} else {
+		mPool->start(new Runnable(*this, index));
+	}
+}
@@ -0,0 +1,105 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <exception>
+#include <functional>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtCore/QWaitCondition>
+
+class QThreadPool;
+
+namespace trikControl {
+
+/// Runs initialization tasks as a dependency graph: a task starts as soon as all tasks it depends on are finished, and
+/// independent tasks run in parallel in a thread pool, so a device that waits for its driver does not delay others.
+/// Tasks that create objects relying on an event loop of a caller thread (GUI, file notifiers) are run in a caller
+/// thread by run() itself. Objects created by other tasks shall be moved to a proper thread by tasks themselves.
+class InitializationGraph
+{
+public:
+	/// Timing of a task.
+	struct Timing {
+		QString name;
+
+		/// Time from the start of run() to the start of a task, milliseconds.
+		qint64 start;
+
+		/// Duration of a task, milliseconds.
+		qint64 duration;
+
+		/// Task has thrown an exception or was not run because a task it depends on has failed.
+		bool failed;
+	};
+
+	/// Adds a task.
+	/// @param name - unique name of a task, used in dependencies and in timings.
+	/// @param task - function to run.
+	/// @param dependencies - names of tasks that shall be finished before this one, they shall be added before.
+	/// @param inCallerThread - true if task shall be run in a thread that calls run().
+	void addTask(const QString &name, const std::function<void()> &task, const QStringList &dependencies = {}
+			, bool inCallerThread = false);
+
+	/// Runs all tasks, at most maxThreads of them in parallel, and returns when all of them are finished. If a task
+	/// throws, tasks depending on it are skipped, others are run as usual, and the first exception is rethrown then.
+	void run(int maxThreads);
+
+	/// Returns timings of tasks in order of their start, for tasks that are finished.
+	QList<Timing> timings() const;
+
+	/// Returns time of the last run, milliseconds.
+	qint64 totalTime() const;
+
+private:
+	class Runnable;
+
+	struct Task {
+		std::function<void()> function;
+		QVector<int> dependents;
+		int pendingDependencies;
+		bool inCallerThread;
+		Timing timing;
+	};
+
+	/// Runs a task in a current thread and schedules tasks that depend on it.
+	void execute(int index);
+
+	/// Starts a task in a pool or queues it for a caller thread. Shall be called with mutex locked.
+	void schedule(int index);
+
+	QVector<Task> mTasks;
+	QHash<QString, int> mIndices;
+
+	QMutex mMutex;
+	QWaitCondition mCondition;
+
+	/// Tasks that are ready to be run in a caller thread.
+	QQueue<int> mCallerQueue;
+
+	int mFinished = 0;
+	QThreadPool *mPool = nullptr;
+	QElapsedTimer mClock;
+	qint64 mTotalTime = 0;
+	std::exception_ptr mError;
+};
+
+}
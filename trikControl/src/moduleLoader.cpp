@@ -25,6 +25,7 @@ ModuleLoader::ModuleLoader(trikHal::SystemConsoleInterface &console)
 
 bool ModuleLoader::load(const QString &module)
 {
+	QMutexLocker locker(&mLock);
 	if (mLoadedModules.contains(module)) {
 		return true;
 	}
@@ -14,6 +14,7 @@
 
 #pragma once
 
+#include <QtCore/QMutex>
 #include <QtCore/QString>
 #include <QtCore/QSet>
 
@@ -30,10 +31,12 @@ public:
 	/// @param console - system console that is used to issue "modprobe" command.
 	ModuleLoader(trikHal::SystemConsoleInterface &console);
 
-	/// Loads given module using modprobe. Returns true if module is loaded.
+	/// Loads given module using modprobe. Returns true if module is loaded. Thread-safe, since devices are created
+	/// in parallel.
 	bool load(const QString &module);
 
 private:
+	QMutex mLock;
 	QSet<QString> mLoadedModules;
 	trikHal::SystemConsoleInterface &mConsole;
 };
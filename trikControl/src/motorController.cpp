@@ -0,0 +1,249 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "motorController.h"
+
+#include <QtCore/qmath.h>
+
+#include <trikKernel/configurer.h>
+#include <QsLog.h>
+
+#include "controlLoopInterface.h"
+#include "encoderInterface.h"
+#include "motorInterface.h"
+
+using namespace trikControl;
+
+static const qreal maxPower = 100;
+
+/// Time constant of low-pass filter of measured speed, in seconds.
+static const qreal speedFilterTime = 0.1;
+
+/// Reads parameter of motor controller, or returns default value if it is not configured.
+static qreal parameter(const trikKernel::Configurer &configurer, const QString &name, qreal defaultValue)
+{
+	return configurer.hasAttributeByDevice("motorController", name)
+			? configurer.attributeByDevice("motorController", name).toDouble()
+			: defaultValue;
+}
+
+/// Moves value towards target by no more than maxChange.
+static qreal approach(qreal value, qreal target, qreal maxChange)
+{
+	return value < target ? qMin(value + maxChange, target) : qMax(value - maxChange, target);
+}
+
+MotorController::MotorController(MotorInterface &motor, EncoderInterface &encoder, ControlLoopInterface &loop
+		, const trikKernel::Configurer &configurer)
+	: mMotor(motor)
+	, mEncoder(encoder)
+	, mLoop(loop)
+	, mState("Motor controller")
+	, mMaxSpeed(parameter(configurer, "maxSpeed", 720))
+	, mAcceleration(parameter(configurer, "acceleration", 1440))
+	, mPositionKp(parameter(configurer, "positionKp", 10))
+	, mSpeedKp(parameter(configurer, "speedKp", 0.05))
+	, mSpeedKi(parameter(configurer, "speedKi", 0.2))
+	, mPositionTolerance(parameter(configurer, "positionTolerance", 2))
+	, mSpeedTolerance(parameter(configurer, "speedTolerance", 20))
+{
+	if (mMaxSpeed <= 0 || mAcceleration <= 0) {
+		QLOG_ERROR() << "Incorrect motor controller max speed" << mMaxSpeed << "or acceleration" << mAcceleration;
+		mState.fail();
+		return;
+	}
+
+	mState.ready();
+}
+
+MotorController::~MotorController()
+{
+	stop();
+}
+
+MotorController::Status MotorController::status() const
+{
+	return combine(mMotor, combine(mEncoder, mState.status()));
+}
+
+bool MotorController::usesEncoder(const EncoderInterface &encoder) const
+{
+	return &mEncoder == &encoder;
+}
+
+void MotorController::setSpeed(qreal speed)
+{
+	Command newCommand;
+	newCommand.mode = Mode::speed;
+	newCommand.target = qBound(-mMaxSpeed, speed, mMaxSpeed);
+	command(newCommand);
+}
+
+void MotorController::moveTo(qreal position, qreal speed)
+{
+	Command newCommand;
+	newCommand.mode = Mode::position;
+	newCommand.target = position;
+	newCommand.cruiseSpeed = speed > 0 ? qMin(speed, mMaxSpeed) : mMaxSpeed;
+	command(newCommand);
+}
+
+bool MotorController::isSettled() const
+{
+	QMutexLocker locker(&mLock);
+	return mSettled;
+}
+
+qreal MotorController::position() const
+{
+	QMutexLocker locker(&mLock);
+	return mMeasuredPosition;
+}
+
+qreal MotorController::speed() const
+{
+	QMutexLocker locker(&mLock);
+	return mMeasuredSpeed;
+}
+
+void MotorController::stop()
+{
+	QMutexLocker registrationLocker(&mRegistrationLock);
+	if (mControllerId == -1) {
+		return;
+	}
+
+	// Controller step takes mLock, so it shall not be held while waiting for the current cycle.
+	mLoop.removeController(mControllerId);
+	mControllerId = -1;
+
+	{
+		QMutexLocker locker(&mLock);
+		mCommand = Command();
+		mSettled = true;
+	}
+
+	mMotor.powerOff();
+}
+
+void MotorController::command(const Command &command)
+{
+	if (mState.isFailed()) {
+		QLOG_ERROR() << "Trying to command motor controller which is not ready, ignoring";
+		return;
+	}
+
+	{
+		QMutexLocker locker(&mLock);
+		mCommand = command;
+		mSettled = false;
+	}
+
+	QMutexLocker registrationLocker(&mRegistrationLock);
+	if (mControllerId == -1) {
+		mStarted = false;
+		mControllerId = mLoop.addController([this](qreal, qreal dt) { step(dt); });
+	}
+}
+
+void MotorController::step(qreal dt)
+{
+	const qreal position = mEncoder.read();
+
+	Command command;
+	{
+		QMutexLocker locker(&mLock);
+		command = mCommand;
+	}
+
+	if (!mStarted || dt <= 0) {
+		// Profile starts from where motor is now.
+		mStarted = true;
+		mReferencePosition = position;
+		mReferenceSpeed = 0;
+		mPreviousPosition = position;
+		mSpeed = 0;
+		mIntegral = 0;
+		mPowerSent = false;
+		return;
+	}
+
+	const qreal speedChange = mAcceleration * dt;
+	mSpeed += ((position - mPreviousPosition) / dt - mSpeed) * qMin(1.0, dt / speedFilterTime);
+	mPreviousPosition = position;
+
+	bool profileDone = false;
+	if (command.mode == Mode::speed) {
+		mReferenceSpeed = approach(mReferenceSpeed, command.target, speedChange);
+		mReferencePosition += mReferenceSpeed * dt;
+
+		// Reference shall not run away from a motor which can not keep up, or it will rush to catch up later.
+		const qreal maxLag = mMaxSpeed * 0.1;
+		mReferencePosition = qBound(position - maxLag, mReferencePosition, position + maxLag);
+		profileDone = mReferenceSpeed == command.target;
+	} else if (command.mode == Mode::position) {
+		const qreal distance = command.target - mReferencePosition;
+
+		// Fastest speed from which motor still can stop at target with configured acceleration.
+		const qreal stoppingSpeed = qSqrt(2 * mAcceleration * qAbs(distance));
+		const qreal desiredSpeed = (distance < 0 ? -1 : 1) * qMin(command.cruiseSpeed, stoppingSpeed);
+		mReferenceSpeed = approach(mReferenceSpeed, desiredSpeed, speedChange);
+
+		const qreal move = mReferenceSpeed * dt;
+		if (qAbs(distance) <= qMax(qAbs(move), speedChange * dt)) {
+			mReferencePosition = command.target;
+			mReferenceSpeed = 0;
+			profileDone = true;
+		} else {
+			mReferencePosition += move;
+		}
+	}
+
+	const qreal commandedSpeed = mReferenceSpeed + mPositionKp * (mReferencePosition - position);
+	const qreal speedError = commandedSpeed - mSpeed;
+	if (mSpeedKi != 0) {
+		const qreal integralLimit = maxPower / qAbs(mSpeedKi);
+		mIntegral = qBound(-integralLimit, mIntegral + speedError * dt, integralLimit);
+	}
+
+	const qreal power = commandedSpeed * maxPower / mMaxSpeed + mSpeedKp * speedError + mSpeedKi * mIntegral;
+	const int roundedPower = qRound(qBound(-maxPower, power, maxPower));
+
+	// Bus is written only when power actually changes, most cycles of a settled motor only read encoder. Power of
+	// a motor may also be changed by others (a script, a motor group or brick stop), then it is set again.
+	if (!mPowerSent || roundedPower != mPower || mMotor.power() != mMotorPower) {
+		mMotor.setPower(roundedPower);
+		mPower = roundedPower;
+		mMotorPower = mMotor.power();
+		mPowerSent = true;
+	}
+
+	bool settled = false;
+	if (command.mode == Mode::speed) {
+		settled = profileDone && qAbs(mSpeed - command.target) <= mSpeedTolerance;
+	} else if (command.mode == Mode::position) {
+		settled = profileDone && qAbs(command.target - position) <= mPositionTolerance
+				&& qAbs(mSpeed) <= mSpeedTolerance;
+	}
+
+	QMutexLocker locker(&mLock);
+	mMeasuredPosition = position;
+	mMeasuredSpeed = mSpeed;
+
+	// Command may have been changed during the step, then its status is not known yet.
+	if (mCommand.mode == command.mode && mCommand.target == command.target
+			&& mCommand.cruiseSpeed == command.cruiseSpeed) {
+		mSettled = settled;
+	}
+}
@@ -0,0 +1,131 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QMutex>
+
+#include "motorControllerInterface.h"
+#include "deviceState.h"
+
+namespace trikKernel {
+class Configurer;
+}
+
+namespace trikControl {
+
+class ControlLoopInterface;
+class EncoderInterface;
+class MotorInterface;
+
+/// Closed-loop motor controller. Profile generator gives reference position and speed, position error is turned
+/// into speed correction, and speed is kept by feed-forward plus PI controller on measured speed.
+/// Parameters are taken from "motorController" device class in system config: "maxSpeed" (degrees per second at full
+/// power, also default cruise speed), "acceleration" (degrees per second squared), "positionKp", "speedKp",
+/// "speedKi", and "positionTolerance", "speedTolerance" used to decide whether motor is settled.
+///
+/// Every cycle reads encoder once and sends power to a motor only if it has changed, to keep bus load low.
+/// Controller is registered in control loop only while it has a command.
+class MotorController : public MotorControllerInterface
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.
+	/// @param motor - motor to control.
+	/// @param encoder - encoder of the same motor, reading shall grow when motor gets positive power.
+	/// @param loop - control loop which runs controller.
+	/// @param configurer - configurer object containing preparsed XML files with controller parameters.
+	MotorController(MotorInterface &motor, EncoderInterface &encoder, ControlLoopInterface &loop
+			, const trikKernel::Configurer &configurer);
+
+	~MotorController() override;
+
+	Status status() const override;
+
+	/// Returns true if controller uses given encoder.
+	bool usesEncoder(const EncoderInterface &encoder) const;
+
+public slots:
+	void setSpeed(qreal speed) override;
+
+	void moveTo(qreal position, qreal speed = 0) override;
+
+	bool isSettled() const override;
+
+	qreal position() const override;
+
+	qreal speed() const override;
+
+	void stop() override;
+
+private:
+	enum class Mode {
+		idle
+		, speed
+		, position
+	};
+
+	/// Command given by a script.
+	struct Command {
+		Mode mode = Mode::idle;
+		qreal target = 0;
+		qreal cruiseSpeed = 0;
+	};
+
+	/// One cycle of control, called by control loop.
+	void step(qreal dt);
+
+	/// Gives new command and registers controller in control loop if it is not registered.
+	void command(const Command &command);
+
+	MotorInterface &mMotor;
+	EncoderInterface &mEncoder;
+	ControlLoopInterface &mLoop;
+	DeviceState mState;
+
+	qreal mMaxSpeed = 0;
+	qreal mAcceleration = 0;
+	qreal mPositionKp = 0;
+	qreal mSpeedKp = 0;
+	qreal mSpeedKi = 0;
+	qreal mPositionTolerance = 0;
+	qreal mSpeedTolerance = 0;
+
+	/// Guards command and measured state, shared by script thread and control loop thread.
+	mutable QMutex mLock;
+	Command mCommand;
+	qreal mMeasuredPosition = 0;
+	qreal mMeasuredSpeed = 0;
+	bool mSettled = true;
+
+	/// Id of controller in control loop, -1 if it is not registered. Guarded by mRegistrationLock.
+	int mControllerId = -1;
+	QMutex mRegistrationLock;
+
+	/// State of control, used only by control loop thread.
+	bool mStarted = false;
+	qreal mReferencePosition = 0;
+	qreal mReferenceSpeed = 0;
+	qreal mPreviousPosition = 0;
+	qreal mSpeed = 0;
+	qreal mIntegral = 0;
+
+	/// Last power set by controller, and power of a motor after that (they differ if motor linearises power).
+	int mPower = 0;
+	int mMotorPower = 0;
+	bool mPowerSent = false;
+};
+
+}
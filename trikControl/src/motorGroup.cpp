@@ -0,0 +1,104 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "motorGroup.h"
+
+#include <QsLog.h>
+
+#include "mspCommunicatorInterface.h"
+#include "powerMotor.h"
+
+using namespace trikControl;
+
+MotorGroup::MotorGroup(const QStringList &ports, const QList<PowerMotor *> &motors
+		, MspCommunicatorInterface &communicator)
+	: mPorts(ports)
+	, mMotors(motors)
+	, mCommunicator(communicator)
+{
+}
+
+MotorGroup::Status MotorGroup::status() const
+{
+	for (const PowerMotor * const motor : mMotors) {
+		if (motor->status() != Status::ready) {
+			return motor->status();
+		}
+	}
+
+	return Status::ready;
+}
+
+bool MotorGroup::hasPort(const QString &port) const
+{
+	return mPorts.contains(port);
+}
+
+QStringList MotorGroup::ports() const
+{
+	return mPorts;
+}
+
+void MotorGroup::setPowers(const QVector<int> &powers)
+{
+	if (powers.size() != mMotors.size()) {
+		QLOG_ERROR() << "Motor group on" << mPorts << "got" << powers.size() << "powers, ignoring";
+		return;
+	}
+
+	QVector<QByteArray> commands;
+	commands.reserve(mMotors.size());
+	for (int i = 0; i < mMotors.size(); ++i) {
+		commands.append(mMotors[i]->powerCommand(powers[i]));
+	}
+
+	send(commands);
+	for (int i = 0; i < mMotors.size(); ++i) {
+		mMotors[i]->commandSent(powers[i]);
+	}
+}
+
+void MotorGroup::stopAll()
+{
+	QVector<QByteArray> commands;
+	commands.reserve(mMotors.size());
+	for (PowerMotor * const motor : mMotors) {
+		// Ignoring power units translation, as PowerMotor::powerOff() does.
+		commands.append(motor->powerCommand(0, false));
+	}
+
+	send(commands);
+	for (PowerMotor * const motor : mMotors) {
+		motor->commandSent(0, false);
+	}
+}
+
+QVariantList MotorGroup::commandTimes() const
+{
+	QMutexLocker locker(&mLock);
+	return mCommandTimes;
+}
+
+void MotorGroup::send(const QVector<QByteArray> &commands)
+{
+	const QVector<qint64> times = mCommunicator.sendBurst(commands);
+
+	QVariantList commandTimes;
+	for (const qint64 time : times) {
+		commandTimes.append(time);
+	}
+
+	QMutexLocker locker(&mLock);
+	mCommandTimes = commandTimes;
+}
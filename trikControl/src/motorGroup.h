@@ -0,0 +1,66 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+
+#include "motorGroupInterface.h"
+
+namespace trikControl {
+
+class MspCommunicatorInterface;
+class PowerMotor;
+
+/// Implementation of a group of power motors. Commands of a group are sent by MSP communicator as one burst.
+class MotorGroup : public MotorGroupInterface
+{
+	Q_OBJECT
+
+public:
+	/// Constructor.
+	/// @param ports - ports of motors.
+	/// @param motors - motors on these ports, in the same order.
+	/// @param communicator - MSP communicator used by motors.
+	MotorGroup(const QStringList &ports, const QList<PowerMotor *> &motors, MspCommunicatorInterface &communicator);
+
+	Status status() const override;
+
+	/// Returns true if a group has a motor on given port.
+	bool hasPort(const QString &port) const;
+
+public slots:
+	QStringList ports() const override;
+
+	void setPowers(const QVector<int> &powers) override;
+
+	void stopAll() override;
+
+	QVariantList commandTimes() const override;
+
+private:
+	/// Sends commands as one burst and remembers when they were sent.
+	void send(const QVector<QByteArray> &commands);
+
+	const QStringList mPorts;
+	const QList<PowerMotor *> mMotors;
+	MspCommunicatorInterface &mCommunicator;
+
+	/// Guards times of commands.
+	mutable QMutex mLock;
+	QVariantList mCommandTimes;
+};
+
+}
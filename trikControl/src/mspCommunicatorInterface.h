@@ -15,6 +15,7 @@
 #pragma once
 
 #include <QtCore/QByteArray>
+#include <QtCore/QVector>
 
 #include "deviceInterface.h"
 #include "deviceState.h"
@@ -31,6 +32,17 @@ public:
 
 	/// Reads data by given I2C command number and returns the result.
 	virtual int read(const QByteArray &data) = 0;
+
+	/// Sends several commands right one after another, so that other commands are not sent in between. MSP has no
+	/// multi-command transactions, so it is the tightest burst possible.
+	/// @returns times when commands were sent, in microseconds of trikKernel::Metrics::now() clock, or empty vector
+	/// if nothing was sent.
+	virtual QVector<qint64> sendBurst(const QVector<QByteArray> &commands) = 0;
+
+	/// Reads data by several commands right one after another, so that other commands are not sent in between.
+	/// @param times - times when commands were sent, in microseconds of trikKernel::Metrics::now() clock.
+	/// @returns results of commands, or empty vector if nothing was read.
+	virtual QVector<int> readBurst(const QVector<QByteArray> &commands, QVector<qint64> &times) = 0;
 };
 
 }
@@ -15,12 +15,17 @@
 #include "src/mspI2cCommunicator.h"
 
 #include <trikKernel/configurer.h>
+#include <trikKernel/metrics.h>
 
 #include <trikHal/mspI2cInterface.h>
 #include <QsLog.h>
 
 using namespace trikControl;
 
+static trikKernel::Metrics::Histogram &sendTime = trikKernel::Metrics::histogram("msp.i2c.send");
+static trikKernel::Metrics::Histogram &readTime = trikKernel::Metrics::histogram("msp.i2c.read");
+static trikKernel::Metrics::Histogram &burstTime = trikKernel::Metrics::histogram("msp.i2c.burst");
+
 MspI2cCommunicator::MspI2cCommunicator(const trikKernel::Configurer &configurer, trikHal::MspI2cInterface &i2c)
 	: mI2c(i2c)
 	, mState("MSP I2C Communicator")
@@ -57,6 +62,7 @@ void MspI2cCommunicator::send(const QByteArray &data)
 	}
 
 	QMutexLocker lock(&mLock);
+	trikKernel::Metrics::ScopedTimer timer(sendTime);
 	mI2c.send(data);
 }
 
@@ -68,9 +74,48 @@ int MspI2cCommunicator::read(const QByteArray &data)
 	}
 
 	QMutexLocker lock(&mLock);
+	trikKernel::Metrics::ScopedTimer timer(readTime);
 	return mI2c.read(data);
 }
 
+QVector<qint64> MspI2cCommunicator::sendBurst(const QVector<QByteArray> &commands)
+{
+	if (!mState.isReady()) {
+		QLOG_ERROR() << "Trying to send data through I2C communicator which is not ready, ignoring";
+		return {};
+	}
+
+	QVector<qint64> times(commands.size());
+	QMutexLocker lock(&mLock);
+	trikKernel::Metrics::ScopedTimer timer(burstTime);
+	for (int i = 0; i < commands.size(); ++i) {
+		times[i] = trikKernel::Metrics::now();
+		mI2c.send(commands[i]);
+	}
+
+	return times;
+}
+
+QVector<int> MspI2cCommunicator::readBurst(const QVector<QByteArray> &commands, QVector<qint64> &times)
+{
+	if (!mState.isReady()) {
+		QLOG_ERROR() << "Trying to read data from I2C communicator which is not ready, ignoring";
+		times.clear();
+		return {};
+	}
+
+	QVector<int> results(commands.size());
+	times.resize(commands.size());
+	QMutexLocker lock(&mLock);
+	trikKernel::Metrics::ScopedTimer timer(burstTime);
+	for (int i = 0; i < commands.size(); ++i) {
+		times[i] = trikKernel::Metrics::now();
+		results[i] = mI2c.read(commands[i]);
+	}
+
+	return results;
+}
+
 DeviceInterface::Status MspI2cCommunicator::status() const
 {
 	return mState.status();
@@ -15,6 +15,7 @@
 #include "src/mspUsbCommunicator.h"
 
 #include <trikKernel/configurer.h>
+#include <trikKernel/metrics.h>
 #include <trikHal/mspUsbInterface.h>
 
 #include <QsLog.h>
@@ -61,6 +62,42 @@ int MspUsbCommunicator::read(const QByteArray &data)
 	return mUsb.read(data);
 }
 
+QVector<qint64> MspUsbCommunicator::sendBurst(const QVector<QByteArray> &commands)
+{
+	if (!mState.isReady()) {
+		QLOG_ERROR() << "Trying to send data through USB I2C communicator which is not ready, ignoring";
+		return {};
+	}
+
+	QVector<qint64> times(commands.size());
+	QMutexLocker lock(&mLock);
+	for (int i = 0; i < commands.size(); ++i) {
+		times[i] = trikKernel::Metrics::now();
+		mUsb.send(commands[i]);
+	}
+
+	return times;
+}
+
+QVector<int> MspUsbCommunicator::readBurst(const QVector<QByteArray> &commands, QVector<qint64> &times)
+{
+	if (!mState.isReady()) {
+		QLOG_ERROR() << "Trying to read data from USB I2C communicator which is not ready, ignoring";
+		times.clear();
+		return {};
+	}
+
+	QVector<int> results(commands.size());
+	times.resize(commands.size());
+	QMutexLocker lock(&mLock);
+	for (int i = 0; i < commands.size(); ++i) {
+		times[i] = trikKernel::Metrics::now();
+		results[i] = mUsb.read(commands[i]);
+	}
+
+	return results;
+}
+
 DeviceInterface::Status MspUsbCommunicator::status() const
 {
 	return mState.status();
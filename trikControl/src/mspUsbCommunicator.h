@@ -45,6 +45,10 @@ public:
 	/// Reads data by given I2C command number and returns the result.
 	int read(const QByteArray &data) override;
 
+	QVector<qint64> sendBurst(const QVector<QByteArray> &commands) override;
+
+	QVector<int> readBurst(const QVector<QByteArray> &commands, QVector<qint64> &times) override;
+
 	Status status() const override;
 
 private:
@@ -54,6 +54,29 @@ PowerMotor::Status PowerMotor::status() const
 }
 
 void PowerMotor::setPower(int power, bool constrain)
+{
+	mCommunicator.send(powerCommand(power, constrain));
+	commandSent(power, constrain);
+}
+
+QByteArray PowerMotor::powerCommand(int power, bool constrain) const
+{
+	power = controlValue(power, constrain);
+	power = mInvert ? -power : power;
+
+	QByteArray command(3, '\0');
+	command[0] = static_cast<char>(mMspCommandNumber & 0xFF);
+	command[1] = static_cast<char>((mMspCommandNumber >> 8) & 0xFF);
+	command[2] = static_cast<char>(power & 0xFF);
+	return command;
+}
+
+void PowerMotor::commandSent(int power, bool constrain)
+{
+	mCurrentPower = controlValue(power, constrain);
+}
+
+int PowerMotor::controlValue(int power, bool constrain) const
 {
 	if (constrain) {
 		if (power > maxControlValue) {
@@ -64,17 +87,7 @@ void PowerMotor::setPower(int power, bool constrain)
 		power = power <= 0 ? -mPowerMap[-power] : mPowerMap[power];
 	}
 
-	mCurrentPower = power;
-
-
-	power = mInvert ? -power : power;
-
-	QByteArray command(3, '\0');
-	command[0] = static_cast<char>(mMspCommandNumber & 0xFF);
-	command[1] = static_cast<char>((mMspCommandNumber >> 8) & 0xFF);
-	command[2] = static_cast<char>(power & 0xFF);
-
-	mCommunicator.send(command);
+	return power;
 }
 
 int PowerMotor::power() const
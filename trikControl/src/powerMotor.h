@@ -49,6 +49,14 @@ public:
 
 	int maxControl() const override;
 
+	/// Makes MSP command setting given power, to be sent by caller together with commands for other motors.
+	/// Parameters are the same as for setPower(). Does not change the motor, caller shall call commandSent() with the
+	/// same parameters when the command is sent.
+	QByteArray powerCommand(int power, bool constrain = true) const;
+
+	/// Remembers power set by a command from powerCommand() as current power of a motor.
+	void commandSent(int power, bool constrain = true);
+
 public slots:
 	void setPower(int power, bool constrain = true) override;
 
@@ -69,6 +77,9 @@ public slots:
 private:
 	void lineariseMotor(const QString &port, const trikKernel::Configurer &configurer);
 
+	/// Returns control value for given power: bounded and linearised if constrain is true, as is otherwise.
+	int controlValue(int power, bool constrain) const;
+
 	MspCommunicatorInterface &mCommunicator;
 	int mMspCommandNumber;
 	const bool mInvert;
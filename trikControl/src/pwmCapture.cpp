@@ -14,9 +14,6 @@
 
 #include "pwmCapture.h"
 
-#include <QtCore/QByteArray>
-#include <QtCore/QTextStream>
-
 #include <trikKernel/configurer.h>
 #include <trikHal/hardwareAbstractionInterface.h>
 
@@ -56,10 +53,8 @@ QVector<int> PwmCapture::frequency()
 		return {};
 	}
 
-	mFrequencyFile->reset();
-	QVector<int> data(3);
-	char c = '\0';
-	mFrequencyFile->stream() >> data[0] >> c >> data[1] >> c >> data[2] >> c;
+	QVector<int> data = mFrequencyFile->readNumbers();
+	data.resize(3);
 	return data;
 }
 
@@ -69,9 +64,6 @@ int PwmCapture::duty()
 		return {};
 	}
 
-	mDutyFile->reset();
-	int data = 0;
-	char c = '\0';
-	mDutyFile->stream() >> data >> c;
-	return data;
+	const QVector<int> data = mDutyFile->readNumbers();
+	return data.isEmpty() ? 0 : data.first();
 }
@@ -54,7 +54,7 @@ ServoMotor::ServoMotor(const QString &port, const trikKernel::Configurer &config
 		mState.fail();
 		return;
 	} else {
-		mRunFile->write(QString::number(mRun ? 1 : 0));
+		mRunFile->writeNumber(mRun ? 1 : 0);
 	}
 
 	setPeriod(mPeriod / 1000);
@@ -107,19 +107,15 @@ void ServoMotor::powerOff()
 		return;
 	}
 
-	mDutyFile->write(QString::number(mStop));
-	mRunFile->write(QString::number(0));
+	mDutyFile->writeNumber(mStop);
+	mRunFile->writeNumber(0);
 	mRun = false;
 	mCurrentPower = 0;
-
-	mRun = false;
-	mRunFile->write(QString::number(mRun));
 }
 
 void ServoMotor::setPeriod(int uSec)
 {
-	const QString command = QString::number(uSec * 1000);
-	mPeriodFile->write(command);
+	mPeriodFile->writeNumber(uSec * 1000);
 }
 
 void ServoMotor::setPower(int power, bool constrain)
@@ -147,14 +143,14 @@ void ServoMotor::setPower(int power, bool constrain)
 
 	const qreal powerFactor = static_cast<qreal>(range) / (mMaxControlRange - mMinControlRange) * 2;
 	const int duty = static_cast<int>(mZero + (power - meanControlRange) * powerFactor);
-	const QString command = QString::number(duty);
 
 	mCurrentDutyPercent = 100 * duty / mPeriod;
 
-	mDutyFile->write(command);
+	// Device file skips writing a duty which is already set.
+	mDutyFile->writeNumber(duty);
 
 	if (!mRun) {
 		mRun = true;
-		mRunFile->write(QString::number(mRun));
+		mRunFile->writeNumber(1);
 	}
 }
@@ -0,0 +1,139 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "sharedStateClient.h"
+
+#include <atomic>
+#include <cstring>
+#include <limits>
+
+#include <QsLog.h>
+
+using namespace trikControl;
+using namespace trikControl::sharedState;
+
+/// Number of attempts to copy a snapshot before giving up.
+static const int readAttempts = 100;
+
+/// Returns port names from fixed-size array of a segment.
+static QStringList portNames(const char names[][portNameSize], int count)
+{
+	QStringList result;
+	for (int i = 0; i < count; ++i) {
+		result << QString::fromLatin1(names[i], static_cast<int>(qstrnlen(names[i], portNameSize)));
+	}
+
+	return result;
+}
+
+SharedStateClient::SharedStateClient(const QString &key)
+	: mMemory(key)
+{
+}
+
+SharedStateClient::~SharedStateClient()
+{
+	if (mMemory.isAttached()) {
+		mMemory.detach();
+	}
+}
+
+bool SharedStateClient::attach()
+{
+	if (isAttached()) {
+		return true;
+	}
+
+	if (!mMemory.attach(QSharedMemory::ReadWrite)) {
+		QLOG_INFO() << "Shared state" << mMemory.key() << "is not published:" << mMemory.errorString();
+		return false;
+	}
+
+	Segment * const segment = static_cast<Segment *>(mMemory.data());
+	if (mMemory.size() < static_cast<int>(sizeof(Segment)) || segment->magic != magic
+			|| segment->version != version || segment->size != sizeof(Segment))
+	{
+		QLOG_ERROR() << "Shared state" << mMemory.key() << "has incompatible layout";
+		mMemory.detach();
+		return false;
+	}
+
+	mSegment = segment;
+	return true;
+}
+
+bool SharedStateClient::isAttached() const
+{
+	return mSegment != nullptr;
+}
+
+QStringList SharedStateClient::sensorPorts() const
+{
+	return isAttached() ? portNames(mSegment->ports.sensors, mSegment->ports.sensorCount) : QStringList();
+}
+
+QStringList SharedStateClient::motorPorts() const
+{
+	return isAttached() ? portNames(mSegment->ports.motors, mSegment->ports.motorCount) : QStringList();
+}
+
+bool SharedStateClient::read(Snapshot &snapshot) const
+{
+	if (!isAttached()) {
+		return false;
+	}
+
+	for (int i = 0; i < readAttempts; ++i) {
+		const quint32 before = mSegment->sequence.loadAcquire();
+		if (before & 1) {
+			continue;
+		}
+
+		std::memcpy(&snapshot, &mSegment->snapshot, sizeof(Snapshot));
+
+		// Copy shall be complete before the counter is checked again.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (mSegment->sequence.load() == before) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool SharedStateClient::setPower(const QString &port, int power)
+{
+	return setPower(motorPorts().indexOf(port), power);
+}
+
+bool SharedStateClient::setPower(int motor, int power)
+{
+	if (!isAttached() || motor < 0 || motor >= mSegment->ports.motorCount) {
+		return false;
+	}
+
+	// Claiming a slot, other clients may be claiming slots at the same time.
+	quint32 head = mSegment->commandHead.loadAcquire();
+	do {
+		if (head - mSegment->commandTail.loadAcquire() >= static_cast<quint32>(commandRingSize)) {
+			return false;
+		}
+	} while (!mSegment->commandHead.testAndSetOrdered(head, head + 1, head));
+
+	// Slot is no longer waiting for this command if runtime has skipped it while this client was stalled, then
+	// command is not written. Power is bounded to fit a slot, motors bound it further anyway.
+	const int boundedPower = qBound<int>(std::numeric_limits<qint16>::min(), power, std::numeric_limits<qint16>::max());
+	Command &command = mSegment->commands[head % commandRingSize];
+	return command.word.testAndSetRelease(freeSlot(head), writtenSlot(head, motor, boundedPower));
+}
@@ -0,0 +1,255 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "sharedStatePublisher.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+
+#include <trikKernel/configurer.h>
+#include <QsLog.h>
+
+#include "brickInterface.h"
+#include "controlLoopInterface.h"
+
+using namespace trikControl;
+using namespace trikControl::sharedState;
+
+static const int defaultRate = 100;
+
+/// Time after which a claimed command which is still not written is skipped, in seconds. Client may have crashed
+/// between claiming a slot and writing a command, and the ring would be blocked forever.
+static const qreal stalledCommandTimeout = 0.1;
+
+/// Copies port names into fixed-size array of a segment, returns number of copied names.
+static int copyPortNames(const QStringList &ports, char names[][portNameSize], int maxCount)
+{
+	const int count = qMin(ports.size(), maxCount);
+	for (int i = 0; i < count; ++i) {
+		qstrncpy(names[i], ports[i].toLatin1().constData(), portNameSize);
+	}
+
+	if (ports.size() > maxCount) {
+		QLOG_ERROR() << "Too many ports for shared state, publishing only" << ports.mid(0, maxCount);
+	}
+
+	return count;
+}
+
+SharedStatePublisher::SharedStatePublisher(const trikKernel::Configurer &configurer, BrickInterface &brick
+		, ControlLoopInterface &loop, const QStringList &sensorPorts, const QStringList &motorPorts)
+	: mBrick(brick)
+	, mLoop(loop)
+	, mState("Shared state")
+	, mMemory(configurer.hasAttributeByDevice("sharedState", "key")
+			? configurer.attributeByDevice("sharedState", "key") : QString(defaultKey))
+{
+	const int rate = configurer.hasAttributeByDevice("sharedState", "rate")
+			? configurer.attributeByDevice("sharedState", "rate").toInt() : defaultRate;
+	mPeriod = 1.0 / (rate > 0 ? rate : defaultRate);
+
+	mState.start();
+
+	bool isCreated = mMemory.create(sizeof(Segment));
+	if (!isCreated && mMemory.error() == QSharedMemory::AlreadyExists) {
+		// Segment of a crashed runtime is destroyed when the last process detaches from it.
+		QLOG_INFO() << "Replacing existing shared state" << mMemory.key();
+		if (mMemory.attach()) {
+			mMemory.detach();
+		}
+
+		isCreated = mMemory.create(sizeof(Segment));
+	}
+
+	if (!isCreated) {
+		QLOG_ERROR() << "Can not create shared state" << mMemory.key() << ":" << mMemory.errorString();
+		mState.fail();
+		return;
+	}
+
+	mSegment = static_cast<Segment *>(mMemory.data());
+	std::memset(mSegment, 0, sizeof(Segment));
+	mSegment->size = sizeof(Segment);
+	mSegment->version = version;
+	mSegment->ports.sensorCount = copyPortNames(sensorPorts, mSegment->ports.sensors, maxSensors);
+	mSegment->ports.motorCount = copyPortNames(motorPorts, mSegment->ports.motors, maxMotors);
+
+	// Magic is written last, so a client does not accept a segment which is not filled yet.
+	std::atomic_thread_fence(std::memory_order_release);
+	mSegment->magic = magic;
+
+	for (int i = 0; i < mSegment->ports.sensorCount; ++i) {
+		mSensorHandles.append(mBrick.handle(sensorPorts[i]));
+	}
+
+	mMotorPorts = motorPorts.mid(0, mSegment->ports.motorCount);
+	mSensorValues.resize(mSensorHandles.size());
+
+	mState.ready();
+}
+
+SharedStatePublisher::~SharedStatePublisher()
+{
+	stop();
+}
+
+DeviceInterface::Status SharedStatePublisher::status() const
+{
+	return mState.status();
+}
+
+void SharedStatePublisher::start()
+{
+	QMutexLocker locker(&mRegistrationLock);
+	if (mControllerId == -1 && mState.isReady()) {
+		mSinceSnapshot = mPeriod;
+		mControllerId = mLoop.addController([this](qreal, qreal dt) { step(dt); });
+	}
+}
+
+void SharedStatePublisher::stop()
+{
+	QMutexLocker locker(&mRegistrationLock);
+	if (mControllerId != -1) {
+		mLoop.removeController(mControllerId);
+		mControllerId = -1;
+		dropCommands();
+	}
+}
+
+void SharedStatePublisher::step(qreal dt)
+{
+	executeCommands(dt);
+
+	mSinceSnapshot += dt;
+	if (mSinceSnapshot >= mPeriod) {
+		// Not catching up after a stall, like control loop itself.
+		mSinceSnapshot = qMin(mSinceSnapshot - mPeriod, mPeriod);
+		publish();
+	}
+}
+
+void SharedStatePublisher::publish()
+{
+	// Devices are read before the seqlock is taken, so readers retry only while values are copied.
+	mBrick.readAll(mSensorHandles, mSensorValues.data());
+
+	Snapshot snapshot;
+	std::memset(&snapshot, 0, sizeof(Snapshot));
+	snapshot.time = std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	std::copy(mSensorValues.constBegin(), mSensorValues.constEnd(), snapshot.sensors);
+	for (int i = 0; i < mMotorPorts.size(); ++i) {
+		MotorInterface * const motor = mBrick.motor(mMotorPorts[i]);
+		snapshot.motors[i] = motor ? motor->power() : 0;
+	}
+
+	if (VectorSensorInterface * const accelerometer = mBrick.accelerometer()) {
+		const QVector<int> values = accelerometer->read();
+		std::copy(values.constBegin(), values.constBegin() + qMin(values.size(), 3), snapshot.accelerometer);
+	}
+
+	if (GyroSensorInterface * const gyroscope = mBrick.gyroscope()) {
+		const QVector<int> values = gyroscope->read();
+		std::copy(values.constBegin(), values.constBegin() + qMin(values.size(), gyroscopeSize)
+				, snapshot.gyroscope);
+	}
+
+	if (GamepadInterface * const gamepad = mBrick.gamepad()) {
+		snapshot.gamepad.isConnected = gamepad->isConnected();
+		snapshot.gamepad.wheel = gamepad->wheel();
+		for (int button = 1; button <= gamepadButtons; ++button) {
+			snapshot.gamepad.buttons |= gamepad->buttonIsPressed(button) ? 1 << (button - 1) : 0;
+		}
+
+		for (int pad = 1; pad <= 2; ++pad) {
+			snapshot.gamepad.padPressed[pad - 1] = gamepad->isPadPressed(pad);
+			snapshot.gamepad.padX[pad - 1] = gamepad->padX(pad);
+			snapshot.gamepad.padY[pad - 1] = gamepad->padY(pad);
+		}
+	}
+
+	const quint32 sequence = mSegment->sequence.load();
+	snapshot.frame = sequence / 2 + 1;
+
+	mSegment->sequence.store(sequence + 1);
+
+	// Snapshot shall not be written before the counter becomes odd.
+	std::atomic_thread_fence(std::memory_order_release);
+	std::memcpy(&mSegment->snapshot, &snapshot, sizeof(Snapshot));
+	mSegment->sequence.storeRelease(sequence + 2);
+}
+
+void SharedStatePublisher::executeCommands(qreal dt)
+{
+	if (!mSegment) {
+		return;
+	}
+
+	quint32 tail = mSegment->commandTail.load();
+	while (tail != mSegment->commandHead.loadAcquire()) {
+		Command &command = mSegment->commands[tail % commandRingSize];
+		const quint64 word = command.word.loadAcquire();
+		if (isWritten(word, tail)) {
+			const int motorIndex = commandMotor(word);
+			if (motorIndex < mMotorPorts.size()) {
+				if (MotorInterface * const motor = mBrick.motor(mMotorPorts[motorIndex])) {
+					motor->setPower(commandPower(word));
+				}
+			}
+
+			// Only runtime changes written slots, so slot is released by a plain store.
+			command.word.storeRelease(freeSlot(tail + commandRingSize));
+		} else {
+			// Slot is claimed but not written yet, it will be executed in one of the next cycles.
+			mStalledTime += dt;
+			if (mStalledTime < stalledCommandTimeout) {
+				break;
+			}
+
+			// Client may write the command right now, then it is executed as usual.
+			if (!command.word.testAndSetOrdered(word, freeSlot(tail + commandRingSize))) {
+				continue;
+			}
+
+			QLOG_WARN() << "Shared state command" << tail << "was not written in time, skipping it";
+		}
+
+		mStalledTime = 0;
+		++tail;
+		mSegment->commandTail.storeRelease(tail);
+	}
+}
+
+void SharedStatePublisher::dropCommands()
+{
+	if (!mSegment) {
+		return;
+	}
+
+	// Commands which are still being written are dropped too, their clients will fail to write them. Slots are
+	// released for the next commands one by one, as when commands are executed.
+	mStalledTime = 0;
+	quint32 tail = mSegment->commandTail.load();
+	while (tail != mSegment->commandHead.loadAcquire()) {
+		Command &command = mSegment->commands[tail % commandRingSize];
+		const quint64 word = command.word.loadAcquire();
+		if (command.word.testAndSetOrdered(word, freeSlot(tail + commandRingSize))) {
+			++tail;
+			mSegment->commandTail.storeRelease(tail);
+		}
+	}
+}
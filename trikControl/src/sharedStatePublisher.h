@@ -0,0 +1,100 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QMutex>
+#include <QtCore/QSharedMemory>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+#include "sharedStateLayout.h"
+#include "deviceState.h"
+
+namespace trikKernel {
+class Configurer;
+}
+
+namespace trikControl {
+
+class BrickInterface;
+class ControlLoopInterface;
+
+/// Publishes state of devices in shared memory for local processes (see SharedStateClient) and executes motor
+/// commands they send. Works in control loop: snapshot is taken at configured rate, commands are executed in every
+/// cycle. Parameters are "key" (key of shared memory segment) and "rate" (snapshots per second) attributes of
+/// "sharedState" device class in system config.
+class SharedStatePublisher
+{
+public:
+	/// Constructor. Creates a segment, replacing a segment left by a crashed runtime if any.
+	/// @param sensorPorts - sensor and encoder ports to publish.
+	/// @param motorPorts - power motor ports which can be commanded.
+	SharedStatePublisher(const trikKernel::Configurer &configurer, BrickInterface &brick, ControlLoopInterface &loop
+			, const QStringList &sensorPorts, const QStringList &motorPorts);
+
+	~SharedStatePublisher();
+
+	/// Returns status of a publisher, it is failed if a segment can not be created.
+	DeviceInterface::Status status() const;
+
+	/// Starts publishing.
+	void start();
+
+	/// Stops publishing and drops commands that were not executed yet.
+	void stop();
+
+private:
+	/// Called by control loop.
+	void step(qreal dt);
+
+	/// Writes a new snapshot of devices.
+	void publish();
+
+	/// Executes commands sent by clients. A command which is claimed but not written for too long is skipped.
+	/// @param dt - time since the previous call, in seconds.
+	void executeCommands(qreal dt);
+
+	/// Drops commands that were not executed yet, including the ones that are being written.
+	void dropCommands();
+
+	BrickInterface &mBrick;
+	ControlLoopInterface &mLoop;
+	DeviceState mState;
+	QSharedMemory mMemory;
+	sharedState::Segment *mSegment = nullptr;
+
+	/// Snapshot period, in seconds.
+	qreal mPeriod = 0;
+
+	/// Time since the last snapshot, in seconds. Used only by control loop.
+	qreal mSinceSnapshot = 0;
+
+	/// Time the oldest claimed command waits to be written, in seconds. Used only by control loop.
+	qreal mStalledTime = 0;
+
+	QVector<int> mSensorHandles;
+
+	/// Motors are looked up by port every time, so they may be reconfigured while publisher works.
+	QStringList mMotorPorts;
+
+	/// Buffer for sensor readings, reused between snapshots.
+	QVector<int> mSensorValues;
+
+	/// Id of publisher in control loop, -1 if it is not started. Guarded by mRegistrationLock.
+	int mControllerId = -1;
+	QMutex mRegistrationLock;
+};
+
+}
@@ -40,10 +40,6 @@ VectorSensorWorker::VectorSensorWorker(const QString &eventFile, DeviceState &st
 
 	moveToThread(&thread);
 
-	mLastEventTimer.moveToThread(&thread);
-	mLastEventTimer.setInterval(maxEventDelay);
-	mLastEventTimer.setSingleShot(false);
-
 	mTryReopenTimer.moveToThread(&thread);
 	mTryReopenTimer.setInterval(reopenDelay);
 	mTryReopenTimer.setSingleShot(false);
@@ -51,16 +47,17 @@ VectorSensorWorker::VectorSensorWorker(const QString &eventFile, DeviceState &st
 	connect(mEventFile.data(), SIGNAL(newEvent(int, int, int, trikKernel::TimeVal))
 			, this, SLOT(onNewEvent(int, int, int, trikKernel::TimeVal)));
 
-	connect(&mLastEventTimer, SIGNAL(timeout()), this, SLOT(onSensorHanged()));
 	connect(&mTryReopenTimer, SIGNAL(timeout()), this, SLOT(onTryReopen()));
 
 	mEventFile->open();
+	if (mEventFile->isOpened()) {
+		// Started before the thread, so that the first events will only restart it.
+		restartHangTimer();
+	}
+
 	thread.start();
 
-	if (mEventFile->isOpened()) {
-		// Timer should be started in its thread, so doing it via metacall
-		QMetaObject::invokeMethod(&mLastEventTimer, "start");
-	} else {
+	if (!mEventFile->isOpened()) {
 		QLOG_WARN() << "Sensor" << mState.deviceName() << ", device file can not be opened, will retry in"
 				<< reopenDelay << "milliseconds";
 		// Timer should be started in its thread, so doing it via metacall
@@ -69,9 +66,14 @@ VectorSensorWorker::VectorSensorWorker(const QString &eventFile, DeviceState &st
 	}
 }
 
+VectorSensorWorker::~VectorSensorWorker()
+{
+	stopHangTimer();
+}
+
 void VectorSensorWorker::onNewEvent(int eventType, int code, int value, const trikKernel::TimeVal &eventTime)
 {
-	mLastEventTimer.start();
+	restartHangTimer();
 
 	if (mState.isFailed()) {
 		mState.resetFailure();
@@ -120,7 +122,7 @@ QVector<int> VectorSensorWorker::read()
 
 void VectorSensorWorker::deinitialize()
 {
-	mLastEventTimer.stop();
+	stopHangTimer();
 	mTryReopenTimer.stop();
 }
 
@@ -128,7 +130,7 @@ void VectorSensorWorker::onSensorHanged()
 {
 	QLOG_WARN() << "Sensor" << mState.deviceName() << "hanged for " << maxEventDelay << "ms, reopening device file...";
 	mState.fail();
-	mLastEventTimer.stop();
+	stopHangTimer();
 
 	mEventFile->close();
 	mEventFile->open();
@@ -137,7 +139,7 @@ void VectorSensorWorker::onSensorHanged()
 		mTryReopenTimer.start();
 	} else {
 		QLOG_INFO() << "Sensor" << mState.deviceName() << ", device file reopened.";
-		mLastEventTimer.start();
+		restartHangTimer();
 		mTryReopenTimer.stop();
 	}
 }
@@ -146,3 +148,17 @@ void VectorSensorWorker::onTryReopen()
 {
 	onSensorHanged();
 }
+
+void VectorSensorWorker::restartHangTimer()
+{
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	if (!wheel.restart(mLastEventTimer)) {
+		mLastEventTimer = wheel.startQueued(maxEventDelay, this, "onSensorHanged");
+	}
+}
+
+void VectorSensorWorker::stopHangTimer()
+{
+	trikKernel::TimerWheel::instance().stop(mLastEventTimer);
+	mLastEventTimer = 0;
+}
@@ -22,6 +22,7 @@
 #include <QtCore/QThread>
 
 #include <trikHal/hardwareAbstractionInterface.h>
+#include <trikKernel/timerWheel.h>
 
 #include "deviceState.h"
 
@@ -45,6 +46,8 @@ public:
 			, const trikHal::HardwareAbstractionInterface &hardwareAbstraction
 			, QThread &thread);
 
+	~VectorSensorWorker() override;
+
 signals:
 	/// Emitted when new sensor reading is ready.
 	void newData(QVector<int> reading, const trikKernel::TimeVal &eventTime);
@@ -69,6 +72,12 @@ private slots:
 	void onTryReopen();
 
 private:
+	/// Starts or restarts hang detection timer.
+	void restartHangTimer();
+
+	/// Stops hang detection timer.
+	void stopHangTimer();
+
 	/// Event file for that sensor.
 	QScopedPointer<trikHal::EventFileInterface> mEventFile;
 
@@ -81,8 +90,9 @@ private:
 	/// Device state, shared between worker and proxy.
 	DeviceState &mState;
 
-	/// Timer that reopens event file when there are no events for too long (1 second hardcoded).
-	QTimer mLastEventTimer;
+	/// Timer that reopens event file when there are no events for too long (1 second hardcoded). It is restarted on
+	/// every event, so it lives in the shared timer wheel, where restart is cheap.
+	trikKernel::TimerWheel::TimerId mLastEventTimer = 0;
 
 	/// Timer that initiates attempts to reopen device file if there is a hangup.
 	QTimer mTryReopenTimer;
@@ -23,6 +23,7 @@ PUBLIC_HEADERS += \
 	$$PWD/include/trikControl/brickInterface.h \
 	$$PWD/include/trikControl/cameraDeviceInterface.h \
 	$$PWD/include/trikControl/colorSensorInterface.h \
+	$$PWD/include/trikControl/controlLoopInterface.h \
 	$$PWD/include/trikControl/declSpec.h \
 	$$PWD/include/trikControl/deviceInterface.h \
 	$$PWD/include/trikControl/displayInterface.h \
@@ -36,10 +37,14 @@ PUBLIC_HEADERS += \
 	$$PWD/include/trikControl/keysInterface.h \
 	$$PWD/include/trikControl/ledInterface.h \
 	$$PWD/include/trikControl/lineSensorInterface.h \
+	$$PWD/include/trikControl/motorControllerInterface.h \
+	$$PWD/include/trikControl/motorGroupInterface.h \
 	$$PWD/include/trikControl/motorInterface.h \
 	$$PWD/include/trikControl/objectSensorInterface.h \
 	$$PWD/include/trikControl/pwmCaptureInterface.h \
 	$$PWD/include/trikControl/sensorInterface.h \
+	$$PWD/include/trikControl/sharedStateClient.h \
+	$$PWD/include/trikControl/sharedStateLayout.h \
 	$$PWD/include/trikControl/soundSensorInterface.h \
 	$$PWD/include/trikControl/vectorSensorInterface.h \
 	$$PWD/include/trikControl/gyroSensorInterface.h \
@@ -58,10 +63,12 @@ HEADERS += \
 	$$PWD/src/colorSensor.h \
 	$$PWD/src/colorSensorWorker.h \
 	$$PWD/src/configurerHelper.h \
+	$$PWD/src/controlLoop.h \
 	$$PWD/src/deviceState.h \
 	$$PWD/src/digitalSensor.h \
 	$$PWD/src/display.h \
 	$$PWD/src/encoder.h \
+	$$PWD/src/encoderSampler.h \
 	$$PWD/src/event.h \
 	$$PWD/src/eventCode.h \
 	$$PWD/src/eventDevice.h \
@@ -70,12 +77,15 @@ HEADERS += \
 	$$PWD/src/gamepad.h \
 	$$PWD/src/graphicsWidget.h \
 	$$PWD/src/guiWorker.h \
+	$$PWD/src/initializationGraph.h \
 	$$PWD/src/keys.h \
 	$$PWD/src/keysWorker.h \
 	$$PWD/src/led.h \
 	$$PWD/src/lineSensor.h \
 	$$PWD/src/lineSensorWorker.h \
 	$$PWD/src/moduleLoader.h \
+	$$PWD/src/motorController.h \
+	$$PWD/src/motorGroup.h \
 	$$PWD/src/mspCommunicatorInterface.h \
 	$$PWD/src/mspBusAutoDetector.h \
 	$$PWD/src/mspI2cCommunicator.h \
@@ -87,6 +97,7 @@ HEADERS += \
 	$$PWD/src/rangeSensor.h \
 	$$PWD/src/rangeSensorWorker.h \
 	$$PWD/src/servoMotor.h \
+	$$PWD/src/sharedStatePublisher.h \
 	$$PWD/src/soundSensor.h \
 	$$PWD/src/soundSensorWorker.h \
 	$$PWD/src/tonePlayer.h \
@@ -117,10 +128,12 @@ SOURCES += \
 	$$PWD/src/colorSensor.cpp \
 	$$PWD/src/colorSensorWorker.cpp \
 	$$PWD/src/configurerHelper.cpp \
+	$$PWD/src/controlLoop.cpp \
 	$$PWD/src/deviceState.cpp \
 	$$PWD/src/digitalSensor.cpp \
 	$$PWD/src/display.cpp \
 	$$PWD/src/encoder.cpp \
+	$$PWD/src/encoderSampler.cpp \
 	$$PWD/src/event.cpp \
 	$$PWD/src/eventCode.cpp \
 	$$PWD/src/eventDevice.cpp \
@@ -129,12 +142,15 @@ SOURCES += \
 	$$PWD/src/gamepad.cpp \
 	$$PWD/src/graphicsWidget.cpp \
 	$$PWD/src/guiWorker.cpp \
+	$$PWD/src/initializationGraph.cpp \
 	$$PWD/src/keys.cpp \
 	$$PWD/src/keysWorker.cpp \
 	$$PWD/src/led.cpp \
 	$$PWD/src/lineSensor.cpp \
 	$$PWD/src/lineSensorWorker.cpp \
 	$$PWD/src/moduleLoader.cpp \
+	$$PWD/src/motorController.cpp \
+	$$PWD/src/motorGroup.cpp \
 	$$PWD/src/mspBusAutoDetector.cpp \
 	$$PWD/src/mspI2cCommunicator.cpp \
 	$$PWD/src/mspUsbCommunicator.cpp \
@@ -145,6 +161,8 @@ SOURCES += \
 	$$PWD/src/rangeSensor.cpp \
 	$$PWD/src/rangeSensorWorker.cpp \
 	$$PWD/src/servoMotor.cpp \
+	$$PWD/src/sharedStateClient.cpp \
+	$$PWD/src/sharedStatePublisher.cpp \
 	$$PWD/src/soundSensor.cpp \
 	$$PWD/src/soundSensorWorker.cpp \
 	$$PWD/src/tonePlayer.cpp \
@@ -27,6 +27,11 @@ class HardwareAbstractionFactory
 public:
 	/// Returns pointer to hardware abstraction object.
 	static QSharedPointer<HardwareAbstractionInterface> create();
+
+	/// Returns pointer to stub hardware abstraction object whose input and output device files are ordinary files
+	/// in a given directory, for example, "/sys/class/pwm/ecap.0/run" is "<deviceFilesRoot>/sys/class/pwm/ecap.0/run".
+	/// Allows to test and benchmark device file I/O on desktop against fake sysfs. Supported only on Linux.
+	static QSharedPointer<HardwareAbstractionInterface> createWithFakeSysfs(const QString &deviceFilesRoot);
 };
 
 }
@@ -15,6 +15,7 @@
 #pragma once
 
 #include <QtCore/QTextStream>
+#include <QtCore/QVector>
 
 namespace trikHal {
 
@@ -35,6 +36,11 @@ public:
 
 	/// Resets input file, moving file cursor to the beginning of the file.
 	virtual void reset() = 0;
+
+	/// Reads a file from the beginning and returns integers found in it, separated by any other characters.
+	/// Does not use stream() and does not move its cursor, cheaper than stream() for small files read periodically.
+	/// Returns empty vector if a file can not be read.
+	virtual QVector<int> readNumbers() = 0;
 };
 
 }
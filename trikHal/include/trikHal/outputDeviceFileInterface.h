@@ -34,6 +34,10 @@ public:
 	/// Write data to a file using UTF-8 encoding.
 	virtual void write(const QString &data) = 0;
 
+	/// Writes integer value as decimal text, replacing previous contents of a file. Does nothing if the value is the
+	/// same as the last one written by this method, so it is cheap to call in control loops.
+	virtual void writeNumber(int value) = 0;
+
 	/// Returns name of a file.
 	virtual QString fileName() const = 0;
 };
@@ -22,3 +22,9 @@ QSharedPointer<HardwareAbstractionInterface> HardwareAbstractionFactory::create(
 {
 	return QSharedPointer<stub::StubHardwareAbstraction>::create();
 }
+
+QSharedPointer<HardwareAbstractionInterface> HardwareAbstractionFactory::createWithFakeSysfs(
+		const QString &deviceFilesRoot)
+{
+	return QSharedPointer<stub::StubHardwareAbstraction>::create(deviceFilesRoot);
+}
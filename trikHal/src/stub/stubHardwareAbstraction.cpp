@@ -22,16 +22,27 @@
 #include "stubOutputDeviceFile.h"
 #include "stubFifo.h"
 
+#ifdef Q_OS_LINUX
+	#include "src/trik/trikInputDeviceFile.h"
+	#include "src/trik/trikOutputDeviceFile.h"
+#endif
+
 #include "QsLog.h"
 
 using namespace trikHal;
 using namespace trikHal::stub;
 
-StubHardwareAbstraction::StubHardwareAbstraction()
+StubHardwareAbstraction::StubHardwareAbstraction(const QString &deviceFilesRoot)
 	: mMspI2cBus(new StubMspI2C())
 	, mMspUsbBus(new StubMspUsb())
 	, mSystemConsole(new StubSystemConsole())
+	, mDeviceFilesRoot(deviceFilesRoot)
 {
+#ifndef Q_OS_LINUX
+	if (!mDeviceFilesRoot.isEmpty()) {
+		QLOG_WARN() << "Fake sysfs is not supported on this platform, device files are stubs";
+	}
+#endif
 }
 
 StubHardwareAbstraction::~StubHardwareAbstraction()
@@ -66,11 +77,23 @@ FifoInterface *StubHardwareAbstraction::createFifo(const QString &fileName) cons
 
 InputDeviceFileInterface *StubHardwareAbstraction::createInputDeviceFile(const QString &fileName) const
 {
+#ifdef Q_OS_LINUX
+	if (!mDeviceFilesRoot.isEmpty()) {
+		return new trik::TrikInputDeviceFile(mDeviceFilesRoot + "/" + fileName);
+	}
+#endif
+
 	return new StubInputDeviceFile(fileName);
 }
 
 OutputDeviceFileInterface *StubHardwareAbstraction::createOutputDeviceFile(const QString &fileName) const
 {
+#ifdef Q_OS_LINUX
+	if (!mDeviceFilesRoot.isEmpty()) {
+		return new trik::TrikOutputDeviceFile(mDeviceFilesRoot + "/" + fileName);
+	}
+#endif
+
 	return new StubOutputDeviceFile(fileName);
 }
 
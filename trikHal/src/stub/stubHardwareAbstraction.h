@@ -25,7 +25,10 @@ namespace stub {
 class StubHardwareAbstraction : public HardwareAbstractionInterface
 {
 public:
-	StubHardwareAbstraction();
+	/// Constructor.
+	/// @param deviceFilesRoot - if not empty, input and output device files are real files with their paths relative
+	///        to this directory (fake sysfs), otherwise they are stubs too. Fake sysfs is supported only on Linux.
+	explicit StubHardwareAbstraction(const QString &deviceFilesRoot = QString());
 	~StubHardwareAbstraction() override;
 
 	MspI2cInterface &mspI2c() override;
@@ -42,6 +45,7 @@ private:
 	QScopedPointer<MspI2cInterface> mMspI2cBus;
 	QScopedPointer<MspUsbInterface> mMspUsbBus;
 	QScopedPointer<SystemConsoleInterface> mSystemConsole;
+	const QString mDeviceFilesRoot;
 };
 
 }
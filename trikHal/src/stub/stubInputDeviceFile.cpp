@@ -43,3 +43,9 @@ void StubInputDeviceFile::reset()
 {
 	QLOG_INFO() << "Resetting stub input device file" << mFile.fileName();
 }
+
+QVector<int> StubInputDeviceFile::readNumbers()
+{
+	QLOG_TRACE() << "Reading numbers from stub input device file" << mFile.fileName();
+	return {};
+}
@@ -34,6 +34,7 @@ public:
 	void close() override;
 	QTextStream &stream() override;
 	void reset() override;
+	QVector<int> readNumbers() override;
 
 private:
 	QFile mFile;
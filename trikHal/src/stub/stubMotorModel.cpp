@@ -0,0 +1,92 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "stubMotorModel.h"
+
+#include <QtCore/qmath.h>
+
+using namespace trikHal::stub;
+
+static const int firstMotorCommand = 0x14;
+static const int firstEncoderCommand = 0x30;
+
+/// Speed of a wheel at full power, in encoder ticks per second.
+static const double maxSpeed = 1200;
+
+/// Time constant of a motor, in seconds.
+static const double timeConstant = 0.05;
+
+StubMotorModel::StubMotorModel()
+{
+	mTimer.start();
+}
+
+bool StubMotorModel::send(const QByteArray &data)
+{
+	if (data.size() != 3) {
+		return false;
+	}
+
+	const int command = static_cast<quint8>(data[0]) | (static_cast<quint8>(data[1]) << 8);
+	QMutexLocker locker(&mLock);
+	if (command >= firstMotorCommand && command < firstMotorCommand + wheels) {
+		update();
+
+		// Power out of range (like 0x7f used for braking) stops a wheel.
+		const int power = static_cast<qint8>(data[2]);
+		mPower[command - firstMotorCommand] = qAbs(power) <= 100 ? power : 0;
+		return true;
+	}
+
+	if (command >= firstEncoderCommand && command < firstEncoderCommand + wheels) {
+		update();
+		mPosition[command - firstEncoderCommand] = 0;
+		return true;
+	}
+
+	return false;
+}
+
+bool StubMotorModel::read(const QByteArray &data, int &result)
+{
+	if (data.size() < 1) {
+		return false;
+	}
+
+	const int command = static_cast<quint8>(data[0]) | (data.size() > 1 ? static_cast<quint8>(data[1]) << 8 : 0);
+	if (command < firstEncoderCommand || command >= firstEncoderCommand + wheels) {
+		return false;
+	}
+
+	QMutexLocker locker(&mLock);
+	update();
+	result = -qRound(mPosition[command - firstEncoderCommand]);
+	return true;
+}
+
+void StubMotorModel::update()
+{
+	const qint64 now = mTimer.nsecsElapsed();
+	const double dt = (now - mLastUpdate) / 1e9;
+	mLastUpdate = now;
+
+	// Exact solution of first-order system for constant power during the interval.
+	const double decay = qExp(-dt / timeConstant);
+	for (int i = 0; i < wheels; ++i) {
+		const double targetSpeed = mPower[i] / 100 * maxSpeed;
+		const double speed = targetSpeed + (mSpeed[i] - targetSpeed) * decay;
+		mPosition[i] += targetSpeed * dt + (mSpeed[i] - targetSpeed) * timeConstant * (1 - decay);
+		mSpeed[i] = speed;
+	}
+}
@@ -0,0 +1,53 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+
+namespace trikHal {
+namespace stub {
+
+/// Simulated power motors with encoders behind MSP stubs, so that closed-loop control can be tested without a robot.
+/// Motor with MSP command 0x14 + i turns a wheel which is read by encoder with MSP command 0x30 + i. Speed of a
+/// wheel follows power as first-order system, encoder counts ticks in the direction opposite to positive power.
+class StubMotorModel
+{
+public:
+	StubMotorModel();
+
+	/// Applies motor power or encoder reset command, returns false if command is not for a motor or an encoder.
+	bool send(const QByteArray &data);
+
+	/// Reads encoder, returns false if command is not for an encoder.
+	bool read(const QByteArray &data, int &result);
+
+private:
+	static const int wheels = 4;
+
+	/// Advances simulation to current time.
+	void update();
+
+	QMutex mLock;
+	QElapsedTimer mTimer;
+	qint64 mLastUpdate = 0;
+	double mPower[wheels] = {};
+	double mSpeed[wheels] = {};
+	double mPosition[wheels] = {};
+};
+
+}
+}
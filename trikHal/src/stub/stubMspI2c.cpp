@@ -20,13 +20,24 @@ using namespace trikHal::stub;
 
 void StubMspI2C::send(const QByteArray &data)
 {
-	QLOG_INFO() << "Sending thru MSP I2C stub" << data;
+	// Motor commands are sent every control loop cycle, so they are logged only at trace level.
+	if (mMotorModel.send(data)) {
+		QLOG_TRACE() << "Sending thru MSP I2C stub" << data;
+	} else {
+		QLOG_INFO() << "Sending thru MSP I2C stub" << data;
+	}
 }
 
 int StubMspI2C::read(const QByteArray &data)
 {
-	QLOG_INFO() << "Reading from MSP I2C stub" << data;
-	return 0;
+	int result = 0;
+	if (mMotorModel.read(data, result)) {
+		QLOG_TRACE() << "Reading from MSP I2C stub" << data << result;
+	} else {
+		QLOG_INFO() << "Reading from MSP I2C stub" << data;
+	}
+
+	return result;
 }
 
 bool StubMspI2C::connect(const QString &devicePath, int deviceId)
@@ -16,10 +16,12 @@
 
 #include "mspI2cInterface.h"
 
+#include "stubMotorModel.h"
+
 namespace trikHal {
 namespace stub {
 
-/// Empty implementation of I2C bus communicator. Only logs operations, returns 0 on all "read" calls.
+/// Stub implementation of I2C bus communicator. Simulates motors with encoders, other "read" calls return 0.
 class StubMspI2C : public MspI2cInterface
 {
 public:
@@ -27,6 +29,9 @@ public:
 	int read(const QByteArray &data) override;
 	bool connect(const QString &devicePath, int deviceId) override;
 	void disconnect() override;
+
+private:
+	StubMotorModel mMotorModel;
 };
 
 }
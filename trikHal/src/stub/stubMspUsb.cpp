@@ -20,13 +20,24 @@ using namespace trikHal::stub;
 
 void StubMspUsb::send(const QByteArray &data)
 {
-	QLOG_INFO() << "Sending thru MSP USB stub" << data;
+	// Motor commands are sent every control loop cycle, so they are logged only at trace level.
+	if (mMotorModel.send(data)) {
+		QLOG_TRACE() << "Sending thru MSP USB stub" << data;
+	} else {
+		QLOG_INFO() << "Sending thru MSP USB stub" << data;
+	}
 }
 
 int StubMspUsb::read(const QByteArray &data)
 {
-	QLOG_INFO() << "Reading from MSP USB stub" << data;
-	return 0;
+	int result = 0;
+	if (mMotorModel.read(data, result)) {
+		QLOG_TRACE() << "Reading from MSP USB stub" << data << result;
+	} else {
+		QLOG_INFO() << "Reading from MSP USB stub" << data;
+	}
+
+	return result;
 }
 
 bool StubMspUsb::connect()
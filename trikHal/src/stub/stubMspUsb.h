@@ -16,10 +16,12 @@
 
 #include "mspUsbInterface.h"
 
+#include "stubMotorModel.h"
+
 namespace trikHal {
 namespace stub {
 
-/// Empty implementation of MSP USB bus communicator. Only logs operations, returns 0 on all "read" calls.
+/// Stub implementation of MSP USB bus communicator. Simulates motors with encoders, other "read" calls return 0.
 class StubMspUsb : public MspUsbInterface
 {
 public:
@@ -27,6 +29,9 @@ public:
 	int read(const QByteArray &data) override;
 	bool connect() override;
 	void disconnect() override;
+
+private:
+	StubMotorModel mMotorModel;
 };
 
 }
@@ -36,9 +36,23 @@ void StubOutputDeviceFile::close()
 
 void StubOutputDeviceFile::write(const QString &data)
 {
+	mHasLastNumber = false;
 	QLOG_INFO() << "Writing to stub output device file" << mFile.fileName() << ":" << data;
 }
 
+void StubOutputDeviceFile::writeNumber(int value)
+{
+	if (mHasLastNumber && value == mLastNumber) {
+		return;
+	}
+
+	mHasLastNumber = true;
+	mLastNumber = value;
+
+	// Numbers are written by motors in control loops, so they are logged only at trace level.
+	QLOG_TRACE() << "Writing to stub output device file" << mFile.fileName() << ":" << value;
+}
+
 QString StubOutputDeviceFile::fileName() const
 {
 	return mFile.fileName();
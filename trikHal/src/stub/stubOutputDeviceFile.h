@@ -33,10 +33,15 @@ public:
 	bool open() override;
 	void close() override;
 	void write(const QString &data) override;
+	void writeNumber(int value) override;
 	QString fileName() const override;
 
 private:
 	QFile mFile;
+
+	/// Last value given to writeNumber(), unchanged values are skipped as real device file does.
+	bool mHasLastNumber = false;
+	int mLastNumber = 0;
 };
 
 }
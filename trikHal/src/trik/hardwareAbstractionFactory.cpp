@@ -15,6 +15,7 @@
 #include "hardwareAbstractionFactory.h"
 
 #include "trikHardwareAbstraction.h"
+#include "src/stub/stubHardwareAbstraction.h"
 
 using namespace trikHal;
 
@@ -22,3 +23,9 @@ QSharedPointer<HardwareAbstractionInterface> HardwareAbstractionFactory::create(
 {
 	return QSharedPointer<trik::TrikHardwareAbstraction>::create();
 }
+
+QSharedPointer<HardwareAbstractionInterface> HardwareAbstractionFactory::createWithFakeSysfs(
+		const QString &deviceFilesRoot)
+{
+	return QSharedPointer<stub::StubHardwareAbstraction>::create(deviceFilesRoot);
+}
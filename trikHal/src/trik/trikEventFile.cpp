@@ -16,6 +16,7 @@
 
 #include <unistd.h>
 #include <fcntl.h>
+#include <sys/time.h>
 #include <linux/input.h>
 
 #include <QtCore/QFileInfo>
@@ -25,10 +26,15 @@
 #include <QtCore/QSocketNotifier>
 
 #include <QsLog.h>
+#include <trikKernel/metrics.h>
 #include <trikKernel/timeVal.h>
 
 using namespace trikHal::trik;
 
+static trikKernel::Metrics::Counter &eventCount = trikKernel::Metrics::counter("hal.eventFile.events");
+static trikKernel::Metrics::Histogram &eventLatency = trikKernel::Metrics::histogram("hal.eventFile.latency");
+static trikKernel::Metrics::Histogram &dispatchTime = trikKernel::Metrics::histogram("hal.eventFile.dispatch");
+
 TrikEventFile::TrikEventFile(const QString &fileName, QThread &thread)
 	: mFileName(fileName)
 	, mThread(thread)
@@ -116,9 +122,19 @@ void TrikEventFile::readFile()
 
 	mSocketNotifier->setEnabled(false);
 
+	trikKernel::Metrics::ScopedTimer timer(dispatchTime);
 	while ((size = ::read(mEventFileDescriptor, reinterpret_cast<char *>(&event), sizeof(event)))
 			== static_cast<int>(sizeof(event)))
 	{
+		if (trikKernel::Metrics::isEnabled()) {
+			// Event times are taken by the kernel from the wall clock.
+			timeval now;
+			gettimeofday(&now, nullptr);
+			eventCount.add();
+			eventLatency.record((now.tv_sec - event.time.tv_sec) * Q_INT64_C(1000000)
+					+ now.tv_usec - event.time.tv_usec);
+		}
+
 		trikKernel::TimeVal eventTime(event.time.tv_sec, event.time.tv_usec);
 		emit newEvent(event.type, event.code, event.value, eventTime);
 	}
@@ -14,6 +14,10 @@
 
 #include "trikInputDeviceFile.h"
 
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
 #include <QsLog.h>
 
 using namespace trikHal::trik;
@@ -52,3 +56,48 @@ void TrikInputDeviceFile::reset()
 {
 	mStream.seek(0);
 }
+
+QVector<int> TrikInputDeviceFile::readNumbers()
+{
+	QVector<int> result;
+	if (!mFile.isOpen()) {
+		return result;
+	}
+
+	// Device files of drivers are small, and positioned read does not disturb the stream.
+	char buffer[256];
+	ssize_t size = 0;
+	do {
+		size = ::pread(mFile.handle(), buffer, sizeof(buffer), 0);
+	} while (size < 0 && errno == EINTR);
+
+	if (size < 0) {
+		QLOG_ERROR() << "Failed to read input device file" << mFile.fileName() << ":" << strerror(errno);
+		return result;
+	}
+
+	bool inNumber = false;
+	bool negative = false;
+	int value = 0;
+	for (ssize_t i = 0; i < size; ++i) {
+		const char c = buffer[i];
+		if (c >= '0' && c <= '9') {
+			if (!inNumber) {
+				inNumber = true;
+				negative = i > 0 && buffer[i - 1] == '-';
+				value = 0;
+			}
+
+			value = value * 10 + (c - '0');
+		} else if (inNumber) {
+			result.append(negative ? -value : value);
+			inNumber = false;
+		}
+	}
+
+	if (inNumber) {
+		result.append(negative ? -value : value);
+	}
+
+	return result;
+}
@@ -14,42 +14,140 @@
 
 #include "trikOutputDeviceFile.h"
 
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+
 #include <QsLog.h>
 
 using namespace trikHal::trik;
 
+/// Writes whole buffer to a file descriptor, at given offset or sequentially if offset is negative.
+static bool writeAll(int fileDescriptor, const char *data, int size, off_t offset)
+{
+	while (size > 0) {
+		const ssize_t written = offset < 0
+				? ::write(fileDescriptor, data, size)
+				: ::pwrite(fileDescriptor, data, size, offset);
+		if (written < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+
+			return false;
+		}
+
+		data += written;
+		size -= written;
+		if (offset >= 0) {
+			offset += written;
+		}
+	}
+
+	return true;
+}
+
+/// Formats integer as decimal text at the end of a buffer, returns pointer to the first character.
+static char *formatNumber(int value, char *end)
+{
+	// Unsigned arithmetic handles minimal int value.
+	unsigned int magnitude = value < 0 ? 0u - static_cast<unsigned int>(value) : static_cast<unsigned int>(value);
+	char *begin = end;
+	do {
+		*--begin = static_cast<char>('0' + magnitude % 10);
+		magnitude /= 10;
+	} while (magnitude != 0);
+
+	if (value < 0) {
+		*--begin = '-';
+	}
+
+	return begin;
+}
+
 TrikOutputDeviceFile::TrikOutputDeviceFile(const QString &fileName)
-	: mFile(fileName)
+	: mFileName(fileName)
+{
+}
+
+TrikOutputDeviceFile::~TrikOutputDeviceFile()
 {
+	close();
 }
 
 bool TrikOutputDeviceFile::open()
 {
-	QLOG_INFO() << "Opening output device file" << mFile.fileName();
+	QLOG_INFO() << "Opening output device file" << mFileName;
 
-	if (!mFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Unbuffered | QIODevice::Text)) {
-		QLOG_ERROR() << "File" << mFile.fileName() << " failed to open for writing";
+	close();
+	mFileDescriptor = ::open(mFileName.toLocal8Bit().constData(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0666);
+	if (mFileDescriptor < 0) {
+		QLOG_ERROR() << "File" << mFileName << " failed to open for writing:" << strerror(errno);
 		return false;
 	}
 
+	mSeekable = ::lseek(mFileDescriptor, 0, SEEK_CUR) >= 0;
+	mHasLastNumber = false;
+	mLastNumberLength = 0;
 	return true;
 }
 
 void TrikOutputDeviceFile::close()
 {
-	if (mFile.isOpen()) {
-		QLOG_INFO() << "Closing output device file" << mFile.fileName();
-		mFile.close();
+	if (mFileDescriptor >= 0) {
+		QLOG_INFO() << "Closing output device file" << mFileName;
+		::close(mFileDescriptor);
+		mFileDescriptor = -1;
 	}
 }
 
 void TrikOutputDeviceFile::write(const QString &data)
 {
-	mFile.write(data.toUtf8());
-	mFile.flush();
+	if (mFileDescriptor < 0) {
+		return;
+	}
+
+	// Text may not replace the last number completely, so the next number shall be written anyway.
+	mHasLastNumber = false;
+	mLastNumberLength = 0;
+
+	const QByteArray bytes = data.toUtf8();
+	if (!writeAll(mFileDescriptor, bytes.constData(), bytes.size(), -1)) {
+		QLOG_ERROR() << "Failed to write to output device file" << mFileName << ":" << strerror(errno);
+	}
+}
+
+void TrikOutputDeviceFile::writeNumber(int value)
+{
+	if (mFileDescriptor < 0 || (mHasLastNumber && value == mLastNumber)) {
+		return;
+	}
+
+	char buffer[16];
+	char * const end = buffer + sizeof(buffer);
+	const char * const begin = formatNumber(value, end);
+	const int length = static_cast<int>(end - begin);
+
+	if (!writeAll(mFileDescriptor, begin, length, mSeekable ? 0 : -1)) {
+		QLOG_ERROR() << "Failed to write" << value << "to output device file" << mFileName << ":" << strerror(errno);
+		mHasLastNumber = false;
+		return;
+	}
+
+	// Drivers take the whole value from one write, but ordinary files (like fake sysfs in tests) keep the tail of
+	// a longer previous value. Truncation is not supported by some device files, so its failure is ignored.
+	if (mSeekable && length < mLastNumberLength) {
+		const int result = ::ftruncate(mFileDescriptor, length);
+		Q_UNUSED(result)
+	}
+
+	mHasLastNumber = true;
+	mLastNumber = value;
+	mLastNumberLength = length;
 }
 
 QString TrikOutputDeviceFile::fileName() const
 {
-	return mFile.fileName();
+	return mFileName;
 }
@@ -15,14 +15,15 @@
 #pragma once
 
 #include <QtCore/QString>
-#include <QtCore/QFile>
 
 #include "outputDeviceFileInterface.h"
 
 namespace trikHal {
 namespace trik {
 
-/// Real implementation for output device file (a file to which we can only write).
+/// Real implementation for output device file (a file to which we can only write). Writes go directly to a file
+/// descriptor without buffering. Numbers are written at the beginning of a file by one pwrite() call, as drivers
+/// expect them, and unchanged numbers are not written at all.
 class TrikOutputDeviceFile : public OutputDeviceFileInterface
 {
 public:
@@ -30,14 +31,27 @@ public:
 	/// @param fileName - name of a device file .
 	TrikOutputDeviceFile(const QString &fileName);
 
+	~TrikOutputDeviceFile() override;
+
 	bool open() override;
 	void close() override;
 	void write(const QString &data) override;
+	void writeNumber(int value) override;
 	QString fileName() const override;
 
 private:
-	/// Underlying file.
-	QFile mFile;
+	QString mFileName;
+
+	/// Underlying file descriptor, -1 if a file is not open.
+	int mFileDescriptor = -1;
+
+	/// False for pipes, they are written sequentially.
+	bool mSeekable = false;
+
+	/// Last value written by writeNumber() and length of its text, valid if mHasLastNumber is true.
+	bool mHasLastNumber = false;
+	int mLastNumber = 0;
+	int mLastNumberLength = 0;
 };
 
 }
@@ -13,6 +13,7 @@
  * limitations under the License. */
 
 #include "trikV4l2VideoDevice.h"
+#include "yuvConversion.h"
 
 #include <sys/ioctl.h>
 #include <sys/mman.h>
@@ -23,6 +24,7 @@
 #include <unistd.h>
 #include <QtCore/QEventLoop>
 #include <QtCore/QTimer>
+#include <trikKernel/metrics.h>
 #include "QsLog.h"
 
 #define v4l2_open open
@@ -31,80 +33,8 @@
 #define v4l2_munmap munmap
 #define v4l2_ioctl ioctl
 
-// convertion funtions
+// convertion funtions, see also yuvConversion.h
 namespace {
-
-	inline unsigned clip255(int x) { return x >= 255 ? 255 : (x <= 0)? 0 : x; }
-
-	QVector<uint8_t> yuyvToRgb(const QVector<uint8_t> &shot, int height, int width) {
-		// yuyv (yuv422) convertion to rgb888
-		QVector<uint8_t> result(height * width * 3);
-		int startIndex = 0;
-		for (auto row = 0; row < height; ++ row) {
-			for (auto col = 0; col < width; col+=2) {
-				// format is y0 cb y1 cr, cb and cr are equal for 2 pixels
-				auto y0 = shot[startIndex];
-				auto cb = shot[startIndex + 1];
-				auto y1 = shot[startIndex + 2];
-				auto cr = shot[startIndex + 3];
-				startIndex += 4;
-
-				auto resRgb = &result[(row * width + col) * 3];
-				resRgb[0] = clip255(y0 + 1.402 * (cr - 128)); // red
-				resRgb[1] = clip255(y0 - 0.3441 * (cb - 128) - 0.7141 * (cr - 128)); // green
-				resRgb[2] = clip255(y0 + 1.772 * (cb - 128)); // blue
-
-				resRgb[3] = clip255(y1 + 1.402 * (cr - 128)); // red
-				resRgb[4] = clip255(y1 - 0.3441 * (cb - 128) - 0.7141 * (cr - 128)); // green
-				resRgb[5] = clip255(y1 + 1.772 * (cb - 128)); // blue
-			}
-		}
-
-		return result;
-	}
-
-	QVector<uint8_t> yuv422pToRgb(const QVector<uint8_t> &shot, int height, int width) {
-		// yuv422p convertion to rgb888
-		QVector<uint8_t> result(height * width * 3);
-		if ( width <= 0 || height <= 0 )
-			return result;
-		const auto Y = &shot[0];
-		const auto U = &shot[width * height];
-		const auto V = &shot[3 * width * height / 2];
-
-		for (auto row = 0; row < height; ++row) {
-			for (auto col = 0; col < width; col+=2) {
-				auto startIndex = row * width + col;
-				auto y1 = Y[startIndex] - 16;
-				auto y2 = Y[startIndex+1] - 16;
-				auto u  = U[startIndex>>1] - 128;
-				auto v  = V[startIndex>>1] - 128;
-				auto _298y1 = 298 * y1;
-				auto _298y2 = 298 * y2;
-				auto _409v  = 409 * v;
-				auto _100u  = -100 * u;
-				auto _516u  = 516 * u;
-				auto _208v  = -208 * v;
-				auto r1 = clip255 ((_298y1 + _409v + 128) >> 8);
-				auto g1 = clip255 ((_298y1 + _100u + _208v + 128) >> 8);
-				auto b1 = clip255 ((_298y1 + _516u + 128) >> 8);
-				auto r2 = clip255 ((_298y2 + _409v + 128) >> 8);
-				auto g2 = clip255 ((_298y2 + _100u + _208v + 128) >> 8);
-				auto b2 = clip255 ((_298y2 + _516u + 128) >> 8);
-
-				auto rgb = &result[startIndex*3];
-				rgb[0] = r1;
-				rgb[1] = g1;
-				rgb[2] = b1;
-				rgb[3] = r2;
-				rgb[4] = g2;
-				rgb[5] = b2;
-			}
-		}
-
-		return result;
-	}
-
 	QVector<uint8_t> convertToEmpty(const QVector<uint8_t> &shot, int height, int width) {
 		Q_UNUSED(shot);
 		Q_UNUSED(height);
@@ -116,6 +46,10 @@ namespace {
 
 template <typename T> void reset(T &x) { ::memset(&x, 0, sizeof(x)); }
 
+static trikKernel::Metrics::Histogram &shotTime = trikKernel::Metrics::histogram("hal.v4l2.shot");
+static trikKernel::Metrics::Histogram &dequeueTime = trikKernel::Metrics::histogram("hal.v4l2.dequeue");
+static trikKernel::Metrics::Histogram &conversionTime = trikKernel::Metrics::histogram("hal.v4l2.conversion");
+
 TrikV4l2VideoDevice::TrikV4l2VideoDevice(const QString &inputFile)
 	: fileDevicePath(inputFile), mConvertFunc(convertToEmpty)
 {
@@ -200,11 +134,11 @@ void TrikV4l2VideoDevice::setFormat()
 			// V4L2_PIX_FMT_YUYV
 			if (fmtTry.pixelformat == V4L2_PIX_FMT_YUV422P) {
 				QLOG_INFO() << "V4l2: found format V4L2_PIX_FMT_YUV422P";
-				mConvertFunc = yuv422pToRgb;
+				mConvertFunc = trikHal::trik::yuv422pToRgb;
 				break;
 			} else if (fmtTry.pixelformat == V4L2_PIX_FMT_YUYV) {
 				QLOG_INFO() << "V4l2: found format V4L2_PIX_FMT_YUYV (YUV422)";
-				mConvertFunc = yuyvToRgb;
+				mConvertFunc = trikHal::trik::yuyvToRgb;
 				break;
 			}
 		}
@@ -254,6 +188,7 @@ void TrikV4l2VideoDevice::closeDevice()
 
 const QVector<uint8_t> & TrikV4l2VideoDevice::makeShot()
 {
+	trikKernel::Metrics::ScopedTimer timer(shotTime);
 	QEventLoop loop;
 	QTimer watchdog;
 	watchdog.setSingleShot(true);
@@ -283,6 +218,7 @@ const QVector<uint8_t> & TrikV4l2VideoDevice::makeShot()
 				<< "bytes, got " << mFrame.size() / 4 * 2 << " bytes";
 	}
 
+	trikKernel::Metrics::ScopedTimer conversionTimer(conversionTime);
 	mFrame = mConvertFunc(mFrame, IMAGE_HEIGHT, IMAGE_WIDTH);
 	return mFrame;
 }
@@ -361,6 +297,7 @@ void TrikV4l2VideoDevice::readFrameData(int fd) {
 	}
 
 	mNotifier->setEnabled(false);
+	trikKernel::Metrics::ScopedTimer timer(dequeueTime);
 	v4l2_buffer buf;
 	reset(buf);
 	buf.type = mFormat.type;
@@ -30,6 +30,7 @@
 #include <QtCore/QThread>
 
 #include <QsLog.h>
+#include <trikKernel/metrics.h>
 
 #include "usbMSP430Defines.h"
 #include "usbMSP430Interface.h"
@@ -170,10 +171,14 @@ uint32_t init_USBTTYDevice()
 	return NO_ERROR;
 }
 
+static trikKernel::Metrics::Histogram &packetTime = trikKernel::Metrics::histogram("msp.usb.packet");
+static trikKernel::Metrics::Counter &packetErrors = trikKernel::Metrics::counter("msp.usb.errors");
+
 /// Send USB packet
 uint32_t sendUSBPacket(char *in_msp_packet
 			, char *out_msp_packet)
 {
+	trikKernel::Metrics::ScopedTimer timer(packetTime);
 	uint32_t tout = 0;	    // Timeout counter
 	uint32_t n_written = 0;	    // Number of written bytes
 	int32_t n_read = 0;	    // Number of read bytes
@@ -193,6 +198,7 @@ uint32_t sendUSBPacket(char *in_msp_packet
 	if (n_written != strlen(s1))
 	{
 		QLOG_ERROR() << "Error writing: " << strerror(errno);
+		packetErrors.add();
 		return PACKET_ERROR;
 	}
 	tcflush(usb_out_descr, TCOFLUSH);
@@ -212,6 +218,7 @@ uint32_t sendUSBPacket(char *in_msp_packet
 		QLOG_ERROR() << "Error reading: " << strerror(errno);
 		out_msp_packet[0] = 0x00;
 		out_msp_packet[1] = 0x00;
+		packetErrors.add();
 		return PACKET_ERROR;
 	}
 	else
@@ -0,0 +1,29 @@
+/* Copyright 2018 Ivan Tyulyandin and CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QVector>
+
+namespace trikHal {
+namespace trik {
+
+/// Converts a frame in YUYV format (packed YUV 4:2:2, "y0 cb y1 cr" for every 2 pixels) to RGB888.
+QVector<uint8_t> yuyvToRgb(const QVector<uint8_t> &shot, int height, int width);
+
+/// Converts a frame in YUV 4:2:2 planar format (Y plane, then U and V planes of half width) to RGB888.
+QVector<uint8_t> yuv422pToRgb(const QVector<uint8_t> &shot, int height, int width);
+
+}
+}
@@ -40,7 +40,8 @@ PUBLIC_HEADERS += \
 		$$PWD/src/trik/trikFifo.h \
 		$$PWD/src/trik/usbMsp/usbMSP430Interface.h \
 		$$PWD/src/trik/usbMsp/usbMSP430Defines.h \
-		$$PWD/src/trik/trikV4l2VideoDevice.h
+		$$PWD/src/trik/trikV4l2VideoDevice.h \
+		$$PWD/src/trik/yuvConversion.h
 }
 
 HEADERS += \
@@ -52,6 +53,7 @@ HEADERS += \
 	$$PWD/src/stub/stubInputDeviceFile.h \
 	$$PWD/src/stub/stubOutputDeviceFile.h \
 	$$PWD/src/stub/stubFifo.h \
+	$$PWD/src/stub/stubMotorModel.h \
 
 !win32:!macx {
 	SOURCES += \
@@ -64,7 +66,8 @@ HEADERS += \
 		$$PWD/src/trik/trikOutputDeviceFile.cpp \
 		$$PWD/src/trik/trikFifo.cpp \
 		$$PWD/src/trik/usbMsp/usbMSP430Interface.cpp \
-		$$PWD/src/trik/trikV4l2VideoDevice.cpp
+		$$PWD/src/trik/trikV4l2VideoDevice.cpp \
+		$$PWD/src/trik/yuvConversion.cpp
 }
 
 SOURCES += \
@@ -76,6 +79,7 @@ SOURCES += \
 	$$PWD/src/stub/stubInputDeviceFile.cpp \
 	$$PWD/src/stub/stubOutputDeviceFile.cpp \
 	$$PWD/src/stub/stubFifo.cpp \
+	$$PWD/src/stub/stubMotorModel.cpp \
 
 equals(ARCHITECTURE, arm) {
 	SOURCES += $$PWD/src/trik/hardwareAbstractionFactory.cpp
@@ -16,15 +16,19 @@
 
 #include <QtCore/QString>
 #include <QtCore/QStringList>
-#include <QtCore/QHash>
-
-class QDomElement;
+#include <QtCore/QSharedPointer>
 
 namespace trikKernel {
 
+class ConfigurationModel;
+
 /// Generic configuration helper, parses configuration XML files and presents configuration as a set of attributes
 /// with their values for each configurable device. Respects configuration overriding rules:
 /// Model config > device type config > device-port pair config > device class config
+///
+/// Configuration is compiled once and cached in a binary file next to model config, so configurers created for the
+/// same files (by brick, GUI and mailbox) share one model and do not parse XML while config files are unchanged.
+/// Configurers are cheap to copy.
 class Configurer
 {
 public:
@@ -33,9 +37,14 @@ public:
 	/// @param modelConfig - file name (with path) of model config, absolute or relative to current directory.
 	Configurer(const QString &systemConfig, const QString &modelConfig);
 
+	~Configurer();
+
 	/// Returns value of given attribute of given device.
 	QString attributeByDevice(const QString &deviceClass, const QString &attributeName) const;
 
+	/// Returns true if given device has given attribute, to check optional attributes without an exception.
+	bool hasAttributeByDevice(const QString &deviceClass, const QString &attributeName) const;
+
 	/// Returns value of given attribute of a device on given port.
 	QString attributeByPort(const QString &port, const QString &attributeName) const;
 
@@ -61,56 +70,8 @@ public:
 	QString version() const;
 
 private:
-	struct Device {
-		QString name;
-		QHash<QString, QString> attributes;
-		QHash<QString, QHash<QString, QString>> portSpecificAttributes;
-		bool isOptional = false;
-	};
-
-	struct DeviceType {
-		QString name;
-		QString deviceClass;
-		QHash<QString, QString> attributes;
-	};
-
-	struct ModelConfigurationElement {
-		QString port;
-		QString deviceType;
-		QHash<QString, QString> attributes;
-	};
-
-	struct AdditionalModelConfigurationElement {
-		QString deviceClass;
-		QHash<QString, QString> attributes;
-	};
-
-	void parseDeviceClasses(const QDomElement &element);
-	void parseDevicePorts(const QDomElement &element);
-	void parseDeviceTypes(const QDomElement &element);
-	void parseInitScript(const QDomElement &element);
-	void parseAdditionalConfigurations(const QDomElement &element);
-	void parseModelConfig(const QDomElement &element);
-
-	QStringList mInitScripts;
-
-	/// Maps device class name to its configuration.
-	QHash<QString, Device> mDevices;
-
-	/// Maps device type name to its configuration.
-	QHash<QString, DeviceType> mDeviceTypes;
-
-	/// Maps device class name to its configuration.
-	QHash<QString, Device> mAdditionalConfiguration;
-
-	/// Maps port name to configuration of device on that port.
-	QHash<QString, ModelConfigurationElement> mModelConfiguration;
-
-	/// Maps device type name to its configuration.
-	QHash<QString, AdditionalModelConfigurationElement> mAdditionalModelConfiguration;
-
-	/// Version of the config file which shall correspond to casing model.
-	QString mVersion;
+	/// Compiled configuration, shared with other configurers of the same config files until configure() is called.
+	QSharedPointer<const ConfigurationModel> mModel;
 };
 
 }
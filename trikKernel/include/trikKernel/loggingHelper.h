@@ -31,8 +31,14 @@ public:
 	/// @param pathToLog - path to "trik.log" file that will be created or appended by logger. Supposed to end with "/".
 	LoggingHelper(const QString &pathToLog);
 
+	/// Destructor. Waits until all logged messages are written to disk.
 	~LoggingHelper();
 
+	/// Sets logging levels of categories (names of modules or source files, like "trikNetwork" or "mailboxServer")
+	/// from a string like "trikNetwork=warn,trikControl=info". Levels are trace, debug, info, warn, error, fatal
+	/// and off. Returns false if the string is malformed, levels that were parsed before an error are applied.
+	static bool setCategoryLevels(const QString &levels);
+
 private:
 	QSharedPointer<QsLogging::Destination> mFileDestination;
 	QSharedPointer<QsLogging::Destination> mConsoleDestination;
@@ -0,0 +1,171 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QAtomicInteger>
+#include <QtCore/QByteArray>
+#include <QtCore/QString>
+
+namespace trikKernel {
+
+/// Process-wide registry of performance metrics: counters, histograms and timers that feed histograms and a trace.
+/// Metrics are registered once by name, usually into static references at file scope of instrumented code, and are
+/// updated without locks. Metrics are disabled by default; when disabled, updating a metric costs one relaxed atomic
+/// load and a branch, so instrumentation can stay in hot paths.
+///
+/// Timed sections are also recorded into a ring of the latest trace events which can be dumped in Chrome trace event
+/// format (chrome://tracing, Perfetto).
+///
+/// For example:
+///     static trikKernel::Metrics::Histogram &readTime = trikKernel::Metrics::histogram("msp.i2c.read");
+///     ...
+///     trikKernel::Metrics::ScopedTimer timer(readTime);
+class Metrics
+{
+public:
+	/// Monotonically increasing counter.
+	class Counter
+	{
+	public:
+		/// Adds given value to a counter if metrics are enabled.
+		inline void add(qint64 value = 1)
+		{
+			if (isEnabled()) {
+				mValue.fetchAndAddRelaxed(value);
+			}
+		}
+
+		qint64 value() const;
+
+		const QString &name() const;
+
+	private:
+		friend class Metrics;
+
+		explicit Counter(const QString &name);
+		Q_DISABLE_COPY(Counter)
+
+		const QString mName;
+		QAtomicInteger<qint64> mValue;
+	};
+
+	/// Distribution of values (usually durations in microseconds) in buckets of powers of 2.
+	class Histogram
+	{
+	public:
+		/// Records a value if metrics are enabled.
+		inline void record(qint64 value)
+		{
+			if (isEnabled()) {
+				doRecord(value);
+			}
+		}
+
+		qint64 count() const;
+
+		qint64 sum() const;
+
+		qint64 max() const;
+
+		/// Returns an estimate of a percentile: upper bound of a bucket where it falls, but not more than max().
+		/// @param fraction - percentile as a fraction, from 0 to 1.
+		qint64 percentile(qreal fraction) const;
+
+		const QString &name() const;
+
+	private:
+		friend class Metrics;
+
+		/// Bucket i > 0 holds values from 2^(i - 1) to 2^i - 1, bucket 0 holds values less than 1.
+		static const int buckets = 40;
+
+		explicit Histogram(const QString &name);
+		Q_DISABLE_COPY(Histogram)
+
+		void doRecord(qint64 value);
+
+		void clear();
+
+		const QString mName;
+
+		/// Name in UTF-8, used by trace dump.
+		const QByteArray mUtf8Name;
+
+		QAtomicInteger<qint64> mCount;
+		QAtomicInteger<qint64> mSum;
+		QAtomicInteger<qint64> mMax;
+		QAtomicInteger<qint64> mBuckets[buckets];
+	};
+
+	/// Measures time of a scope in microseconds, records it into a histogram and adds a trace event. Does nothing if
+	/// metrics were disabled when timer was created.
+	class ScopedTimer
+	{
+	public:
+		explicit ScopedTimer(Histogram &histogram)
+			: mHistogram(isEnabled() ? &histogram : nullptr)
+			, mStart(mHistogram ? now() : 0)
+		{
+		}
+
+		~ScopedTimer()
+		{
+			if (mHistogram) {
+				finish(*mHistogram, mStart);
+			}
+		}
+
+	private:
+		Q_DISABLE_COPY(ScopedTimer)
+
+		Histogram * const mHistogram;
+		const qint64 mStart;
+	};
+
+	/// Returns true if metrics are collected.
+	static inline bool isEnabled()
+	{
+		return sEnabled.load() != 0;
+	}
+
+	/// Enables or disables collection of metrics. Collected values are kept when metrics are disabled.
+	static void setEnabled(bool enabled);
+
+	/// Returns counter with given name, registering it on first call. Reference is valid until process exits.
+	static Counter &counter(const QString &name);
+
+	/// Returns histogram with given name, registering it on first call. Reference is valid until process exits.
+	static Histogram &histogram(const QString &name);
+
+	/// Returns time in microseconds of a monotonic clock, used by timers and trace.
+	static qint64 now();
+
+	/// Clears all metrics and trace.
+	static void reset();
+
+	/// Returns human-readable report with one metric per line, sorted by name.
+	static QString report();
+
+	/// Returns the latest trace events as Chrome trace event format JSON.
+	static QByteArray chromeTrace();
+
+private:
+	/// Records duration of a timed section that started at given time, and adds a trace event.
+	static void finish(Histogram &histogram, qint64 start);
+
+	static QBasicAtomicInt sEnabled;
+};
+
+}
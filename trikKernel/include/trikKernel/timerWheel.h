@@ -0,0 +1,147 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <functional>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMutex>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QWaitCondition>
+
+class QObject;
+
+namespace trikKernel {
+
+/// Shared timer service: hierarchical hashed timer wheel driven by one background thread. Starting, restarting and
+/// stopping a timer is O(1) and does not involve event dispatcher of a calling thread, so it is cheap enough to be
+/// done on every sensor event or network packet (hang detection, keepalives and so on).
+///
+/// Callbacks are called in a thread of the wheel, with internal lock held, so they shall be short and shall not
+/// block. The usual way is to post a queued call to an object living in other thread, see startQueued().
+/// It is safe to start, restart and stop timers from a callback. When stop() returns, the callback of a stopped
+/// timer is guaranteed not to be running and not to be called again.
+class TimerWheel
+{
+public:
+	/// Timer identifier, 0 is never a valid id.
+	typedef quint64 TimerId;
+
+	/// Timer callback.
+	typedef std::function<void()> Callback;
+
+	/// Constructor. Starts the wheel thread.
+	/// @param tickMicroseconds - resolution of a wheel.
+	explicit TimerWheel(int tickMicroseconds = 1000);
+
+	~TimerWheel();
+
+	/// Returns wheel shared by all components of the runtime.
+	static TimerWheel &instance();
+
+	/// Starts a timer.
+	/// @param milliseconds - interval of a timer.
+	/// @param callback - function to call when the timer expires, is called in the wheel thread.
+	/// @param singleShot - if true, timer is stopped and forgotten after first expiration, otherwise it is periodic.
+	/// @returns id of the timer.
+	TimerId start(int milliseconds, const Callback &callback, bool singleShot = false);
+
+	/// Starts a timer that invokes given slot or Q_INVOKABLE method of a receiver through a queued connection, so it
+	/// is executed in a thread of a receiver. Timer shall be stopped before receiver is deleted.
+	TimerId startQueued(int milliseconds, QObject *receiver, const char *method, bool singleShot = false);
+
+	/// Restarts timer with its interval counted from now, like QTimer::start() without parameters.
+	/// @returns false if there is no such timer, including expired single-shot ones, so a new timer shall be started.
+	bool restart(TimerId id);
+
+	/// Stops and forgets timer. Does nothing if there is no such timer or it is an expired single-shot one.
+	void stop(TimerId id);
+
+	/// Returns number of timers that are waiting for expiration.
+	int activeTimers() const;
+
+	/// Returns resolution of a wheel in microseconds.
+	int tickMicroseconds() const;
+
+private:
+	class Driver;
+	struct Node;
+
+	/// Wheel has 4 levels, 64 slots each, that gives 2^24 ticks (4.6 hours with default resolution) before
+	/// timer shall be recascaded from the topmost level.
+	static const int levels = 4;
+	static const int slotBits = 6;
+	static const int slotCount = 1 << slotBits;
+	static const int slotMask = slotCount - 1;
+
+	/// Puts a node into a slot corresponding to its expiration tick.
+	void link(Node *node);
+
+	/// Removes a node from its slot, if any.
+	void unlink(Node *node);
+
+	/// Moves all nodes from a slot of upper level to a lower ones.
+	void cascade(int level);
+
+	/// Processes all ticks up to current time. Called by driver with mMutex locked.
+	void advance();
+
+	/// Returns number of ticks driver can sleep without missing a timer.
+	qint64 idleTicks() const;
+
+	/// Returns current tick according to mClock.
+	qint64 now() const;
+
+	/// Body of a driver thread.
+	void run();
+
+	const int mTickMicroseconds;
+
+	QElapsedTimer mClock;
+
+	/// Last processed tick.
+	qint64 mCurrentTick = 0;
+
+	/// Slot lists with sentinel heads.
+	Node *mSlots[levels][slotCount];
+
+	QHash<TimerId, Node *> mTimers;
+
+	/// Node which callback is being executed right now.
+	Node *mFiring = nullptr;
+
+	/// True, if mFiring was stopped by its own callback.
+	bool mFiringStopped = false;
+
+	TimerId mNextId = 1;
+
+	int mActive = 0;
+
+	/// Guards all the wheel. Recursive, so callbacks can manipulate timers.
+	mutable QMutex mMutex;
+
+	/// Tick at which sleeping driver will wake up, timers expiring earlier shall wake it.
+	qint64 mNextWake = -1;
+
+	/// Used by driver to sleep until next tick or until woken up by new timer.
+	QMutex mSleepMutex;
+	QWaitCondition mWakeUp;
+	bool mStopping = false;
+
+	QScopedPointer<Driver> mDriver;
+};
+
+}
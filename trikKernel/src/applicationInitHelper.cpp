@@ -67,6 +67,11 @@ ApplicationInitHelper::ApplicationInitHelper(QCoreApplication &app)
 			, QObject::tr("Path to a directory where core dump will be saved in case of creation.")
 			);
 
+	mCommandLineParser.addOption("l", "log-levels"
+			, QObject::tr("Logging levels of modules or source files, for example \"trikNetwork=warn,trikGui=info\".\n"
+			"\tLevels are trace, debug, info, warn, error, fatal and off.")
+			);
+
 #ifdef Q_WS_QWS
 	if (!app.arguments().contains("--no-display") && !app.arguments().contains("-no-display")) {
 		QWSServer * const server = QWSServer::instance();
@@ -112,6 +117,10 @@ void ApplicationInitHelper::init()
 		mConfigPath = trikKernel::FileUtils::normalizePath(mCommandLineParser.value("c"));
 	}
 
+	if (mCommandLineParser.isSet("l")) {
+		LoggingHelper::setCategoryLevels(mCommandLineParser.value("l"));
+	}
+
 	QLOG_INFO() << "====================================================================";
 }
 
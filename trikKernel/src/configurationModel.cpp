@@ -0,0 +1,601 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "src/configurationModel.h"
+
+#include <functional>
+
+#include <QtCore/QCryptographicHash>
+#include <QtCore/QDataStream>
+#include <QtCore/QDateTime>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QFileInfo>
+#include <QtCore/QMutex>
+#include <QtCore/QSaveFile>
+#include <QtCore/QWeakPointer>
+#include <QtXml/QDomElement>
+
+#include <QsLog.h>
+
+#include "exceptions/malformedConfigException.h"
+#include "fileUtils.h"
+
+#if QT_VERSION < QT_VERSION_CHECK(5, 0, 0)
+	#define QDomNamedNodeMapLengthType unsigned
+#else
+	#define QDomNamedNodeMapLengthType int
+#endif
+
+using namespace trikKernel;
+
+/// Identifies cache files, "TCFG".
+static const quint32 cacheMagic = 0x54434647;
+
+/// Shall be incremented when layout of a cache file changes.
+static const quint32 cacheFormatVersion = 1;
+
+/// Models used at the moment, by paths of their config files. Models are owned by configurers, so a model is loaded
+/// again when all configurers that used it are destroyed.
+static QHash<QString, QWeakPointer<const ConfigurationModel>> loadedModels;
+static QMutex loadedModelsLock;
+
+namespace trikKernel {
+
+static QDataStream &operator <<(QDataStream &stream, const ConfigurationModel::Device &device)
+{
+	return stream << device.name << device.attributes << device.portSpecificAttributes << device.isOptional;
+}
+
+static QDataStream &operator >>(QDataStream &stream, ConfigurationModel::Device &device)
+{
+	return stream >> device.name >> device.attributes >> device.portSpecificAttributes >> device.isOptional;
+}
+
+static QDataStream &operator <<(QDataStream &stream, const ConfigurationModel::DeviceType &deviceType)
+{
+	return stream << deviceType.name << deviceType.deviceClass << deviceType.attributes;
+}
+
+static QDataStream &operator >>(QDataStream &stream, ConfigurationModel::DeviceType &deviceType)
+{
+	return stream >> deviceType.name >> deviceType.deviceClass >> deviceType.attributes;
+}
+
+static QDataStream &operator <<(QDataStream &stream, const ConfigurationModel::PortConfiguration &configuration)
+{
+	return stream << configuration.deviceType << configuration.attributes;
+}
+
+static QDataStream &operator >>(QDataStream &stream, ConfigurationModel::PortConfiguration &configuration)
+{
+	return stream >> configuration.deviceType >> configuration.attributes;
+}
+
+static QDataStream &operator <<(QDataStream &stream, const ConfigurationModel::Port &port)
+{
+	return stream << port.deviceType << port.deviceClass << port.classError << port.attributeError << port.values;
+}
+
+static QDataStream &operator >>(QDataStream &stream, ConfigurationModel::Port &port)
+{
+	return stream >> port.deviceType >> port.deviceClass >> port.classError >> port.attributeError >> port.values;
+}
+
+static QDataStream &operator <<(QDataStream &stream, const ConfigurationModel::FileStamp &stamp)
+{
+	return stream << stamp.path << stamp.hash;
+}
+
+static QDataStream &operator >>(QDataStream &stream, ConfigurationModel::FileStamp &stamp)
+{
+	return stream >> stamp.path >> stamp.hash;
+}
+
+}
+
+/// Returns stamp of a file without hash.
+static ConfigurationModel::FileStamp fileStamp(const QString &fileName)
+{
+	const QFileInfo info(fileName);
+	ConfigurationModel::FileStamp stamp;
+	stamp.path = info.exists() ? info.canonicalFilePath() : info.absoluteFilePath();
+	if (info.exists()) {
+		stamp.size = info.size();
+		stamp.modified = info.lastModified().toMSecsSinceEpoch();
+	}
+
+	return stamp;
+}
+
+/// Computes hash of a file, leaves it empty if file can not be read.
+static void hashFile(ConfigurationModel::FileStamp &stamp)
+{
+	QFile file(stamp.path);
+	if (file.open(QIODevice::ReadOnly)) {
+		QCryptographicHash hash(QCryptographicHash::Sha1);
+		if (hash.addData(&file)) {
+			stamp.hash = hash.result();
+		}
+	}
+}
+
+static bool isSameFile(const ConfigurationModel::FileStamp &loaded, const ConfigurationModel::FileStamp &current)
+{
+	return loaded.size == current.size && loaded.modified == current.modified;
+}
+
+QSharedPointer<const ConfigurationModel> ConfigurationModel::load(const QString &systemConfig
+		, const QString &modelConfig)
+{
+	FileStamp systemConfigStamp = fileStamp(systemConfig);
+	FileStamp modelConfigStamp = fileStamp(modelConfig);
+	const QString key = systemConfigStamp.path + '\n' + modelConfigStamp.path;
+
+	// Lock is held while loading, so configurers created in parallel for the same files wait for one model.
+	QMutexLocker locker(&loadedModelsLock);
+	const QSharedPointer<const ConfigurationModel> loaded = loadedModels.value(key).toStrongRef();
+	if (loaded && isSameFile(loaded->mSystemConfig, systemConfigStamp)
+			&& isSameFile(loaded->mModelConfig, modelConfigStamp))
+	{
+		return loaded;
+	}
+
+	hashFile(systemConfigStamp);
+	hashFile(modelConfigStamp);
+
+	const QString cacheFile = cacheFileName(modelConfig);
+	QSharedPointer<ConfigurationModel> model = readCache(cacheFile, systemConfigStamp, modelConfigStamp);
+	const bool fromCache = !model.isNull();
+	if (!fromCache) {
+		model.reset(new ConfigurationModel());
+		model->parse(systemConfig, modelConfig);
+	}
+
+	model->mSystemConfig = systemConfigStamp;
+	model->mModelConfig = modelConfigStamp;
+	if (!fromCache && !systemConfigStamp.hash.isEmpty() && !modelConfigStamp.hash.isEmpty()) {
+		model->writeCache(cacheFile);
+	}
+
+	loadedModels.insert(key, model);
+	return model;
+}
+
+QString ConfigurationModel::cacheFileName(const QString &modelConfig)
+{
+	const QFileInfo info(modelConfig);
+	return info.absoluteDir().filePath(info.completeBaseName() + ".cache");
+}
+
+const ConfigurationModel::Port *ConfigurationModel::port(const QString &name) const
+{
+	const auto port = mPorts.constFind(name);
+	return port != mPorts.constEnd() ? &port.value() : nullptr;
+}
+
+const QString *ConfigurationModel::attribute(const Port &port, const QString &attributeName) const
+{
+	const qint32 key = mKeyIds.value(attributeName, -1);
+	if (key < 0) {
+		return nullptr;
+	}
+
+	const qint32 value = port.values.at(key);
+	return value >= 0 ? &mValues.at(value) : nullptr;
+}
+
+const QString *ConfigurationModel::attribute(const QString &deviceClass, const QString &attributeName) const
+{
+	const auto device = mDeviceAttributes.constFind(deviceClass);
+	const qint32 key = mKeyIds.value(attributeName, -1);
+	if (device == mDeviceAttributes.constEnd() || key < 0) {
+		return nullptr;
+	}
+
+	const qint32 value = device.value().at(key);
+	return value >= 0 ? &mValues.at(value) : nullptr;
+}
+
+bool ConfigurationModel::isEnabled(const QString &deviceName) const
+{
+	if (mAdditionalModelConfiguration.contains(deviceName)) {
+		return true;
+	}
+
+	const auto device = mDevices.constFind(deviceName);
+	return device != mDevices.constEnd() && !device.value().isOptional;
+}
+
+QStringList ConfigurationModel::ports() const
+{
+	return mModelConfiguration.keys();
+}
+
+QStringList ConfigurationModel::initScripts() const
+{
+	return mInitScripts;
+}
+
+QString ConfigurationModel::version() const
+{
+	return mVersion;
+}
+
+void ConfigurationModel::configure(const QString &portName, const QString &deviceName)
+{
+	mModelConfiguration[portName] = { deviceName, {} };
+	resolvePort(portName);
+}
+
+void ConfigurationModel::parse(const QString &systemConfigFileName, const QString &modelConfigFileName)
+{
+	const QDomElement systemConfig = trikKernel::FileUtils::readXmlFile(systemConfigFileName);
+	const QDomElement modelConfig = trikKernel::FileUtils::readXmlFile(modelConfigFileName);
+
+	auto parseSection = [&systemConfig](const QString &sectionName, std::function<void(const QDomElement &)> action) {
+		const QDomNodeList section = systemConfig.elementsByTagName(sectionName);
+		if (section.size() != 1) {
+			throw MalformedConfigException("'" + sectionName + "' element shall appear exactly once in config");
+		}
+
+		action(section.at(0).toElement());
+	};
+
+	if (systemConfig.tagName() != "config") {
+		throw MalformedConfigException("'config' tag shall be the root attribute of system config");
+	}
+
+	mVersion = systemConfig.attribute("version", "");
+
+	parseSection("deviceClasses", [this](const QDomElement &element) { parseDeviceClasses(element); });
+	parseSection("devicePorts", [this](const QDomElement &element) { parseDevicePorts(element); });
+	parseSection("deviceTypes", [this](const QDomElement &element) { parseDeviceTypes(element); });
+
+	parseSection("initScript", [this](const QDomElement &element) { parseInitScript(element); });
+
+	parseAdditionalConfigurations(systemConfig);
+
+	parseModelConfig(modelConfig);
+
+	mValueIds.clear();
+	resolve();
+}
+
+void ConfigurationModel::parseDeviceClasses(const QDomElement &element)
+{
+	const QDomNodeList deviceClasses = element.childNodes();
+	for (int i = 0; i < deviceClasses.size(); ++i) {
+		const QDomElement deviceNode = deviceClasses.item(i).toElement();
+		if (!deviceNode.isNull()) {
+			Device device;
+			device.name = deviceNode.tagName();
+			device.isOptional = deviceNode.attribute("optional", "false") == "true";
+			device.attributes = attributes(deviceNode);
+			mDevices.insert(device.name, device);
+		}
+	}
+}
+
+void ConfigurationModel::parseDevicePorts(const QDomElement &element)
+{
+	const QDomNodeList devicePorts = element.childNodes();
+	for (int i = 0; i < devicePorts.size(); ++i) {
+		const QDomElement devicePortNode = devicePorts.item(i).toElement();
+		if (!devicePortNode.isNull()) {
+			const QString deviceName = devicePortNode.tagName();
+			if (!mDevices.contains(deviceName)) {
+				throw MalformedConfigException("Device is not listed in 'DeviceClasses' section", devicePortNode);
+			}
+
+			const QString port = devicePortNode.attribute("port");
+			if (port.isEmpty()) {
+				throw MalformedConfigException("Port map shall have non-empty 'port' attribute", devicePortNode);
+			}
+
+			Attributes &portAttributes = mDevices[deviceName].portSpecificAttributes[port];
+			const Attributes elementAttributes = attributes(devicePortNode);
+			for (auto attribute = elementAttributes.cbegin(); attribute != elementAttributes.cend(); ++attribute) {
+				portAttributes.insert(attribute.key(), attribute.value());
+			}
+		}
+	}
+}
+
+void ConfigurationModel::parseDeviceTypes(const QDomElement &element)
+{
+	const QDomNodeList deviceTypes = element.childNodes();
+	for (int i = 0; i < deviceTypes.size(); ++i) {
+		const QDomElement deviceTypeNode = deviceTypes.item(i).toElement();
+		if (!deviceTypeNode.isNull()) {
+			DeviceType deviceType;
+			deviceType.name = deviceTypeNode.tagName();
+			deviceType.deviceClass = deviceTypeNode.attribute("class");
+			if (deviceType.deviceClass.isEmpty()) {
+				throw MalformedConfigException("Device type shall have 'class' attribute", deviceTypeNode);
+			}
+
+			if (!mDevices.contains(deviceType.deviceClass)) {
+				throw MalformedConfigException("Device is not listed in 'DeviceClasses' section", deviceTypeNode);
+			}
+
+			deviceType.attributes = attributes(deviceTypeNode);
+			mDeviceTypes.insert(deviceType.name, deviceType);
+		}
+	}
+}
+
+void ConfigurationModel::parseInitScript(const QDomElement &element)
+{
+	mInitScripts.append(element.text());
+}
+
+void ConfigurationModel::parseAdditionalConfigurations(const QDomElement &element)
+{
+	const QDomNodeList tags = element.childNodes();
+	for (int i = 0; i < tags.size(); ++i) {
+		const QDomElement tag = tags.item(i).toElement();
+		if (!tag.isNull()) {
+			if (tag.tagName() == "initScript"
+					|| tag.tagName() == "deviceClasses"
+					|| tag.tagName() == "devicePorts"
+					|| tag.tagName() == "deviceTypes")
+			{
+				continue;
+			}
+
+			mAdditionalConfiguration.insert(tag.tagName(), attributes(tag));
+		}
+	}
+}
+
+void ConfigurationModel::parseModelConfig(const QDomElement &element)
+{
+	const QDomNodeList tags = element.childNodes();
+	for (int i = 0; i < tags.size(); ++i) {
+		const QDomElement tag = tags.item(i).toElement();
+		if (!tag.isNull()) {
+			if (tag.tagName() == "initScript") {
+				parseInitScript(tag);
+			} else if (tag.hasChildNodes()) {
+				const QDomNodeList devices = tag.childNodes();
+				if (devices.count() > 1) {
+					throw MalformedConfigException("Only one device can be configured on a port", tag);
+				}
+
+				const QDomElement device = devices.item(0).toElement();
+				if (!device.isNull()) {
+					mModelConfiguration.insert(tag.tagName(), { device.tagName(), attributes(device) });
+				}
+			} else {
+				const QString deviceClass = tag.tagName();
+				if (!mDevices.contains(deviceClass)) {
+					throw MalformedConfigException(
+							"Device shall be listed in 'deviceClasses' section in system config", tag);
+				}
+
+				if (tag.attribute("disabled", "false") == "false") {
+					mAdditionalModelConfiguration.insert(deviceClass, attributes(tag));
+				}
+			}
+		}
+	}
+}
+
+ConfigurationModel::Attributes ConfigurationModel::attributes(const QDomElement &element)
+{
+	Attributes result;
+	const QDomNamedNodeMap &attributes = element.attributes();
+	for (QDomNamedNodeMapLengthType j = 0; j < attributes.length(); ++j) {
+		const QDomAttr &attribute = attributes.item(j).toAttr();
+
+		auto key = mKeyIds.constFind(attribute.name());
+		if (key == mKeyIds.constEnd()) {
+			key = mKeyIds.insert(attribute.name(), mKeyIds.size());
+		}
+
+		auto value = mValueIds.constFind(attribute.value());
+		if (value == mValueIds.constEnd()) {
+			value = mValueIds.insert(attribute.value(), mValues.size());
+			mValues.append(attribute.value());
+		}
+
+		result.insert(key.value(), value.value());
+	}
+
+	return result;
+}
+
+void ConfigurationModel::resolve()
+{
+	mPorts.clear();
+	for (auto port = mModelConfiguration.cbegin(); port != mModelConfiguration.cend(); ++port) {
+		resolvePort(port.key());
+	}
+
+	QStringList deviceClasses = mDevices.keys() + mAdditionalConfiguration.keys()
+			+ mAdditionalModelConfiguration.keys();
+	deviceClasses.removeDuplicates();
+
+	mDeviceAttributes.clear();
+	for (const QString &deviceClass : deviceClasses) {
+		QVector<qint32> values(mKeyIds.size(), -1);
+		const auto add = [&values](const Attributes &attributes) {
+			for (auto attribute = attributes.cbegin(); attribute != attributes.cend(); ++attribute) {
+				if (values[attribute.key()] < 0) {
+					values[attribute.key()] = attribute.value();
+				}
+			}
+		};
+
+		add(mAdditionalModelConfiguration.value(deviceClass));
+		add(mAdditionalConfiguration.value(deviceClass));
+		add(mDevices.value(deviceClass).attributes);
+		mDeviceAttributes.insert(deviceClass, values);
+	}
+}
+
+void ConfigurationModel::resolvePort(const QString &name)
+{
+	const PortConfiguration &configuration = mModelConfiguration[name];
+	const QString &deviceType = configuration.deviceType;
+
+	Port port;
+	port.deviceType = deviceType;
+	port.values.fill(-1, mKeyIds.size());
+	const auto add = [&port](const Attributes &attributes) {
+		for (auto attribute = attributes.cbegin(); attribute != attributes.cend(); ++attribute) {
+			if (port.values[attribute.key()] < 0) {
+				port.values[attribute.key()] = attribute.value();
+			}
+		}
+	};
+
+	add(configuration.attributes);
+
+	if (mDeviceTypes.contains(deviceType)) {
+		const DeviceType &type = mDeviceTypes[deviceType];
+		port.deviceClass = type.deviceClass;
+		add(type.attributes);
+		if (mDevices.contains(type.deviceClass)) {
+			const Device &device = mDevices[type.deviceClass];
+			add(device.portSpecificAttributes.value(name));
+			add(device.attributes);
+			if (!device.portSpecificAttributes.contains(name)) {
+				port.attributeError = QString("Device type '%1' is not allowed on port %2.").arg(deviceType).arg(name);
+			}
+		} else {
+			port.attributeError = QString(
+					"Device type '%1' has device class '%2' which is not listed in 'deviceClasses' section.")
+							.arg(deviceType).arg(type.deviceClass);
+		}
+	} else if (mDevices.contains(deviceType)) {
+		port.deviceClass = deviceType;
+	} else {
+		port.classError = QString("Port '%1' is configured to use unknown device class '%2'")
+				.arg(name).arg(deviceType);
+	}
+
+	if (port.attributeError.isEmpty() && mDevices.contains(deviceType)) {
+		const Device &device = mDevices[deviceType];
+		add(device.portSpecificAttributes.value(name));
+		add(device.attributes);
+	}
+
+	mPorts.insert(name, port);
+}
+
+void ConfigurationModel::save(QDataStream &stream) const
+{
+	stream << mKeyIds << mValues << mInitScripts << mDevices << mDeviceTypes << mAdditionalConfiguration
+			<< mModelConfiguration << mAdditionalModelConfiguration << mPorts << mDeviceAttributes << mVersion;
+}
+
+bool ConfigurationModel::restore(QDataStream &stream)
+{
+	stream >> mKeyIds >> mValues >> mInitScripts >> mDevices >> mDeviceTypes >> mAdditionalConfiguration
+			>> mModelConfiguration >> mAdditionalModelConfiguration >> mPorts >> mDeviceAttributes >> mVersion;
+
+	if (stream.status() != QDataStream::Ok) {
+		return false;
+	}
+
+	// Values are used as indexes without checks, so tables shall be consistent with each other.
+	const auto isValid = [this](const QVector<qint32> &values) {
+		if (values.size() != mKeyIds.size()) {
+			return false;
+		}
+
+		for (const qint32 value : values) {
+			if (value >= mValues.size()) {
+				return false;
+			}
+		}
+
+		return true;
+	};
+
+	for (const Port &port : mPorts) {
+		if (!isValid(port.values)) {
+			return false;
+		}
+	}
+
+	for (const QVector<qint32> &values : mDeviceAttributes) {
+		if (!isValid(values)) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+QSharedPointer<ConfigurationModel> ConfigurationModel::readCache(const QString &fileName
+		, const FileStamp &systemConfig, const FileStamp &modelConfig)
+{
+	if (systemConfig.hash.isEmpty() || modelConfig.hash.isEmpty()) {
+		return {};
+	}
+
+	QFile file(fileName);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return {};
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+
+	quint32 magic = 0;
+	quint32 formatVersion = 0;
+	FileStamp cachedSystemConfig;
+	FileStamp cachedModelConfig;
+	stream >> magic >> formatVersion;
+	if (magic != cacheMagic || formatVersion != cacheFormatVersion) {
+		return {};
+	}
+
+	stream >> cachedSystemConfig >> cachedModelConfig;
+	if (stream.status() != QDataStream::Ok
+			|| cachedSystemConfig.path != systemConfig.path || cachedSystemConfig.hash != systemConfig.hash
+			|| cachedModelConfig.path != modelConfig.path || cachedModelConfig.hash != modelConfig.hash)
+	{
+		return {};
+	}
+
+	QSharedPointer<ConfigurationModel> model(new ConfigurationModel());
+	if (!model->restore(stream)) {
+		QLOG_WARN() << "Configuration cache" << fileName << "is corrupted, parsing config files";
+		return {};
+	}
+
+	return model;
+}
+
+void ConfigurationModel::writeCache(const QString &fileName) const
+{
+	QSaveFile file(fileName);
+	if (!file.open(QIODevice::WriteOnly)) {
+		QLOG_INFO() << "Can not write configuration cache" << fileName << ":" << file.errorString();
+		return;
+	}
+
+	QDataStream stream(&file);
+	stream.setVersion(QDataStream::Qt_5_0);
+	stream << cacheMagic << cacheFormatVersion << mSystemConfig << mModelConfig;
+	save(stream);
+
+	if (stream.status() != QDataStream::Ok || !file.commit()) {
+		QLOG_INFO() << "Can not write configuration cache" << fileName << ":" << file.errorString();
+	}
+}
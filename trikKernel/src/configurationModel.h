@@ -0,0 +1,194 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+
+class QDataStream;
+class QDomElement;
+
+namespace trikKernel {
+
+/// Compiled configuration of a pair of system and model config files. Attribute names and values are interned, and
+/// attributes of every configured port and of every device class are resolved according to overriding rules into
+/// tables indexed by attribute id, so getting an attribute costs a lookup of a port and of an attribute name.
+///
+/// Model is saved into a binary cache next to model config and is loaded from it while both config files have the
+/// same contents. Loaded models are shared by all configurers of the same files in a process while they are alive.
+class ConfigurationModel
+{
+public:
+	/// Attribute values by attribute ids, values are indexes in the table of values.
+	typedef QHash<qint32, qint32> Attributes;
+
+	struct Device {
+		QString name;
+		Attributes attributes;
+		QHash<QString, Attributes> portSpecificAttributes;
+		bool isOptional = false;
+	};
+
+	struct DeviceType {
+		QString name;
+		QString deviceClass;
+		Attributes attributes;
+	};
+
+	/// Device configured on a port in model config.
+	struct PortConfiguration {
+		QString deviceType;
+		Attributes attributes;
+	};
+
+	/// Resolved configuration of a port.
+	struct Port {
+		/// Device type or device class configured on a port.
+		QString deviceType;
+
+		/// Device class, empty if configured device is unknown.
+		QString deviceClass;
+
+		/// Error to report when class of unknown device is requested.
+		QString classError;
+
+		/// Error to report instead of unknown attribute when a device is misconfigured on a port.
+		QString attributeError;
+
+		/// Indexes of values by attribute ids, -1 for attributes that are not set.
+		QVector<qint32> values;
+	};
+
+	/// Identity of a config file used to check whether a model is up to date.
+	struct FileStamp {
+		/// Canonical path.
+		QString path;
+		qint64 size = -1;
+		qint64 modified = -1;
+
+		/// SHA-1 of contents, computed only when cache file is checked.
+		QByteArray hash;
+	};
+
+	/// Returns model of given config files: the one already used in this process if files are not modified since
+	/// then, loaded from cache if cache is up to date, or parsed from XML (and cached) otherwise.
+	/// Throws an exception if config files can not be read or are malformed.
+	static QSharedPointer<const ConfigurationModel> load(const QString &systemConfig, const QString &modelConfig);
+
+	/// Returns name of a binary cache file for given model config.
+	static QString cacheFileName(const QString &modelConfig);
+
+	/// Returns resolved configuration of a port, or nullptr if port is not configured.
+	const Port *port(const QString &name) const;
+
+	/// Returns value of an attribute of a port, or nullptr if it is not set.
+	const QString *attribute(const Port &port, const QString &attributeName) const;
+
+	/// Returns value of an attribute of a device class, or nullptr if it is not set.
+	const QString *attribute(const QString &deviceClass, const QString &attributeName) const;
+
+	/// Returns true if device is enabled in model config or can not be disabled.
+	bool isEnabled(const QString &deviceName) const;
+
+	/// Ports configured in model config.
+	QStringList ports() const;
+
+	/// Init scripts, first from system config then from model config.
+	QStringList initScripts() const;
+
+	/// Version of system config.
+	QString version() const;
+
+	/// Configures given device on given port and resolves port configuration again.
+	void configure(const QString &portName, const QString &deviceName);
+
+private:
+	/// Parses config files and resolves attributes.
+	void parse(const QString &systemConfigFileName, const QString &modelConfigFileName);
+
+	void parseDeviceClasses(const QDomElement &element);
+	void parseDevicePorts(const QDomElement &element);
+	void parseDeviceTypes(const QDomElement &element);
+	void parseInitScript(const QDomElement &element);
+	void parseAdditionalConfigurations(const QDomElement &element);
+	void parseModelConfig(const QDomElement &element);
+
+	/// Returns interned attributes of an XML element.
+	Attributes attributes(const QDomElement &element);
+
+	/// Resolves attributes of all ports and device classes.
+	void resolve();
+
+	/// Resolves attributes of a port according to overriding rules.
+	void resolvePort(const QString &name);
+
+	/// Writes model to a stream, without file stamps.
+	void save(QDataStream &stream) const;
+
+	/// Reads model from a stream, returns false if data is corrupted.
+	bool restore(QDataStream &stream);
+
+	/// Returns model from cache file if it was made from config files with given hashes, or nullptr otherwise.
+	static QSharedPointer<ConfigurationModel> readCache(const QString &fileName
+			, const FileStamp &systemConfig, const FileStamp &modelConfig);
+
+	/// Writes cache file, failure is not an error since config directory may be read-only.
+	void writeCache(const QString &fileName) const;
+
+	/// Ids of attribute names.
+	QHash<QString, qint32> mKeyIds;
+
+	/// Attribute values by their ids.
+	QStringList mValues;
+
+	/// Ids of attribute values, used only while parsing.
+	QHash<QString, qint32> mValueIds;
+
+	QStringList mInitScripts;
+
+	/// Maps device class name to its configuration.
+	QHash<QString, Device> mDevices;
+
+	/// Maps device type name to its configuration.
+	QHash<QString, DeviceType> mDeviceTypes;
+
+	/// Maps device class name to its additional configuration from system config.
+	QHash<QString, Attributes> mAdditionalConfiguration;
+
+	/// Maps port name to configuration of device on that port.
+	QHash<QString, PortConfiguration> mModelConfiguration;
+
+	/// Maps device class name to configuration from model config, for enabled devices only.
+	QHash<QString, Attributes> mAdditionalModelConfiguration;
+
+	/// Resolved configurations of ports.
+	QHash<QString, Port> mPorts;
+
+	/// Resolved attributes of device classes, indexes of values by attribute ids.
+	QHash<QString, QVector<qint32>> mDeviceAttributes;
+
+	/// Version of the config file which shall correspond to casing model.
+	QString mVersion;
+
+	/// Files this model was made from.
+	FileStamp mSystemConfig;
+	FileStamp mModelConfig;
+};
+
+}
@@ -15,6 +15,7 @@
 #include "loggingHelper.h"
 
 #include <QtCore/QDir>
+#include <QtCore/QStringList>
 
 #include <QsLog.h>
 
@@ -54,4 +55,24 @@ LoggingHelper::LoggingHelper(const QString &pathToLog)
 
 LoggingHelper::~LoggingHelper()
 {
+	// Messages are written by a background thread in batches, so the last ones may still be in a queue.
+	QsLogging::Logger::instance().flush();
+}
+
+bool LoggingHelper::setCategoryLevels(const QString &levels)
+{
+	static const QStringList levelNames = {"trace", "debug", "info", "warn", "error", "fatal", "off"};
+
+	for (const QString &categoryLevel : levels.split(',', QString::SkipEmptyParts)) {
+		const QStringList parts = categoryLevel.split('=');
+		const int level = parts.size() == 2 ? levelNames.indexOf(parts[1].trimmed().toLower()) : -1;
+		if (level < 0 || parts[0].trimmed().isEmpty()) {
+			QLOG_ERROR() << "Malformed logging level of a category:" << categoryLevel;
+			return false;
+		}
+
+		QsLogging::Logger::instance().setCategoryLevel(parts[0].trimmed(), static_cast<QsLogging::Level>(level));
+	}
+
+	return true;
 }
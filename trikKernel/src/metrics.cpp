@@ -0,0 +1,292 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "metrics.h"
+
+#include <atomic>
+#include <chrono>
+
+#include <QtCore/QMap>
+#include <QtCore/QMutex>
+#include <QtCore/QStringList>
+#include <QtCore/qalgorithms.h>
+#include <QtCore/qmath.h>
+
+using namespace trikKernel;
+
+QBasicAtomicInt Metrics::sEnabled = Q_BASIC_ATOMIC_INITIALIZER(0);
+
+namespace {
+
+/// Number of trace events kept, shall be a power of 2.
+const int traceSize = 8192;
+
+/// Trace event of a timed section. Fields are protected by a stamp, like a seqlock: it is 0 while an event is being
+/// written and is a number of an event plus 1 afterwards.
+struct TraceEvent
+{
+	QAtomicInteger<quint32> stamp;
+	const Metrics::Histogram *histogram = nullptr;
+	qint64 start = 0;
+	qint64 duration = 0;
+	int thread = 0;
+};
+
+/// All registered metrics and trace.
+struct Registry
+{
+	QMutex lock;
+	QMap<QString, Metrics::Counter *> counters;
+	QMap<QString, Metrics::Histogram *> histograms;
+
+	QAtomicInteger<quint32> traceHead;
+	TraceEvent trace[traceSize];
+
+	QAtomicInt nextThread;
+};
+
+/// Registry is never destroyed, since metrics are referenced by static variables of other libraries which may be
+/// used during exit.
+Registry &registry()
+{
+	static Registry * const instance = new Registry();
+	return *instance;
+}
+
+/// Returns small number of a current thread, used as thread id in trace.
+int currentThread()
+{
+	static thread_local int thread = registry().nextThread.fetchAndAddRelaxed(1) + 1;
+	return thread;
+}
+
+/// Atomically raises value to at least given one.
+void raise(QAtomicInteger<qint64> &value, qint64 candidate)
+{
+	qint64 current = value.load();
+	while (current < candidate && !value.testAndSetRelaxed(current, candidate, current)) {
+	}
+}
+
+}
+
+Metrics::Counter::Counter(const QString &name)
+	: mName(name)
+{
+}
+
+qint64 Metrics::Counter::value() const
+{
+	return mValue.load();
+}
+
+const QString &Metrics::Counter::name() const
+{
+	return mName;
+}
+
+Metrics::Histogram::Histogram(const QString &name)
+	: mName(name)
+	, mUtf8Name(name.toUtf8())
+{
+}
+
+qint64 Metrics::Histogram::count() const
+{
+	return mCount.load();
+}
+
+qint64 Metrics::Histogram::sum() const
+{
+	return mSum.load();
+}
+
+qint64 Metrics::Histogram::max() const
+{
+	return mMax.load();
+}
+
+qint64 Metrics::Histogram::percentile(qreal fraction) const
+{
+	const qint64 total = count();
+	if (total == 0) {
+		return 0;
+	}
+
+	const qint64 rank = qMax<qint64>(1, qCeil(qBound<qreal>(0, fraction, 1) * total));
+	qint64 seen = 0;
+	for (int i = 0; i < buckets; ++i) {
+		seen += mBuckets[i].load();
+		if (seen >= rank) {
+			return i == 0 ? 0 : qMin((Q_INT64_C(1) << i) - 1, max());
+		}
+	}
+
+	return max();
+}
+
+const QString &Metrics::Histogram::name() const
+{
+	return mName;
+}
+
+void Metrics::Histogram::doRecord(qint64 value)
+{
+	const int bucket = value < 1 ? 0 : qMin(64 - qCountLeadingZeroBits(static_cast<quint64>(value)), buckets - 1);
+	mBuckets[bucket].fetchAndAddRelaxed(1);
+	mCount.fetchAndAddRelaxed(1);
+	mSum.fetchAndAddRelaxed(value);
+	raise(mMax, value);
+}
+
+void Metrics::Histogram::clear()
+{
+	mCount.store(0);
+	mSum.store(0);
+	mMax.store(0);
+	for (QAtomicInteger<qint64> &bucket : mBuckets) {
+		bucket.store(0);
+	}
+}
+
+void Metrics::setEnabled(bool enabled)
+{
+	sEnabled.store(enabled ? 1 : 0);
+}
+
+Metrics::Counter &Metrics::counter(const QString &name)
+{
+	Registry &metrics = registry();
+	QMutexLocker locker(&metrics.lock);
+	Counter *&result = metrics.counters[name];
+	if (!result) {
+		result = new Counter(name);
+	}
+
+	return *result;
+}
+
+Metrics::Histogram &Metrics::histogram(const QString &name)
+{
+	Registry &metrics = registry();
+	QMutexLocker locker(&metrics.lock);
+	Histogram *&result = metrics.histograms[name];
+	if (!result) {
+		result = new Histogram(name);
+	}
+
+	return *result;
+}
+
+qint64 Metrics::now()
+{
+	return std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void Metrics::reset()
+{
+	Registry &metrics = registry();
+	QMutexLocker locker(&metrics.lock);
+	for (Counter * const counter : metrics.counters) {
+		counter->mValue.store(0);
+	}
+
+	for (Histogram * const histogram : metrics.histograms) {
+		histogram->clear();
+	}
+
+	for (TraceEvent &event : metrics.trace) {
+		event.stamp.store(0);
+	}
+}
+
+QString Metrics::report()
+{
+	Registry &metrics = registry();
+	QMutexLocker locker(&metrics.lock);
+	QStringList lines;
+	for (const Counter * const counter : metrics.counters) {
+		lines << QString("%1 %2").arg(counter->name()).arg(counter->value());
+	}
+
+	for (const Histogram * const histogram : metrics.histograms) {
+		const qint64 count = histogram->count();
+		lines << QString("%1 count=%2 mean=%3 p50=%4 p99=%5 max=%6").arg(histogram->name()).arg(count)
+				.arg(count == 0 ? 0 : histogram->sum() / count).arg(histogram->percentile(0.5))
+				.arg(histogram->percentile(0.99)).arg(histogram->max());
+	}
+
+	lines.sort();
+	return lines.join('\n');
+}
+
+QByteArray Metrics::chromeTrace()
+{
+	Registry &metrics = registry();
+	const quint32 head = metrics.traceHead.loadAcquire();
+	const quint32 size = qMin<quint32>(head, traceSize);
+
+	QByteArray result = "{\"traceEvents\":[";
+	bool isFirst = true;
+	for (quint32 i = head - size; i != head; ++i) {
+		TraceEvent &slot = metrics.trace[i % traceSize];
+		const quint32 stamp = slot.stamp.loadAcquire();
+		if (stamp != i + 1) {
+			continue;
+		}
+
+		const Histogram * const histogram = slot.histogram;
+		const qint64 start = slot.start;
+		const qint64 duration = slot.duration;
+		const int thread = slot.thread;
+
+		// Event is valid only if it was not overwritten while it was copied.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (slot.stamp.load() != stamp) {
+			continue;
+		}
+
+		if (!isFirst) {
+			result += ',';
+		}
+
+		isFirst = false;
+		result += "{\"name\":\"" + histogram->mUtf8Name + "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+				+ QByteArray::number(thread) + ",\"ts\":" + QByteArray::number(start)
+				+ ",\"dur\":" + QByteArray::number(duration) + "}";
+	}
+
+	result += "],\"displayTimeUnit\":\"ms\"}";
+	return result;
+}
+
+void Metrics::finish(Histogram &histogram, qint64 start)
+{
+	const qint64 duration = now() - start;
+	histogram.doRecord(duration);
+
+	Registry &metrics = registry();
+	const quint32 index = metrics.traceHead.fetchAndAddRelaxed(1);
+	TraceEvent &slot = metrics.trace[index % traceSize];
+	slot.stamp.store(0);
+
+	// Fields shall not be written before the stamp is cleared.
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.histogram = &histogram;
+	slot.start = start;
+	slot.duration = duration;
+	slot.thread = currentThread();
+	slot.stamp.storeRelease(index + 1);
+}
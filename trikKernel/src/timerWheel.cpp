@@ -0,0 +1,341 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "timerWheel.h"
+
+#include <limits>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QMetaObject>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QThread>
+
+using namespace trikKernel;
+
+/// Thread that drives the wheel.
+class TimerWheel::Driver : public QThread
+{
+public:
+	explicit Driver(TimerWheel &wheel)
+		: mWheel(wheel)
+	{
+	}
+
+protected:
+	void run() override
+	{
+		mWheel.run();
+	}
+
+private:
+	TimerWheel &mWheel;
+};
+
+/// Timer or a sentinel head of a slot list.
+struct TimerWheel::Node
+{
+	TimerId id;
+	qint64 expires;
+	qint64 interval;
+	Callback callback;
+	bool singleShot;
+
+	/// Neighbours in a slot list, both are nullptr if a node is not linked into the wheel.
+	Node *prev;
+	Node *next;
+};
+
+/// Value of mNextWake meaning that driver is not sleeping and will recalculate its wake up time anyway.
+static const qint64 driverIsAwake = -1;
+
+/// Value of mNextWake meaning that there are no timers and driver sleeps until woken up.
+static const qint64 sleepForever = std::numeric_limits<qint64>::max();
+
+TimerWheel::TimerWheel(int tickMicroseconds)
+	: mTickMicroseconds(qMax(tickMicroseconds, 1))
+	, mMutex(QMutex::Recursive)
+	, mDriver(new Driver(*this))
+{
+	for (int level = 0; level < levels; ++level) {
+		for (int slot = 0; slot < slotCount; ++slot) {
+			Node * const head = new Node{0, 0, 0, Callback(), false, nullptr, nullptr};
+			head->prev = head;
+			head->next = head;
+			mSlots[level][slot] = head;
+		}
+	}
+
+	mClock.start();
+	mDriver->start(QThread::TimeCriticalPriority);
+}
+
+TimerWheel::~TimerWheel()
+{
+	mSleepMutex.lock();
+	mStopping = true;
+	mWakeUp.wakeOne();
+	mSleepMutex.unlock();
+
+	mDriver->wait();
+
+	qDeleteAll(mTimers);
+	for (int level = 0; level < levels; ++level) {
+		for (int slot = 0; slot < slotCount; ++slot) {
+			delete mSlots[level][slot];
+		}
+	}
+}
+
+TimerWheel &TimerWheel::instance()
+{
+	static TimerWheel wheel;
+	return wheel;
+}
+
+TimerWheel::TimerId TimerWheel::start(int milliseconds, const Callback &callback, bool singleShot)
+{
+	const qint64 interval = qMax<qint64>(qint64(milliseconds) * 1000 / mTickMicroseconds, 1);
+
+	mMutex.lock();
+	const TimerId id = mNextId++;
+	Node * const node = new Node{id, qMax(now(), mCurrentTick) + interval, interval, callback, singleShot
+			, nullptr, nullptr};
+
+	mTimers.insert(id, node);
+	link(node);
+	const bool needWake = node->expires < mNextWake;
+	mMutex.unlock();
+
+	if (needWake) {
+		mSleepMutex.lock();
+		mWakeUp.wakeOne();
+		mSleepMutex.unlock();
+	}
+
+	return id;
+}
+
+TimerWheel::TimerId TimerWheel::startQueued(int milliseconds, QObject *receiver, const char *method, bool singleShot)
+{
+	const QByteArray methodName(method);
+	const QPointer<QObject> guard(receiver);
+	return start(milliseconds, [guard, methodName]() {
+		if (guard) {
+			QMetaObject::invokeMethod(guard.data(), methodName.constData(), Qt::QueuedConnection);
+		}
+	}, singleShot);
+}
+
+bool TimerWheel::restart(TimerId id)
+{
+	mMutex.lock();
+	Node * const node = mTimers.value(id);
+	if (!node) {
+		mMutex.unlock();
+		return false;
+	}
+
+	unlink(node);
+	node->expires = qMax(now(), mCurrentTick) + node->interval;
+	link(node);
+	const bool needWake = node->expires < mNextWake;
+	mMutex.unlock();
+
+	if (needWake) {
+		mSleepMutex.lock();
+		mWakeUp.wakeOne();
+		mSleepMutex.unlock();
+	}
+
+	return true;
+}
+
+void TimerWheel::stop(TimerId id)
+{
+	QMutexLocker locker(&mMutex);
+	Node * const node = mTimers.take(id);
+	if (!node) {
+		return;
+	}
+
+	unlink(node);
+	if (node == mFiring) {
+		// Callback is stopping its own timer, node will be deleted when callback returns.
+		mFiringStopped = true;
+	} else {
+		delete node;
+	}
+}
+
+int TimerWheel::activeTimers() const
+{
+	QMutexLocker locker(&mMutex);
+	return mActive;
+}
+
+int TimerWheel::tickMicroseconds() const
+{
+	return mTickMicroseconds;
+}
+
+void TimerWheel::link(Node *node)
+{
+	// Node shall expire in the future, otherwise it will wait for the whole turn of the wheel.
+	const qint64 expires = qMax(node->expires, mCurrentTick + 1);
+	const qint64 delta = expires - mCurrentTick;
+
+	int level = 0;
+	while (level < levels - 1 && delta >= (Q_INT64_C(1) << (slotBits * (level + 1)))) {
+		++level;
+	}
+
+	// Timers that are too far away are put to the last slot of the topmost level and will be recascaded.
+	const qint64 maxDelta = (Q_INT64_C(1) << (slotBits * levels)) - 1;
+	const qint64 placement = delta > maxDelta ? mCurrentTick + maxDelta : expires;
+
+	Node * const head = mSlots[level][(placement >> (slotBits * level)) & slotMask];
+	node->prev = head->prev;
+	node->next = head;
+	head->prev->next = node;
+	head->prev = node;
+	++mActive;
+}
+
+void TimerWheel::unlink(Node *node)
+{
+	if (!node->next) {
+		return;
+	}
+
+	node->prev->next = node->next;
+	node->next->prev = node->prev;
+	node->prev = nullptr;
+	node->next = nullptr;
+	--mActive;
+}
+
+void TimerWheel::cascade(int level)
+{
+	Node * const head = mSlots[level][(mCurrentTick >> (slotBits * level)) & slotMask];
+	while (head->next != head) {
+		Node * const node = head->next;
+		unlink(node);
+		link(node);
+	}
+}
+
+void TimerWheel::advance()
+{
+	const qint64 target = now();
+	while (mCurrentTick < target) {
+		++mCurrentTick;
+
+		for (int level = 1; level < levels; ++level) {
+			if ((mCurrentTick & ((Q_INT64_C(1) << (slotBits * level)) - 1)) != 0) {
+				break;
+			}
+
+			cascade(level);
+		}
+
+		// Timers rescheduled by callbacks always expire after current tick, so they will not get into this slot.
+		Node * const head = mSlots[0][mCurrentTick & slotMask];
+		while (head->next != head) {
+			Node * const node = head->next;
+			unlink(node);
+
+			if (!node->singleShot) {
+				// Periodic timers keep their phase, but missed periods are skipped.
+				node->expires += node->interval;
+				if (node->expires <= mCurrentTick) {
+					node->expires = mCurrentTick + node->interval;
+				}
+
+				link(node);
+			} else {
+				// Expired single-shot timer is forgotten before its callback, so stopping it is a no-op from now on.
+				mTimers.remove(node->id);
+			}
+
+			mFiring = node;
+			mFiringStopped = false;
+			node->callback();
+			mFiring = nullptr;
+
+			if (mFiringStopped || node->singleShot) {
+				delete node;
+			}
+		}
+	}
+}
+
+qint64 TimerWheel::idleTicks() const
+{
+	if (mActive == 0) {
+		return -1;
+	}
+
+	// Look for a nearest non-empty slot of the lowest level, but wake up on next cascade anyway.
+	for (qint64 delta = 1; ; ++delta) {
+		const qint64 tick = mCurrentTick + delta;
+		const Node * const head = mSlots[0][tick & slotMask];
+		if (head->next != head || (tick & slotMask) == 0) {
+			return delta;
+		}
+	}
+}
+
+qint64 TimerWheel::now() const
+{
+	return mClock.nsecsElapsed() / 1000 / mTickMicroseconds;
+}
+
+void TimerWheel::run()
+{
+	forever {
+		mMutex.lock();
+		mNextWake = driverIsAwake;
+		advance();
+		mMutex.unlock();
+
+		mSleepMutex.lock();
+		if (mStopping) {
+			mSleepMutex.unlock();
+			return;
+		}
+
+		// Wake up time is published under both locks, so a timer started after that will wake the driver up
+		// either before it starts to wait (and it will not wait) or while it waits.
+		mMutex.lock();
+		const qint64 idle = idleTicks();
+		mNextWake = idle < 0 ? sleepForever : mCurrentTick + idle;
+		const qint64 wakeMicroseconds = idle < 0 ? -1 : (mCurrentTick + idle) * mTickMicroseconds;
+		const bool missed = now() > mCurrentTick;
+		mMutex.unlock();
+
+		if (!missed) {
+			if (wakeMicroseconds < 0) {
+				mWakeUp.wait(&mSleepMutex);
+			} else {
+				const qint64 remaining = wakeMicroseconds - mClock.nsecsElapsed() / 1000;
+				if (remaining > 0) {
+					mWakeUp.wait(&mSleepMutex, static_cast<unsigned long>((remaining + 999) / 1000));
+				}
+			}
+		}
+
+		mSleepMutex.unlock();
+	}
+}
@@ -18,7 +18,7 @@ include(../global.pri)
 
 QT += widgets xml
 
-HEADERS += \
+PUBLIC_HEADERS += \
 	$$PWD/include/trikKernel/applicationInitHelper.h \
 	$$PWD/include/trikKernel/configurer.h \
 	$$PWD/include/trikKernel/coreDumping.h \
@@ -27,10 +27,12 @@ HEADERS += \
 	$$PWD/include/trikKernel/differentOwnerPointer.h \
 	$$PWD/include/trikKernel/fileUtils.h \
 	$$PWD/include/trikKernel/loggingHelper.h \
+	$$PWD/include/trikKernel/metrics.h \
 	$$PWD/include/trikKernel/commandLineParser.h \
 	$$PWD/include/trikKernel/paths.h \
 	$$PWD/include/trikKernel/rcReader.h \
 	$$PWD/include/trikKernel/synchronizedVar.h \
+	$$PWD/include/trikKernel/timerWheel.h \
 	$$PWD/include/trikKernel/timeVal.h \
 	$$PWD/include/trikKernel/translationsHelper.h \
 	$$PWD/include/trikKernel/version.h \
@@ -40,15 +42,21 @@ HEADERS += \
 	$$PWD/include/trikKernel/exceptions/malformedConfigException.h \
 	$$PWD/include/trikKernel/exceptions/trikRuntimeException.h \
 
+HEADERS += \
+	$$PWD/src/configurationModel.h \
+
 SOURCES += \
 	$$PWD/src/applicationInitHelper.cpp \
 	$$PWD/src/commandLineParser.cpp \
+	$$PWD/src/configurationModel.cpp \
 	$$PWD/src/configurer.cpp \
 	$$PWD/src/debug.cpp \
 	$$PWD/src/deinitializationHelper.cpp \
 	$$PWD/src/fileUtils.cpp \
 	$$PWD/src/loggingHelper.cpp \
+	$$PWD/src/metrics.cpp \
 	$$PWD/src/rcReader.cpp \
+	$$PWD/src/timerWheel.cpp \
 	$$PWD/src/timeVal.cpp \
 	$$PWD/src/translationsHelper.cpp \
 	$$PWD/src/$$PLATFORM/coreDumping.cpp \
@@ -16,10 +16,11 @@
 
 #include <QtCore/QObject>
 #include <QtCore/QScopedPointer>
-#include <QtCore/QTimer>
 #include <QtNetwork/QTcpSocket>
 #include <QtNetwork/QHostAddress>
 
+#include <trikKernel/timerWheel.h>
+
 #include "declSpec.h"
 
 namespace trikNetwork {
@@ -45,8 +46,8 @@ enum class Heartbeat
 	, dontUse
 };
 
-/// Abstract class that serves one client of TrikServer. Meant to work in separate thread. Creates its own socket and
-/// handles all incoming messages.
+/// Abstract class that serves one client of TrikServer. Meant to work in one of I/O threads of a server, shared with
+/// other connections, so it shall never block. Creates its own socket and handles all incoming messages.
 class TRIKNETWORK_EXPORT Connection : public QObject
 {
 	Q_OBJECT
@@ -57,13 +58,18 @@ public:
 	/// @param useHeartbeat - use or don't use heartbeat protocol option.
 	explicit Connection(Protocol connectionProtocol, Heartbeat useHeartbeat);
 
+	~Connection() override;
+
 	/// Returns true if socket is opened or false otherwise.
 	bool isConnected() const;
 
 	/// Returns peer address of a connection, if it is open, or empty QHostAddress if connection is not established yet.
+	/// Address is remembered when connection is established, so it can be safely called from other threads after
+	/// connected() signal is received.
 	QHostAddress peerAddress() const;
 
 	/// Returns peer port of a connection, if it is open, or -1 if connection is not established yet.
+	/// Can be safely called from other threads after connected() signal is received.
 	int peerPort() const;
 
 	/// Creates socket and initializes incoming connection, shall be called when Connection is already in its own
@@ -77,12 +83,13 @@ signals:
 	/// Emitted after connection becomes closed.
 	void disconnected(Connection *self);
 
-	/// Emitted after connection is established.
+	/// Emitted after connection is established, both for incoming and outgoing connections.
 	void connected(Connection *self);
 
 protected:
 	/// Creates socket and initializes outgoing connection, shall be called when Connection is already in its own
-	/// thread.
+	/// thread. Returns immediately, connected() or disconnected() signal is emitted when connection is established
+	/// or failed.
 	/// @param ip - target ip address.
 	/// @param port - target port.
 	void init(const QHostAddress &ip, int port);
@@ -122,23 +129,33 @@ private:
 	/// Helper method that notifies everyone about disconnect and closes connection gracefully.
 	void doDisconnect();
 
-	/// Initializes keepalive and heartbeat timers.
-	void initKeepalive();
+	/// Starts or restarts a timer in a shared timer wheel that calls given slot of this object.
+	void restartTimer(quint64 &timer, int interval, const char *slot);
+
+	/// Starts or restarts both keepalive and heartbeat timers.
+	void startKeepalive();
+
+	/// Stops keepalive and heartbeat timers.
+	void stopKeepalive();
 
 	/// Buffer to accumulate parts of a message.
 	QByteArray mBuffer;
 
+	/// Position in mBuffer of the first byte that is not parsed yet.
+	int mBufferOffset = 0;
+
 	/// Declared size of a current message.
 	int mExpectedBytes = 0;
 
 	/// Protocol selected for this connection.
 	Protocol mProtocol;
 
-	/// Timer that is used to send keepalive packets.
-	QScopedPointer<QTimer> mKeepAliveTimer;
+	/// Timer that is used to send keepalive packets. Both timers are restarted on every message, so they are
+	/// timers of trikKernel::TimerWheel, where restart is cheap.
+	trikKernel::TimerWheel::TimerId mKeepAliveTimer = 0;
 
 	/// Timer that is used to check that keepalive packets from other end of the line were properly received.
-	QScopedPointer<QTimer> mHeartbeatTimer;
+	trikKernel::TimerWheel::TimerId mHeartbeatTimer = 0;
 
 	/// Flag that ensures that "disconnected" signal will be sent only once.
 	bool mDisconnectReported = false;
@@ -148,6 +165,12 @@ private:
 
 	/// Socket for this connection.
 	QScopedPointer<QTcpSocket> mSocket;
+
+	/// Address of a peer, remembered when connection is established.
+	QHostAddress mPeerAddress;
+
+	/// Port of a peer, remembered when connection is established.
+	int mPeerPort = -1;
 };
 
 }
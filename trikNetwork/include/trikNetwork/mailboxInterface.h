@@ -15,6 +15,7 @@
 #pragma once
 
 #include <QtCore/QObject>
+#include <QtCore/QVariantList>
 #include <QtNetwork/QHostAddress>
 #include <QtXml/QDomElement>
 
@@ -45,12 +46,17 @@ public:
 	/// Returns our IP address, or empty QHostAddress if we are not connected.
 	virtual QHostAddress myIp() const = 0;
 
-	/// Clears message queue.
+	/// Clears message queue and allows waiting for messages again after stopWaiting().
 	virtual void clearQueue() = 0;
 
-	/// Stops waiting for messages.
+	/// Stops waiting for messages. Receiving with waiting returns at once until clearQueue() or resumeWaiting() is
+	/// called.
 	virtual void stopWaiting() = 0;
 
+	/// Allows waiting for messages again after stopWaiting(), keeping messages in a queue. Called when a new script
+	/// starts, so that stopping of a previous one does not affect it.
+	virtual void resumeWaiting() = 0;
+
 	/// Returns true if mailbox is enabled in current configuration.
 	virtual bool isEnabled() = 0;
 
@@ -79,6 +85,17 @@ public slots:
 	/// @param wait - if false, doesn't wait for new messages and returns empty string if message queue is empty
 	virtual QString receive(bool wait = true) = 0;
 
+	/// Receives and returns one incoming message from a robot with given hull number, messages from other robots
+	/// stay in a queue. Blocks like receive().
+	/// @param wait - if false, doesn't wait for new messages and returns empty string if there are no messages
+	///        from this robot
+	virtual QString receiveFrom(int hullNumber, bool wait = true) = 0;
+
+	/// Receives up to given number of incoming messages in order of arrival, does not wait. Every message is a map
+	/// with "sender" (hull number of a sender, -1 if it is unknown), "message" and "timestamp" (time of arrival,
+	/// milliseconds since epoch).
+	virtual QVariantList receiveBatch(int max) = 0;
+
 	/// Returns hull number of this robot.
 	virtual int myHullNumber() const = 0;
 
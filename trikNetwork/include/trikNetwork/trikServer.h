@@ -17,9 +17,13 @@
 #include <functional>
 
 #include <QtCore/QHash>
+#include <QtCore/QPair>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QSet>
 #include <QtCore/QThread>
+#include <QtCore/QVector>
+#include <QtNetwork/QHostAddress>
 #include <QtNetwork/QTcpServer>
-#include <QtCore/QTimer>
 
 #include "declSpec.h"
 
@@ -31,7 +35,8 @@ namespace trikNetwork {
 
 class Connection;
 
-/// Server that can handle multiple clients. Actual work is done in separate threads by Connection objects.
+/// Server that can handle multiple clients. Actual work is done by Connection objects in a small fixed pool of I/O
+/// threads, each thread runs an event loop that serves many connections.
 class TRIKNETWORK_EXPORT TrikServer : public QTcpServer
 {
 	Q_OBJECT
@@ -39,13 +44,17 @@ class TRIKNETWORK_EXPORT TrikServer : public QTcpServer
 public:
 	/// Constructor.
 	/// @param connectionFactory - function that provides actual connection objects.
-	explicit TrikServer(const std::function<Connection *()> &connectionFactory);
+	/// @param ioThreads - number of I/O threads, 0 means one thread per CPU core.
+	explicit TrikServer(const std::function<Connection *()> &connectionFactory, int ioThreads = 0);
 
 	~TrikServer() override;
 
 	/// Returns number of connections currently opened.
 	int activeConnections() const;
 
+	/// Returns number of I/O threads started so far. Threads are started when needed, up to the pool size.
+	int ioThreads() const;
+
 	/// Starts listening given port on all network interfaces.
 	Q_INVOKABLE void startServer(const int &port);
 
@@ -63,25 +72,61 @@ signals:
 protected:
 	void incomingConnection(qintptr socketDescriptor) override;
 
-	/// Launches given connection in a separate thread. Takes ownership over connectionWorker object.
+	/// Launches given connection in one of I/O threads, threads are assigned round-robin. Takes ownership over
+	/// connectionWorker object.
 	void startConnection(Connection * const connectionWorker);
 
+	/// Stops listening, stops I/O threads and deletes all connections. Called by destructor; derived servers whose
+	/// connections use their resources shall call it in their own destructors.
+	void closeConnections();
+
 	/// Searches connection to given IP and port in a list of all open connections. Note that if connection is added
 	/// by startConnection() call but not finished to open yet, it will not be found.
+	/// Can be safely called from other threads.
 	Connection *connection(const QHostAddress &ip, int port) const;
 
 	/// Searches connection to given IP and any port in a list of all open connections. Will return arbitrary matching
 	/// connection if there are more than one connection with this IP. Note that if connection is added
 	/// by startConnection() call but not finished to open yet, it will not be found.
+	/// Can be safely called from other threads.
 	Connection *connection(const QHostAddress &ip) const;
 
 private slots:
-	/// Called when connection thread finishes.
+	/// Called when connection is established, adds it to endpoint index.
+	void onConnectionOpened(Connection *connection);
+
+	/// Called when connection is closed.
 	void onConnectionClosed(Connection *connection);
 
 private:
-	/// Maps thread object to corresponding connection worker object, to be able to correctly stop and delete them all.
-	QHash<QThread *, Connection *> mConnections;  // Has ownership over threads and connections.
+	typedef QPair<QHostAddress, int> Endpoint;
+
+	/// Returns I/O thread for a new connection, starting new thread if pool is not full yet.
+	QThread *nextThread();
+
+	/// All connections, opened or not yet.
+	QSet<Connection *> mConnections;  // Has ownership.
+
+	/// Index of opened connections by peer IP and port.
+	QHash<Endpoint, Connection *> mEndpoints;  // Does not have ownership.
+
+	/// Index of opened connections by peer IP.
+	QMultiHash<QHostAddress, Connection *> mAddresses;  // Does not have ownership.
+
+	/// Endpoints under which opened connections are indexed, to remove them from index when they close.
+	QHash<Connection *, Endpoint> mIndexedEndpoints;
+
+	/// Guards connections set and indices, since connections are searched from other threads (by mailbox, for example).
+	mutable QReadWriteLock mConnectionsLock;
+
+	/// I/O threads, started when needed.
+	QVector<QThread *> mThreads;  // Has ownership.
+
+	/// Maximal number of I/O threads.
+	int mMaxThreads;
+
+	/// Index of a thread that will get next connection.
+	int mNextThread = 0;
 
 	/// Function that provides actual connection objects.
 	std::function<Connection *()> mConnectionFactory;
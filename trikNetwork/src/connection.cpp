@@ -12,8 +12,7 @@
  * See the License for the specific language governing permissions and
  * limitations under the License. */
 
-#include <QtCore/QThread>
-
+#include <trikKernel/metrics.h>
 #include <trikKernel/version.h>
 #include <QsLog.h>
 
@@ -24,10 +23,48 @@ using namespace trikNetwork;
 const int keepaliveTime = 3000;
 const int heartbeatTime = 5000;
 
+/// Maximal size of a message, larger ones are considered malformed, so a broken peer can not exhaust memory.
+const int maxMessageSize = 64 * 1024 * 1024;
+
+/// Initial capacity of receive buffer, it grows if larger messages are received.
+const int initialBufferCapacity = 4096;
+
+/// Capacity of receive buffer that is kept after large messages are processed.
+const int maxIdleBufferCapacity = 256 * 1024;
+
+/// Maximal number of characters in a message length prefix.
+const int maxLengthDigits = 10;
+
+/// Number of bytes of a message that get to the log.
+const int maxLoggedBytes = 128;
+
+static trikKernel::Metrics::Counter &sentBytesCount = trikKernel::Metrics::counter("network.sentBytes");
+static trikKernel::Metrics::Counter &receivedBytesCount = trikKernel::Metrics::counter("network.receivedBytes");
+static trikKernel::Metrics::Counter &receivedMessagesCount = trikKernel::Metrics::counter("network.receivedMessages");
+static trikKernel::Metrics::Histogram &sendQueueBytes = trikKernel::Metrics::histogram("network.sendQueueBytes");
+static trikKernel::Metrics::Histogram &processingTime = trikKernel::Metrics::histogram("network.processing");
+
+/// Returns message prepared for logging, long messages are truncated.
+static QByteArray logged(const QByteArray &data)
+{
+	if (data.size() <= maxLoggedBytes) {
+		return data;
+	}
+
+	return data.left(maxLoggedBytes) + "... (" + QByteArray::number(data.size()) + " bytes)";
+}
+
 Connection::Connection(Protocol connectionProtocol, Heartbeat useHeartbeat)
 	: mProtocol(connectionProtocol)
 	, mUseHeartbeat(useHeartbeat == Heartbeat::use)
 {
+	// Reserved capacity is kept when buffer is emptied, so reads do not reallocate it.
+	mBuffer.reserve(initialBufferCapacity);
+}
+
+Connection::~Connection()
+{
+	stopKeepalive();
 }
 
 bool Connection::isConnected() const
@@ -37,22 +74,12 @@ bool Connection::isConnected() const
 
 QHostAddress Connection::peerAddress() const
 {
-	if (!mSocket) {
-		QLOG_FATAL() << "Connection::peerAddress() called on empty socket, thread:" << thread();
-		Q_ASSERT(false);
-	}
-
-	return mSocket->peerAddress();
+	return mPeerAddress;
 }
 
 int Connection::peerPort() const
 {
-	if (!mSocket) {
-		QLOG_FATAL() << "Connection::peerPort() called on empty socket, thread:" << thread();
-		Q_ASSERT(false);
-	}
-
-	return mSocket->peerPort();
+	return mPeerPort;
 }
 
 void Connection::init(const QHostAddress &ip, int port)
@@ -61,46 +88,54 @@ void Connection::init(const QHostAddress &ip, int port)
 
 	connectSlots();
 
-	initKeepalive();
-
+	// Connection does not wait here, since its thread serves other connections too. Data sent before the socket is
+	// connected is buffered by a socket, connected() is emitted from onConnect().
 	mSocket->connectToHost(ip, port);
-
-	if (!mSocket->waitForConnected()) {
-		QLOG_ERROR() << "Connection to" << ip << ":" << port << "failed";
-		doDisconnect();
-	} else {
-		if (mUseHeartbeat) {
-			mKeepAliveTimer->start();
-			mHeartbeatTimer->start();
-		}
-
-		emit connected(this);
-	}
 }
 
 void Connection::send(const QByteArray &data)
 {
-	if (mSocket->state() != QAbstractSocket::ConnectedState) {
+	if (mSocket->state() != QAbstractSocket::ConnectedState
+			&& mSocket->state() != QAbstractSocket::ConnectingState
+			&& mSocket->state() != QAbstractSocket::HostLookupState)
+	{
 		QLOG_ERROR() << "Trying to send through unconnected socket, message is not delivered";
 		return;
 	}
 
 	if (data != "keepalive") {
-		QLOG_INFO() << "Sending:" << data << " to" << peerAddress() << ":" << peerPort();
+		QLOG_INFO() << "Sending:" << logged(data) << " to" << peerAddress() << ":" << peerPort();
 	}
 
 	if (mUseHeartbeat) {
 		/// Reset keepalive timer to avoid spamming with keepalive packets.
-		mKeepAliveTimer->start();
+		restartTimer(mKeepAliveTimer, keepaliveTime, "keepAlive");
 	}
 
-	const QByteArray message = mProtocol == Protocol::messageLength
-			? QByteArray::number(data.size()) + ':' + data
-			: data + '\n';
+	// Header and data are appended to socket write buffer separately, without building a message copy.
+	qint64 expectedBytes = data.size();
+	qint64 sentBytes = 0;
+	if (mProtocol == Protocol::messageLength) {
+		char header[16];
+		const int headerSize = qsnprintf(header, sizeof(header), "%d:", data.size());
+		expectedBytes += headerSize;
+		sentBytes += qMax<qint64>(mSocket->write(header, headerSize), 0);
+		sentBytes += qMax<qint64>(mSocket->write(data), 0);
+	} else {
+		expectedBytes += 1;
+		sentBytes += qMax<qint64>(mSocket->write(data), 0);
+		sentBytes += qMax<qint64>(mSocket->write("\n", 1), 0);
+	}
+
+	if (sentBytes != expectedBytes) {
+		QLOG_ERROR() << "Failed to send message" << logged(data) << ", " << sentBytes << "of" << expectedBytes
+				<< "bytes sent.";
+	}
 
-	const qint64 sentBytes = mSocket->write(message);
-	if (sentBytes != message.size()) {
-		QLOG_ERROR() << "Failed to send message" << message << ", " << sentBytes << "sent.";
+	sentBytesCount.add(sentBytes);
+	if (trikKernel::Metrics::isEnabled()) {
+		// Bytes not yet written to the socket show how far a slow peer lags behind.
+		sendQueueBytes.record(mSocket->bytesToWrite());
 	}
 }
 
@@ -108,8 +143,6 @@ void Connection::init(int socketDescriptor)
 {
 	mSocket.reset(new QTcpSocket());
 
-	initKeepalive();
-
 	if (!mSocket->setSocketDescriptor(socketDescriptor)) {
 		QLOG_ERROR() << "Failed to set socket descriptor" << socketDescriptor;
 		return;
@@ -118,9 +151,12 @@ void Connection::init(int socketDescriptor)
 	connectSlots();
 
 	if (mUseHeartbeat) {
-		mKeepAliveTimer->start();
-		mHeartbeatTimer->start();
+		startKeepalive();
 	}
+
+	mPeerAddress = mSocket->peerAddress();
+	mPeerPort = mSocket->peerPort();
+	emit connected(this);
 }
 
 void Connection::onReadyRead()
@@ -131,77 +167,117 @@ void Connection::onReadyRead()
 
 	if (mUseHeartbeat) {
 		/// Reset heartbeat timer, we received something, so connection is up.
-		mHeartbeatTimer->start();
+		restartTimer(mHeartbeatTimer, heartbeatTime, "onHeartbeatTimeout");
 	}
 
-	const QByteArray &data = mSocket->readAll();
-	mBuffer.append(data);
-
-	if (mBuffer != "9:keepalive") {
-		QLOG_INFO() << "Received from" << peerAddress() << ":" << peerPort() << ":" << mBuffer;
+	// Reading directly into the tail of the buffer, its capacity is reused between reads.
+	const qint64 available = mSocket->bytesAvailable();
+	if (available <= 0) {
+		return;
 	}
 
+	const int oldSize = mBuffer.size();
+	mBuffer.resize(oldSize + static_cast<int>(available));
+	const qint64 read = mSocket->read(mBuffer.data() + oldSize, available);
+	mBuffer.resize(oldSize + static_cast<int>(qMax<qint64>(read, 0)));
+	receivedBytesCount.add(qMax<qint64>(read, 0));
+
 	processBuffer();
 }
 
 void Connection::processBuffer()
 {
+	// Messages are parsed from mBufferOffset on, consumed data is removed from the buffer once per call, so parsing
+	// of many messages received at once is linear.
 	switch (mProtocol) {
 	case Protocol::messageLength:
 	{
-		while (!mBuffer.isEmpty()) {
+		while (mBufferOffset < mBuffer.size()) {
 			if (mExpectedBytes == 0) {
 				// Determining the length of a message.
-				const int delimiterIndex = mBuffer.indexOf(':');
+				const int delimiterIndex = mBuffer.indexOf(':', mBufferOffset);
 				if (delimiterIndex == -1) {
 					// We did not receive full message length yet.
-					return;
-				} else {
-					const QByteArray length = mBuffer.left(delimiterIndex);
-					mBuffer = mBuffer.mid(delimiterIndex + 1);
-					bool ok = false;
-					mExpectedBytes = length.toInt(&ok);
-					if (!ok) {
-						QLOG_ERROR() << "Malformed message, can not determine message length from this:" << length;
-						mExpectedBytes = 0;
+					if (mBuffer.size() - mBufferOffset > maxLengthDigits) {
+						QLOG_ERROR() << "Malformed message, no message length in" << logged(mBuffer.mid(mBufferOffset));
+						mBufferOffset = mBuffer.size();
 					}
-				}
-			} else {
-				if (mBuffer.size() >= mExpectedBytes) {
-					QByteArray const message = mBuffer.left(mExpectedBytes);
-					mBuffer = mBuffer.mid(mExpectedBytes);
 
-					handleIncomingData(message);
+					break;
+				}
 
+				const QByteArray length = QByteArray::fromRawData(mBuffer.constData() + mBufferOffset
+						, delimiterIndex - mBufferOffset);
+				bool ok = false;
+				mExpectedBytes = length.toInt(&ok);
+				mBufferOffset = delimiterIndex + 1;
+				if (!ok || mExpectedBytes < 0 || mExpectedBytes > maxMessageSize) {
+					QLOG_ERROR() << "Malformed message, can not determine message length from this:"
+							<< logged(length);
 					mExpectedBytes = 0;
-				} else {
-					// We don't have all message yet.
-					return;
 				}
+			} else if (mBuffer.size() - mBufferOffset >= mExpectedBytes) {
+				const QByteArray message = mBuffer.mid(mBufferOffset, mExpectedBytes);
+				mBufferOffset += mExpectedBytes;
+				mExpectedBytes = 0;
+
+				handleIncomingData(message);
+			} else {
+				// We don't have all message yet.
+				break;
 			}
 		}
 		break;
 	}
 	case Protocol::endOfLineSeparator:
 	{
-		if (mBuffer.contains('\n')) {
-			const auto messages = mBuffer.split('\n');
-			for (int i = 0; i < messages.size() - 1; ++i) {
-				handleIncomingData(messages.at(i));
+		while (mBufferOffset < mBuffer.size()) {
+			const int separatorIndex = mBuffer.indexOf('\n', mBufferOffset);
+			if (separatorIndex == -1) {
+				if (mBuffer.size() - mBufferOffset > maxMessageSize) {
+					QLOG_ERROR() << "Message is too long, dropping" << mBuffer.size() - mBufferOffset << "bytes";
+					mBufferOffset = mBuffer.size();
+				}
+
+				break;
 			}
 
-			mBuffer = messages.last();
+			const QByteArray message = mBuffer.mid(mBufferOffset, separatorIndex - mBufferOffset);
+			mBufferOffset = separatorIndex + 1;
+
+			handleIncomingData(message);
 		}
 		break;
 	}
 	}
+
+	if (mBufferOffset == mBuffer.size()) {
+		if (mBuffer.capacity() > maxIdleBufferCapacity) {
+			// Memory taken by a large message is returned.
+			mBuffer = QByteArray();
+			mBuffer.reserve(initialBufferCapacity);
+		} else {
+			mBuffer.resize(0);
+		}
+
+		mBufferOffset = 0;
+	} else if (mBufferOffset > 0) {
+		mBuffer.remove(0, mBufferOffset);
+		mBufferOffset = 0;
+	}
 }
 
 void Connection::handleIncomingData(const QByteArray &data)
 {
 	if (data == "keepalive") {
 		return;
-	} if (data == "version") {
+	}
+
+	receivedMessagesCount.add();
+	trikKernel::Metrics::ScopedTimer timer(processingTime);
+	QLOG_INFO() << "Received from" << peerAddress() << ":" << peerPort() << ":" << logged(data);
+
+	if (data == "version") {
 		send(QString("version: " + trikKernel::version).toUtf8());
 	} else {
 		processData(data);
@@ -211,9 +287,12 @@ void Connection::handleIncomingData(const QByteArray &data)
 void Connection::onConnect()
 {
 	if (mUseHeartbeat) {
-		mKeepAliveTimer->start();
-		mHeartbeatTimer->start();
+		startKeepalive();
 	}
+
+	mPeerAddress = mSocket->peerAddress();
+	mPeerPort = mSocket->peerPort();
+	emit connected(this);
 }
 
 void Connection::onDisconnect()
@@ -227,6 +306,9 @@ void Connection::onError(QAbstractSocket::SocketError error)
 {
 	if (error == QAbstractSocket::RemoteHostClosedError) {
 		QLOG_ERROR() << "Connection" << mSocket->socketDescriptor() << ": remote host closed";
+	} else if (mPeerPort == -1) {
+		QLOG_ERROR() << "Connection to" << mSocket->peerName() << ":" << mSocket->peerPort() << "failed:"
+				<< mSocket->errorString();
 	} else {
 		QLOG_ERROR() << "Connection" << mSocket->socketDescriptor() << "errored.";
 	}
@@ -261,30 +343,33 @@ void Connection::doDisconnect()
 	}
 
 	if (mUseHeartbeat) {
-		mKeepAliveTimer->stop();
-		mHeartbeatTimer->stop();
+		stopKeepalive();
 	}
 
 	mDisconnectReported = true;
 
 	emit disconnected(this);
-
-	thread()->quit();
 }
 
-void Connection::initKeepalive()
+void Connection::restartTimer(quint64 &timer, int interval, const char *slot)
 {
-	if (mUseHeartbeat) {
-		mKeepAliveTimer.reset(new QTimer);
-		mHeartbeatTimer.reset(new QTimer);
-
-		connect(mKeepAliveTimer.data(), SIGNAL(timeout()), this, SLOT(keepAlive()));
-		connect(mHeartbeatTimer.data(), SIGNAL(timeout()), this, SLOT(onHeartbeatTimeout()));
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	if (!wheel.restart(timer)) {
+		timer = wheel.startQueued(interval, this, slot);
+	}
+}
 
-		mKeepAliveTimer->setSingleShot(false);
-		mHeartbeatTimer->setSingleShot(false);
+void Connection::startKeepalive()
+{
+	restartTimer(mKeepAliveTimer, keepaliveTime, "keepAlive");
+	restartTimer(mHeartbeatTimer, heartbeatTime, "onHeartbeatTimeout");
+}
 
-		mKeepAliveTimer->setInterval(keepaliveTime);
-		mHeartbeatTimer->setInterval(heartbeatTime);
-	}
+void Connection::stopKeepalive()
+{
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	wheel.stop(mKeepAliveTimer);
+	wheel.stop(mHeartbeatTimer);
+	mKeepAliveTimer = 0;
+	mHeartbeatTimer = 0;
 }
@@ -15,16 +15,53 @@
 #include "mailbox.h"
 #include "mailboxServer.h"
 
-#include <QtCore/QEventLoop>
+#include <QtCore/QVariantMap>
 
 #include <trikKernel/configurer.h>
 #include <trikKernel/exceptions/malformedConfigException.h>
 
 using namespace trikNetwork;
 
+/// Returns value of optional attribute of mailbox configuration or given default value if it is not configured.
+static QString optionalAttribute(const trikKernel::Configurer &configurer, const QString &attributeName
+		, const QString &defaultValue)
+{
+	return configurer.hasAttributeByDevice("mailbox", attributeName)
+			? configurer.attributeByDevice("mailbox", attributeName) : defaultValue;
+}
+
+static MulticastSettings multicastSettings(const trikKernel::Configurer &configurer)
+{
+	MulticastSettings settings;
+	settings.enabled = optionalAttribute(configurer, "transport", "tcp") == "multicast";
+	if (!settings.enabled) {
+		return settings;
+	}
+
+	settings.group = QHostAddress(optionalAttribute(configurer, "multicastGroup", settings.group.toString()));
+	if (settings.group.isNull()) {
+		throw trikKernel::MalformedConfigException("Incorrect mailbox multicast group");
+	}
+
+	bool ok = false;
+	settings.port = optionalAttribute(configurer, "multicastPort", QString::number(settings.port)).toInt(&ok);
+	if (!ok) {
+		throw trikKernel::MalformedConfigException("Incorrect mailbox multicast port");
+	}
+
+	settings.batchDelay = optionalAttribute(configurer, "batchDelay", QString::number(settings.batchDelay)).toInt(&ok);
+	if (!ok) {
+		throw trikKernel::MalformedConfigException("Incorrect mailbox multicast batch delay");
+	}
+
+	settings.interfaceName = optionalAttribute(configurer, "multicastInterface", "");
+	settings.reliable = optionalAttribute(configurer, "reliable", "true") != "false";
+	return settings;
+}
+
 Mailbox::Mailbox(int port)
 {
-	init(port);
+	init(port, MulticastSettings());
 }
 
 Mailbox::Mailbox(const trikKernel::Configurer &configurer)
@@ -35,7 +72,7 @@ Mailbox::Mailbox(const trikKernel::Configurer &configurer)
 		throw trikKernel::MalformedConfigException("Incorrect mailbox port");
 	}
 
-	init(port);
+	init(port, multicastSettings(configurer));
 }
 
 Mailbox::~Mailbox()
@@ -80,14 +117,17 @@ QHostAddress Mailbox::myIp() const
 
 void Mailbox::clearQueue()
 {
-	while (mWorker->hasMessages()) {
-		mWorker->receive();
-	}
+	mWorker->inbox().clear();
 }
 
 void Mailbox::stopWaiting()
 {
-	emit stopWaitingSignal();
+	mWorker->inbox().interrupt();
+}
+
+void Mailbox::resumeWaiting()
+{
+	mWorker->inbox().resume();
 }
 
 bool Mailbox::isEnabled()
@@ -117,32 +157,39 @@ void Mailbox::send(const QString &message)
 
 bool Mailbox::hasMessages()
 {
-	return mWorker->hasMessages();
+	return !mWorker->inbox().isEmpty();
 }
 
 QString Mailbox::receive(bool wait)
 {
-	QString result;
-
-	QEventLoop loop;
-	QObject::connect(this, SIGNAL(stopWaitingSignal()), &loop, SLOT(quit()), Qt::QueuedConnection);
+	MailboxMessage message;
+	return mWorker->inbox().take(message, wait) ? QString::fromUtf8(message.data) : QString();
+}
 
-	if (!mWorker->hasMessages() && wait) {
-		loop.exec();
-	}
+QString Mailbox::receiveFrom(int hullNumber, bool wait)
+{
+	MailboxMessage message;
+	return mWorker->inbox().takeFrom(hullNumber, message, wait) ? QString::fromUtf8(message.data) : QString();
+}
 
-	if (mWorker->hasMessages()) {
-		result = mWorker->receive();
+QVariantList Mailbox::receiveBatch(int max)
+{
+	QVariantList result;
+	for (const MailboxMessage &message : mWorker->inbox().takeBatch(max)) {
+		QVariantMap item;
+		item["sender"] = message.sender;
+		item["message"] = QString::fromUtf8(message.data);
+		item["timestamp"] = message.timestamp;
+		result << item;
 	}
 
 	return result;
 }
 
-void Mailbox::init(int port)
+void Mailbox::init(int port, const MulticastSettings &multicast)
 {
-	mWorker.reset(new MailboxServer(port));
+	mWorker.reset(new MailboxServer(port, multicast));
 	QObject::connect(mWorker.data(), SIGNAL(newMessage(int, QString)), this, SIGNAL(newMessage(int, QString)));
-	QObject::connect(mWorker.data(), SIGNAL(newMessage(int, QString)), this, SIGNAL(stopWaitingSignal()));
 	QObject::connect(mWorker.data(), SIGNAL(connected()), this, SLOT(updateConnectionStatus()));
 	QObject::connect(mWorker.data(), SIGNAL(disconnected()), this, SLOT(updateConnectionStatus()));
 
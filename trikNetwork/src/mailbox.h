@@ -19,6 +19,7 @@
 #include <QtXml/QDomElement>
 
 #include "mailboxInterface.h"
+#include "multicastTransport.h"
 
 namespace trikKernel {
 class Configurer;
@@ -39,7 +40,8 @@ public:
 	Mailbox(int port);
 
 	/// Constructor.
-	/// @param configurer - configurer object that contains preparsed XML config.
+	/// @param configurer - configurer object that contains preparsed XML config. Besides "port", "mailbox" section
+	///        may contain settings of multicast transport for broadcasts, see MulticastSettings.
 	Mailbox(const trikKernel::Configurer &configurer);
 
 	~Mailbox() override;
@@ -58,6 +60,8 @@ public:
 
 	void stopWaiting() override;
 
+	void resumeWaiting() override;
+
 public slots:
 	void connect(const QString &ip, int port) override;
 
@@ -71,20 +75,20 @@ public slots:
 
 	QString receive(bool wait = true) override;
 
+	QString receiveFrom(int hullNumber, bool wait = true) override;
+
+	QVariantList receiveBatch(int max) override;
+
 	int myHullNumber() const override;
 
 	void renewIp() override;
 
-signals:
-	/// Used to interrupt waiting for new message.
-	void stopWaitingSignal();
-
 private slots:
 	void updateConnectionStatus();
 
 private:
 	/// Starts mailbox listening given port.
-	void init(int port);
+	void init(int port, const MulticastSettings &multicast);
 
 	/// Server that works in separate thread.
 	QScopedPointer<MailboxServer> mWorker;
@@ -0,0 +1,151 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "src/mailboxInbox.h"
+
+#include <QtCore/QDateTime>
+
+using namespace trikNetwork;
+
+void MailboxInbox::push(int sender, const QByteArray &data)
+{
+	const QSharedPointer<Entry> entry(new Entry{{sender, data, QDateTime::currentMSecsSinceEpoch()}, false});
+
+	QMutexLocker locker(&mMutex);
+	mQueue.enqueue(entry);
+	mBySender[sender].enqueue(entry);
+	++mCount;
+	mCondition.wakeAll();
+}
+
+bool MailboxInbox::isEmpty() const
+{
+	QMutexLocker locker(&mMutex);
+	return mCount == 0;
+}
+
+bool MailboxInbox::take(MailboxMessage &message, bool wait)
+{
+	QMutexLocker locker(&mMutex);
+	Queue *queue = nullptr;
+	if (!waitFor(queue, -1, false, wait)) {
+		return false;
+	}
+
+	message = takeHead(*queue);
+	return true;
+}
+
+bool MailboxInbox::takeFrom(int sender, MailboxMessage &message, bool wait)
+{
+	QMutexLocker locker(&mMutex);
+	Queue *queue = nullptr;
+	if (!waitFor(queue, sender, true, wait)) {
+		return false;
+	}
+
+	message = takeHead(*queue);
+	return true;
+}
+
+QList<MailboxMessage> MailboxInbox::takeBatch(int max)
+{
+	QList<MailboxMessage> result;
+
+	QMutexLocker locker(&mMutex);
+	while (result.size() < max) {
+		trim(mQueue);
+		if (mQueue.isEmpty()) {
+			break;
+		}
+
+		result << takeHead(mQueue);
+	}
+
+	return result;
+}
+
+void MailboxInbox::interrupt()
+{
+	QMutexLocker locker(&mMutex);
+	mInterrupted = true;
+	mCondition.wakeAll();
+}
+
+void MailboxInbox::resume()
+{
+	QMutexLocker locker(&mMutex);
+	mInterrupted = false;
+}
+
+void MailboxInbox::clear()
+{
+	QMutexLocker locker(&mMutex);
+	mQueue.clear();
+	mBySender.clear();
+	mCount = 0;
+	mInterrupted = false;
+}
+
+void MailboxInbox::trim(Queue &queue)
+{
+	while (!queue.isEmpty() && queue.head()->taken) {
+		queue.dequeue();
+	}
+}
+
+MailboxMessage MailboxInbox::takeHead(Queue &queue)
+{
+	const QSharedPointer<Entry> entry = queue.dequeue();
+	entry->taken = true;
+	--mCount;
+
+	// Message is the oldest one of its sender or the oldest one at all, so if it is still in other queue, it is
+	// at its head and is dropped right away.
+	trim(mQueue);
+	const auto senderQueue = mBySender.find(entry->message.sender);
+	if (senderQueue != mBySender.end()) {
+		trim(senderQueue.value());
+		if (senderQueue.value().isEmpty()) {
+			mBySender.erase(senderQueue);
+		}
+	}
+
+	return entry->message;
+}
+
+bool MailboxInbox::waitFor(Queue *&queue, int sender, bool bySender, bool wait)
+{
+	forever {
+		if (bySender) {
+			const auto senderQueue = mBySender.find(sender);
+			queue = senderQueue != mBySender.end() ? &senderQueue.value() : nullptr;
+		} else {
+			queue = &mQueue;
+		}
+
+		if (queue != nullptr) {
+			trim(*queue);
+			if (!queue->isEmpty()) {
+				return true;
+			}
+		}
+
+		if (!wait || mInterrupted) {
+			return false;
+		}
+
+		mCondition.wait(&mMutex);
+	}
+}
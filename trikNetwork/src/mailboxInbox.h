@@ -0,0 +1,109 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMutex>
+#include <QtCore/QQueue>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QWaitCondition>
+
+namespace trikNetwork {
+
+/// Message received by a mailbox.
+struct MailboxMessage {
+	/// Hull number of a sender, -1 if it is unknown.
+	int sender;
+
+	/// Message itself, in UTF-8.
+	QByteArray data;
+
+	/// Time when message was received, milliseconds since epoch.
+	qint64 timestamp;
+};
+
+/// Queue of incoming mailbox messages which can be consumed in order of arrival, in batches, or only from a given
+/// sender. Messages are filled by mailbox server thread and consumed by script threads; consumers wait on a condition
+/// variable, not in a nested event loop, so waiting does not process unrelated events of a script thread.
+///
+/// Every message is kept in a common queue and in a queue of its sender. Taking a message from one queue marks it as
+/// taken, and it is dropped from the other queue when it gets to its head, so all operations are amortized O(1).
+class MailboxInbox
+{
+public:
+	/// Adds a message and wakes up waiting consumers.
+	void push(int sender, const QByteArray &data);
+
+	/// Returns true if there are no messages.
+	bool isEmpty() const;
+
+	/// Takes the oldest message. If there are none and wait is true, blocks until a message arrives or interrupt() is
+	/// called, and does not block at all if interrupt() was already called. Returns false if no message was taken.
+	bool take(MailboxMessage &message, bool wait);
+
+	/// Takes the oldest message from a given sender, waits like take().
+	bool takeFrom(int sender, MailboxMessage &message, bool wait);
+
+	/// Takes up to max oldest messages without waiting.
+	QList<MailboxMessage> takeBatch(int max);
+
+	/// Wakes up all waiting consumers, they return without a message. Later waits also return at once, until clear()
+	/// or resume().
+	void interrupt();
+
+	/// Allows consumers to wait again after interrupt(), messages are kept.
+	void resume();
+
+	/// Drops all messages and allows consumers to wait again after interrupt().
+	void clear();
+
+private:
+	struct Entry {
+		MailboxMessage message;
+		bool taken;
+	};
+
+	typedef QQueue<QSharedPointer<Entry>> Queue;
+
+	/// Drops already taken messages from the head of a queue.
+	static void trim(Queue &queue);
+
+	/// Takes a message from the head of a queue, which shall be trimmed and not empty.
+	MailboxMessage takeHead(Queue &queue);
+
+	/// Waits for a message in a queue of a given sender or in a common queue if sender is not given.
+	/// Returns false if waiting was interrupted or not allowed. Shall be called with mutex locked.
+	bool waitFor(Queue *&queue, int sender, bool bySender, bool wait);
+
+	/// All messages in order of arrival.
+	Queue mQueue;
+
+	/// Messages by hull numbers of their senders.
+	QHash<int, Queue> mBySender;
+
+	/// Number of messages that are not taken yet.
+	int mCount = 0;
+
+	/// Set by interrupt() and reset by clear() or resume(), consumers do not wait while it is set. It is a latch and not a pulse,
+	/// so interrupt which comes just before a consumer starts waiting is not lost.
+	bool mInterrupted = false;
+
+	mutable QMutex mMutex;
+	QWaitCondition mCondition;
+};
+
+}
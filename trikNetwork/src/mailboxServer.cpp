@@ -24,11 +24,12 @@
 
 using namespace trikNetwork;
 
-MailboxServer::MailboxServer(int port)
+MailboxServer::MailboxServer(int port, const MulticastSettings &multicast)
 	: TrikServer([this] () { return connectionFactory(); })
 	, mHullNumber(0)
 	, mMyIp(determineMyIp())
 	, mMyPort(port)
+	, mMulticastSettings(multicast)
 {
 	setObjectName("MailboxServer");
 	qRegisterMetaType<QHostAddress>("QHostAddress");
@@ -37,19 +38,16 @@ MailboxServer::MailboxServer(int port)
 
 bool MailboxServer::isConnected()
 {
-	bool result = false;
-	mKnownRobotsLock.lockForRead();
-	for (const auto &endpoint : mKnownRobots.values()) {
-		Connection * const connection = this->connection(endpoint.ip, endpoint.port);
+	const auto peers = mPeers.snapshot();
+	for (const auto &endpoint : peers->endpoints()) {
+		Connection * const connection = openedConnection(*peers, endpoint);
 		MailboxConnection * const mailboxConnection = dynamic_cast<MailboxConnection *>(connection);
 		if (mailboxConnection && mailboxConnection->isConnected()) {
-			result = true;
-			break;
+			return true;
 		}
 	}
 
-	mKnownRobotsLock.unlock();
-	return result;
+	return false;
 }
 
 int MailboxServer::hullNumber() const
@@ -79,6 +77,17 @@ void MailboxServer::start()
 {
 	startServer(mMyPort);
 
+	if (mMulticastSettings.enabled) {
+		mMulticast.reset(new MulticastTransport(mMulticastSettings));
+		if (mMulticast->start()) {
+			QObject::connect(mMulticast.data(), SIGNAL(newData(int, QByteArray))
+					, this, SLOT(onMulticastData(int, QByteArray)));
+		} else {
+			QLOG_ERROR() << "Mailbox multicast transport failed to start, broadcasts will be sent via TCP";
+			mMulticast.reset();
+		}
+	}
+
 	if (!mServerIp.isNull() && mServerIp != mMyIp && mMyIp == mSavedIp) {
 		connect(mServerIp, mServerPort);
 	}
@@ -140,6 +149,17 @@ Connection *MailboxServer::connect(const QHostAddress &ip, int port)
 
 	startConnection(connection);
 
+	const Endpoint endpoint{ip, port};
+	mPendingConnections.insert(endpoint, connection);
+	const auto forget = [this, endpoint, connection]() {
+		if (mPendingConnections.value(endpoint).data() == connection) {
+			mPendingConnections.remove(endpoint);
+		}
+	};
+
+	QObject::connect(connection, &Connection::connected, this, forget);
+	QObject::connect(connection, &Connection::disconnected, this, forget);
+
 	QMetaObject::invokeMethod(connection, "connect"
 			, Q_ARG(const QHostAddress &, ip)
 			, Q_ARG(int, port)
@@ -192,32 +212,37 @@ QHostAddress MailboxServer::determineMyIp()
 	return QHostAddress();
 }
 
-Connection *MailboxServer::prepareConnection(const QHostAddress &ip)
+Connection *MailboxServer::openedConnection(const PeerRegistry::Snapshot &peers, const Endpoint &endpoint) const
 {
-	// First, trying to reuse existing connection.
-	const auto connectionObject = connection(ip);
-	if (connectionObject != nullptr) {
-		return connectionObject;
+	Connection * const outgoing = connection(endpoint.ip, endpoint.port);
+	if (outgoing != nullptr) {
+		return outgoing;
 	}
 
-	// Next, trying to create new connection to given IP. We need port, so checking if robot is known.
-	Endpoint targetEndpoint;
-	mKnownRobotsLock.lockForRead();
-	for (const auto &endpoint : mKnownRobots.values()) {
-		if (endpoint.ip == ip) {
-			targetEndpoint = endpoint;
-			break;
-		}
+	const Endpoint route = peers.route(endpoint);
+	return route.ip.isNull() ? nullptr : connection(route.ip, route.port);
+}
+
+Connection *MailboxServer::prepareConnection(const PeerRegistry::Snapshot &peers, const Endpoint &endpoint)
+{
+	// First, trying to reuse existing connection to this robot or, if we do not know which one it is, any connection
+	// to its IP.
+	Connection *connectionObject = openedConnection(peers, endpoint);
+	if (connectionObject == nullptr) {
+		connectionObject = connection(endpoint.ip);
 	}
 
-	mKnownRobotsLock.unlock();
+	if (connectionObject != nullptr) {
+		return connectionObject;
+	}
 
-	if (targetEndpoint.ip.isNull()) {
-		QLOG_ERROR() << "Trying to connect to unknown robot, IP:" << ip;
-		return nullptr;
+	// Next, waiting for a connection that is being established.
+	const QPointer<Connection> pending = mPendingConnections.value(endpoint);
+	if (!pending.isNull()) {
+		return pending.data();
 	}
 
-	return connect(targetEndpoint.ip, targetEndpoint.port);
+	return connect(endpoint.ip, endpoint.port);
 }
 
 void MailboxServer::onNewConnection(const QHostAddress &ip, int clientPort, int serverPort, int hullNumber)
@@ -227,10 +252,9 @@ void MailboxServer::onNewConnection(const QHostAddress &ip, int clientPort, int
 		return;
 	}
 
-	mKnownRobotsLock.lockForRead();
-	const bool knownRobot = mKnownRobots.contains(hullNumber, {ip, serverPort});
-	const auto endpoints = mKnownRobots.values();
-	mKnownRobotsLock.unlock();
+	const Endpoint endpoint{ip, serverPort};
+	const auto peers = mPeers.snapshot();
+	const bool knownRobot = peers->contains(hullNumber, endpoint);
 
 	if (!knownRobot) {
 		// Propagate information about newly connected robot through robot network.
@@ -247,12 +271,11 @@ void MailboxServer::onNewConnection(const QHostAddress &ip, int clientPort, int
 	// Send known connection information to newly connected robot.
 	const auto connectionObject = connection(ip, clientPort);
 	if (connectionObject != nullptr) {
-		mKnownRobotsLock.lockForRead();
-		for (const auto &endpoint: endpoints) {
+		for (const auto &knownEndpoint : peers->endpoints()) {
 			QMetaObject::invokeMethod(connectionObject, "sendConnectionInfo"
-					, Q_ARG(const QHostAddress &, endpoint.ip)
-					, Q_ARG(int, endpoint.port)
-					, Q_ARG(int, mKnownRobots.key(endpoint))
+					, Q_ARG(const QHostAddress &, knownEndpoint.ip)
+					, Q_ARG(int, knownEndpoint.port)
+					, Q_ARG(int, peers->hullNumber(knownEndpoint))
 					);
 		}
 
@@ -260,23 +283,35 @@ void MailboxServer::onNewConnection(const QHostAddress &ip, int clientPort, int
 		QMetaObject::invokeMethod(connectionObject, "sendSelfInfo"
 				, Q_ARG(int, mHullNumber)
 				);
-
-		mKnownRobotsLock.unlock();
 	} else {
 		QLOG_ERROR() << "Something went wrong, new connection to" << ip << ":" << clientPort << "is dead";
 		return;
 	}
 
 	if (!knownRobot) {
-		mKnownRobotsLock.lockForWrite();
-
-		mKnownRobots.insertMulti(hullNumber, {ip, serverPort});
-		mKnownRobotsLock.unlock();
+		mPeers.insert(hullNumber, endpoint);
 	}
+
+	// Replies to this robot will go through connection it has opened, and data received through it is attributed
+	// to this robot even if there are other robots with the same IP. Link is forgotten when connection is closed,
+	// so the registry does not grow with reconnects.
+	const Endpoint connectionEndpoint{ip, clientPort};
+	mPeers.link(endpoint, connectionEndpoint);
+	QObject::connect(connectionObject, &Connection::disconnected, this, [this, connectionEndpoint]() {
+		mPeers.unlink(connectionEndpoint);
+	});
 }
 
 void MailboxServer::send(int hullNumber, const QString &message)
 {
+	if (hullNumber == -1 && !mMulticast.isNull()) {
+		const QByteArray data = message.toUtf8();
+		if (data.size() <= MulticastTransport::maxMessageSize) {
+			mMulticast->send(mHullNumber, data);
+			return;
+		}
+	}
+
 	forEveryConnection([&message](Connection *connection) {
 		const auto data = QString("data:%1").arg(message).toUtf8();
 		QMetaObject::invokeMethod(connection, "send"
@@ -293,71 +328,37 @@ void MailboxServer::send(const QString &message)
 
 void MailboxServer::onConnectionInfo(const QHostAddress &ip, int port, int hullNumber)
 {
-	QList<Endpoint> toDelete;
-	mKnownRobotsLock.lockForRead();
-	for (const auto &endpoint : mKnownRobots.values()) {
-		if (endpoint == Endpoint{ip, port}) {
-			toDelete << endpoint;
-		}
-	}
-
-	mKnownRobotsLock.unlock();
-
-	mKnownRobotsLock.lockForWrite();
-	for (const auto &endpoint : toDelete) {
-		const auto keys = mKnownRobots.keys(endpoint);
-		for (const auto &key : keys) {
-			mKnownRobots.remove(key, endpoint);
-		}
-	}
-
-	mKnownRobots.insertMulti(hullNumber, {ip, port});
-	mKnownRobotsLock.unlock();
+	mPeers.insert(hullNumber, {ip, port});
 }
 
 void MailboxServer::onNewData(const QHostAddress &ip, int port, const QByteArray &data)
 {
-	QLOG_INFO() << "New data received by a mailbox from " << ip << ":" << port << ", data is:" << data;
-	qDebug() << "New data received by a mailbox from " << ip << ":" << port << ", data is:" << data;
-
-	int senderHullNumber = -1;
-	mKnownRobotsLock.lockForRead();
-	for (const auto &endpoint : mKnownRobots.values()) {
-		if (endpoint.ip == ip) {
-			senderHullNumber = mKnownRobots.key(endpoint);
-		}
-	}
+	QLOG_TRACE() << "New data received by a mailbox from " << ip << ":" << port << ", data is:" << data;
 
-	mKnownRobotsLock.unlock();
+	const int senderHullNumber = mPeers.snapshot()->senderHullNumber({ip, port});
 
 	if (senderHullNumber == -1) {
-		QLOG_INFO() << "Received message from" << ip << ":" << port << "which is unknown at the moment";
-		qDebug() << "Received message from" << ip << ":" << port << "which is unknown at the moment";
+		QLOG_DEBUG() << "Received message from" << ip << ":" << port << "which is unknown at the moment";
 	}
 
-	mMessagesQueueLock.lockForWrite();
-	mMessagesQueue.enqueue(data);
-	mMessagesQueueLock.unlock();
+	deliver(senderHullNumber, data);
+}
 
-	emit newMessage(senderHullNumber, QString(data));
+void MailboxServer::onMulticastData(int senderHullNumber, const QByteArray &data)
+{
+	deliver(senderHullNumber, data);
 }
 
-bool MailboxServer::hasMessages()
+void MailboxServer::deliver(int senderHullNumber, const QByteArray &data)
 {
-	mMessagesQueueLock.lockForRead();
-	const bool result = !mMessagesQueue.isEmpty();
-	mMessagesQueueLock.unlock();
+	mInbox.push(senderHullNumber, data);
 
-	return result;
+	emit newMessage(senderHullNumber, QString(data));
 }
 
-QString MailboxServer::receive()
+MailboxInbox &MailboxServer::inbox()
 {
-	mMessagesQueueLock.lockForWrite();
-	QByteArray const result = !mMessagesQueue.isEmpty() ? mMessagesQueue.dequeue() : QByteArray();
-	mMessagesQueueLock.unlock();
-
-	return QString(result);
+	return mInbox;
 }
 
 void MailboxServer::loadSettings()
@@ -384,12 +385,9 @@ void MailboxServer::saveSettings()
 
 void MailboxServer::forEveryConnection(std::function<void(Connection *)> method, int hullNumber)
 {
-	mKnownRobotsLock.lockForRead();
-	const auto endpoints = hullNumber == -1 ? mKnownRobots.values() : mKnownRobots.values(hullNumber);
-	mKnownRobotsLock.unlock();
-
-	for (const auto &endpoint : endpoints) {
-		const auto connection = prepareConnection(endpoint.ip);
+	const auto peers = mPeers.snapshot();
+	for (const auto &endpoint : peers->endpoints(hullNumber)) {
+		const auto connection = prepareConnection(*peers, endpoint);
 		if (connection == nullptr) {
 			QLOG_ERROR() << "Connection to" << endpoint.ip << ":" << endpoint.port << "is dead at the moment, message"
 					<< "is not delivered. Will try to reestablish connection on next send.";
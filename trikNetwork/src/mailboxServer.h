@@ -15,12 +15,16 @@
 #pragma once
 
 #include <QtCore/QObject>
-#include <QtCore/QMultiHash>
+#include <QtCore/QHash>
+#include <QtCore/QPointer>
 #include <QtCore/QReadWriteLock>
-#include <QtCore/QQueue>
+#include <QtCore/QScopedPointer>
 #include <QtNetwork/QHostAddress>
 
 #include "trikServer.h"
+#include "mailboxInbox.h"
+#include "multicastTransport.h"
+#include "peerRegistry.h"
 
 namespace trikNetwork {
 
@@ -32,6 +36,10 @@ namespace trikNetwork {
 /// hullNumber - hull number of this robot.
 /// server - IP of a robot we last connected to.
 /// serverPort - mailbox port of a robot we last connected to.
+///
+/// Messages to a given hull number are always sent via TCP connections. Broadcasts are sent via TCP connections to
+/// every known robot too, unless multicast transport is enabled, then they are sent once to a multicast group (and
+/// messages too big for a datagram still go via TCP). All robots in a swarm shall use the same transport.
 class MailboxServer : public TrikServer
 {
 	Q_OBJECT
@@ -39,7 +47,8 @@ class MailboxServer : public TrikServer
 public:
 	/// Constructor.
 	/// @param port - a port for mailbox server.
-	MailboxServer(int port);
+	/// @param multicast - settings of multicast transport for broadcasts.
+	explicit MailboxServer(int port, const MulticastSettings &multicast = MulticastSettings());
 
 	/// Returns true if at least one opened mailbox connection presents at the moment.
 	bool isConnected();
@@ -74,11 +83,8 @@ public:
 	/// Sends message to all known robots.
 	Q_INVOKABLE void send(const QString &message);
 
-	/// Returns true if there are incoming messages.
-	Q_INVOKABLE bool hasMessages();
-
-	/// Returns one incoming message or empty string if there are none.
-	Q_INVOKABLE QString receive();
+	/// Returns queue of incoming messages, it is thread-safe.
+	MailboxInbox &inbox();
 
 signals:
 	/// Emitted when new message was received from a robot with given hull number.
@@ -88,8 +94,11 @@ private slots:
 	void onNewConnection(const QHostAddress &ip, int clientPort, int serverPort, int hullNumber);
 	void onConnectionInfo(const QHostAddress &ip, int port, int hullNumber);
 	void onNewData(const QHostAddress &ip, int port, const QByteArray &data);
+	void onMulticastData(int senderHullNumber, const QByteArray &data);
 
 private:
+	typedef PeerRegistry::Endpoint Endpoint;
+
 	Connection *connect(const QHostAddress &ip, int port);
 
 	Connection *connectionFactory();
@@ -98,13 +107,22 @@ private:
 
 	static QHostAddress determineMyIp();
 
-	Connection *prepareConnection(const QHostAddress &ip);
+	/// Returns opened connection to a robot with given mailbox server endpoint, either outgoing one or opened by
+	/// a robot, or nullptr if there is none.
+	Connection *openedConnection(const PeerRegistry::Snapshot &peers, const Endpoint &endpoint) const;
+
+	/// Returns connection to a robot with given mailbox server endpoint, reusing opened or opening connection if
+	/// there is one, or opens new connection.
+	Connection *prepareConnection(const PeerRegistry::Snapshot &peers, const Endpoint &endpoint);
 
 	void loadSettings();
 	void saveSettings();
 
 	void forEveryConnection(std::function<void(Connection *)> method, int hullNumber = -1);
 
+	/// Puts received message into a queue and notifies about it.
+	void deliver(int senderHullNumber, const QByteArray &data);
+
 	int mHullNumber;
 	QHostAddress mMyIp;
 	QHostAddress mSavedIp;
@@ -113,37 +131,21 @@ private:
 	QHostAddress mServerIp;
 	int mServerPort;
 
-	struct Endpoint {
-		QHostAddress ip;
-		int port;
-	};
+	const MulticastSettings mMulticastSettings;
 
-	inline uint qHash(const Endpoint &key)
-	{
-		return ::qHash(key.ip.toString()) ^ key.port;
-	}
+	/// Transport for broadcasts, null if multicast is disabled or failed to start.
+	QScopedPointer<MulticastTransport> mMulticast;
 
-	friend bool operator ==(const MailboxServer::Endpoint &left, const MailboxServer::Endpoint &right);
-	friend inline QDebug operator <<(QDebug dbg, const Endpoint &endpoint);
+	/// Robots known to this mailbox.
+	PeerRegistry mPeers;
 
-	QMultiHash<int, Endpoint> mKnownRobots;
+	/// Outgoing connections which are not opened yet by target endpoint, so messages sent while connection is being
+	/// established do not open more connections. Used only from mailbox server thread.
+	QHash<Endpoint, QPointer<Connection>> mPendingConnections;
 
-	QQueue<QByteArray> mMessagesQueue;
-	QReadWriteLock mMessagesQueueLock;
-	QReadWriteLock mKnownRobotsLock;
+	MailboxInbox mInbox;
 
 	QReadWriteLock mAuxiliaryInformationLock;
 };
 
-inline bool operator ==(const MailboxServer::Endpoint &left, const MailboxServer::Endpoint &right)
-{
-	return left.ip == right.ip && left.port == right.port;
-}
-
-inline QDebug operator <<(QDebug dbg, const MailboxServer::Endpoint &endpoint)
-{
-	dbg.nospace() << endpoint.ip << ":" << endpoint.port;
-	return dbg.space();
-}
-
 }
@@ -0,0 +1,344 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "src/multicastTransport.h"
+
+#include <random>
+
+#include <QtCore/QtEndian>
+#include <QtNetwork/QNetworkInterface>
+#include <QtNetwork/QUdpSocket>
+
+#include <QsLog.h>
+
+using namespace trikNetwork;
+
+static const char magic[] = "TM";
+static const char formatVersion = 1;
+static const char dataType = 0;
+static const char nackType = 1;
+static const int headerSize = 2 + 1 + 1 + 4 + 4 + 4;
+static const int nackSize = headerSize + 4 + 4 + 2;
+
+/// Batch is sent as soon as it reaches this size, so datagrams usually fit into one Ethernet frame.
+static const int batchSize = 1400;
+
+/// Number of sent datagrams kept for retransmission, also maximal number of datagrams waiting for a gap to be filled.
+static const int historySize = 1024;
+
+/// Interval in milliseconds between NACKs for the same gap.
+static const int nackInterval = 20;
+
+/// Time in milliseconds after which a gap is considered unrecoverable and skipped.
+static const int giveUpTime = 500;
+
+template<typename T>
+static void appendLittleEndian(QByteArray &data, T value)
+{
+	uchar buffer[sizeof(T)];
+	qToLittleEndian(value, buffer);
+	data.append(reinterpret_cast<const char *>(buffer), sizeof(T));
+}
+
+static void appendHeader(QByteArray &datagram, char type, quint32 instance, qint32 hullNumber, quint32 sequence)
+{
+	datagram.append(magic, 2);
+	datagram.append(formatVersion);
+	datagram.append(type);
+	appendLittleEndian<quint32>(datagram, instance);
+	appendLittleEndian<qint32>(datagram, hullNumber);
+	appendLittleEndian<quint32>(datagram, sequence);
+}
+
+static const uchar *bytes(const QByteArray &datagram)
+{
+	return reinterpret_cast<const uchar *>(datagram.constData());
+}
+
+MulticastTransport::MulticastTransport(const MulticastSettings &settings)
+	: mSettings(settings)
+	, mInstance(std::random_device()())
+{
+}
+
+MulticastTransport::~MulticastTransport()
+{
+	trikKernel::TimerWheel::instance().stop(mFlushTimer);
+	trikKernel::TimerWheel::instance().stop(mGapTimer);
+}
+
+bool MulticastTransport::start()
+{
+	mSocket.reset(new QUdpSocket());
+	if (!mSocket->bind(QHostAddress::AnyIPv4, mSettings.port
+			, QUdpSocket::ShareAddress | QUdpSocket::ReuseAddressHint))
+	{
+		QLOG_ERROR() << "Can not bind mailbox multicast socket to port" << mSettings.port << ":"
+				<< mSocket->errorString();
+		mSocket.reset();
+		return false;
+	}
+
+	// Other mailboxes on this host shall receive our datagrams, own ones are filtered out by instance id.
+	mSocket->setSocketOption(QAbstractSocket::MulticastLoopbackOption, 1);
+
+	if (mSettings.group.isMulticast()) {
+		const QNetworkInterface networkInterface = QNetworkInterface::interfaceFromName(mSettings.interfaceName);
+		if (networkInterface.isValid()) {
+			mSocket->setMulticastInterface(networkInterface);
+		}
+
+		const bool joined = networkInterface.isValid()
+				? mSocket->joinMulticastGroup(mSettings.group, networkInterface)
+				: mSocket->joinMulticastGroup(mSettings.group);
+
+		if (!joined) {
+			QLOG_ERROR() << "Can not join mailbox multicast group" << mSettings.group << ":" << mSocket->errorString();
+			mSocket.reset();
+			return false;
+		}
+	}
+
+	connect(mSocket.data(), SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+
+	if (mSettings.reliable) {
+		mGapTimer = trikKernel::TimerWheel::instance().startQueued(nackInterval, this, "checkGaps");
+	}
+
+	QLOG_INFO() << "Mailbox multicast transport started on" << mSettings.group << ":" << mSettings.port
+			<< ", instance" << mInstance;
+
+	return true;
+}
+
+void MulticastTransport::send(int senderHullNumber, const QByteArray &message)
+{
+	if (message.size() > maxMessageSize) {
+		QLOG_ERROR() << "Message of" << message.size() << "bytes is too big for mailbox multicast, dropped";
+		return;
+	}
+
+	if (!mBatch.isEmpty() && (mBatchHullNumber != senderHullNumber
+			|| headerSize + mBatch.size() + 2 + message.size() > batchSize))
+	{
+		flush();
+	}
+
+	mBatchHullNumber = senderHullNumber;
+	appendLittleEndian<quint16>(mBatch, static_cast<quint16>(message.size()));
+	mBatch.append(message);
+
+	if (headerSize + mBatch.size() >= batchSize || mSettings.batchDelay <= 0) {
+		flush();
+	} else if (mFlushTimer == 0) {
+		mFlushTimer = trikKernel::TimerWheel::instance().startQueued(mSettings.batchDelay, this, "flush", true);
+	}
+}
+
+int MulticastTransport::lostDatagrams() const
+{
+	return mLostDatagrams.load();
+}
+
+void MulticastTransport::flush()
+{
+	trikKernel::TimerWheel::instance().stop(mFlushTimer);
+	mFlushTimer = 0;
+
+	if (mBatch.isEmpty() || mSocket.isNull()) {
+		return;
+	}
+
+	QByteArray datagram;
+	datagram.reserve(headerSize + mBatch.size());
+	appendHeader(datagram, dataType, mInstance, mBatchHullNumber, mNextSequence);
+	datagram.append(mBatch);
+	mBatch.clear();
+
+	if (mSettings.reliable) {
+		mHistory.insert(mNextSequence, datagram);
+		mHistoryOrder.enqueue(mNextSequence);
+		if (mHistoryOrder.size() > historySize) {
+			mHistory.remove(mHistoryOrder.dequeue());
+		}
+	}
+
+	++mNextSequence;
+	sendDatagram(datagram);
+}
+
+void MulticastTransport::onReadyRead()
+{
+	while (mSocket->hasPendingDatagrams()) {
+		const qint64 size = mSocket->pendingDatagramSize();
+		QByteArray datagram(static_cast<int>(qMax<qint64>(size, 0)), Qt::Uninitialized);
+		if (mSocket->readDatagram(datagram.data(), datagram.size()) != datagram.size()
+				|| datagram.size() < headerSize || !datagram.startsWith(magic) || datagram.at(2) != formatVersion)
+		{
+			continue;
+		}
+
+		const quint32 instance = qFromLittleEndian<quint32>(bytes(datagram) + 4);
+		if (instance == mInstance) {
+			continue;
+		}
+
+		if (datagram.at(3) == dataType) {
+			handleData(instance, qFromLittleEndian<quint32>(bytes(datagram) + 12), datagram);
+		} else if (datagram.at(3) == nackType) {
+			handleNack(datagram);
+		}
+	}
+}
+
+void MulticastTransport::checkGaps()
+{
+	for (auto it = mStreams.begin(); it != mStreams.end(); ++it) {
+		Stream &stream = it.value();
+		if (stream.pending.isEmpty()) {
+			continue;
+		}
+
+		if (stream.gapTimer.elapsed() >= giveUpTime) {
+			skipGap(it.key(), stream);
+		} else if (stream.nackTimer.elapsed() >= nackInterval) {
+			sendNack(it.key(), stream);
+		}
+	}
+}
+
+void MulticastTransport::sendDatagram(const QByteArray &datagram)
+{
+	if (mSocket->writeDatagram(datagram, mSettings.group, static_cast<quint16>(mSettings.port)) == -1) {
+		QLOG_WARN() << "Failed to send mailbox multicast datagram:" << mSocket->errorString();
+	}
+}
+
+void MulticastTransport::handleData(quint32 instance, quint32 sequence, const QByteArray &datagram)
+{
+	auto it = mStreams.find(instance);
+	if (it == mStreams.end()) {
+		// Joining a stream in the middle, earlier datagrams were sent before we started.
+		Stream stream;
+		stream.expected = sequence;
+		it = mStreams.insert(instance, stream);
+	}
+
+	Stream &stream = it.value();
+	const qint32 distance = static_cast<qint32>(sequence - stream.expected);
+	if (distance < 0 || stream.pending.contains(sequence)) {
+		// Duplicate, for example retransmission requested by other receiver.
+		return;
+	}
+
+	if (distance == 0) {
+		deliver(datagram);
+		++stream.expected;
+		drain(stream);
+		if (!stream.pending.isEmpty()) {
+			// There is a next gap.
+			stream.gapTimer.start();
+			sendNack(instance, stream);
+		}
+
+		return;
+	}
+
+	if (!mSettings.reliable) {
+		mLostDatagrams.fetchAndAddRelaxed(distance);
+		QLOG_WARN() << "Mailbox multicast: lost" << distance << "datagrams from instance" << instance;
+		deliver(datagram);
+		stream.expected = sequence + 1;
+		return;
+	}
+
+	const bool newGap = stream.pending.isEmpty();
+	stream.pending.insert(sequence, datagram);
+	if (newGap) {
+		stream.gapTimer.start();
+		sendNack(instance, stream);
+	} else if (stream.pending.size() > historySize) {
+		skipGap(instance, stream);
+	}
+}
+
+void MulticastTransport::handleNack(const QByteArray &datagram)
+{
+	if (datagram.size() < nackSize || qFromLittleEndian<quint32>(bytes(datagram) + headerSize) != mInstance) {
+		return;
+	}
+
+	const quint32 first = qFromLittleEndian<quint32>(bytes(datagram) + headerSize + 4);
+	const int count = qMin<int>(qFromLittleEndian<quint16>(bytes(datagram) + headerSize + 8), historySize);
+	for (int i = 0; i < count; ++i) {
+		const auto it = mHistory.constFind(first + static_cast<quint32>(i));
+		if (it != mHistory.constEnd()) {
+			sendDatagram(it.value());
+		}
+	}
+}
+
+void MulticastTransport::deliver(const QByteArray &datagram)
+{
+	const int senderHullNumber = qFromLittleEndian<qint32>(bytes(datagram) + 8);
+	int position = headerSize;
+	while (position + 2 <= datagram.size()) {
+		const int length = qFromLittleEndian<quint16>(bytes(datagram) + position);
+		position += 2;
+		if (position + length > datagram.size()) {
+			QLOG_ERROR() << "Malformed mailbox multicast datagram from hull number" << senderHullNumber;
+			return;
+		}
+
+		emit newData(senderHullNumber, datagram.mid(position, length));
+		position += length;
+	}
+}
+
+void MulticastTransport::drain(Stream &stream)
+{
+	while (!stream.pending.isEmpty() && stream.pending.firstKey() == stream.expected) {
+		deliver(stream.pending.take(stream.expected));
+		++stream.expected;
+	}
+}
+
+void MulticastTransport::skipGap(quint32 instance, Stream &stream)
+{
+	const quint32 lost = stream.pending.firstKey() - stream.expected;
+	mLostDatagrams.fetchAndAddRelaxed(static_cast<int>(lost));
+	QLOG_WARN() << "Mailbox multicast: lost" << lost << "datagrams from instance" << instance;
+
+	stream.expected = stream.pending.firstKey();
+	drain(stream);
+	if (!stream.pending.isEmpty()) {
+		stream.gapTimer.start();
+		sendNack(instance, stream);
+	}
+}
+
+void MulticastTransport::sendNack(quint32 instance, Stream &stream)
+{
+	const quint32 missing = stream.pending.firstKey() - stream.expected;
+
+	QByteArray datagram;
+	datagram.reserve(nackSize);
+	appendHeader(datagram, nackType, mInstance, -1, 0);
+	appendLittleEndian<quint32>(datagram, instance);
+	appendLittleEndian<quint32>(datagram, stream.expected);
+	appendLittleEndian<quint16>(datagram, static_cast<quint16>(qMin<quint32>(missing, 0xFFFF)));
+
+	stream.nackTimer.start();
+	sendDatagram(datagram);
+}
@@ -0,0 +1,162 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QObject>
+#include <QtCore/QQueue>
+#include <QtCore/QScopedPointer>
+#include <QtNetwork/QHostAddress>
+
+#include <trikKernel/timerWheel.h>
+
+class QUdpSocket;
+
+namespace trikNetwork {
+
+/// Settings of multicast transport, read from "mailbox" section of system config.
+struct MulticastSettings {
+	/// Multicast transport is used for broadcasts if "transport" attribute is "multicast".
+	bool enabled = false;
+
+	/// Multicast group, "multicastGroup" attribute. Broadcast address like 255.255.255.255 also works.
+	QHostAddress group = QHostAddress("239.255.77.77");
+
+	/// UDP port, "multicastPort" attribute. All robots in a group shall use the same port.
+	int port = 8890;
+
+	/// Name of network interface, "multicastInterface" attribute. Empty for default interface, "lo" allows to run
+	/// several mailboxes on one computer.
+	QString interfaceName;
+
+	/// If true, lost datagrams are requested again with NACKs, "reliable" attribute.
+	bool reliable = true;
+
+	/// Time in milliseconds during which messages are collected into one datagram, "batchDelay" attribute.
+	int batchDelay = 2;
+};
+
+/// Transport for mailbox broadcasts: messages are batched into UDP datagrams and sent to a multicast group, so
+/// broadcast cost does not depend on the number of robots and does not need TCP connection to each of them.
+///
+/// Every datagram has a sequence number in a stream of its sender. Receivers deliver messages of a stream in order,
+/// detect gaps and, if reliability is enabled, ask a sender to retransmit missing datagrams by NACK sent to the
+/// group. Sender keeps a history of last datagrams for retransmission; if a datagram can not be recovered in time,
+/// receiver skips it and reports loss in a log.
+///
+/// Datagram format (all integers are little-endian):
+///     2 bytes   - magic "TM"
+///     1 byte    - format version, currently 1
+///     1 byte    - type, 0 for data, 1 for NACK
+///     4 bytes   - instance id of a sender, random for every mailbox, so several mailboxes may share a host and a port
+///     4 bytes   - hull number of a sender
+///     4 bytes   - sequence number of a datagram (for NACK it is ignored)
+///     then for data, messages, each is 2 bytes of length and UTF-8 bytes of a message;
+///     for NACK, 4 bytes of instance id of a stream, 4 bytes of first missing sequence number and 2 bytes of count.
+class MulticastTransport : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Maximal size of a message that can be sent by this transport, bigger ones shall be sent by TCP.
+	static const int maxMessageSize = 60000;
+
+	/// Constructor.
+	explicit MulticastTransport(const MulticastSettings &settings);
+
+	~MulticastTransport() override;
+
+	/// Binds socket and joins multicast group, shall be called in a thread where transport will live. Returns false
+	/// if socket can not be bound, then transport can not be used.
+	bool start();
+
+	/// Queues message for broadcast. It will be sent with other messages queued during batch delay.
+	void send(int senderHullNumber, const QByteArray &message);
+
+	/// Number of datagrams that were lost and could not be recovered since start. Thread-safe.
+	int lostDatagrams() const;
+
+signals:
+	/// Emitted when a message from other mailbox is received.
+	void newData(int senderHullNumber, const QByteArray &data);
+
+private slots:
+	void onReadyRead();
+
+	/// Sends queued messages as one datagram.
+	void flush();
+
+	/// Resends NACKs for gaps that are still open and gives up on old ones.
+	void checkGaps();
+
+private:
+	/// Receiving side state of a stream of one sender.
+	struct Stream {
+		/// Sequence number of the next datagram to be delivered.
+		quint32 expected = 0;
+
+		/// Datagrams received ahead of a gap, by sequence number.
+		QMap<quint32, QByteArray> pending;
+
+		/// Time since the oldest gap is open.
+		QElapsedTimer gapTimer;
+
+		/// Time since last NACK for this stream.
+		QElapsedTimer nackTimer;
+	};
+
+	void sendDatagram(const QByteArray &datagram);
+	void handleData(quint32 instance, quint32 sequence, const QByteArray &datagram);
+	void handleNack(const QByteArray &datagram);
+
+	/// Delivers messages of a datagram.
+	void deliver(const QByteArray &datagram);
+
+	/// Delivers datagrams that are next in a stream.
+	void drain(Stream &stream);
+
+	/// Gives up on datagrams in current gap of a stream and delivers datagrams after it.
+	void skipGap(quint32 instance, Stream &stream);
+
+	/// Asks sender of a stream for datagrams in current gap.
+	void sendNack(quint32 instance, Stream &stream);
+
+	const MulticastSettings mSettings;
+	QScopedPointer<QUdpSocket> mSocket;
+
+	/// Random id of this mailbox, distinguishes its datagrams from datagrams of other mailboxes on the same host.
+	const quint32 mInstance;
+
+	/// Sending side state.
+	quint32 mNextSequence = 0;
+	QByteArray mBatch;
+	int mBatchHullNumber = -1;
+	trikKernel::TimerWheel::TimerId mFlushTimer = 0;
+
+	/// Last sent datagrams by sequence number, kept for retransmission.
+	QHash<quint32, QByteArray> mHistory;
+	QQueue<quint32> mHistoryOrder;
+
+	/// Receiving side state by sender instance id.
+	QHash<quint32, Stream> mStreams;
+	trikKernel::TimerWheel::TimerId mGapTimer = 0;
+	QAtomicInt mLostDatagrams;
+};
+
+}
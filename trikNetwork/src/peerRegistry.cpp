@@ -0,0 +1,164 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "src/peerRegistry.h"
+
+using namespace trikNetwork;
+
+bool PeerRegistry::Snapshot::contains(int hullNumber, const Endpoint &endpoint) const
+{
+	const auto it = mHullNumbers.constFind(endpoint);
+	return it != mHullNumbers.constEnd() && it.value() == hullNumber;
+}
+
+int PeerRegistry::Snapshot::hullNumber(const Endpoint &endpoint) const
+{
+	return mHullNumbers.value(endpoint, -1);
+}
+
+int PeerRegistry::Snapshot::senderHullNumber(const Endpoint &connection) const
+{
+	const auto sender = mSenders.constFind(connection);
+	if (sender != mSenders.constEnd()) {
+		const int result = hullNumber(sender.value());
+		if (result != -1) {
+			return result;
+		}
+	}
+
+	const int result = hullNumber(connection);
+	if (result != -1) {
+		return result;
+	}
+
+	const auto address = mAddresses.constFind(connection.ip);
+	return address != mAddresses.constEnd() ? hullNumber(address.value()) : -1;
+}
+
+PeerRegistry::Endpoint PeerRegistry::Snapshot::endpoint(const QHostAddress &ip) const
+{
+	return mAddresses.value(ip, Endpoint{QHostAddress(), 0});
+}
+
+PeerRegistry::Endpoint PeerRegistry::Snapshot::route(const Endpoint &endpoint) const
+{
+	return mRoutes.value(endpoint, Endpoint{QHostAddress(), 0});
+}
+
+QList<PeerRegistry::Endpoint> PeerRegistry::Snapshot::endpoints(int hullNumber) const
+{
+	return hullNumber == -1 ? mHullNumbers.keys() : mEndpoints.values(hullNumber);
+}
+
+void PeerRegistry::Snapshot::insert(int hullNumber, const Endpoint &endpoint)
+{
+	remove(endpoint);
+	mEndpoints.insert(hullNumber, endpoint);
+	mHullNumbers.insert(endpoint, hullNumber);
+	mAddresses.insert(endpoint.ip, endpoint);
+}
+
+void PeerRegistry::Snapshot::remove(const Endpoint &endpoint)
+{
+	const auto it = mHullNumbers.find(endpoint);
+	if (it == mHullNumbers.end()) {
+		return;
+	}
+
+	mEndpoints.remove(it.value(), endpoint);
+	mAddresses.remove(endpoint.ip, endpoint);
+	mHullNumbers.erase(it);
+}
+
+void PeerRegistry::Snapshot::link(const Endpoint &endpoint, const Endpoint &connection)
+{
+	const auto oldRoute = mRoutes.constFind(endpoint);
+	if (oldRoute != mRoutes.constEnd()) {
+		mSenders.remove(oldRoute.value());
+	}
+
+	// Connection could have been linked to other endpoint of the same robot before.
+	unlink(connection);
+	mRoutes.insert(endpoint, connection);
+	mSenders.insert(connection, endpoint);
+}
+
+void PeerRegistry::Snapshot::unlink(const Endpoint &connection)
+{
+	const auto sender = mSenders.find(connection);
+	if (sender == mSenders.end()) {
+		return;
+	}
+
+	const auto route = mRoutes.find(sender.value());
+	if (route != mRoutes.end() && route.value() == connection) {
+		mRoutes.erase(route);
+	}
+
+	mSenders.erase(sender);
+}
+
+PeerRegistry::PeerRegistry()
+	: mSnapshot(std::make_shared<const Snapshot>())
+{
+}
+
+std::shared_ptr<const PeerRegistry::Snapshot> PeerRegistry::snapshot() const
+{
+	return std::atomic_load(&mSnapshot);
+}
+
+bool PeerRegistry::insert(int hullNumber, const Endpoint &endpoint)
+{
+	bool inserted = false;
+	update([&](Snapshot &snapshot) {
+		inserted = !snapshot.contains(hullNumber, endpoint);
+		if (inserted) {
+			snapshot.insert(hullNumber, endpoint);
+		}
+	});
+
+	return inserted;
+}
+
+void PeerRegistry::link(const Endpoint &endpoint, const Endpoint &connection)
+{
+	update([&](Snapshot &snapshot) {
+		snapshot.link(endpoint, connection);
+	});
+}
+
+void PeerRegistry::unlink(const Endpoint &connection)
+{
+	if (!snapshot()->mSenders.contains(connection)) {
+		// Most closed connections were never linked, snapshot is not copied for them.
+		return;
+	}
+
+	update([&](Snapshot &snapshot) {
+		snapshot.unlink(connection);
+	});
+}
+
+template<typename Change>
+void PeerRegistry::update(const Change &change)
+{
+	QMutexLocker writeLocker(&mWriteLock);
+
+	// Containers are implicitly shared, so copy is cheap and only changed containers are detached.
+	const auto copy = std::make_shared<Snapshot>(*snapshot());
+	change(*copy);
+
+	std::atomic_store(&mSnapshot, std::shared_ptr<const Snapshot>(copy));
+}
@@ -0,0 +1,135 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <memory>
+
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QMultiHash>
+#include <QtCore/QMutex>
+#include <QtNetwork/QHostAddress>
+
+namespace trikNetwork {
+
+/// Table of robots known to a mailbox, indexed by hull number, by mailbox server endpoint, by IP and by endpoint of a
+/// connection through which a robot talks to us. Lookups are read-mostly and happen for every message, changes happen
+/// only when robots join or change hull numbers, so the table is published as immutable snapshots: readers take
+/// current snapshot and use it without any locks, writers copy it, modify the copy and publish it instead of old one.
+/// Snapshot pointer itself is read and replaced by atomic operations, so readers never wait for writers.
+class PeerRegistry
+{
+public:
+	/// Network address of a robot or of one of its connections.
+	struct Endpoint {
+		QHostAddress ip;
+		int port;
+	};
+
+	/// Immutable state of a registry.
+	class Snapshot
+	{
+	public:
+		/// Returns true if a robot with given mailbox server endpoint has given hull number.
+		bool contains(int hullNumber, const Endpoint &endpoint) const;
+
+		/// Returns hull number of a robot with given mailbox server endpoint, or -1 if it is unknown.
+		int hullNumber(const Endpoint &endpoint) const;
+
+		/// Returns hull number of a robot that sent data through a connection with given peer endpoint. Connections
+		/// which are known to belong to a robot are checked first, then any robot with the same IP is taken.
+		/// Returns -1 if sender is unknown.
+		int senderHullNumber(const Endpoint &connection) const;
+
+		/// Returns mailbox server endpoint of some robot with given IP, or endpoint with null IP if there are none.
+		Endpoint endpoint(const QHostAddress &ip) const;
+
+		/// Returns peer endpoint of a connection opened by a robot with given mailbox server endpoint, or endpoint
+		/// with null IP if robot did not connect to us.
+		Endpoint route(const Endpoint &endpoint) const;
+
+		/// Returns mailbox server endpoints of robots with given hull number, or of all robots if hull number is -1.
+		QList<Endpoint> endpoints(int hullNumber = -1) const;
+
+	private:
+		friend class PeerRegistry;
+
+		void insert(int hullNumber, const Endpoint &endpoint);
+		void remove(const Endpoint &endpoint);
+		void link(const Endpoint &endpoint, const Endpoint &connection);
+		void unlink(const Endpoint &connection);
+
+		/// Mailbox server endpoints of robots by their hull numbers.
+		QMultiHash<int, Endpoint> mEndpoints;
+
+		/// Hull numbers of robots by their mailbox server endpoints.
+		QHash<Endpoint, int> mHullNumbers;
+
+		/// Mailbox server endpoints of robots by their IPs.
+		QMultiHash<QHostAddress, Endpoint> mAddresses;
+
+		/// Peer endpoints of incoming connections by mailbox server endpoints of robots that opened them.
+		QHash<Endpoint, Endpoint> mRoutes;
+
+		/// Mailbox server endpoints of robots by peer endpoints of incoming connections they opened.
+		QHash<Endpoint, Endpoint> mSenders;
+	};
+
+	PeerRegistry();
+
+	/// Returns current state of a registry. It is not affected by later changes. Thread-safe and does not block.
+	std::shared_ptr<const Snapshot> snapshot() const;
+
+	/// Adds a robot with given hull number, a robot that had other hull number is moved to a new one. Thread-safe.
+	/// Returns false if a robot was already known with this hull number.
+	bool insert(int hullNumber, const Endpoint &endpoint);
+
+	/// Remembers that a robot with given mailbox server endpoint talks to us through a connection with given peer
+	/// endpoint. Thread-safe.
+	void link(const Endpoint &endpoint, const Endpoint &connection);
+
+	/// Forgets a connection with given peer endpoint when it is closed, robot that opened it stays known. Thread-safe.
+	void unlink(const Endpoint &connection);
+
+private:
+	/// Copies current snapshot, applies a change to a copy and publishes it.
+	template<typename Change>
+	void update(const Change &change);
+
+	/// Current snapshot. Shall be accessed only through std::atomic_load() and std::atomic_store().
+	std::shared_ptr<const Snapshot> mSnapshot;
+
+	/// Serializes writers, so no change is lost.
+	QMutex mWriteLock;
+};
+
+inline bool operator ==(const PeerRegistry::Endpoint &left, const PeerRegistry::Endpoint &right)
+{
+	return left.ip == right.ip && left.port == right.port;
+}
+
+inline uint qHash(const PeerRegistry::Endpoint &key, uint seed = 0)
+{
+	return qHash(key.ip, seed) ^ static_cast<uint>(key.port);
+}
+
+inline QDebug operator <<(QDebug dbg, const PeerRegistry::Endpoint &endpoint)
+{
+	dbg.nospace() << endpoint.ip << ":" << endpoint.port;
+	return dbg.space();
+}
+
+}
@@ -22,22 +22,40 @@
 
 using namespace trikNetwork;
 
-TrikServer::TrikServer(const std::function<Connection *()> &connectionFactory)
-	: mConnectionFactory(connectionFactory)
+TrikServer::TrikServer(const std::function<Connection *()> &connectionFactory, int ioThreads)
+	: mMaxThreads(ioThreads > 0 ? ioThreads : qMax(QThread::idealThreadCount(), 1))
+	, mConnectionFactory(connectionFactory)
 {
 }
 
 TrikServer::~TrikServer()
 {
-	for (QThread *thread : mConnections.keys()) {
+	closeConnections();
+}
+
+void TrikServer::closeConnections()
+{
+	close();
+
+	for (QThread * const thread : mThreads) {
 		thread->quit();
 		if (!thread->wait(1000)) {
 			QLOG_ERROR() << "Unable to stop thread" << thread;
 		}
 	}
 
-	qDeleteAll(mConnections);
-	qDeleteAll(mConnections.keys());
+	mConnectionsLock.lockForWrite();
+	const QSet<Connection *> connections = mConnections;
+	mConnections.clear();
+	mEndpoints.clear();
+	mAddresses.clear();
+	mIndexedEndpoints.clear();
+	mConnectionsLock.unlock();
+
+	qDeleteAll(connections);
+	qDeleteAll(mThreads);
+	mThreads.clear();
+	mNextThread = 0;
 }
 
 void TrikServer::startServer(const int &port)
@@ -52,16 +70,25 @@ void TrikServer::startServer(const int &port)
 
 void TrikServer::sendMessage(const QString &message)
 {
-	for (Connection * const connection : mConnections.values()) {
-		QMetaObject::invokeMethod(connection, "send", Q_ARG(QByteArray, message.toUtf8()));
+	const QByteArray data = message.toUtf8();
+	QReadLocker locker(&mConnectionsLock);
+	for (Connection * const connection : mConnections) {
+		QMetaObject::invokeMethod(connection, "send", Q_ARG(QByteArray, data));
 	}
 }
 
 int TrikServer::activeConnections() const
 {
+	QReadLocker locker(&mConnectionsLock);
 	return mConnections.size();
 }
 
+int TrikServer::ioThreads() const
+{
+	QReadLocker locker(&mConnectionsLock);
+	return mThreads.size();
+}
+
 void TrikServer::incomingConnection(qintptr socketDescriptor)
 {
 	QLOG_INFO() << "New connection, socket descriptor: " << socketDescriptor;
@@ -74,17 +101,14 @@ void TrikServer::incomingConnection(qintptr socketDescriptor)
 
 void TrikServer::startConnection(Connection * const connectionWorker)
 {
-	QThread * const connectionThread = new QThread();
-
-	connect(connectionThread, SIGNAL(finished()), connectionThread, SLOT(deleteLater()));
+	connect(connectionWorker, SIGNAL(connected(Connection*)), this, SLOT(onConnectionOpened(Connection *)));
 	connect(connectionWorker, SIGNAL(disconnected(Connection*)), this, SLOT(onConnectionClosed(Connection *)));
 
-	connectionWorker->moveToThread(connectionThread);
-
+	mConnectionsLock.lockForWrite();
+	connectionWorker->moveToThread(nextThread());
 	const bool firstConnection = mConnections.isEmpty();
-	mConnections.insert(connectionThread, connectionWorker);
-
-	connectionThread->start();
+	mConnections.insert(connectionWorker);
+	mConnectionsLock.unlock();
 
 	if (firstConnection) {
 		/// @todo: Emit "connected" signal only when socket is actually connected.
@@ -92,43 +116,67 @@ void TrikServer::startConnection(Connection * const connectionWorker)
 	}
 }
 
-Connection *TrikServer::connection(const QHostAddress &ip, int port) const
+QThread *TrikServer::nextThread()
 {
-	for (auto *connection : mConnections.values()) {
-		if (connection->peerAddress() == ip && connection->peerPort() == port) {
-			return connection;
-		}
+	if (mThreads.size() < mMaxThreads) {
+		QThread * const thread = new QThread();
+		thread->setObjectName(QString("%1 I/O %2").arg(objectName()).arg(mThreads.size()));
+		thread->start();
+		mThreads.append(thread);
+		return thread;
 	}
 
-	return nullptr;
+	QThread * const thread = mThreads[mNextThread];
+	mNextThread = (mNextThread + 1) % mThreads.size();
+	return thread;
+}
+
+Connection *TrikServer::connection(const QHostAddress &ip, int port) const
+{
+	QReadLocker locker(&mConnectionsLock);
+	return mEndpoints.value({ip, port}, nullptr);
 }
 
 Connection *TrikServer::connection(const QHostAddress &ip) const
 {
-	for (auto *connection : mConnections.values()) {
-		if (connection->peerAddress() == ip) {
-			return connection;
-		}
+	QReadLocker locker(&mConnectionsLock);
+	return mAddresses.value(ip, nullptr);
+}
+
+void TrikServer::onConnectionOpened(Connection *connection)
+{
+	QWriteLocker locker(&mConnectionsLock);
+
+	// Connection may be already closed, then it shall not get into index.
+	if (!mConnections.contains(connection) || mIndexedEndpoints.contains(connection)) {
+		return;
 	}
 
-	return nullptr;
+	const Endpoint endpoint(connection->peerAddress(), connection->peerPort());
+	mEndpoints.insert(endpoint, connection);
+	mAddresses.insert(endpoint.first, connection);
+	mIndexedEndpoints.insert(connection, endpoint);
 }
 
 void TrikServer::onConnectionClosed(Connection *connection)
 {
-	QThread * const thread = mConnections.key(connection);
+	mConnectionsLock.lockForWrite();
+	if (mIndexedEndpoints.contains(connection)) {
+		const Endpoint endpoint = mIndexedEndpoints.take(connection);
+		if (mEndpoints.value(endpoint) == connection) {
+			mEndpoints.remove(endpoint);
+		}
 
-	// Thread shall already be finished here.
-	if (thread->isRunning()) {
-		QLOG_ERROR() << "Thread shall already be finished here" << thread;
-		thread->wait();
+		mAddresses.remove(endpoint.first, connection);
 	}
 
-	connection->deleteLater();
+	mConnections.remove(connection);
+	const bool lastConnection = mConnections.isEmpty();
+	mConnectionsLock.unlock();
 
-	mConnections.remove(thread);
+	connection->deleteLater();
 
-	if (mConnections.isEmpty()) {
+	if (lastConnection) {
 		emit disconnected();
 	}
 }
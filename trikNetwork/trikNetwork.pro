@@ -26,14 +26,20 @@ PUBLIC_HEADERS += \
 HEADERS += \
 	$$PWD/src/mailbox.h \
 	$$PWD/src/mailboxConnection.h \
+	$$PWD/src/mailboxInbox.h \
 	$$PWD/src/mailboxServer.h \
+	$$PWD/src/multicastTransport.h \
+	$$PWD/src/peerRegistry.h \
 
 SOURCES += \
 	$$PWD/src/connection.cpp \
 	$$PWD/src/mailbox.cpp \
 	$$PWD/src/mailboxConnection.cpp \
 	$$PWD/src/mailboxFactory.cpp \
+	$$PWD/src/mailboxInbox.cpp \
 	$$PWD/src/mailboxServer.cpp \
+	$$PWD/src/multicastTransport.cpp \
+	$$PWD/src/peerRegistry.cpp \
 	$$PWD/src/trikServer.cpp \
 
 INCLUDEPATH += $$PWD/include \
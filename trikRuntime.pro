@@ -35,7 +35,13 @@ initvars.file = $$PWD/initvars.pre
 
 tests {
 	SUBDIRS *= tests
-	tests.depends = trikScriptRunner trikCommunicator trikKernel
+	tests.depends = trikScriptRunner trikCommunicator trikTelemetry trikKernel
+}
+
+# Build with CONFIG+=benchmarks, run "benchmarks -o results.json" from a directory with binaries.
+benchmarks {
+	SUBDIRS *= benchmarks
+	benchmarks.depends = trikScriptRunner trikNetwork trikControl trikHal trikKernel qslog
 }
 
 qslog.file = qslog/QsLogSharedLibrary.pro
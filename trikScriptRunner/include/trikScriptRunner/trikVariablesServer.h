@@ -14,12 +14,24 @@
 
 #pragma once
 
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QJsonObject>
 #include <QtCore/QObject>
 #include <QtNetwork/QTcpServer>
 
+class QTcpSocket;
+
 namespace trikScriptRunner {
 
-/// Class for script variables observing, based on HTTP server
+/// Class for script variables observing, based on HTTP server. Serves any number of clients, keeps connections
+/// alive if client asks for it, and supports requests:
+/// - GET /web/ --- JSON object with values of all properties of "web" object of a script.
+/// - GET /web/stream?rate=<Hz> --- stream of server-sent events ("text/event-stream"), the first event contains
+///   all variables, next ones only variables changed since previous event (removed ones have null value). Events are
+///   sent at most given number of times per second (10 by default), and only if something changed.
+/// Snapshots of variables are taken asynchronously by a script thread between statements, server never waits for
+/// them and answers all clients that asked for variables at the same time with one snapshot.
 class TrikVariablesServer : public QObject
 {
 	Q_OBJECT
@@ -27,26 +39,87 @@ public:
 	/// Constructor
 	TrikVariablesServer();
 
+	~TrikVariablesServer() override;
+
 signals:
-	/// Emitted when there is a new connection with a HTTP-request of variables values
+	/// Emitted when a snapshot of variables values is needed, onVariablesReady() shall be called in response.
 	/// @param propertyName - name of variables prefix, i.e prefix "web" for variable "web.light"
 	void getVariables(const QString &propertyName);
 
 public slots:
-	/// Sends HTTP response with JSON data about variables
+	/// Receives a snapshot of variables, answers waiting clients and sends changes to streaming clients.
 	/// @param json - JSON container for variables values
-	void sendHTTPResponse(const QJsonObject &json);
+	void onVariablesReady(const QJsonObject &json);
 
 private slots:
 	/// Appends new connection for handling it
 	void onNewConnection();
 
-	/// Process incoming HTTP request which was sent through current connection
-	void processHTTPRequest();
+	/// Process incoming HTTP requests of a connection.
+	void onReadyRead();
+
+	void onDisconnected();
+
+	/// Asks script for a snapshot, if it was not asked already.
+	void requestSnapshot();
+
+	/// Answers waiting clients with the last snapshot if script does not respond (for example, it is not running).
+	void onSnapshotTimeout();
 
 private:
+	/// State of one client connection.
+	struct Client {
+		/// Received data that is not processed yet.
+		QByteArray buffer;
+
+		/// Connection shall be kept open after response.
+		bool keepAlive = false;
+
+		/// Client waits for a snapshot.
+		bool waiting = false;
+
+		/// Interval between events in milliseconds for streaming clients, 0 for others.
+		int streamInterval = 0;
+
+		/// Time since last event.
+		QElapsedTimer lastEvent;
+
+		/// Variables as they were sent to a streaming client.
+		QJsonObject sent;
+	};
+
+	/// Handles one request, returns false if connection shall be closed.
+	bool processRequest(QTcpSocket &socket, Client &client, const QByteArray &request);
+
+	void sendResponse(QTcpSocket &socket, const Client &client, const QByteArray &status, const QByteArray &body);
+
+	/// Sends streaming event with changes, if there are any.
+	void sendEvent(QTcpSocket &socket, Client &client);
+
+	/// Answers all waiting clients with current snapshot.
+	void answerWaitingClients();
+
+	/// Starts, restarts or stops periodic snapshot requests according to rates of streaming clients.
+	void updateSampling();
+
+	/// Returns variables changed in "to" comparing with "from", removed ones have null value.
+	static QJsonObject diff(const QJsonObject &from, const QJsonObject &to);
+
 	QScopedPointer<QTcpServer> mTcpServer;
-	QTcpSocket *mCurrentConnection; // Has ownership in QTcpServer
+
+	/// Connections and their states. Sockets are owned by QTcpServer and deleted when disconnected.
+	QHash<QTcpSocket *, Client> mClients;
+
+	/// Last received snapshot of variables.
+	QJsonObject mSnapshot;
+
+	/// Snapshot was requested and not received yet.
+	bool mSnapshotRequested = false;
+
+	/// Ids of timers in trikKernel::TimerWheel.
+	quint64 mSamplingTimer = 0;
+	quint64 mTimeoutTimer = 0;
+	int mSamplingInterval = 0;
 
 	constexpr static int port = 10000;
 };
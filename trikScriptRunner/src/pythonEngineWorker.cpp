@@ -18,9 +18,16 @@
 #include <trikKernel/paths.h>
 
 #include "pythonEngineWorker.h"
+#include "pythonVectorBuffer.h"
 
 using namespace trikScriptRunner;
 
+/// Time given to a script to react on abortScript() before it is interrupted, in milliseconds.
+static const int interruptTimeout = 100;
+
+/// Time given to script threads to finish when script module is released, in milliseconds.
+static const int threadsJoinTimeout = 500;
+
 PythonEngineWorker::PythonEngineWorker(trikControl::BrickInterface &brick
 		, trikNetwork::MailboxInterface * const mailbox
 		)
@@ -29,22 +36,64 @@ PythonEngineWorker::PythonEngineWorker(trikControl::BrickInterface &brick
 	, mState(ready)
 {}
 
+PythonEngineWorker::~PythonEngineWorker()
+{
+	trikKernel::TimerWheel::instance().stop(mInterruptTimer);
+}
+
 void PythonEngineWorker::init()
 {
+	// Slot calls release the GIL and callbacks from Qt take it back, so script threads run while other threads are
+	// blocked in device calls (camera, mailbox, sensors waiting).
+	PythonQt::setEnableThreadSupport(true);
+
 	// init PythonQt
 	PythonQt::init(PythonQt::IgnoreSiteModule | PythonQt::RedirectStdOut);
 	connect(PythonQt::self(), SIGNAL(pythonStdErr(const QString &)), this, SLOT(updateErrorMessage(const QString &)));
+
+	// sys.exit() shall finish a script, not the whole runtime.
+	PythonQt::self()->setSystemExitExceptionHandlerEnabled(true);
+	connect(PythonQt::self(), SIGNAL(systemExitExceptionRaised(int)), this, SLOT(onScriptRequestingToQuit()));
 	PythonQt_QtAll::init();
 	mMainContext = PythonQt::self()->getMainModule();
 
-	initTrik();
+	// Wrappers are registered only once, script modules use them through the shared interpreter.
+	PythonQt_init_PyTrikControl(mMainContext);
+	PythonVectorBuffer::registerConverters();
+
+	newContext();
+}
+
+void PythonEngineWorker::newContext()
+{
+	releaseContext();
+
+	// Drop interruption that may be left from a script that has finished before it was delivered.
+	if (PyErr_CheckSignals() != 0) {
+		PyErr_Clear();
+	}
+
+	PythonQt::self()->clearError();
+
+	mScriptContextName = QString("trikScript%1").arg(mContextsCreated++);
+	mScriptContext = PythonQt::self()->createModuleFromScript(mScriptContextName);
+	mScriptContext.addObject("brick", &mBrick);
+
+	evalSystemPy();
 }
 
-void PythonEngineWorker::recreateContext()
+void PythonEngineWorker::releaseContext()
 {
-	mMainContext.evalScript("script.kill()");
+	if (mScriptContext.isNull()) {
+		return;
+	}
 
-	initTrik();
+	mScriptContext.evalScript(QString("script.kill()\nscript.joinAll(%1)").arg(threadsJoinTimeout));
+
+	// Script objects (timers, event loops, user callbacks) reference module dictionary, so clear it explicitly.
+	PyDict_Clear(PyModule_GetDict(mScriptContext));
+	mMainContext.evalScript(QString("import sys\nsys.modules.pop('%1', None)").arg(mScriptContextName));
+	mScriptContext = nullptr;
 }
 
 void PythonEngineWorker::evalSystemPy()
@@ -52,20 +101,12 @@ void PythonEngineWorker::evalSystemPy()
 	const QString systemPyPath = trikKernel::Paths::systemScriptsPath() + "system.py";
 
 	if (QFile::exists(systemPyPath)) {
-		mMainContext.evalFile(systemPyPath);
+		mScriptContext.evalFile(systemPyPath);
 	} else {
 		QLOG_ERROR() << "system.py not found, path:" << systemPyPath;
 	}
 }
 
-void PythonEngineWorker::initTrik()
-{
-	PythonQt_init_PyTrikControl(mMainContext);
-	mMainContext.addObject("brick", &mBrick);
-
-	evalSystemPy();
-}
-
 void PythonEngineWorker::resetBrick()
 {
 	QLOG_INFO() << "Stopping robot";
@@ -105,15 +146,35 @@ void PythonEngineWorker::stopScript()
 		mMailbox->stopWaiting();
 	}
 
-	QMetaObject::invokeMethod(this, "recreateContext"); /// recreates python module, which we use
+	mAbortRequested = 1;
+	mAbortDelivered = 0;
+	QMetaObject::invokeMethod(this, "abortScript");
+	// Interruption is done from a timer thread, since a script busy in Python code does not process events.
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	wheel.stop(mInterruptTimer);
+	mInterruptTimer = wheel.start(interruptTimeout, [this]() { interruptScript(); }, true);
 
 	mState = ready;
 
-	/// @todo: is it actually stopped?
-
 	QLOG_INFO() << "PythonEngineWorker: stopping complete";
 }
 
+void PythonEngineWorker::abortScript()
+{
+	mAbortDelivered = 1;
+	if (!mScriptContext.isNull()) {
+		mScriptContext.evalScript("script.kill()");
+	}
+}
+
+void PythonEngineWorker::interruptScript()
+{
+	if (mAbortRequested && !mAbortDelivered) {
+		QLOG_INFO() << "PythonEngineWorker: script does not respond to stop request, interrupting";
+		PyErr_SetInterrupt();
+	}
+}
+
 void PythonEngineWorker::run(const QString &script)
 {
 	QMutexLocker locker(&mScriptStateMutex);
@@ -125,19 +186,29 @@ void PythonEngineWorker::run(const QString &script)
 void PythonEngineWorker::doRun(const QString &script)
 {
 	mErrorMessage.clear();
+	mAbortRequested = 0;
+	newContext();
+
 	/// When starting script execution (by any means), clear button states.
 	mBrick.keys()->reset();
 
-	mMainContext.evalScript(script);
+	// Previous script was stopped with mailbox->stopWaiting(), new one shall be able to wait for messages.
+	if (mMailbox) {
+		mMailbox->resumeWaiting();
+	}
 
 	mState = running;
+	mScriptContext.evalScript(script);
+
 	QLOG_INFO() << "PythonEngineWorker: evaluation ended";
 
-	if (PythonQt::self()->hadError()) {
+	if (PythonQt::self()->hadError() && !mAbortRequested) {
 		emit completed(mErrorMessage, 0);
 	} else {
 		emit completed("", 0);
 	}
+
+	mAbortRequested = 0;
 }
 
 void PythonEngineWorker::runDirect(const QString &command)
@@ -148,12 +219,13 @@ void PythonEngineWorker::runDirect(const QString &command)
 
 void PythonEngineWorker::doRunDirect(const QString &command)
 {
+	// Direct commands share a namespace like an interactive interpreter does, so an error does not reset it.
 	if (PythonQt::self()->hadError()) {
 		PythonQt::self()->clearError();
 		mErrorMessage.clear();
-		recreateContext();
 	}
-	mMainContext.evalScript(command);
+
+	mScriptContext.evalScript(command);
 }
 
 void PythonEngineWorker::updateErrorMessage(const QString &err)
@@ -163,5 +235,5 @@ void PythonEngineWorker::updateErrorMessage(const QString &err)
 
 void PythonEngineWorker::onScriptRequestingToQuit()
 {
-	throw "Not implemented";
+	stopScript();
 }
@@ -15,10 +15,12 @@
 #pragma once
 
 #include <QtCore/QString>
+#include <QtCore/QAtomicInt>
 #include <QtCore/QThread>
 #include <QMutex>
 
 #include <trikControl/brickInterface.h>
+#include <trikKernel/timerWheel.h>
 #include <trikNetwork/mailboxInterface.h>
 
 #include "PythonQt_QtAll.h"
@@ -42,6 +44,8 @@ public:
 			, trikNetwork::MailboxInterface * const mailbox
 			);
 
+	~PythonEngineWorker() override;
+
 	/// Clears execution state and stops robot.
 	/// Can be safely called from other threads.
 	void resetBrick();
@@ -77,24 +81,26 @@ public slots:
 	/// Can be safely called from other threads.
 	void runDirect(const QString &command);
 
-	/// Initializes PythonQt and creates new main module, which will be used by user
+	/// Initializes PythonQt and registers trikControl wrappers. It is done once per worker, scripts are then run in
+	/// fresh module namespaces of the same interpreter (see newContext()).
 	/// Must be invoked (called by the same thread as `run` or `runDirect`)
-	/// Calls initTrik()
 	void init();
 
-	/// Recreates Main Context made by init
-	void recreateContext();
+	/// Replaces script module by a fresh one with only "brick" and system.py contents in it. The interpreter and
+	/// wrappers registry are kept.
+	void newContext();
 
 	/// Plays "beep" sound.
 	/// Can be safely called from other threads.
 	void brickBeep();
 
 private slots:
-	/// Abort script execution.
+	/// Abort script execution. Called when a script raises SystemExit (sys.exit() or script.quit()).
 	void onScriptRequestingToQuit();
 
-	/// Adds trik object to main Python context
-	void initTrik();
+	/// Asks running script to stop by means of system.py. Is delivered by an event loop, so it works when a script
+	/// waits (script.wait() and so on).
+	void abortScript();
 
 	/// Actually runs given script. Is to be called from a thread owning PythonEngineWorker.
 	void doRun(const QString &script);
@@ -121,6 +127,13 @@ private:
 	/// Evaluates "system.py" file in the current context.
 	void evalSystemPy();
 
+	/// Forgets current script module, breaking reference cycles in it.
+	void releaseContext();
+
+	/// Interrupts a script that did not get abortScript() in time, i.e. busy in Python code.
+	/// Called from a timer thread.
+	void interruptScript();
+
 	/// Turns the worker to a starting state, emits startedScript() signal.
 	void startScriptEvaluation(int scriptId);
 
@@ -135,6 +148,24 @@ private:
 
 	PythonQtObjectPtr mMainContext;
 
+	/// Module with a namespace of a current script.
+	PythonQtObjectPtr mScriptContext;
+
+	/// Name of mScriptContext in sys.modules.
+	QString mScriptContextName;
+
+	/// Counter used to make unique module names.
+	int mContextsCreated = 0;
+
+	/// True if stop was requested for a script being evaluated now.
+	QAtomicInt mAbortRequested;
+
+	/// True if abortScript() was delivered to a worker thread.
+	QAtomicInt mAbortDelivered;
+
+	/// Timer that interrupts a script which does not respond to abortScript().
+	trikKernel::TimerWheel::TimerId mInterruptTimer = 0;
+
 	QString mErrorMessage;
 };
 
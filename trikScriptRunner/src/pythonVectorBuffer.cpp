@@ -0,0 +1,467 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "pythonVectorBuffer.h"
+
+#include <limits>
+#include <new>
+
+#include <QtCore/QMetaType>
+#include <QtCore/QVector>
+
+#include <PythonQt.h>
+#include <PythonQtConversion.h>
+
+#include <QsLog.h>
+
+using namespace trikScriptRunner;
+
+Q_DECLARE_METATYPE(QVector<uint8_t>)
+
+namespace {
+
+/// Buffer protocol format of an element type.
+template<typename T> struct ElementFormat;
+
+template<> struct ElementFormat<int>
+{
+	static const char *name() { return "IntVector"; }
+	static const char *format() { return "i"; }
+};
+
+template<> struct ElementFormat<uint8_t>
+{
+	static const char *name() { return "ByteVector"; }
+	static const char *format() { return "B"; }
+};
+
+/// Python object that holds a shared copy of a QVector.
+template<typename T>
+struct VectorObject
+{
+	PyObject_HEAD
+	QVector<T> data;
+	Py_ssize_t shape;
+
+	/// Number of buffers exported by buffer protocol and not released yet, data can not be replaced while they exist.
+	Py_ssize_t exports;
+};
+
+/// List method that is called on a list copy of a vector. If method is mutating, vector is replaced with a list after
+/// the call, so vectors behave like lists which PythonQt returned before.
+struct ListMethod
+{
+	const char *name;
+	bool mutating;
+};
+
+const ListMethod listMethods[] = {
+	{"index", false}, {"count", false}, {"copy", false}
+	, {"append", true}, {"extend", true}, {"insert", true}, {"pop", true}, {"remove", true}, {"reverse", true}
+	, {"sort", true}, {"clear", true}
+};
+
+/// Returns a list copy of an object if it is a vector, or the object itself otherwise. Returns new reference.
+PyObject *listOrSelf(PyObject *object);
+
+template<typename T>
+class VectorType
+{
+public:
+	static PyTypeObject *type()
+	{
+		// Type is readied in place, PyType_Ready stores pointers to it in its dictionary and method descriptors.
+		static PyTypeObject result = {PyVarObject_HEAD_INIT(nullptr, 0) nullptr};
+		static const bool isReady = initialize(result);
+		Q_UNUSED(isReady)
+		return &result;
+	}
+
+	static bool check(PyObject *object)
+	{
+		return Py_TYPE(object) == type();
+	}
+
+	static PyObject *wrap(const QVector<T> &vector)
+	{
+		VectorObject<T> * const self = PyObject_New(VectorObject<T>, type());
+		if (!self) {
+			return nullptr;
+		}
+
+		new (&self->data) QVector<T>(vector);
+		self->shape = vector.size();
+		self->exports = 0;
+		return reinterpret_cast<PyObject *>(self);
+	}
+
+	static PyObject *toPython(const void *object, int metaTypeId)
+	{
+		Q_UNUSED(metaTypeId)
+		return wrap(*static_cast<const QVector<T> *>(object));
+	}
+
+	static PyObject *toList(PyObject *object, PyObject *)
+	{
+		const QVector<T> &data = cast(object)->data;
+		PyObject * const list = PyList_New(data.size());
+		if (!list) {
+			return nullptr;
+		}
+
+		for (int i = 0; i < data.size(); ++i) {
+			PyList_SET_ITEM(list, i, PyLong_FromLong(data.at(i)));
+		}
+
+		return list;
+	}
+
+private:
+	static VectorObject<T> *cast(PyObject *object)
+	{
+		return reinterpret_cast<VectorObject<T> *>(object);
+	}
+
+	static void dealloc(PyObject *object)
+	{
+		cast(object)->data.~QVector<T>();
+		PyObject_Del(object);
+	}
+
+	/// Converts Python integer to an element, sets Python error and returns false if it is not possible.
+	static bool toElement(PyObject *value, T &element)
+	{
+		PyObject * const index = PyNumber_Index(value);
+		if (!index) {
+			return false;
+		}
+
+		const long long result = PyLong_AsLongLong(index);
+		Py_DECREF(index);
+		if (result == -1 && PyErr_Occurred()) {
+			return false;
+		}
+
+		if (result < std::numeric_limits<T>::min() || result > std::numeric_limits<T>::max()) {
+			PyErr_SetString(PyExc_ValueError, "value is out of range of vector elements");
+			return false;
+		}
+
+		element = static_cast<T>(result);
+		return true;
+	}
+
+	/// Checks that data can be changed, sets Python error and returns false if it can not.
+	static bool isMutable(PyObject *object)
+	{
+		if (cast(object)->exports > 0) {
+			PyErr_SetString(PyExc_BufferError, "vector can not be changed while its buffer is used");
+			return false;
+		}
+
+		return true;
+	}
+
+	/// Replaces data with elements of a list, sets Python error and returns false if some of them are not integers
+	/// in range of elements.
+	static bool assign(PyObject *object, PyObject *list)
+	{
+		const Py_ssize_t size = PyList_GET_SIZE(list);
+		QVector<T> data(static_cast<int>(size));
+		for (Py_ssize_t i = 0; i < size; ++i) {
+			if (!toElement(PyList_GET_ITEM(list, i), data[static_cast<int>(i)])) {
+				return false;
+			}
+		}
+
+		cast(object)->data = data;
+		cast(object)->shape = size;
+		return true;
+	}
+
+	static Py_ssize_t length(PyObject *object)
+	{
+		return cast(object)->data.size();
+	}
+
+	static PyObject *item(PyObject *object, Py_ssize_t index)
+	{
+		const QVector<T> &data = cast(object)->data;
+		if (index < 0 || index >= data.size()) {
+			PyErr_SetString(PyExc_IndexError, "index out of range");
+			return nullptr;
+		}
+
+		return PyLong_FromLong(data.at(static_cast<int>(index)));
+	}
+
+	/// Indexing with negative indices and slicing, slices are lists like slices of lists.
+	static PyObject *subscript(PyObject *object, PyObject *key)
+	{
+		if (PyIndex_Check(key)) {
+			Py_ssize_t index = PyNumber_AsSsize_t(key, PyExc_IndexError);
+			if (index == -1 && PyErr_Occurred()) {
+				return nullptr;
+			}
+
+			return item(object, index < 0 ? index + length(object) : index);
+		}
+
+		PyObject * const list = toList(object, nullptr);
+		if (!list) {
+			return nullptr;
+		}
+
+		PyObject * const result = PyObject_GetItem(list, key);
+		Py_DECREF(list);
+		return result;
+	}
+
+	/// Assignment to an element is done in place, other assignments and deletions are done on a list copy.
+	static int assignSubscript(PyObject *object, PyObject *key, PyObject *value)
+	{
+		if (!isMutable(object)) {
+			return -1;
+		}
+
+		QVector<T> &data = cast(object)->data;
+		if (value && PyIndex_Check(key)) {
+			Py_ssize_t index = PyNumber_AsSsize_t(key, PyExc_IndexError);
+			if (index == -1 && PyErr_Occurred()) {
+				return -1;
+			}
+
+			index = index < 0 ? index + data.size() : index;
+			if (index < 0 || index >= data.size()) {
+				PyErr_SetString(PyExc_IndexError, "assignment index out of range");
+				return -1;
+			}
+
+			return toElement(value, data[static_cast<int>(index)]) ? 0 : -1;
+		}
+
+		PyObject * const list = toList(object, nullptr);
+		if (!list) {
+			return -1;
+		}
+
+		int result = value ? PyObject_SetItem(list, key, value) : PyObject_DelItem(list, key);
+		if (result == 0 && !assign(object, list)) {
+			result = -1;
+		}
+
+		Py_DECREF(list);
+		return result;
+	}
+
+	/// Applies operation to list copies of operands which are vectors, so vectors compare, add and multiply like lists.
+	static PyObject *onLists(PyObject *left, PyObject *right, PyObject *(*operation)(PyObject *, PyObject *))
+	{
+		PyObject * const leftList = listOrSelf(left);
+		if (!leftList) {
+			return nullptr;
+		}
+
+		PyObject * const rightList = listOrSelf(right);
+		if (!rightList) {
+			Py_DECREF(leftList);
+			return nullptr;
+		}
+
+		PyObject * const result = operation(leftList, rightList);
+		Py_DECREF(leftList);
+		Py_DECREF(rightList);
+		return result;
+	}
+
+	static PyObject *add(PyObject *left, PyObject *right)
+	{
+		return onLists(left, right, &PyNumber_Add);
+	}
+
+	static PyObject *multiply(PyObject *left, PyObject *right)
+	{
+		return onLists(left, right, &PyNumber_Multiply);
+	}
+
+	static PyObject *richCompare(PyObject *object, PyObject *other, int operation)
+	{
+		PyObject * const list = listOrSelf(object);
+		if (!list) {
+			return nullptr;
+		}
+
+		PyObject * const otherList = listOrSelf(other);
+		if (!otherList) {
+			Py_DECREF(list);
+			return nullptr;
+		}
+
+		PyObject * const result = PyObject_RichCompare(list, otherList, operation);
+		Py_DECREF(list);
+		Py_DECREF(otherList);
+		return result;
+	}
+
+	template<int method>
+	static PyObject *callListMethod(PyObject *object, PyObject *args, PyObject *kwargs)
+	{
+		const ListMethod &listMethod = listMethods[method];
+		if (listMethod.mutating && !isMutable(object)) {
+			return nullptr;
+		}
+
+		PyObject * const list = toList(object, nullptr);
+		if (!list) {
+			return nullptr;
+		}
+
+		PyObject * const function = PyObject_GetAttrString(list, listMethod.name);
+		PyObject *result = function ? PyObject_Call(function, args, kwargs) : nullptr;
+		Py_XDECREF(function);
+		if (result && listMethod.mutating && !assign(object, list)) {
+			Py_DECREF(result);
+			result = nullptr;
+		}
+
+		Py_DECREF(list);
+		return result;
+	}
+
+	template<int method>
+	static PyMethodDef listMethodDef()
+	{
+		// Methods with keyword arguments are called with 3 arguments, PyMethodDef stores them as PyCFunction.
+		return {listMethods[method].name
+				, reinterpret_cast<PyCFunction>(reinterpret_cast<void (*)()>(&callListMethod<method>))
+				, METH_VARARGS | METH_KEYWORDS, "The same as the method of a list."};
+	}
+
+	static PyObject *repr(PyObject *object)
+	{
+		PyObject * const list = toList(object, nullptr);
+		if (!list) {
+			return nullptr;
+		}
+
+		PyObject * const result = PyObject_Repr(list);
+		Py_DECREF(list);
+		return result;
+	}
+
+	static int getBuffer(PyObject *object, Py_buffer *view, int flags)
+	{
+		if (flags & PyBUF_WRITABLE) {
+			PyErr_SetString(PyExc_BufferError, "device data is read-only");
+			view->obj = nullptr;
+			return -1;
+		}
+
+		VectorObject<T> * const self = cast(object);
+		view->obj = object;
+		Py_INCREF(object);
+		view->buf = const_cast<T *>(self->data.constData());
+		view->len = static_cast<Py_ssize_t>(self->data.size() * sizeof(T));
+		view->readonly = 1;
+		view->itemsize = sizeof(T);
+		view->format = (flags & PyBUF_FORMAT) ? const_cast<char *>(ElementFormat<T>::format()) : nullptr;
+		view->ndim = 1;
+		view->shape = (flags & PyBUF_ND) ? &self->shape : nullptr;
+		view->strides = (flags & PyBUF_STRIDES) ? &view->itemsize : nullptr;
+		view->suboffsets = nullptr;
+		view->internal = nullptr;
+		++self->exports;
+		return 0;
+	}
+
+	static void releaseBuffer(PyObject *object, Py_buffer *view)
+	{
+		Q_UNUSED(view)
+		--cast(object)->exports;
+	}
+
+	static bool initialize(PyTypeObject &result)
+	{
+		static PySequenceMethods sequenceMethods;
+		sequenceMethods.sq_length = &length;
+		sequenceMethods.sq_item = &item;
+
+		static PyMappingMethods mappingMethods;
+		mappingMethods.mp_length = &length;
+		mappingMethods.mp_subscript = &subscript;
+		mappingMethods.mp_ass_subscript = &assignSubscript;
+
+		static PyNumberMethods numberMethods;
+		numberMethods.nb_add = &add;
+		numberMethods.nb_multiply = &multiply;
+
+		static PyBufferProcs bufferProcs;
+		bufferProcs.bf_getbuffer = &getBuffer;
+		bufferProcs.bf_releasebuffer = &releaseBuffer;
+
+		static PyMethodDef methods[] = {
+			{"tolist", &toList, METH_NOARGS, "Returns a copy of data as a list."}
+			, listMethodDef<0>(), listMethodDef<1>(), listMethodDef<2>(), listMethodDef<3>(), listMethodDef<4>()
+			, listMethodDef<5>(), listMethodDef<6>(), listMethodDef<7>(), listMethodDef<8>(), listMethodDef<9>()
+			, listMethodDef<10>()
+			, {nullptr, nullptr, 0, nullptr}
+		};
+
+		static_assert(sizeof(listMethods) / sizeof(listMethods[0]) == 11, "Every list method shall have a definition");
+
+		result.tp_name = ElementFormat<T>::name();
+		result.tp_basicsize = sizeof(VectorObject<T>);
+		result.tp_dealloc = &dealloc;
+		result.tp_repr = &repr;
+		result.tp_as_number = &numberMethods;
+		result.tp_as_sequence = &sequenceMethods;
+		result.tp_as_mapping = &mappingMethods;
+		result.tp_as_buffer = &bufferProcs;
+		result.tp_richcompare = &richCompare;
+		result.tp_flags = Py_TPFLAGS_DEFAULT;
+		result.tp_doc = "Vector of device data supporting buffer protocol, behaves like a list.";
+		result.tp_methods = methods;
+
+		if (PyType_Ready(&result) < 0) {
+			QLOG_ERROR() << "Failed to initialize Python type" << result.tp_name;
+			return false;
+		}
+
+		return true;
+	}
+};
+
+PyObject *listOrSelf(PyObject *object)
+{
+	if (VectorType<int>::check(object)) {
+		return VectorType<int>::toList(object, nullptr);
+	}
+
+	if (VectorType<uint8_t>::check(object)) {
+		return VectorType<uint8_t>::toList(object, nullptr);
+	}
+
+	Py_INCREF(object);
+	return object;
+}
+
+}
+
+void PythonVectorBuffer::registerConverters()
+{
+	PythonQtConv::registerMetaTypeToPythonConverter(qRegisterMetaType<QVector<int>>("QVector<int>")
+			, &VectorType<int>::toPython);
+	PythonQtConv::registerMetaTypeToPythonConverter(qRegisterMetaType<QVector<uint8_t>>("QVector<uint8_t>")
+			, &VectorType<uint8_t>::toPython);
+}
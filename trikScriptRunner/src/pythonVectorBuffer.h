@@ -0,0 +1,36 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+namespace trikScriptRunner {
+
+/// Python bindings for vectors returned by devices (sensor readings, camera frames).
+/// By default PythonQt converts every QVector into a new Python list element by element. Instead, vectors are
+/// wrapped into sequence objects that share storage with a QVector (it is implicitly shared, so wrapping
+/// does not copy data) and support read-only buffer protocol, so memoryview(), array and NumPy (numpy.frombuffer(),
+/// numpy.asarray()) can use frames without per-element conversion. For scripts written for lists objects behave like
+/// lists: they support slicing, item assignment, comparison with lists, concatenation, repetition and list methods.
+/// Slices and results of operators are lists, tolist() returns a copy of data as a list. Vectors can not be changed
+/// while their buffers are used (raises BufferError, like bytearray does).
+class PythonVectorBuffer
+{
+public:
+	PythonVectorBuffer() = delete;
+
+	/// Registers converters for QVector<int> and QVector<uint8_t>. Shall be called after PythonQt initialization.
+	static void registerConverters();
+};
+
+}
@@ -42,6 +42,7 @@
 #include <trikNetwork/mailboxInterface.h>
 
 #include "scriptable.h"
+#include "taskScheduler.h"
 #include "utils.h"
 
 #include <QsLog.h>
@@ -72,6 +73,7 @@ Q_DECLARE_METATYPE(QTimer*)
 #define REGISTER_DEVICES_WITH_TEMPLATE(TEMPLATE) \
 	TEMPLATE(BatteryInterface) \
 	TEMPLATE(ColorSensorInterface) \
+	TEMPLATE(ControlLoopInterface) \
 	TEMPLATE(FifoInterface) \
 	TEMPLATE(DisplayInterface) \
 	TEMPLATE(EncoderInterface) \
@@ -86,6 +88,8 @@ Q_DECLARE_METATYPE(QTimer*)
 	TEMPLATE(LineSensorInterface) \
 	TEMPLATE(MailboxInterface) \
 	TEMPLATE(MarkerInterface) \
+	TEMPLATE(MotorControllerInterface) \
+	TEMPLATE(MotorGroupInterface) \
 	TEMPLATE(MotorInterface) \
 	TEMPLATE(ObjectSensorInterface) \
 	TEMPLATE(SoundSensorInterface) \
@@ -146,19 +150,6 @@ QScriptValue timeInterval(QScriptContext *context, QScriptEngine *engine)
 	return engine->toScriptValue(result);
 }
 
-static inline int32_t getMedian(uint8_t &a, uint8_t &b, uint8_t &c, uint8_t &d)
-{
-	if (a > b)
-		std::swap(a, b);
-	if (c > d)
-		std::swap(c, d);
-	if (a > c)
-		std::swap(a, c);
-	if (b > d)
-		std::swap(b, d);
-	return (static_cast<int32_t>(b) + c) >> 1;
-}
-
 QScriptValue getPhoto(QScriptContext *context,	QScriptEngine *engine)
 {
 	const QScriptValue & brickValue = engine->globalObject().property("brick");
@@ -172,34 +163,9 @@ QScriptValue getPhoto(QScriptContext *context,	QScriptEngine *engine)
 				: QString("/dev/video0");
 			QLOG_INFO() << "Calling getStillImage()";
 			auto data = brick->getStillImage();
-			QList<int32_t> result;
-			result.reserve(data.size() / 3); //Repack RGB88 from 3 x uint8_t into int32_t
 			constexpr auto IMAGE_WIDTH = 320;
 			constexpr auto IMAGE_HEIGHT = 240;
-			if (data.size() >= IMAGE_WIDTH * IMAGE_HEIGHT * 3) {
-				for(int row = 0; row < IMAGE_HEIGHT; row += 2) {
-					for(int col = 0; col < IMAGE_WIDTH; col+=2) {
-						auto row1 = &data[(row*IMAGE_WIDTH+col)*3];
-						auto row2 = row1 + IMAGE_WIDTH*3;
-						auto r1 = row1[0];
-						auto g1 = row1[1];
-						auto b1 = row1[2];
-						auto r2 = row1[3];
-						auto g2 = row1[4];
-						auto b2 = row1[5];
-						auto r3 = row2[0];
-						auto g3 = row2[1];
-						auto b3 = row2[2];
-						auto r4 = row2[3];
-						auto g4 = row2[4];
-						auto b4 = row2[5];
-
-						result.push_back((getMedian(r1, r2, r3, r4) << 16)
-							| (getMedian(g1, g2, g3, g4) << 8)
-							| getMedian(b1, b2, b3, b4));
-					}
-				}
-			}
+			const QList<int32_t> result = Utils::repackPhoto(data, IMAGE_WIDTH, IMAGE_HEIGHT);
 
 			QLOG_INFO() << "Constructed result of getStillImage()";
 			auto val = engine->toScriptValue(result);
@@ -304,9 +270,10 @@ void ScriptEngineWorker::stopScript()
 
 QStringList ScriptEngineWorker::knownMethodNames() const
 {
-	QSet<QString> result = {"brick", "script", "threading"};
+	QSet<QString> result = {"brick", "script", "threading", "tasks"};
 	collectMethodNames(result, mBrick.metaObject());
 	collectMethodNames(result, mScriptControl.metaObject());
+	collectMethodNames(result, &TaskScheduler::staticMetaObject);
 	if (mMailbox) {
 		result.insert("mailbox");
 		collectMethodNames(result, mMailbox->metaObject());
@@ -388,6 +355,12 @@ void ScriptEngineWorker::startScriptEvaluation(int scriptId)
 	QLOG_INFO() << "ScriptEngineWorker: starting script" << scriptId << ", thread:" << QThread::currentThread();
 	mState = starting;
 	mScriptId = scriptId;
+
+	// Previous script was stopped with mailbox->stopWaiting(), new one shall be able to wait for messages.
+	if (mMailbox) {
+		mMailbox->resumeWaiting();
+	}
+
 	emit startedScript(mScriptId);
 }
 
@@ -431,6 +404,11 @@ QScriptEngine * ScriptEngineWorker::createScriptEngine(bool supportThreads)
 	engine->globalObject().setProperty("brick", engine->newQObject(&mBrick));
 	engine->globalObject().setProperty("script", engine->newQObject(&mScriptControl));
 
+	// Scheduler is owned by the engine, so it is moved to a script thread together with it.
+	TaskScheduler * const tasks = new TaskScheduler(engine);
+	connect(&mScriptControl, SIGNAL(stopWaiting()), tasks, SLOT(clear()));
+	engine->globalObject().setProperty("tasks", engine->newQObject(tasks));
+
 	if (mMailbox) {
 		engine->globalObject().setProperty("mailbox", engine->newQObject(mMailbox));
 	}
@@ -460,7 +438,10 @@ QScriptEngine *ScriptEngineWorker::copyScriptEngine(const QScriptEngine * const
 	QScriptEngine *const result = createScriptEngine();
 
 	QScriptValue globalObject = result->globalObject();
+	// Task scheduler belongs to an engine and its thread, so a copy shall keep its own one.
+	const QScriptValue tasks = globalObject.property("tasks");
 	Utils::copyRecursivelyTo(original->globalObject(), globalObject, result);
+	globalObject.setProperty("tasks", tasks);
 	result->setGlobalObject(globalObject);
 
 	// We need to re-eval system.js after global object copying because functions did not get copied by
@@ -20,6 +20,8 @@
 #include <QtCore/QFileInfo>
 #include <QtCore/QStringList>
 
+#include <trikKernel/timerWheel.h>
+
 #include <QsLog.h>
 
 using namespace trikScriptRunner;
@@ -53,10 +55,12 @@ void ScriptExecutionControl::wait(const int &milliseconds)
 {
 	QEventLoop loop;
 	QObject::connect(this, SIGNAL(stopWaiting()), &loop, SLOT(quit()), Qt::DirectConnection);
-	QTimer t;
-	connect(&t, SIGNAL(timeout()), &loop, SLOT(quit()), Qt::DirectConnection);
-	t.start(milliseconds);
+
+	// Quit is queued, so it will not be lost even if the timer expires before the loop is started.
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	const trikKernel::TimerWheel::TimerId timer = wheel.startQueued(milliseconds, &loop, "quit", true);
 	loop.exec();
+	wheel.stop(timer);
 }
 
 qint64 ScriptExecutionControl::time() const
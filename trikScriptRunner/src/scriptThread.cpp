@@ -16,6 +16,7 @@
 
 #include <QtCore/QEventLoop>
 #include <QtCore/QDateTime>
+#include <QtCore/QTimer>
 #include <QScriptValueIterator>
 #include <QJsonObject>
 
@@ -83,13 +84,21 @@ bool ScriptThread::isEvaluating() const
 
 void ScriptThread::onGetVariables(const QString &propertyName)
 {
-	if (mEngine != nullptr) {
+	if (mEngine == nullptr) {
+		return;
+	}
+
+	// This object lives in a thread that created it, but engine is not thread-safe and shall be accessed only from
+	// the script thread. Engine processes events during evaluation, so snapshot is taken there between statements,
+	// without waiting for a script and without stopping it for longer than iteration over variables takes.
+	QTimer::singleShot(0, mEngine, [this, propertyName]() {
 		QScriptValueIterator it(mEngine->globalObject().property(propertyName));
 		QJsonObject json;
 		while (it.hasNext()) {
 			it.next();
 			json[it.name()] = it.value().toString();
 		}
+
 		emit variablesReady(json);
-	}
+	});
 }
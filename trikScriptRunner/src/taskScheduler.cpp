@@ -0,0 +1,152 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "taskScheduler.h"
+
+#include <QtScript/QScriptEngine>
+
+#include <QsLog.h>
+
+using namespace trikScriptRunner;
+
+TaskScheduler::TaskScheduler(QObject *parent)
+	: QObject(parent)
+	, mTimer(this)
+{
+	mTimer.setSingleShot(true);
+	mTimer.setTimerType(Qt::PreciseTimer);
+	connect(&mTimer, SIGNAL(timeout()), this, SLOT(onTimeout()));
+	mClock.start();
+}
+
+TaskScheduler::~TaskScheduler()
+{
+}
+
+int TaskScheduler::after(int milliseconds, const QScriptValue &callback)
+{
+	return schedule(milliseconds, -1, callback);
+}
+
+int TaskScheduler::every(int milliseconds, const QScriptValue &callback)
+{
+	return schedule(milliseconds, qMax(milliseconds, 0), callback);
+}
+
+int TaskScheduler::post(const QScriptValue &callback)
+{
+	return schedule(0, -1, callback);
+}
+
+void TaskScheduler::cancel(int taskId)
+{
+	const auto task = mTasks.constFind(taskId);
+	if (task == mTasks.constEnd()) {
+		return;
+	}
+
+	mQueue.remove({task->deadline, taskId});
+	mTasks.erase(task);
+	rearm();
+}
+
+bool TaskScheduler::isPending(int taskId) const
+{
+	return mTasks.contains(taskId);
+}
+
+int TaskScheduler::pending() const
+{
+	return mTasks.size();
+}
+
+void TaskScheduler::clear()
+{
+	mTasks.clear();
+	mQueue.clear();
+	mTimer.stop();
+}
+
+void TaskScheduler::onTimeout()
+{
+	const qint64 now = mClock.elapsed();
+
+	// Tasks scheduled by tasks being run get deadlines not earlier than now, and they shall not be run in this pass
+	// even with zero delay, so we take only tasks that were due at the beginning of the pass.
+	QList<int> due;
+	for (auto it = mQueue.begin(); it != mQueue.end() && it.key().first <= now; it = mQueue.erase(it)) {
+		due.append(it.value());
+	}
+
+	for (const int id : due) {
+		auto task = mTasks.find(id);
+		if (task == mTasks.end()) {
+			// Cancelled by one of the previous tasks.
+			continue;
+		}
+
+		QScriptValue callback = task->callback;
+		if (task->interval >= 0) {
+			// Periodic tasks keep their phase, but skip missed periods instead of firing in a burst.
+			task->deadline += task->interval;
+			if (task->deadline <= now) {
+				task->deadline = now + task->interval;
+			}
+
+			mQueue.insert({task->deadline, id}, id);
+		} else {
+			mTasks.erase(task);
+		}
+
+		callback.call();
+		QScriptEngine * const engine = callback.engine();
+		if (engine && engine->hasUncaughtException()) {
+			QLOG_ERROR() << "TaskScheduler: uncaught exception in task" << id << "at line"
+					<< engine->uncaughtExceptionLineNumber() << ":" << engine->uncaughtException().toString();
+			engine->clearExceptions();
+		}
+	}
+
+	rearm();
+}
+
+int TaskScheduler::schedule(int delay, int interval, const QScriptValue &callback)
+{
+	if (!callback.isFunction()) {
+		QLOG_ERROR() << "TaskScheduler: attempt to schedule" << callback.toString() << "which is not a function";
+		return -1;
+	}
+
+	const int id = mNextId++;
+	const qint64 deadline = mClock.elapsed() + qMax(delay, 0);
+	mTasks.insert(id, {callback, interval, deadline});
+	mQueue.insert({deadline, id}, id);
+
+	if (mQueue.constBegin().value() == id) {
+		rearm();
+	}
+
+	return id;
+}
+
+void TaskScheduler::rearm()
+{
+	if (mQueue.isEmpty()) {
+		mTimer.stop();
+		return;
+	}
+
+	const qint64 delay = mQueue.firstKey().first - mClock.elapsed();
+	mTimer.start(static_cast<int>(qMax<qint64>(delay, 0)));
+}
@@ -0,0 +1,106 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QHash>
+#include <QtCore/QMap>
+#include <QtCore/QPair>
+#include <QtCore/QTimer>
+#include <QtScript/QScriptValue>
+
+namespace trikScriptRunner {
+
+/// Cooperative scheduler of script tasks inside one script engine. All tasks are executed on a thread of an engine
+/// one by one and are driven by a single timer that is re-armed to the nearest deadline, so a script can have
+/// dozens of concurrent behaviors without creating a timer or an OS thread (with its own engine) for each of them.
+/// A task is a script function called when its deadline expires; long-running behaviors are expressed as chains of
+/// tasks (a task schedules its continuation). Waiting for signals (sensor events, mailbox messages) is built on top
+/// of it in system.js.
+/// Like timers, tasks are processed only when a script is in event-driven mode (see script.run()).
+class TaskScheduler : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Constructor. Scheduler lives in a thread of its parent, it is expected to be a script engine.
+	explicit TaskScheduler(QObject *parent = nullptr);
+
+	~TaskScheduler() override;
+
+public slots:
+	/// Schedules one-shot call of a given function after given amount of milliseconds.
+	/// @returns id of a task that can be used to cancel it, or -1 if callback is not a function.
+	int after(int milliseconds, const QScriptValue &callback);
+
+	/// Schedules periodic call of a given function with given interval in milliseconds.
+	/// @returns id of a task that can be used to cancel it, or -1 if callback is not a function.
+	int every(int milliseconds, const QScriptValue &callback);
+
+	/// Schedules call of a given function as soon as control returns to the event loop.
+	/// @returns id of a task.
+	int post(const QScriptValue &callback);
+
+	/// Cancels a task with given id. Does nothing if there is no such task.
+	void cancel(int taskId);
+
+	/// Returns true if a task with given id is still scheduled.
+	bool isPending(int taskId) const;
+
+	/// Returns number of scheduled tasks.
+	int pending() const;
+
+	/// Cancels all tasks.
+	void clear();
+
+private slots:
+	/// Runs all tasks whose deadlines are expired and re-arms the timer.
+	void onTimeout();
+
+private:
+	/// Scheduled task.
+	struct Task {
+		QScriptValue callback;
+
+		/// Interval of a periodic task in milliseconds, or -1 for one-shot tasks.
+		int interval;
+
+		/// Deadline in milliseconds since mClock start.
+		qint64 deadline;
+	};
+
+	/// Adds a task to a queue and re-arms the timer if needed.
+	int schedule(int delay, int interval, const QScriptValue &callback);
+
+	/// Starts the timer for the nearest deadline, or stops it if there are no tasks.
+	void rearm();
+
+	/// Single timer that drives all tasks.
+	QTimer mTimer;
+
+	/// Monotonic clock used for deadlines.
+	QElapsedTimer mClock;
+
+	/// Tasks by id.
+	QHash<int, Task> mTasks;
+
+	/// Ids of tasks ordered by their deadlines. Key also contains an id, so tasks with equal deadlines run in order
+	/// of scheduling.
+	QMap<QPair<qint64, int>, int> mQueue;
+
+	int mNextId = 0;
+};
+
+}
@@ -18,6 +18,8 @@
 #include <QtScript/QScriptValueIterator>
 #include <QJsonObject>
 
+#include <trikKernel/metrics.h>
+
 #include "scriptEngineWorker.h"
 #include "src/utils.h"
 #include "src/scriptThread.h"
@@ -26,6 +28,12 @@
 
 using namespace trikScriptRunner;
 
+static trikKernel::Metrics::Histogram &engineCreationTime = trikKernel::Metrics::histogram("script.engineCreation");
+static trikKernel::Metrics::Histogram &engineCloningTime = trikKernel::Metrics::histogram("script.engineCloning");
+static trikKernel::Metrics::Histogram &threadStartTime = trikKernel::Metrics::histogram("script.threadStart");
+static trikKernel::Metrics::Counter &messageCount = trikKernel::Metrics::counter("script.messages");
+static trikKernel::Metrics::Histogram &messageQueueDepth = trikKernel::Metrics::histogram("script.messageQueueDepth");
+
 Threading::Threading(ScriptEngineWorker *scriptWorker, ScriptExecutionControl &scriptControl)
 	: QObject(scriptWorker)
 	, mResetStarted(false)
@@ -50,7 +58,11 @@ void Threading::startMainThread(const QString &script)
 	const QRegExp mainRegexp("(.*var main\\s*=\\s*\\w*\\s*function\\(.*\\).*)|(.*function\\s+%1\\s*\\(.*\\).*)");
 	const bool needCallMain = mainRegexp.exactMatch(script) && !script.trimmed().endsWith("main();");
 
-	mMainScriptEngine = mScriptWorker->createScriptEngine();
+	{
+		trikKernel::Metrics::ScopedTimer timer(engineCreationTime);
+		mMainScriptEngine = mScriptWorker->createScriptEngine();
+	}
+
 	startThread(mMainThreadName, mMainScriptEngine, needCallMain ? script + "\nmain();" : script);
 }
 
@@ -102,10 +114,13 @@ void Threading::startThread(const QString &threadId, QScriptEngine *engine, cons
 
 	engine->moveToThread(thread);
 	connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
-	QEventLoop wait;
-	connect(thread, SIGNAL(started()), &wait, SLOT(quit()));
-	thread->start();
-	wait.exec();
+	{
+		trikKernel::Metrics::ScopedTimer timer(threadStartTime);
+		QEventLoop wait;
+		connect(thread, SIGNAL(started()), &wait, SLOT(quit()));
+		thread->start();
+		wait.exec();
+	}
 
 	QLOG_INFO() << "Threading: started thread" << threadId << "with engine" << engine << ", thread object" << thread;
 	mResetMutex.unlock();
@@ -158,6 +173,7 @@ void Threading::joinThread(const QString &threadId)
 
 QScriptEngine * Threading::cloneEngine(QScriptEngine *engine)
 {
+	trikKernel::Metrics::ScopedTimer timer(engineCloningTime);
 	QScriptEngine *result = mScriptWorker->copyScriptEngine(engine);
 	result->evaluate(mScript);
 	return result;
@@ -240,6 +256,8 @@ void Threading::sendMessage(const QString &threadId, const QScriptValue &message
 	}
 
 	mMessageQueues[threadId].enqueue(message);
+	messageCount.add();
+	messageQueueDepth.record(mMessageQueues[threadId].size());
 	mMessageQueueConditions[threadId]->wakeOne();
 	mMessageMutex.unlock();
 
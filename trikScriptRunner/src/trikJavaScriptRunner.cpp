@@ -47,7 +47,7 @@ TrikJavaScriptRunner::TrikJavaScriptRunner(trikControl::BrickInterface &brick
 
 	connect(mVariablesServer.data(), SIGNAL(getVariables(QString)), mScriptEngineWorker, SIGNAL(getVariables(QString)));
 	connect(mScriptEngineWorker, SIGNAL(variablesReady(QJsonObject))
-		, mVariablesServer.data(), SLOT(sendHTTPResponse(QJsonObject)));
+		, mVariablesServer.data(), SLOT(onVariablesReady(QJsonObject)));
 
 	QLOG_INFO() << "Starting TrikJavaScriptRunner worker thread" << &mWorkerThread;
 
@@ -15,11 +15,24 @@
 #include "trikVariablesServer.h"
 
 #include <QtCore/QJsonDocument>
-#include <QtCore/QRegExp>
+#include <QtCore/QUrl>
+#include <QtCore/QUrlQuery>
 #include <QtNetwork/QTcpSocket>
 
+#include <trikKernel/timerWheel.h>
+#include <QsLog.h>
+
 using namespace trikScriptRunner;
 
+/// Maximal size of request headers, bigger requests are rejected.
+static const int maxRequestSize = 8 * 1024;
+
+/// Time in milliseconds to wait for a snapshot from a script before answering with the last known one.
+static const int snapshotTimeout = 500;
+
+static const int defaultStreamRate = 10;
+static const int maxStreamRate = 100;
+
 TrikVariablesServer::TrikVariablesServer() :
 	mTcpServer(new QTcpServer(this))
 {
@@ -27,48 +40,239 @@ TrikVariablesServer::TrikVariablesServer() :
 	mTcpServer->listen(QHostAddress::LocalHost, port);
 }
 
-void TrikVariablesServer::sendHTTPResponse(const QJsonObject &json)
+TrikVariablesServer::~TrikVariablesServer()
 {
-	QByteArray jsonBytes = QJsonDocument(json).toJson();
-
-	// TODO: Create other way for endline constant, get rid of define
-#define NL "\r\n"
-	QString header = "HTTP/1.0 200 OK" NL
-					 "Connection: close" NL
-					 "Content-type: text/plain, charset=us-ascii" NL
-					 "Content-length: " + QString::number(jsonBytes.size()) + NL
-					 NL;
-#undef NL
-
-	mCurrentConnection->write(header.toLatin1());
-	mCurrentConnection->write(jsonBytes);
-	mCurrentConnection->close();
+	trikKernel::TimerWheel::instance().stop(mSamplingTimer);
+	trikKernel::TimerWheel::instance().stop(mTimeoutTimer);
+}
+
+void TrikVariablesServer::onVariablesReady(const QJsonObject &json)
+{
+	trikKernel::TimerWheel::instance().stop(mTimeoutTimer);
+	mTimeoutTimer = 0;
+	mSnapshotRequested = false;
+	mSnapshot = json;
+
+	answerWaitingClients();
+
+	for (auto it = mClients.begin(); it != mClients.end(); ++it) {
+		Client &client = it.value();
+		// Sampling timer runs at the highest rate of all clients, so intervals are compared with half a period slack.
+		if (client.streamInterval > 0 && (!client.lastEvent.isValid()
+				|| client.lastEvent.elapsed() + mSamplingInterval / 2 >= client.streamInterval))
+		{
+			sendEvent(*it.key(), client);
+		}
+	}
 }
 
 void TrikVariablesServer::onNewConnection()
 {
-	// TODO: Object from nextPendingConnection is a child of QTcpServer, so it will be automatically
-	// deleted when QTcpServer is destroyed. Maybe it may sense to call "deleteLater" explicitly,
-	// to avoid wasting memory.
-	mCurrentConnection = mTcpServer->nextPendingConnection();
-	connect(mCurrentConnection, SIGNAL(readyRead()), this, SLOT(processHTTPRequest()));
+	while (QTcpSocket * const socket = mTcpServer->nextPendingConnection()) {
+		mClients.insert(socket, Client());
+		connect(socket, SIGNAL(readyRead()), this, SLOT(onReadyRead()));
+		connect(socket, SIGNAL(disconnected()), this, SLOT(onDisconnected()));
+	}
+}
+
+void TrikVariablesServer::onReadyRead()
+{
+	QTcpSocket * const socket = qobject_cast<QTcpSocket *>(sender());
+	const auto it = mClients.find(socket);
+	if (it == mClients.end()) {
+		return;
+	}
+
+	Client &client = it.value();
+	client.buffer.append(socket->readAll());
+
+	// Requests may be pipelined, headers of each one end with an empty line. Bodies are not expected.
+	int requestEnd = client.buffer.indexOf("\r\n\r\n");
+	while (requestEnd != -1) {
+		const QByteArray request = client.buffer.left(requestEnd);
+		client.buffer.remove(0, requestEnd + 4);
+		if (!processRequest(*socket, client, request)) {
+			socket->disconnectFromHost();
+			return;
+		}
+
+		requestEnd = client.buffer.indexOf("\r\n\r\n");
+	}
+
+	if (client.buffer.size() > maxRequestSize) {
+		sendResponse(*socket, client, "431 Request Header Fields Too Large", QByteArray());
+		socket->disconnectFromHost();
+	}
+}
+
+void TrikVariablesServer::onDisconnected()
+{
+	QTcpSocket * const socket = qobject_cast<QTcpSocket *>(sender());
+	if (mClients.remove(socket) > 0) {
+		socket->deleteLater();
+		updateSampling();
+	}
+}
+
+void TrikVariablesServer::requestSnapshot()
+{
+	if (mSnapshotRequested) {
+		return;
+	}
+
+	mSnapshotRequested = true;
+	mTimeoutTimer = trikKernel::TimerWheel::instance().startQueued(snapshotTimeout, this, "onSnapshotTimeout", true);
+	emit getVariables("web");
 }
 
-void TrikVariablesServer::processHTTPRequest()
+void TrikVariablesServer::onSnapshotTimeout()
 {
-	// TODO: Make sure, that different connections aren't intersected using mutex or
-	// support multiple connections simultaneously
-	QStringList list;
-	while (mCurrentConnection->canReadLine())
-	{
-		QString data = QString(mCurrentConnection->readLine());
-		list.append(data);
+	if (!mSnapshotRequested) {
+		return;
 	}
 
-	const QString cleanString = list.join("").remove(QRegExp("[\\n\\t\\r]"));
-	const QStringList words = cleanString.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+	mSnapshotRequested = false;
+	mTimeoutTimer = 0;
+	answerWaitingClients();
+}
+
+bool TrikVariablesServer::processRequest(QTcpSocket &socket, Client &client, const QByteArray &request)
+{
+	const QList<QByteArray> lines = request.split('\n');
+	const QList<QByteArray> requestLine = lines.first().trimmed().split(' ');
+	if (requestLine.size() != 3 || requestLine[0] != "GET") {
+		sendResponse(socket, client, "400 Bad Request", QByteArray());
+		return false;
+	}
+
+	// HTTP/1.1 connections are persistent by default, HTTP/1.0 ones only if asked.
+	client.keepAlive = requestLine[2] == "HTTP/1.1";
+	for (int i = 1; i < lines.size(); ++i) {
+		const QByteArray line = lines[i].trimmed().toLower();
+		if (line.startsWith("connection:")) {
+			const QByteArray value = line.mid(QByteArray("connection:").size()).trimmed();
+			client.keepAlive = value == "keep-alive" || (client.keepAlive && value != "close");
+		}
+	}
 
-	if (words[1] == "/web/") {
-		emit getVariables("web");
+	const QUrl url(QString::fromLatin1(requestLine[1]));
+	const QString path = url.path();
+	if (path == "/web/" || path == "/web") {
+		client.waiting = true;
+		requestSnapshot();
+		return true;
 	}
+
+	if (path == "/web/stream") {
+		bool ok = false;
+		int rate = QUrlQuery(url).queryItemValue("rate").toInt(&ok);
+		if (!ok || rate <= 0) {
+			rate = defaultStreamRate;
+		}
+
+		client.streamInterval = 1000 / qMin(rate, maxStreamRate);
+		client.sent = QJsonObject();
+		client.lastEvent.invalidate();
+
+		socket.write("HTTP/1.1 200 OK\r\n"
+				"Content-Type: text/event-stream\r\n"
+				"Cache-Control: no-cache\r\n"
+				"Connection: keep-alive\r\n"
+				"\r\n");
+
+		// The first event contains all variables, it is sent as soon as snapshot is ready.
+		updateSampling();
+		requestSnapshot();
+		return true;
+	}
+
+	sendResponse(socket, client, "404 Not Found", QByteArray());
+	return client.keepAlive;
+}
+
+void TrikVariablesServer::sendResponse(QTcpSocket &socket, const Client &client, const QByteArray &status
+		, const QByteArray &body)
+{
+	QByteArray response;
+	response.reserve(body.size() + 128);
+	response.append("HTTP/1.1 ").append(status).append("\r\n");
+	response.append(client.keepAlive ? "Connection: keep-alive\r\n" : "Connection: close\r\n");
+	response.append("Content-Type: application/json; charset=utf-8\r\n");
+	response.append("Content-Length: ").append(QByteArray::number(body.size())).append("\r\n\r\n");
+	response.append(body);
+	socket.write(response);
+}
+
+void TrikVariablesServer::sendEvent(QTcpSocket &socket, Client &client)
+{
+	const bool first = !client.lastEvent.isValid();
+	const QJsonObject changes = first ? mSnapshot : diff(client.sent, mSnapshot);
+	if (!first && changes.isEmpty()) {
+		return;
+	}
+
+	socket.write("data: " + QJsonDocument(changes).toJson(QJsonDocument::Compact) + "\n\n");
+	client.sent = mSnapshot;
+	client.lastEvent.start();
+}
+
+void TrikVariablesServer::answerWaitingClients()
+{
+	const QByteArray body = QJsonDocument(mSnapshot).toJson();
+	QList<QTcpSocket *> toClose;
+	for (auto it = mClients.begin(); it != mClients.end(); ++it) {
+		Client &client = it.value();
+		if (!client.waiting) {
+			continue;
+		}
+
+		client.waiting = false;
+		sendResponse(*it.key(), client, "200 OK", body);
+		if (!client.keepAlive) {
+			toClose << it.key();
+		}
+	}
+
+	// Disconnecting may remove clients synchronously, so it is done after iteration.
+	for (QTcpSocket * const socket : toClose) {
+		socket->disconnectFromHost();
+	}
+}
+
+void TrikVariablesServer::updateSampling()
+{
+	int interval = 0;
+	for (const Client &client : mClients) {
+		if (client.streamInterval > 0 && (interval == 0 || client.streamInterval < interval)) {
+			interval = client.streamInterval;
+		}
+	}
+
+	if (interval == mSamplingInterval) {
+		return;
+	}
+
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	wheel.stop(mSamplingTimer);
+	mSamplingTimer = interval > 0 ? wheel.startQueued(interval, this, "requestSnapshot") : 0;
+	mSamplingInterval = interval;
+}
+
+QJsonObject TrikVariablesServer::diff(const QJsonObject &from, const QJsonObject &to)
+{
+	QJsonObject result;
+	for (auto it = to.constBegin(); it != to.constEnd(); ++it) {
+		const auto old = from.constFind(it.key());
+		if (old == from.constEnd() || old.value() != it.value()) {
+			result.insert(it.key(), it.value());
+		}
+	}
+
+	for (auto it = from.constBegin(); it != from.constEnd(); ++it) {
+		if (!to.contains(it.key())) {
+			result.insert(it.key(), QJsonValue());
+		}
+	}
+
+	return result;
 }
@@ -14,12 +14,27 @@
 
 #include "utils.h"
 
+#include <algorithm>
+
 #include <QtCore/QDateTime>
 #include <QtCore/QRegExp>
 #include <QtScript/QScriptValueIterator>
 
 using namespace trikScriptRunner;
 
+static inline int32_t getMedian(uint8_t &a, uint8_t &b, uint8_t &c, uint8_t &d)
+{
+	if (a > b)
+		std::swap(a, b);
+	if (c > d)
+		std::swap(c, d);
+	if (a > c)
+		std::swap(a, c);
+	if (b > d)
+		std::swap(b, d);
+	return (static_cast<int32_t>(b) + c) >> 1;
+}
+
 QScriptValue Utils::clone(const QScriptValue &prototype, QScriptEngine * const engine)
 {
 	QScriptValue copy;
@@ -90,3 +105,37 @@ void Utils::copyRecursivelyTo(const QScriptValue &prototype, QScriptValue &targe
 		}
 	}
 }
+
+QList<int32_t> Utils::repackPhoto(const QVector<uint8_t> &rgb888, int width, int height)
+{
+	QList<int32_t> result;
+	if (rgb888.size() < width * height * 3) {
+		return result;
+	}
+
+	result.reserve(width * height / 4);
+	for (int row = 0; row < height; row += 2) {
+		for (int col = 0; col < width; col += 2) {
+			auto row1 = &rgb888[(row * width + col) * 3];
+			auto row2 = row1 + width * 3;
+			uint8_t r1 = row1[0];
+			uint8_t g1 = row1[1];
+			uint8_t b1 = row1[2];
+			uint8_t r2 = row1[3];
+			uint8_t g2 = row1[4];
+			uint8_t b2 = row1[5];
+			uint8_t r3 = row2[0];
+			uint8_t g3 = row2[1];
+			uint8_t b3 = row2[2];
+			uint8_t r4 = row2[3];
+			uint8_t g4 = row2[4];
+			uint8_t b4 = row2[5];
+
+			result.push_back((getMedian(r1, r2, r3, r4) << 16)
+				| (getMedian(g1, g2, g3, g4) << 8)
+				| getMedian(b1, b2, b3, b4));
+		}
+	}
+
+	return result;
+}
@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <QtCore/QList>
+#include <QtCore/QVector>
 #include <QtScript/QScriptEngine>
 
 namespace trikScriptRunner {
@@ -35,6 +37,14 @@ public:
 
 	/// Returns true if a given script value is an object and if it has a property with a given name.
 	static bool hasProperty(const QScriptValue &object, const QString &property);
+
+	/// Repacks RGB888 image from 3 x uint8_t per pixel into one int32_t 0xRRGGBB per pixel of an image of half width
+	/// and half height, each channel of a pixel is a median of 2x2 block of the source image. Used by "getPhoto".
+	/// Returns empty list if image is smaller than given size.
+	/// @param rgb888 - source image, row by row.
+	/// @param width - width of the source image, shall be even.
+	/// @param height - height of the source image, shall be even.
+	static QList<int32_t> repackPhoto(const QVector<uint8_t> &rgb888, int width, int height);
 };
 
 }
@@ -118,8 +118,55 @@ if (!String.prototype.format) {
 }
 
 script.repeat = function(mscs, f) {
-    var timer = script.timer(mscs);
-    timer.timeout.connect(f);
+    return tasks.every(mscs, f);
+}
+
+// Cooperative tasks helpers. Calls callback with arguments of a signal when it is emitted for the first time.
+// If timeout (in milliseconds) is positive and the signal is not emitted in time, onTimeout is called instead.
+// Returns a function that cancels waiting.
+tasks.waitFor = function(signal, timeout, callback, onTimeout) {
+    var done = false;
+    var timeoutTask = -1;
+    var finish = function() {
+        done = true;
+        signal.disconnect(handler);
+        tasks.cancel(timeoutTask);
+    };
+
+    var handler = function() {
+        if (!done) {
+            finish();
+            callback.apply(this, arguments);
+        }
+    };
+
+    signal.connect(handler);
+    if (timeout > 0) {
+        timeoutTask = tasks.after(timeout, function() {
+            if (!done) {
+                finish();
+                if (onTimeout) {
+                    onTimeout();
+                }
+            }
+        });
+    }
+
+    return function() {
+        if (!done) {
+            finish();
+        }
+    };
+}
+
+// Calls callback(sender, message) when the next mailbox message arrives, without blocking a script.
+tasks.receive = function(timeout, callback, onTimeout) {
+    return tasks.waitFor(mailbox.newMessage, timeout, callback, onTimeout);
+}
+
+// Calls callback after given amount of milliseconds; a continuation-passing counterpart of script.wait().
+tasks.sleep = function(mscs, callback) {
+    return tasks.after(mscs, callback);
 }
 
 brick.smile = function() {
@@ -17,6 +17,9 @@ class script(object):
         self.quitTimer.connect("timeout()", self.waitLoop.quit)
         self.waitTimer.connect("timeout()", self.quitTimer.start)
         self.interruptionFlag = False
+        import threading
+        self.mainThread = threading.current_thread()
+        self.threads = {}
 
     def __del__(self):
         for filename in self.files:
@@ -61,8 +64,11 @@ class script(object):
         return time.time() * 1000
 
     def wait(self, ms):
-          #waitTimer object is per instance and we have script's instance per thread
-          #same about waitLoop
+          import threading
+          if threading.current_thread() is not self.mainThread:
+              self._sleep(ms)
+              return
+          #waitTimer and waitLoop belong to the main script thread, other threads just sleep
           self.waitTimer.setInterval(ms)
           self.waitTimer.start()
           self.waitLoop.exec()
@@ -76,7 +82,59 @@ class script(object):
             self.files[filename] = open(filename, 'w+')
         self.files[filename].write(text)
 
+    def _sleep(self, ms):
+        # Worker threads have no event loop, they sleep in short steps to notice script stopping.
+        import time
+        deadline = time.time() + ms / 1000.0
+        while not self.interruptionFlag:
+            remaining = deadline - time.time()
+            if remaining <= 0:
+                return
+            time.sleep(min(remaining, 0.01))
+        raise ValueError()
+
+    def startThread(self, threadId, function, *args):
+        # Threads share the interpreter, but brick calls release the GIL, so a thread polling sensors
+        # keeps running while another one waits for a camera frame or a message.
+        import threading
+        if self.isThreadRunning(threadId):
+            raise ValueError("Thread " + str(threadId) + " is already running")
+        thread = threading.Thread(target=function, args=args, name=str(threadId))
+        thread.daemon = True
+        self.threads[threadId] = thread
+        thread.start()
+
+    def isThreadRunning(self, threadId):
+        thread = self.threads.get(threadId)
+        return thread is not None and thread.is_alive()
+
+    def joinThread(self, threadId, ms=None):
+        thread = self.threads.get(threadId)
+        if thread is not None:
+            thread.join(None if ms is None else ms / 1000.0)
+        return not self.isThreadRunning(threadId)
+
+    def joinAll(self, ms):
+        import time
+        deadline = time.time() + ms / 1000.0
+        for threadId in list(self.threads):
+            self.joinThread(threadId, max(deadline - time.time(), 0) * 1000)
+
+    def killThread(self, threadId):
+        # Exception is raised in a thread as soon as it executes Python code again.
+        import ctypes
+        thread = self.threads.get(threadId)
+        if thread is not None and thread.is_alive():
+            ctypes.pythonapi.PyThreadState_SetAsyncExc(ctypes.c_ulong(thread.ident), ctypes.py_object(SystemExit))
+
+    @staticmethod
+    def quit():
+        raise SystemExit(0)
+
     def kill(self):
         self.interruptionFlag = True
+        self.waitLoop.quit()
+        for threadId in list(self.threads):
+            self.killThread(threadId)
 
 script = script()  # singleton
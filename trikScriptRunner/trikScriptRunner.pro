@@ -27,9 +27,11 @@ HEADERS += \
 	$$PWD/src/scriptExecutionControl.h \
 	$$PWD/src/scriptEngineWorker.h \
 	$$PWD/src/pythonEngineWorker.h \
+	$$PWD/src/pythonVectorBuffer.h \
 	$$PWD/src/threading.h \
 	$$PWD/src/utils.h \
 	$$PWD/src/scriptThread.h \
+	$$PWD/src/taskScheduler.h \
 	$$PWD/include/trikScriptRunner/trikScriptRunnerInterface.h \
 	$$PWD/include/trikScriptRunner/trikPythonRunner.h \
 	$$PWD/include/trikScriptRunner/trikJavaScriptRunner.h \
@@ -39,12 +41,14 @@ SOURCES += \
 	$$PWD/src/scriptExecutionControl.cpp \
 	$$PWD/src/scriptEngineWorker.cpp \
 	$$PWD/src/pythonEngineWorker.cpp \
+	$$PWD/src/pythonVectorBuffer.cpp \
 	$$PWD/src/trikScriptRunner.cpp \
 	$$PWD/src/trikPythonRunner.cpp \
 	$$PWD/src/trikJavaScriptRunner.cpp \
 	$$PWD/src/threading.cpp \
 	$$PWD/src/utils.cpp \
 	$$PWD/src/scriptThread.cpp \
+	$$PWD/src/taskScheduler.cpp \
 	$$PWD/src/trikVariablesServer.cpp
 
 OTHER_FILES += \
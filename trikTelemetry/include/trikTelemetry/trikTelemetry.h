@@ -14,6 +14,8 @@
 
 #pragma once
 
+#include <QtCore/QThread>
+
 #include <trikNetwork/trikServer.h>
 
 namespace trikControl {
@@ -26,8 +28,9 @@ class Connection;
 
 /// TrikTelemetry server provides an interface for getting information about ports configuration and sensors data
 /// of a brick.
-/// TrikTelemetry class creates for each client a new Connection which runs in a separate thread
-/// and serves clients' requests for ports and sensors data.
+/// TrikTelemetry class creates for each client a new Connection which runs in one of server I/O threads
+/// and serves clients' requests for ports and sensors data. Subscriptions for streaming of sensors data
+/// are sampled in a separate sampler thread.
 class TrikTelemetry : public trikNetwork::TrikServer
 {
 	Q_OBJECT
@@ -37,11 +40,16 @@ public:
 	/// @param brick - a Brick used to respond to clients
 	TrikTelemetry(trikControl::BrickInterface &brick);
 
+	~TrikTelemetry() override;
+
 private:
 	Connection *connectionFactory();
 
 	/// A Brick which is used by Connections to respond to clients' requests
 	trikControl::BrickInterface &mBrick;
+
+	/// Thread where subscriptions of all connections sample data.
+	QThread mSamplerThread;
 };
 
 }
@@ -16,14 +16,26 @@
 
 #include "QsLog.h"
 
+#include <QtCore/QHash>
 #include <QtCore/QStringBuilder>
 
+#include <trikKernel/metrics.h>
+
 using namespace trikTelemetry;
 
-Connection::Connection(trikControl::BrickInterface &brick)
+/// Maximal sampling rate of a subscription, Hz.
+static const int maxRate = 1000;
+
+Connection::Connection(trikControl::BrickInterface &brick, QThread &samplerThread)
 	: trikNetwork::Connection(trikNetwork::Protocol::messageLength, trikNetwork::Heartbeat::use)
 	, mBrick(brick)
+	, mSamplerThread(samplerThread)
+{
+}
+
+Connection::~Connection()
 {
+	unsubscribe();
 }
 
 void Connection::processData(const QByteArray &data)
@@ -37,35 +49,45 @@ void Connection::processData(const QByteArray &data)
 	const QString accelerometerRequested("AccelerometerPort");
 	const QString gyroscopeRequested("GyroscopePort");
 	const QString gamepadRequested("Gamepad");
+	const QString subscribeRequested("subscribe:");
+	const QString unsubscribeRequested("unsubscribe");
+	const QString metricsRequested("metrics");
+	const QString traceRequested("trace");
+
+	if (command.startsWith(subscribeRequested)) {
+		subscribe(command.mid(subscribeRequested.length()));
+		return;
+	} else if (command.startsWith(unsubscribeRequested)) {
+		unsubscribe();
+		return;
+	} else if (command.startsWith(traceRequested)) {
+		send("trace:" + trikKernel::Metrics::chromeTrace());
+		return;
+	}
 
 	QString answer;
 	if (command.startsWith(dataRequested)) {
-		auto reportSensorReading = [this, &answer] (const QString &port) {
-			answer += QString("%1:%2:%3;")
-					.arg(port)
-					.arg(mBrick.sensor(port)->read())
-					.arg(mBrick.sensor(port)->readRawData());
-		};
-
-		answer = "allData:";
+		if (mDataHandles.isEmpty()) {
+			// Ports are resolved once per connection, then all of them are read by handles in one pass.
+			mDataPorts = mBrick.sensorPorts(trikControl::SensorInterface::Type::analogSensor)
+					+ mBrick.sensorPorts(trikControl::SensorInterface::Type::digitalSensor)
+					+ mBrick.sensorPorts(trikControl::SensorInterface::Type::specialSensor)
+					+ mBrick.encoderPorts();
+			for (const QString &port : mDataPorts) {
+				mDataHandles << mBrick.handle(port);
+			}
 
-		for (const QString &port : mBrick.sensorPorts(trikControl::SensorInterface::Type::analogSensor)) {
-			reportSensorReading(port);
+			mDataValues.resize(mDataHandles.size());
+			mDataRawValues.resize(mDataHandles.size());
 		}
 
-		for (const QString &port : mBrick.sensorPorts(trikControl::SensorInterface::Type::digitalSensor)) {
-			reportSensorReading(port);
-		}
+		mBrick.readAll(mDataHandles, mDataValues.data());
+		mBrick.readAll(mDataHandles, mDataRawValues.data(), true);
 
-		for (const QString &port : mBrick.sensorPorts(trikControl::SensorInterface::Type::specialSensor)) {
-			reportSensorReading(port);
-		}
+		answer = "allData:";
 
-		for (const QString &port : mBrick.encoderPorts()) {
-			answer += QString("%1:%2:%3;")
-					.arg(port)
-					.arg(mBrick.encoder(port)->read())
-					.arg(mBrick.encoder(port)->readRawData());
+		for (int i = 0; i < mDataPorts.size(); ++i) {
+			answer += QString("%1:%2:%3;").arg(mDataPorts[i]).arg(mDataValues[i]).arg(mDataRawValues[i]);
 		}
 
 		const QString semicolon = ";";
@@ -95,6 +117,18 @@ void Connection::processData(const QByteArray &data)
 				% "Power:" + QString::number(mBrick.keys()->isPressed(116)) % semicolon
 				% "Esc:" + QString::number(mBrick.keys()->isPressed(1));
 
+	} else if (command.startsWith(metricsRequested)) {
+		const QString action = command.mid(metricsRequested.length());
+		if (action == ":on") {
+			trikKernel::Metrics::setEnabled(true);
+		} else if (action == ":off") {
+			trikKernel::Metrics::setEnabled(false);
+		} else if (action == ":reset") {
+			trikKernel::Metrics::reset();
+		}
+
+		answer = QString("metrics:%1\n").arg(trikKernel::Metrics::isEnabled() ? "on" : "off")
+				+ trikKernel::Metrics::report();
 	} else if (command.startsWith(portsRequested)) {
 		answer = "ports:";
 		answer += "analog:" + mBrick.sensorPorts(trikControl::SensorInterface::Type::analogSensor).join(",") + ";";
@@ -134,13 +168,8 @@ void Connection::processData(const QByteArray &data)
 			} else if (command == "GamepadPad2PosPort") {
 				answer += QString("(%1,%2)").arg(mBrick.gamepad()->padX(2)).arg(mBrick.gamepad()->padY(2));
 			}
-		} else if (mBrick.sensorPorts(trikControl::SensorInterface::Type::analogSensor).contains(command)
-				|| mBrick.sensorPorts(trikControl::SensorInterface::Type::digitalSensor).contains(command)
-				|| mBrick.sensorPorts(trikControl::SensorInterface::Type::specialSensor).contains(command))
-		{
-			answer += QString::number(mBrick.sensor(command)->read());
-		} else if (mBrick.encoderPorts().contains(command)) {
-			answer += QString::number(mBrick.encoder(command)->read());
+		} else if (mBrick.handle(command) != -1) {
+			answer += QString::number(mBrick.read(mBrick.handle(command)));
 		} else if (command.startsWith(buttonRequested)) {
 			command.remove(0, buttonRequested.length());
 			answer = "sensor:" + command + ":" + (isButtonPressed(command) ? "1" : "0");
@@ -162,21 +191,135 @@ QString Connection::serializeVector(const QVector<int> &vector) {
 
 bool Connection::isButtonPressed(const QString &buttonName)
 {
-	if (buttonName == "Left") {
-		return mBrick.keys()->isPressed(105);
-	} else if (buttonName == "Up") {
-		return mBrick.keys()->isPressed(103);
-	} else if (buttonName == "Down") {
-		return mBrick.keys()->isPressed(108);
-	} else if (buttonName == "Enter") {
-		return mBrick.keys()->isPressed(28);
-	} else if (buttonName == "Right") {
-		return mBrick.keys()->isPressed(106);
-	} else if (buttonName == "Power") {
-		return mBrick.keys()->isPressed(116);
-	} else if (buttonName == "Esc") {
-		return mBrick.keys()->isPressed(1);
-	} else {
-		return false;
+	const int code = keyCode(buttonName);
+	return code != -1 && mBrick.keys()->isPressed(code);
+}
+
+int Connection::keyCode(const QString &buttonName)
+{
+	static const QHash<QString, int> codes = {
+		{"Left", 105}
+		, {"Up", 103}
+		, {"Down", 108}
+		, {"Enter", 28}
+		, {"Right", 106}
+		, {"Power", 116}
+		, {"Esc", 1}
+	};
+
+	return codes.value(buttonName, -1);
+}
+
+void Connection::subscribe(const QString &command)
+{
+	unsubscribe();
+
+	const int separator = command.indexOf(':');
+	bool ok = false;
+	const int rate = command.left(separator).toInt(&ok);
+	if (separator == -1 || !ok || rate <= 0) {
+		QLOG_ERROR() << "Malformed subscribe command:" << command;
+		send("subscribed:0:");
+		return;
+	}
+
+	QVector<Subscription::Channel> channels;
+	QStringList channelNames;
+	for (const QString &name : command.mid(separator + 1).split(',', QString::SkipEmptyParts)) {
+		const Subscription::Channel reader = channel(name);
+		if (reader) {
+			channels << reader;
+			channelNames << name;
+		} else {
+			QLOG_ERROR() << "Unknown telemetry channel" << name;
+		}
+	}
+
+	const int actualRate = qMin(rate, maxRate);
+	send(QString("subscribed:%1:%2").arg(actualRate).arg(channelNames.join(",")).toUtf8());
+	if (channels.isEmpty()) {
+		return;
+	}
+
+	mSubscription = new Subscription(channels, actualRate);
+	mSubscription->moveToThread(&mSamplerThread);
+	connect(mSubscription.data(), &Subscription::frameReady, this, &Connection::send);
+	QMetaObject::invokeMethod(mSubscription.data(), "start");
+}
+
+void Connection::unsubscribe()
+{
+	if (mSubscription) {
+		mSubscription->deleteLater();
+		mSubscription = nullptr;
+	}
+}
+
+Subscription::Channel Connection::channel(const QString &name)
+{
+	const QStringList sensorPorts = mBrick.sensorPorts(trikControl::SensorInterface::Type::analogSensor)
+			+ mBrick.sensorPorts(trikControl::SensorInterface::Type::digitalSensor)
+			+ mBrick.sensorPorts(trikControl::SensorInterface::Type::specialSensor);
+
+	// Devices are resolved once here, so sampling does not look them up by name.
+	if (sensorPorts.contains(name)) {
+		trikControl::SensorInterface * const sensor = mBrick.sensor(name);
+		return [sensor]() { return sensor->read(); };
+	}
+
+	if (mBrick.encoderPorts().contains(name)) {
+		trikControl::EncoderInterface * const encoder = mBrick.encoder(name);
+		return [encoder]() { return encoder->read(); };
+	}
+
+	const auto vectorChannel = [&name](const QString &port, trikControl::VectorSensorInterface *sensor) {
+		Subscription::Channel result;
+		if (name.length() == port.length() + 1 && name.startsWith(port) && name.at(port.length()) >= 'X'
+				&& name.at(port.length()) <= 'Z')
+		{
+			const int dimension = name.at(port.length()).toLatin1() - 'X';
+			result = [sensor, dimension]() { return sensor->read().value(dimension); };
+		}
+
+		return result;
+	};
+
+	if (const auto result = vectorChannel("AccelerometerPort", mBrick.accelerometer())) {
+		return result;
+	}
+
+	if (const auto result = vectorChannel("GyroscopePort", mBrick.gyroscope())) {
+		return result;
 	}
+
+	trikControl::GamepadInterface * const gamepad = mBrick.gamepad();
+	for (int button = 1; button <= 5; ++button) {
+		if (name == QString("GamepadButton%1Port").arg(button)) {
+			return [gamepad, button]() { return static_cast<int>(gamepad->buttonIsPressed(button)); };
+		}
+	}
+
+	for (int pad = 1; pad <= 2; ++pad) {
+		if (name == QString("GamepadPad%1PressedPort").arg(pad)) {
+			return [gamepad, pad]() { return static_cast<int>(gamepad->isPadPressed(pad)); };
+		} else if (name == QString("GamepadPad%1XPort").arg(pad)) {
+			return [gamepad, pad]() { return gamepad->padX(pad); };
+		} else if (name == QString("GamepadPad%1YPort").arg(pad)) {
+			return [gamepad, pad]() { return gamepad->padY(pad); };
+		}
+	}
+
+	if (name == "GamepadWheelPort") {
+		return [gamepad]() { return gamepad->wheel(); };
+	} else if (name == "GamepadConnectionIndicatorPort") {
+		return [gamepad]() { return static_cast<int>(gamepad->isConnected()); };
+	}
+
+	const int code = keyCode(name);
+	if (code != -1) {
+		trikControl::KeysInterface * const keys = mBrick.keys();
+		return [keys, code]() { return static_cast<int>(keys->isPressed(code)); };
+	}
+
+	return Subscription::Channel();
 }
@@ -14,9 +14,14 @@
 
 #pragma once
 
+#include <QtCore/QPointer>
+#include <QtCore/QThread>
+
 #include <trikNetwork/connection.h>
 #include <trikControl/brickInterface.h>
 
+#include "subscription.h"
+
 namespace trikTelemetry {
 
 /// Connection class accepts requests for sensors configuration and current sensor values. Uses a brick
@@ -25,6 +30,15 @@ namespace trikTelemetry {
 /// Accepted commands:
 ///     data - sends data from sensors to a client
 ///     ports - sends current ports configuration to a client
+///     subscribe:<rate>:<channel>,<channel>,... - starts streaming of binary frames with values of given channels
+///         with given rate in Hz (see Subscription for frame format). Channels are sensor and encoder ports,
+///         AccelerometerPortX (Y, Z), GyroscopePortX (Y, Z), gamepad ports as in "sensor:" command, with
+///         GamepadPad1PosPort split into GamepadPad1XPort and GamepadPad1YPort (same for pad 2), and button names.
+///         Answer is "subscribed:<rate>:<channels>" with known channels in frame order.
+///     unsubscribe - stops streaming
+///     metrics[:on|:off|:reset] - optionally enables, disables or clears runtime performance metrics, then sends
+///         "metrics:<on|off>" and a report with one metric per line (see trikKernel::Metrics)
+///     trace - sends "trace:" followed by the latest timed sections in Chrome trace event JSON format
 class Connection : public trikNetwork::Connection
 {
 	Q_OBJECT
@@ -32,18 +46,48 @@ class Connection : public trikNetwork::Connection
 public:
 	/// Constructor.
 	/// @param brick - a Brick used to respond to clients.
-	/// @param gamepad - gamepad object used to report state of Android gamepad.
-	explicit Connection(trikControl::BrickInterface &brick);
+	/// @param samplerThread - thread where subscriptions sample channels.
+	Connection(trikControl::BrickInterface &brick, QThread &samplerThread);
+
+	~Connection() override;
 
 private:
 	void processData(const QByteArray &data) override;
 
+	/// Handles "subscribe" command, replacing current subscription if any.
+	void subscribe(const QString &command);
+
+	/// Stops current subscription if any.
+	void unsubscribe();
+
+	/// Returns function that reads given channel or empty function if there is no such channel.
+	Subscription::Channel channel(const QString &name);
+
 	static QString serializeVector(const QVector<int> &vector);
 
 	bool isButtonPressed(const QString &buttonName);
 
+	/// Returns code of a key with given name or -1 if there is no such key.
+	static int keyCode(const QString &buttonName);
+
 	/// A Brick which is used by Connections to respond to clients' requests
 	trikControl::BrickInterface &mBrick;
+
+	/// Thread where subscriptions live.
+	QThread &mSamplerThread;
+
+	/// Sensor and encoder ports reported by "data" command, resolved on first request.
+	QStringList mDataPorts;
+
+	/// Handles of mDataPorts.
+	QVector<int> mDataHandles;
+
+	/// Buffers for values and raw data of mDataPorts, reused between requests.
+	QVector<int> mDataValues;
+	QVector<int> mDataRawValues;
+
+	/// Current subscription, lives in a sampler thread and is deleted there.
+	QPointer<Subscription> mSubscription;
 };
 
 }
@@ -0,0 +1,163 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#include "subscription.h"
+
+#include <QtCore/QtEndian>
+
+using namespace trikTelemetry;
+
+static const char magic[] = "TF";
+static const char formatVersion = 1;
+static const char keyFrameFlag = 0x01;
+static const int headerSize = 2 + 1 + 1 + 4 + 8 + 2;
+
+template<typename T>
+static void appendLittleEndian(QByteArray &data, T value)
+{
+	uchar buffer[sizeof(T)];
+	qToLittleEndian(value, buffer);
+	data.append(reinterpret_cast<const char *>(buffer), sizeof(T));
+}
+
+static void appendVarint(QByteArray &data, qint32 value)
+{
+	// Zigzag encoding maps small negative numbers to small unsigned ones.
+	quint32 encoded = (static_cast<quint32>(value) << 1) ^ static_cast<quint32>(value >> 31);
+	while (encoded >= 0x80) {
+		data.append(static_cast<char>((encoded & 0x7F) | 0x80));
+		encoded >>= 7;
+	}
+
+	data.append(static_cast<char>(encoded));
+}
+
+static bool readVarint(const QByteArray &data, int &position, qint32 &value)
+{
+	quint32 encoded = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (position >= data.size()) {
+			return false;
+		}
+
+		const quint8 byte = static_cast<quint8>(data.at(position++));
+		encoded |= static_cast<quint32>(byte & 0x7F) << shift;
+		if (!(byte & 0x80)) {
+			value = static_cast<qint32>((encoded >> 1) ^ (~(encoded & 1) + 1));
+			return true;
+		}
+	}
+
+	return false;
+}
+
+Subscription::Subscription(const QVector<Channel> &channels, int rate)
+	: mChannels(channels)
+	, mRate(rate)
+	, mPrevious(channels.size(), 0)
+	, mCurrent(channels.size(), 0)
+{
+}
+
+Subscription::~Subscription()
+{
+	trikKernel::TimerWheel::instance().stop(mTimer);
+}
+
+void Subscription::start()
+{
+	mClock.start();
+	sample();
+}
+
+void Subscription::sample()
+{
+	for (int i = 0; i < mChannels.size(); ++i) {
+		mCurrent[i] = mChannels[i]();
+	}
+
+	const bool keyFrame = mSequence % mRate == 0;
+	emit frameReady(encodeFrame(mSequence, mClock.nsecsElapsed() / 1000, keyFrame, mCurrent, mPrevious));
+
+	++mSequence;
+	mPrevious.swap(mCurrent);
+	scheduleNext();
+}
+
+void Subscription::scheduleNext()
+{
+	// Deadline of a frame is computed from its number, so rounding of delays to milliseconds does not accumulate.
+	const qint64 deadline = static_cast<qint64>(mSequence) * 1000000 / mRate;
+	const qint64 delay = qRound64((deadline - mClock.nsecsElapsed() / 1000) / 1000.0);
+
+	trikKernel::TimerWheel &wheel = trikKernel::TimerWheel::instance();
+	wheel.stop(mTimer);
+	mTimer = wheel.startQueued(static_cast<int>(qMax<qint64>(delay, 0)), this, "sample", true);
+}
+
+QByteArray Subscription::encodeFrame(quint32 sequence, quint64 timestamp, bool keyFrame
+		, const QVector<int> &values, const QVector<int> &previous)
+{
+	QByteArray frame;
+	frame.reserve(headerSize + values.size() * 5);
+	frame.append(magic, 2);
+	frame.append(formatVersion);
+	frame.append(keyFrame ? keyFrameFlag : '\0');
+	appendLittleEndian<quint32>(frame, sequence);
+	appendLittleEndian<quint64>(frame, timestamp);
+	appendLittleEndian<quint16>(frame, static_cast<quint16>(values.size()));
+
+	for (int i = 0; i < values.size(); ++i) {
+		// Difference is computed in unsigned arithmetic, so overflow wraps around and is restored by decoder.
+		const qint32 delta = keyFrame
+				? values[i]
+				: static_cast<qint32>(static_cast<quint32>(values[i]) - static_cast<quint32>(previous.value(i)));
+		appendVarint(frame, delta);
+	}
+
+	return frame;
+}
+
+bool Subscription::decodeFrame(const QByteArray &frame, quint32 &sequence, quint64 &timestamp, bool &keyFrame
+		, QVector<int> &values)
+{
+	if (frame.size() < headerSize || !frame.startsWith(magic) || frame.at(2) != formatVersion) {
+		return false;
+	}
+
+	const uchar * const data = reinterpret_cast<const uchar *>(frame.constData());
+	keyFrame = data[3] & keyFrameFlag;
+	sequence = qFromLittleEndian<quint32>(data + 4);
+	timestamp = qFromLittleEndian<quint64>(data + 8);
+	const int channels = qFromLittleEndian<quint16>(data + 16);
+
+	if (!keyFrame && values.size() != channels) {
+		return false;
+	}
+
+	values.resize(channels);
+	int position = headerSize;
+	for (int i = 0; i < channels; ++i) {
+		qint32 delta = 0;
+		if (!readVarint(frame, position, delta)) {
+			return false;
+		}
+
+		values[i] = keyFrame
+				? delta
+				: static_cast<qint32>(static_cast<quint32>(values[i]) + static_cast<quint32>(delta));
+	}
+
+	return position == frame.size();
+}
@@ -0,0 +1,99 @@
+/* Copyright 2018 CyberTech Labs Ltd.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License. */
+
+#pragma once
+
+#include <functional>
+
+#include <QtCore/QByteArray>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QObject>
+#include <QtCore/QVector>
+
+#include <trikKernel/timerWheel.h>
+
+namespace trikTelemetry {
+
+/// Periodically samples a set of channels and emits binary frames with their values. Lives in a sampler thread of
+/// TrikTelemetry, so sampling is not delayed by network I/O and does not block it.
+///
+/// Frame format (all integers are little-endian):
+///     2 bytes   - magic "TF"
+///     1 byte    - format version, currently 1
+///     1 byte    - flags, bit 0 is set for key frames
+///     4 bytes   - sequence number of a frame, starting from 0
+///     8 bytes   - timestamp, microseconds since subscription start
+///     2 bytes   - number of channels
+///     then for every channel in subscription order a zigzag-encoded LEB128 varint: difference between current and
+///     previous value of a channel, or a value itself in a key frame.
+/// Key frames are sent first and then once per second, so a client can join a stream or recover after a lost frame.
+class Subscription : public QObject
+{
+	Q_OBJECT
+
+public:
+	/// Function that reads current value of a channel.
+	typedef std::function<int()> Channel;
+
+	/// Constructor.
+	/// @param channels - channels to sample, in order of their values in a frame.
+	/// @param rate - sampling rate in Hz. Frames are scheduled with millisecond resolution, but at multiples of an
+	///        exact period from the start, so rates that do not divide 1000 are kept on average.
+	Subscription(const QVector<Channel> &channels, int rate);
+
+	~Subscription() override;
+
+	/// Encodes values as a frame, previous values are used for delta encoding unless it is a key frame.
+	/// Exposed for clients written in C++ and for tests.
+	static QByteArray encodeFrame(quint32 sequence, quint64 timestamp, bool keyFrame
+			, const QVector<int> &values, const QVector<int> &previous);
+
+	/// Decodes a frame. Values of a previous frame shall be in "values", they are replaced by decoded ones.
+	/// Returns false if data is not a valid frame.
+	static bool decodeFrame(const QByteArray &frame, quint32 &sequence, quint64 &timestamp, bool &keyFrame
+			, QVector<int> &values);
+
+public slots:
+	/// Starts sampling. Shall be called in the sampler thread.
+	void start();
+
+signals:
+	/// Emitted when new frame is ready to be sent to a client.
+	void frameReady(const QByteArray &frame);
+
+private slots:
+	/// Reads all channels, emits a frame and schedules the next one.
+	void sample();
+
+private:
+	/// Starts a timer for the next frame.
+	void scheduleNext();
+
+	const QVector<Channel> mChannels;
+	const int mRate;
+
+	/// Values sent in previous frame.
+	QVector<int> mPrevious;
+
+	/// Values read in current frame, kept to avoid allocation per frame.
+	QVector<int> mCurrent;
+
+	quint32 mSequence = 0;
+	QElapsedTimer mClock;
+
+	/// Id of a single-shot timer of the next frame.
+	trikKernel::TimerWheel::TimerId mTimer = 0;
+};
+
+}
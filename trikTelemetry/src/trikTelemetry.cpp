@@ -23,9 +23,19 @@ TrikTelemetry::TrikTelemetry(trikControl::BrickInterface &brick)
 	, mBrick(brick)
 {
 	setObjectName("TrikTelemetry");
+	mSamplerThread.setObjectName("TrikTelemetrySampler");
+	mSamplerThread.start();
+}
+
+TrikTelemetry::~TrikTelemetry()
+{
+	// Connections delete their subscriptions in the sampler thread, so it shall be running meanwhile.
+	closeConnections();
+	mSamplerThread.quit();
+	mSamplerThread.wait();
 }
 
 Connection * TrikTelemetry::connectionFactory()
 {
-	return new Connection(mBrick);
+	return new Connection(mBrick, mSamplerThread);
 }
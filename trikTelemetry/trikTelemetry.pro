@@ -21,10 +21,12 @@ PUBLIC_HEADERS += \
 
 HEADERS += \
 	$$PWD/src/connection.h \
+	$$PWD/src/subscription.h \
 
 SOURCES += \
 	$$PWD/src/trikTelemetry.cpp \
 	$$PWD/src/connection.cpp \
+	$$PWD/src/subscription.cpp \
 
 QT += network
 